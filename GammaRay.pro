@@ -149,6 +149,9 @@ SOURCES += main.cpp\
     viewer3d/view3dconfigwidgets/v3dcfgwidforattributein3dcartesiangrid.cpp \
     viewer3d/view3dlistrecord.cpp \
     viewer3d/view3dviewdata.cpp \
+    viewer3d/view3dgridpyramid.cpp \
+    viewer3d/view3dbuildservice.cpp \
+    viewer3d/view3dgeometrycache.cpp \
     viewer3d/view3dconfigwidgets/v3dcfgwidforattributeinmapcartesiangrid.cpp \
     domain/auxiliary/dataloader.cpp \
     array3d.cpp \
@@ -180,6 +183,7 @@ SOURCES += main.cpp\
     spectral/svd.cpp \
     spectral/pca.cpp \
     spectral/spectral.cpp \
+    spectral/fftservice.cpp \
     algorithms/ialgorithmdatasource.cpp \
     algorithms/bootstrap.cpp \
     dialogs/machinelearningdialog.cpp \
@@ -189,6 +193,8 @@ SOURCES += main.cpp\
     algorithms/CART/cartnode.cpp \
     algorithms/CART/cartsplitcriterion.cpp \
     algorithms/randomforest.cpp \
+    algorithms/flatforest.cpp \
+    algorithms/workstealingpool.cpp \
     algorithms/decisiontree.cpp \
     domain/auxiliary/variableremover.cpp \
     domain/auxiliary/datasaver.cpp \
@@ -214,6 +220,7 @@ SOURCES += main.cpp\
     calculator/calclinenumberarea.cpp \
 	calculator/calccodeeditor.cpp \
 	imagejockey/vardecomp/variographicdecompositiondialog.cpp \
+	imagejockey/vardecomp/variographicdecompositionengine.cpp \
 	imagejockey/widgets/ijquick3dviewer.cpp \
 	dialogs/factorialkrigingdialog.cpp \
     geostats/fkestimation.cpp \
@@ -227,6 +234,7 @@ SOURCES += main.cpp\
     domain/geogrid.cpp \
     domain/gridfile.cpp \
     domain/auxiliary/meshloader.cpp \
+    domain/auxiliary/geogridpointlocator.cpp \
     geometry/vector3d.cpp \
     geometry/face3d.cpp \
     dialogs/sisimdialog.cpp \
@@ -237,8 +245,10 @@ SOURCES += main.cpp\
     imagejockey/emd/emdanalysisdialog.cpp \
     imagejockey/gabor/gaborfilterdialog.cpp \
     imagejockey/gabor/gaborscandialog.cpp \
+    imagejockey/gabor/gaborscanengine.cpp \
     imagejockey/gabor/gaborutils.cpp \
     imagejockey/gabor/gaborfrequencyazimuthselections.cpp \
+    imagejockey/wavelet/waveletengine.cpp \
     imagejockey/wavelet/wavelettransformdialog.cpp \
     imagejockey/wavelet/waveletutils.cpp \
     imagejockey/ijvariographicmodel2d.cpp \
@@ -260,6 +270,7 @@ SOURCES += main.cpp\
     graphviz/graphviz.cpp \
     dialogs/transiogramdialog.cpp \
     domain/auxiliary/faciestransitionmatrixmaker.cpp \
+    domain/auxiliary/transiographyengine.cpp \
     domain/auxiliary/thicknesscalculator.cpp \
     widgets/transiogramchartview.cpp \
     domain/verticaltransiogrammodel.cpp \
@@ -267,12 +278,14 @@ SOURCES += main.cpp\
     viewer3d/view3dconfigwidgets/v3dcfgwidforattributeinsegmentset.cpp \
     geostats/segmentsetcell.cpp \
     domain/auxiliary/valuestransferer.cpp \
+    domain/auxiliary/regriddingengine.cpp \
     dialogs/mcrfsimdialog.cpp \
     dialogs/lvadatasetdialog.cpp \
     geostats/mcrfsim.cpp \
     gslib/gslibparameterfiles/commonsimulationparameters.cpp \
     spatialindex/spatialindex.cpp \
     geostats/taumodel.cpp \
+    geostats/transiogramtable.cpp \
     dialogs/mcmcdataimputationdialog.cpp
 
 HEADERS  += mainwindow.h \
@@ -397,6 +410,9 @@ HEADERS  += mainwindow.h \
     viewer3d/view3dconfigwidgets/v3dcfgwidforattributein3dcartesiangrid.h \
     viewer3d/view3dlistrecord.h \
     viewer3d/view3dviewdata.h \
+    viewer3d/view3dgridpyramid.h \
+    viewer3d/view3dbuildservice.h \
+    viewer3d/view3dgeometrycache.h \
     viewer3d/view3dconfigwidgets/v3dcfgwidforattributeinmapcartesiangrid.h \
     domain/auxiliary/dataloader.h \
     array3d.h \
@@ -428,6 +444,7 @@ HEADERS  += mainwindow.h \
     spectral/svd.h \
     spectral/pca.h \
     spectral/spectral.h \
+    spectral/fftservice.h \
     algorithms/ialgorithmdatasource.h \
     algorithms/bootstrap.h \
     dialogs/machinelearningdialog.h \
@@ -437,6 +454,8 @@ HEADERS  += mainwindow.h \
     algorithms/CART/cartnode.h \
     algorithms/CART/cartsplitcriterion.h \
     algorithms/randomforest.h \
+    algorithms/flatforest.h \
+    algorithms/workstealingpool.h \
     algorithms/decisiontree.h \
     domain/auxiliary/variableremover.h \
     domain/auxiliary/datasaver.h \
@@ -465,6 +484,7 @@ HEADERS  += mainwindow.h \
     calculator/calclinenumberarea.h \
 	calculator/calccodeeditor.h \
 	imagejockey/vardecomp/variographicdecompositiondialog.h \
+	imagejockey/vardecomp/variographicdecompositionengine.h \
 	imagejockey/widgets/ijquick3dviewer.h \
 	dialogs/factorialkrigingdialog.h \
     geostats/fkestimation.h \
@@ -478,6 +498,7 @@ HEADERS  += mainwindow.h \
     domain/geogrid.h \
     domain/gridfile.h \
     domain/auxiliary/meshloader.h \
+    domain/auxiliary/geogridpointlocator.h \
     geometry/vector3d.h \
     geometry/face3d.h \
     dialogs/sisimdialog.h \
@@ -488,8 +509,10 @@ HEADERS  += mainwindow.h \
     imagejockey/emd/emdanalysisdialog.h \
     imagejockey/gabor/gaborfilterdialog.h \
     imagejockey/gabor/gaborscandialog.h \
+    imagejockey/gabor/gaborscanengine.h \
     imagejockey/gabor/gaborutils.h \
     imagejockey/gabor/gaborfrequencyazimuthselections.h \
+    imagejockey/wavelet/waveletengine.h \
     imagejockey/wavelet/wavelettransformdialog.h \
     imagejockey/wavelet/waveletutils.h \
     imagejockey/ijvariographicmodel2d.h \
@@ -511,6 +534,7 @@ HEADERS  += mainwindow.h \
     graphviz/graphviz.h \
     dialogs/transiogramdialog.h \
     domain/auxiliary/faciestransitionmatrixmaker.h \
+    domain/auxiliary/transiographyengine.h \
     domain/auxiliary/thicknesscalculator.h \
     widgets/transiogramchartview.h \
     domain/verticaltransiogrammodel.h \
@@ -518,12 +542,15 @@ HEADERS  += mainwindow.h \
     viewer3d/view3dconfigwidgets/v3dcfgwidforattributeinsegmentset.h \
     geostats/segmentsetcell.h \
     domain/auxiliary/valuestransferer.h \
+    domain/auxiliary/regriddingengine.h \
     dialogs/mcrfsimdialog.h \
     dialogs/lvadatasetdialog.h \
     geostats/mcrfsim.h \
     gslib/gslibparameterfiles/commonsimulationparameters.h \
     spatialindex/spatialindex.h \
     geostats/taumodel.h \
+    geostats/transiogramtable.h \
+    geostats/neighbor.h \
     dialogs/mcmcdataimputationdialog.h
 
 
@@ -747,6 +774,10 @@ INCLUDEPATH += $$_FFTW3_INCLUDE
 LIBPATH     += $$_FFTW3_LIB
 LIBS        += -lfftw3
 LIBS        += -lfftw3f
+#On Windows the threading routines are built into the FFTW DLLs.
+!win32 {
+    LIBS    += -lfftw3_threads
+}
 #==============================================================
 
 #========= The GSL (GNU Scientific Library) include and lib path and libraries.=========
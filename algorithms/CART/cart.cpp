@@ -2,9 +2,15 @@
 #include "../ialgorithmdatasource.h"
 #include "cartdecisionnode.h"
 #include "cartleafnode.h"
+#include "../flatforest.h"
+#include "../workstealingpool.h"
 #include <tuple>
 #include <algorithm>
 
+/** Branches with at least this number of training rows are built as separate tasks when a pool is available.
+ *  Smaller branches are not worth the overhead. */
+static const unsigned long MIN_ROWS_FOR_PARALLEL_BRANCH = 2000;
+
 CART::CART(const IAlgorithmDataSource &trainingData,
            const IAlgorithmDataSource &outputData,
            const std::vector<int> &trainingFeatureIDs,
@@ -12,7 +18,9 @@ CART::CART(const IAlgorithmDataSource &trainingData,
            int continuousFeaturesMaxSplits) : DecisionTree(),
     m_trainingData( trainingData ),
     m_outputData( outputData ),
-    m_continuousFeaturesMaxSplits( continuousFeaturesMaxSplits )
+    m_continuousFeaturesMaxSplits( continuousFeaturesMaxSplits ),
+    m_pool( nullptr ),
+    m_cancelFlag( nullptr )
 {
     //Create the list with all row IDs.
     long rowCount = trainingData.getRowCount();
@@ -21,16 +29,24 @@ CART::CART(const IAlgorithmDataSource &trainingData,
     for( long iRow = 0; iRow < rowCount; ++iRow )
         rowIDs.push_back( iRow );
 
-    //creates the training-to-output data sets feature column IDs.
-    std::vector<int>::const_iterator itTrainingIDs = trainingFeatureIDs.cbegin();
-    std::vector<int>::const_iterator itOutputIDs = outputFeatureIDs.cbegin();
-    for( ; itTrainingIDs != trainingFeatureIDs.cend(); ++itTrainingIDs, //hopefully both lists have the same size
-                                                       ++itOutputIDs ){
-        m_training2outputFeatureIndexesMap[ *itTrainingIDs ] = *itOutputIDs;
-    }
+    build( rowIDs, trainingFeatureIDs, outputFeatureIDs );
+}
 
-    //Build the CART tree, getting the pointer to the root node.
-    m_root.reset( makeCART( rowIDs, trainingFeatureIDs ) );
+CART::CART(const IAlgorithmDataSource &trainingData,
+           const IAlgorithmDataSource &outputData,
+           const std::vector<long> &trainingRowIDs,
+           const std::vector<int> &trainingFeatureIDs,
+           const std::vector<int> &outputFeatureIDs,
+           int continuousFeaturesMaxSplits,
+           WorkStealingPool *pool,
+           const std::atomic<bool> *cancelFlag) : DecisionTree(),
+    m_trainingData( trainingData ),
+    m_outputData( outputData ),
+    m_continuousFeaturesMaxSplits( continuousFeaturesMaxSplits ),
+    m_pool( pool ),
+    m_cancelFlag( cancelFlag )
+{
+    build( trainingRowIDs, trainingFeatureIDs, outputFeatureIDs );
 }
 
 CART::~CART()
@@ -49,6 +65,27 @@ void CART::regress(long rowIdOutput, int dependentVariableColumnID, DataValue &m
     regress( rowIdOutput, dependentVariableColumnID, nullptr, mean, percent );
 }
 
+void CART::build(const std::vector<long> &rowIDs,
+                 const std::vector<int> &trainingFeatureIDs,
+                 const std::vector<int> &outputFeatureIDs)
+{
+    //creates the training-to-output data sets feature column IDs.
+    std::vector<int>::const_iterator itTrainingIDs = trainingFeatureIDs.cbegin();
+    std::vector<int>::const_iterator itOutputIDs = outputFeatureIDs.cbegin();
+    for( ; itTrainingIDs != trainingFeatureIDs.cend(); ++itTrainingIDs, //hopefully both lists have the same size
+                                                       ++itOutputIDs ){
+        m_training2outputFeatureIndexesMap[ *itTrainingIDs ] = *itOutputIDs;
+    }
+
+    //Build the CART tree, getting the pointer to the root node.
+    m_root.reset( makeCART( rowIDs, trainingFeatureIDs ) );
+}
+
+void CART::flatten(FlatForest &forest, int dependentVariableColumnID, bool useTrainingFeatures) const
+{
+    flatten( m_root.get(), forest.beginTree(), forest, dependentVariableColumnID, useTrainingFeatures );
+}
+
 void CART::getUniqueDataValues(std::vector<DataValue> &result,
                                const std::vector<long> &rowIDs,
                                int columnIndex) const
@@ -207,6 +244,10 @@ std::pair<CARTSplitCriterion, double> CART::getSplitCriterionWithMaximumInformat
 CARTNode *CART::makeCART(const std::vector<long> &rowIDs,
                          const std::vector<int> &featureIDs) const
 {
+    //if the building was cancelled, stop branching.
+    if( m_cancelFlag && *m_cancelFlag )
+        return new CARTLeafNode( m_trainingData, rowIDs );
+
     CARTSplitCriterion splitCriterion( m_trainingData, m_outputData, 0, DataValue(0.0), m_training2outputFeatureIndexesMap );
     double informationGain;
 
@@ -223,8 +264,20 @@ CARTNode *CART::makeCART(const std::vector<long> &rowIDs,
     split( rowIDs, splitCriterion, trueSideRowIDs, falseSideRowIDs );
 
     //make child nodes by recursing this function.
-    CARTNode* trueSideChildNode = makeCART( trueSideRowIDs, featureIDs );
-    CARTNode* falseSideChildNode = makeCART( falseSideRowIDs, featureIDs );
+    CARTNode* trueSideChildNode = nullptr;
+    CARTNode* falseSideChildNode = nullptr;
+    if( m_pool && trueSideRowIDs.size() >= MIN_ROWS_FOR_PARALLEL_BRANCH
+               && falseSideRowIDs.size() >= MIN_ROWS_FOR_PARALLEL_BRANCH ){
+        //large branches: the true side is built by another task (possibly stolen by an idle thread)
+        //while this thread builds the false side.
+        WorkStealingPool::TaskGroup trueSideTask;
+        m_pool->submit( trueSideTask, [&](){ trueSideChildNode = makeCART( trueSideRowIDs, featureIDs ); } );
+        falseSideChildNode = makeCART( falseSideRowIDs, featureIDs );
+        m_pool->wait( trueSideTask );
+    } else {
+        trueSideChildNode = makeCART( trueSideRowIDs, featureIDs );
+        falseSideChildNode = makeCART( falseSideRowIDs, featureIDs );
+    }
 
     //return a non-leaf node.
     return new CARTDecisionNode( splitCriterion, trueSideChildNode, falseSideChildNode, m_outputData );
@@ -284,3 +337,41 @@ void CART::regress(long rowIdOutput, int dependentVariableColumnID, const CARTNo
     else
         regress( rowIdOutput, dependentVariableColumnID, decisionTreeNode->getFalseSideChildNode(), mean, percent );
 }
+
+void CART::flatten(const CARTNode *decisionTreeNode, int flatNodeIndex,
+                   FlatForest &forest, int dependentVariableColumnID, bool useTrainingFeatures) const
+{
+    //upon reaching a leaf node, store the value that classify() or regress() would return.
+    if( decisionTreeNode->isLeaf() ){
+        const CARTLeafNode* leafNode = (const CARTLeafNode*)decisionTreeNode;
+        if( forest.getLeafType() == FlatForestLeafType::CLASS ){
+            //RandomForest::classify() takes the first (lowest) class value found in the leaf as the tree's vote.
+            std::vector< std::pair< DataValue, long> > valuesCounts;
+            leafNode->getUniqueTrainingValuesWithCounts( dependentVariableColumnID, valuesCounts );
+            forest.setLeafNode( flatNodeIndex, valuesCounts.front().first.getCategorical(), 1.0 );
+        } else {
+            DataValue mean( 0.0 );
+            double percent;
+            leafNode->getMeanOfTrainingValuesWithPercentage( dependentVariableColumnID, mean, percent );
+            forest.setLeafNode( flatNodeIndex, mean.getContinuous(), percent );
+        }
+        return;
+    }
+
+    //If execution reaches this point, the node is a decision one.
+    const CARTDecisionNode* decisionNode = (const CARTDecisionNode*)decisionTreeNode;
+    const CARTSplitCriterion& criterion = decisionNode->getSplitCriterion();
+    DataValue criterionValue = criterion.getCriterionValue();
+    double splitValue = criterionValue.isCategorical() ? criterionValue.getCategorical() :
+                                                         criterionValue.getContinuous();
+
+    //the children of a flat decision node are adjacent: true side first.
+    int trueSideChildIndex = forest.appendChildNodes();
+    int columnNumber = useTrainingFeatures ? criterion.getColumnNumberTrainingData() :
+                                             criterion.getColumnNumberOutputData();
+    forest.setDecisionNode( flatNodeIndex, columnNumber, splitValue, trueSideChildIndex );
+    flatten( decisionTreeNode->getTrueSideChildNode(), trueSideChildIndex,
+             forest, dependentVariableColumnID, useTrainingFeatures );
+    flatten( decisionTreeNode->getFalseSideChildNode(), trueSideChildIndex + 1,
+             forest, dependentVariableColumnID, useTrainingFeatures );
+}
@@ -4,9 +4,11 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <atomic>
 #include "../decisiontree.h"
 
 class CARTNode;
+class WorkStealingPool;
 class IAlgorithmDataSource;
 class CARTSplitCriterion;
 
@@ -35,6 +37,23 @@ public:
           const std::vector<int> &outputFeatureIDs,
           int continuousFeaturesMaxSplits );
 
+    /** Same as the other constructor, but only the training data rows given by their indexes are used to build
+     * the tree.  Row indexes may be repeated, which is the case of bagged (bootstrapped) training data.
+     * @param trainingRowIDs The row indexes of the training data to use.
+     * @param pool If not null, the building of large branches of the tree is split into tasks executed by this pool.
+     *             This must be a pool whose threads can wait for the tasks (e.g. the pool running this constructor).
+     * @param cancelFlag If not null and set to true by another thread, the building stops as soon as possible,
+     *                   leaving an incomplete tree.
+     */
+    CART( const IAlgorithmDataSource& trainingData,
+          const IAlgorithmDataSource& outputData,
+          const std::vector<long> &trainingRowIDs,
+          const std::vector<int> &trainingFeatureIDs,
+          const std::vector<int> &outputFeatureIDs,
+          int continuousFeaturesMaxSplits,
+          WorkStealingPool* pool = nullptr,
+          const std::atomic<bool>* cancelFlag = nullptr );
+
     virtual ~CART();
 
     /** Uses the underlying CART decision tree as a classifier to a given output data row, referenced by its row number.
@@ -62,6 +81,10 @@ public:
                           DataValue &mean,
                           double &percent ) const override;
 
+    virtual void flatten( FlatForest& forest,
+                          int dependentVariableColumnID,
+                          bool useTrainingFeatures ) const override;
+
 protected:
 
     /** The root of the CART tree. */
@@ -82,6 +105,17 @@ protected:
     /** Limit to the number of split values for continuous features. */
     int m_continuousFeaturesMaxSplits;
 
+    /** The pool used to build large tree branches in parallel (may be null). */
+    WorkStealingPool* m_pool;
+
+    /** When this flag is set, makeCART() stops branching (may be null). */
+    const std::atomic<bool>* m_cancelFlag;
+
+    /** Common constructor code: builds the tree from the given training data rows. */
+    void build( const std::vector<long> &rowIDs,
+                const std::vector<int> &trainingFeatureIDs,
+                const std::vector<int> &outputFeatureIDs );
+
     /* The functions below are arranged in dependency order. Of course the recursive functions depend
        on themselves. */
 
@@ -183,6 +217,16 @@ protected:
                   const CARTNode* decisionTreeNode,
                   DataValue &mean,
                   double &percent ) const;
+
+    /** The actual recursive implementation of flatten().
+     * @param decisionTreeNode the node of the tree to be copied to the flat forest.
+     * @param flatNodeIndex the index of the node in the flat forest that will receive the copy.
+     */
+    void flatten( const CARTNode* decisionTreeNode,
+                  int flatNodeIndex,
+                  FlatForest& forest,
+                  int dependentVariableColumnID,
+                  bool useTrainingFeatures ) const;
 };
 
 #endif // CART_H
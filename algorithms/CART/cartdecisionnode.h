@@ -16,6 +16,8 @@ public:
     /** Tests whether the refered data row in the output data set satisfies the split criterion of this decision node. */
     bool criterionMatches( long rowIdOutput );
 
+    const CARTSplitCriterion& getSplitCriterion() const { return m_splitCriterion; }
+
     //CARTNode interface
     virtual bool isLeaf() const { return false; }
 protected:
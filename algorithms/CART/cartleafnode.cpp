@@ -13,7 +13,7 @@ CARTLeafNode::CARTLeafNode(const IAlgorithmDataSource &trainingDataSource,
 }
 
 void CARTLeafNode::getUniqueTrainingValuesWithCounts(int columnID,
-                                                     std::vector<std::pair<DataValue, long> > &result)
+                                                     std::vector<std::pair<DataValue, long> > &result) const
 {
     //fetch and sort the values
     std::vector<DataValue> values;
@@ -37,7 +37,7 @@ double operator+( double v1, DataValue v2 ){
     return v2 + v1;
 }
 
-void CARTLeafNode::getMeanOfTrainingValuesWithPercentage( int columnID, DataValue &mean, double &percentage )
+void CARTLeafNode::getMeanOfTrainingValuesWithPercentage( int columnID, DataValue &mean, double &percentage ) const
 {
     //creates a vector with the values referenced by this node.
     std::vector<DataValue> values;
@@ -19,14 +19,14 @@ public:
      *  Only the rows refered to in m_rowIndexes are considered.  Any previous contents in result list are erased.
      */
     void getUniqueTrainingValuesWithCounts(int columnID,
-                                           std::vector<std::pair<DataValue, long> > &result );
+                                           std::vector<std::pair<DataValue, long> > &result ) const;
 
     /** Returns the mean and proportion of rows in the training set used in the mean of values refered by this node.
      *  Only the rows refered to in m_rowIndexes are considered in the mean.
      */
     void getMeanOfTrainingValuesWithPercentage( int columnID,
                                                 DataValue &mean,
-                                                double& percentage );
+                                                double& percentage ) const;
 
     //CARTNode interface
     virtual bool isLeaf() const { return true; }
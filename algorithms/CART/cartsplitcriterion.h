@@ -42,6 +42,15 @@ public:
      */
     bool outputMatches( long rowIndexOutput ) const;
 
+    /** Returns the column index, in the training data set, corresponding to the variable of this split criterion. */
+    int getColumnNumberTrainingData() const { return m_columnNumberTrainingData; }
+
+    /** Returns the column index, in the output data set, corresponding to the variable of this split criterion. */
+    int getColumnNumberOutputData() const { return m_training2outputFeatureIndexesMap.at( m_columnNumberTrainingData ); }
+
+    /** Returns the data value that defines this split criterion. */
+    DataValue getCriterionValue() const { return m_criterionValue; }
+
 protected:
     const IAlgorithmDataSource& m_trainingData;
     const IAlgorithmDataSource& m_outputData;
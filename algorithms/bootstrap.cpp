@@ -36,3 +36,21 @@ void Bootstrap::resample( IAlgorithmDataSource &result, long numberOfSamples )
     }
     //TODO: add suport for the other resampling types here.
 }
+
+void Bootstrap::resample(std::vector<long> &result, long numberOfSamples)
+{
+    //intialize the output.
+    result.clear();
+    result.reserve( numberOfSamples );
+
+    //get the number of samples in the input
+    long sampleCountOfInput = m_input.getRowCount();
+
+    //baggs the input.
+    if( m_resType == ResamplingType::CASE ){
+        for( long sampleNumberOfOutput = 0; sampleNumberOfOutput < numberOfSamples; ++sampleNumberOfOutput)
+            //get a random input sample number
+            result.push_back( useRand( m_randomNumberGenerator, 0, sampleCountOfInput-1) );
+    }
+    //TODO: add suport for the other resampling types here.
+}
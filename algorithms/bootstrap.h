@@ -1,6 +1,7 @@
 #ifndef BOOTSTRAP_H
 #define BOOTSTRAP_H
 #include <random>
+#include <vector>
 
 class IAlgorithmDataSource;
 
@@ -37,6 +38,14 @@ public:
      */
     void resample( IAlgorithmDataSource& result, long numberOfSamples );
 
+    /** Produces the output by bagging, but only the row indexes of the input samples are output, not the
+     * samples themselves.  This saves a lot of memory compared to the other resample() when the bagged samples
+     * are not going to be modified.  The same input row index can appear more than once in the output.
+     * @param result The container to hold the row indexes of bagged samples.  Attention: The previous contents are cleared.
+     * @param numberOfSamples  The number of samples in the output.
+     */
+    void resample( std::vector<long>& result, long numberOfSamples );
+
 protected:
     const IAlgorithmDataSource& m_input;
     ResamplingType m_resType;
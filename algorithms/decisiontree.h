@@ -4,6 +4,7 @@
 #include <vector>
 
 class DataValue;
+class FlatForest;
 
 /** The base class for the decision tree types used by algorithms. */
 class DecisionTree
@@ -36,6 +37,18 @@ public:
                          int dependentVariableColumnID,
                          DataValue &mean,
                          double &percent ) const = 0;
+
+    /** Appends a compact copy of this decision tree to the given flat forest, which is used for fast batch
+     * predictions (see FlatForest).  The values stored in the leaves of the flattened tree are those that would be
+     * returned by classify() or regress(), depending on FlatForest::getLeafType().
+     * @param dependentVariableColumnID  The column id in the training data of the variable to be predicted.
+     * @param useTrainingFeatures If true, the decision nodes of the flattened tree test the feature columns of the
+     *                            training data instead of those of the output data.  This is useful to make
+     *                            predictions on training data rows (e.g. out-of-bag error estimates).
+     */
+    virtual void flatten( FlatForest& forest,
+                          int dependentVariableColumnID,
+                          bool useTrainingFeatures ) const = 0;
 };
 
 #endif // DECISIONTREE_H
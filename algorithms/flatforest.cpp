@@ -0,0 +1,298 @@
+#include "flatforest.h"
+#include "ialgorithmdatasource.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <limits>
+
+/** The number of output rows processed together by the tree-major traversal.  The feature buffer of a block
+ *  and the per-row accumulators must fit comfortably in the L1/L2 caches. */
+static const long ROWS_PER_BLOCK = 256;
+
+FlatForest::FlatForest(FlatForestLeafType leafType) :
+    m_leafType( leafType )
+{
+}
+
+int FlatForest::beginTree()
+{
+    m_nodes.push_back( { 0.0, -1, -1 } );
+    m_treeRoots.push_back( m_nodes.size() - 1 );
+    return m_treeRoots.back();
+}
+
+int FlatForest::appendChildNodes()
+{
+    m_nodes.push_back( { 0.0, -1, -1 } );
+    m_nodes.push_back( { 0.0, -1, -1 } );
+    return m_nodes.size() - 2;
+}
+
+void FlatForest::setDecisionNode(int nodeIndex, int outputColumnID, double splitValue, int trueSideChildIndex)
+{
+    Node& node = m_nodes[ nodeIndex ];
+    node.value = splitValue;
+    node.featureSlot = getFeatureSlot( outputColumnID );
+    node.child = trueSideChildIndex;
+}
+
+void FlatForest::setLeafNode(int nodeIndex, double value, double percent)
+{
+    Node& node = m_nodes[ nodeIndex ];
+    node.value = value;
+    node.featureSlot = -1;
+    node.child = m_leafPercents.size();
+    m_leafPercents.push_back( percent );
+}
+
+int FlatForest::getFeatureSlot(int outputColumnID)
+{
+    std::map<int,int>::iterator it = m_columnID2slot.find( outputColumnID );
+    if( it != m_columnID2slot.end() )
+        return it->second;
+    int slot = m_slotColumnIDs.size();
+    m_slotColumnIDs.push_back( outputColumnID );
+    m_columnID2slot[ outputColumnID ] = slot;
+    return slot;
+}
+
+void FlatForest::finalize()
+{
+    if( m_leafType == FlatForestLeafType::CLASS )
+        buildClassIndexes();
+}
+
+void FlatForest::buildClassIndexes()
+{
+    //collect the unique class codes found in the leaves
+    m_classCodes.clear();
+    for( const Node& node : m_nodes )
+        if( node.featureSlot < 0 )
+            m_classCodes.push_back( (int)node.value );
+    std::sort( m_classCodes.begin(), m_classCodes.end() );
+    m_classCodes.erase( std::unique( m_classCodes.begin(), m_classCodes.end() ), m_classCodes.end() );
+
+    //assign the dense class index to each leaf.
+    m_leafClassIndexes.assign( m_leafPercents.size(), 0 );
+    for( const Node& node : m_nodes )
+        if( node.featureSlot < 0 )
+            m_leafClassIndexes[ node.child ] = std::lower_bound( m_classCodes.begin(),
+                                                                 m_classCodes.end(),
+                                                                 (int)node.value ) - m_classCodes.begin();
+}
+
+void FlatForest::gatherFeatures(const IAlgorithmDataSource &outputData,
+                                long firstRowIdOutput,
+                                long rowCount,
+                                std::vector<double> &features,
+                                std::vector<char> &isCategorical) const
+{
+    int nSlots = m_slotColumnIDs.size();
+    features.resize( rowCount * nSlots );
+    isCategorical.assign( nSlots, 0 );
+    for( long iRow = 0; iRow < rowCount; ++iRow )
+        for( int iSlot = 0; iSlot < nSlots; ++iSlot ){
+            DataValue value = outputData.getDataValue( firstRowIdOutput + iRow, m_slotColumnIDs[iSlot] );
+            if( value.isCategorical() ){
+                isCategorical[iSlot] = 1;
+                features[ iRow * nSlots + iSlot ] = value.getCategorical();
+            } else
+                features[ iRow * nSlots + iSlot ] = value.getContinuous();
+        }
+}
+
+template<typename BlockFunction>
+void FlatForest::forEachBlock(long rowCount, unsigned int nThreads, BlockFunction blockFunction) const
+{
+    long nBlocks = ( rowCount + ROWS_PER_BLOCK - 1 ) / ROWS_PER_BLOCK;
+    if( nThreads == 0 )
+        nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    nThreads = std::max( 1L, std::min( (long)nThreads, nBlocks ) );
+
+    //the threads pick the blocks on demand, so they finish at about the same time.
+    std::atomic<long> nextBlock( 0 );
+    auto worker = [&](){
+        for( long iBlock = nextBlock++; iBlock < nBlocks; iBlock = nextBlock++ ){
+            long firstRow = iBlock * ROWS_PER_BLOCK;
+            blockFunction( firstRow, std::min( ROWS_PER_BLOCK, rowCount - firstRow ) );
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for( unsigned int iThread = 1; iThread < nThreads; ++iThread )
+        threads.emplace_back( worker );
+    worker(); //the calling thread also works
+    for( std::thread& thread : threads )
+        thread.join();
+}
+
+void FlatForest::classify(const IAlgorithmDataSource &outputData,
+                          long firstRowIdOutput,
+                          long rowCount,
+                          double *classes,
+                          double *uncertainties,
+                          unsigned int nThreads) const
+{
+    int nClasses = m_classCodes.size();
+    int nSlots = m_slotColumnIDs.size();
+    unsigned int nTrees = m_treeRoots.size();
+
+    //an empty forest has no votes (and no classes) to predict with
+    if( nTrees == 0 || nClasses == 0 ){
+        std::fill( classes, classes + rowCount, std::numeric_limits<double>::quiet_NaN() );
+        std::fill( uncertainties, uncertainties + rowCount, std::numeric_limits<double>::quiet_NaN() );
+        return;
+    }
+
+    forEachBlock( rowCount, nThreads, [&]( long firstRowOfBlock, long blockSize ){
+        std::vector<double> features;
+        std::vector<char> isCategorical;
+        gatherFeatures( outputData, firstRowIdOutput + firstRowOfBlock, blockSize, features, isCategorical );
+
+        //count the votes of each tree for each row of the block
+        std::vector<int> votes( blockSize * nClasses, 0 );
+        for( unsigned int iTree = 0; iTree < nTrees; ++iTree ){
+            int root = m_treeRoots[iTree];
+            for( long iRow = 0; iRow < blockSize; ++iRow ){
+                const Node& leaf = findLeaf( root, &features[ iRow * nSlots ], isCategorical.data() );
+                ++votes[ iRow * nClasses + m_leafClassIndexes[ leaf.child ] ];
+            }
+        }
+
+        //determine the most voted class for each row.
+        //ties go to the lowest class code, as in RandomForest::classify().
+        for( long iRow = 0; iRow < blockSize; ++iRow ){
+            const int* rowVotes = &votes[ iRow * nClasses ];
+            int mostVotedClassIndex = std::max_element( rowVotes, rowVotes + nClasses ) - rowVotes;
+            classes[ firstRowOfBlock + iRow ] = m_classCodes[ mostVotedClassIndex ];
+            uncertainties[ firstRowOfBlock + iRow ] = 1.0 - rowVotes[ mostVotedClassIndex ] / (double)nTrees;
+        }
+    });
+}
+
+void FlatForest::regress(const IAlgorithmDataSource &outputData,
+                         long firstRowIdOutput,
+                         long rowCount,
+                         double *means,
+                         double *variances,
+                         unsigned int nThreads) const
+{
+    int nSlots = m_slotColumnIDs.size();
+    unsigned int nTrees = m_treeRoots.size();
+
+    //an empty forest has no estimates to average
+    if( nTrees == 0 ){
+        std::fill( means, means + rowCount, std::numeric_limits<double>::quiet_NaN() );
+        std::fill( variances, variances + rowCount, std::numeric_limits<double>::quiet_NaN() );
+        return;
+    }
+
+    forEachBlock( rowCount, nThreads, [&]( long firstRowOfBlock, long blockSize ){
+        std::vector<double> features;
+        std::vector<char> isCategorical;
+        gatherFeatures( outputData, firstRowIdOutput + firstRowOfBlock, blockSize, features, isCategorical );
+
+        //accumulate, for each row, the sums needed to compute the weighted mean and the variance of the estimates
+        std::vector<double> sumWeightedEstimates( blockSize, 0.0 );
+        std::vector<double> sumWeights( blockSize, 0.0 );
+        std::vector<double> sumEstimates( blockSize, 0.0 );
+        std::vector<double> sumSquaredEstimates( blockSize, 0.0 );
+        for( unsigned int iTree = 0; iTree < nTrees; ++iTree ){
+            int root = m_treeRoots[iTree];
+            for( long iRow = 0; iRow < blockSize; ++iRow ){
+                const Node& leaf = findLeaf( root, &features[ iRow * nSlots ], isCategorical.data() );
+                double percent = m_leafPercents[ leaf.child ];
+                sumWeightedEstimates[iRow] += leaf.value * percent;
+                sumWeights[iRow] += percent;
+                sumEstimates[iRow] += leaf.value;
+                sumSquaredEstimates[iRow] += leaf.value * leaf.value;
+            }
+        }
+
+        //the variance is taken about the weighted mean, as in RandomForest::regress().
+        for( long iRow = 0; iRow < blockSize; ++iRow ){
+            double mean = sumWeightedEstimates[iRow] / sumWeights[iRow];
+            double variance = ( sumSquaredEstimates[iRow]
+                                - 2.0 * mean * sumEstimates[iRow]
+                                + nTrees * mean * mean ) / nTrees;
+            means[ firstRowOfBlock + iRow ] = mean;
+            variances[ firstRowOfBlock + iRow ] = std::max( 0.0, variance );
+        }
+    });
+}
+
+double FlatForest::getOutOfBagError(const IAlgorithmDataSource &trainingData,
+                                    int dependentVariableColumnID,
+                                    const std::vector<std::vector<bool> > &inBag,
+                                    unsigned int nThreads) const
+{
+    int nClasses = m_classCodes.size();
+    int nSlots = m_slotColumnIDs.size();
+    unsigned int nTrees = m_treeRoots.size();
+    long rowCount = trainingData.getRowCount();
+
+    //an empty forest leaves all rows out, but predicts none of them (same as no out-of-bag rows)
+    if( nTrees == 0 || ( m_leafType == FlatForestLeafType::CLASS && nClasses == 0 ) )
+        return 0.0;
+
+    //the error totals of all blocks.
+    std::mutex mutexTotals;
+    double totalError = 0.0;
+    long totalRows = 0;
+
+    forEachBlock( rowCount, nThreads, [&]( long firstRowOfBlock, long blockSize ){
+        std::vector<double> features;
+        std::vector<char> isCategorical;
+        gatherFeatures( trainingData, firstRowOfBlock, blockSize, features, isCategorical );
+
+        //accumulate the predictions of the trees that left each row out of their training
+        std::vector<int> votes( m_leafType == FlatForestLeafType::CLASS ? blockSize * nClasses : 0, 0 );
+        std::vector<double> sumWeightedEstimates( blockSize, 0.0 );
+        std::vector<double> sumWeights( blockSize, 0.0 );
+        for( unsigned int iTree = 0; iTree < nTrees; ++iTree ){
+            int root = m_treeRoots[iTree];
+            const std::vector<bool>& treeInBag = inBag[iTree];
+            for( long iRow = 0; iRow < blockSize; ++iRow ){
+                if( treeInBag[ firstRowOfBlock + iRow ] )
+                    continue;
+                const Node& leaf = findLeaf( root, &features[ iRow * nSlots ], isCategorical.data() );
+                if( m_leafType == FlatForestLeafType::CLASS )
+                    ++votes[ iRow * nClasses + m_leafClassIndexes[ leaf.child ] ];
+                else {
+                    sumWeightedEstimates[iRow] += leaf.value * m_leafPercents[ leaf.child ];
+                    sumWeights[iRow] += m_leafPercents[ leaf.child ];
+                }
+            }
+        }
+
+        //compare the predictions with the actual values
+        double blockError = 0.0;
+        long blockRows = 0;
+        for( long iRow = 0; iRow < blockSize; ++iRow ){
+            DataValue actualValue = trainingData.getDataValue( firstRowOfBlock + iRow, dependentVariableColumnID );
+            if( m_leafType == FlatForestLeafType::CLASS ){
+                const int* rowVotes = &votes[ iRow * nClasses ];
+                int mostVotedClassIndex = std::max_element( rowVotes, rowVotes + nClasses ) - rowVotes;
+                if( rowVotes[ mostVotedClassIndex ] == 0 ) //the row was used by all trees
+                    continue;
+                if( m_classCodes[ mostVotedClassIndex ] != actualValue.getCategorical() )
+                    blockError += 1.0;
+            } else {
+                if( sumWeights[iRow] == 0.0 ) //the row was used by all trees
+                    continue;
+                double error = sumWeightedEstimates[iRow] / sumWeights[iRow] - actualValue.getContinuous();
+                blockError += error * error;
+            }
+            ++blockRows;
+        }
+
+        std::unique_lock<std::mutex> lock( mutexTotals );
+        totalError += blockError;
+        totalRows += blockRows;
+    });
+
+    if( totalRows == 0 )
+        return 0.0;
+    return totalError / totalRows;
+}
@@ -0,0 +1,177 @@
+#ifndef FLATFOREST_H
+#define FLATFOREST_H
+
+#include <vector>
+#include <map>
+
+class IAlgorithmDataSource;
+
+/*! What the leaf nodes of a flattened forest hold. */
+enum class FlatForestLeafType : unsigned int{
+    CLASS, /*! The leaves hold the class voted by the tree (classification). */
+    MEAN   /*! The leaves hold a mean value and its representativeness (regression). */
+};
+
+/**
+ * The FlatForest class is a read-only, cache-friendly representation of a set of trained decision trees meant for
+ * fast inference.  All nodes of all trees are stored in a single contiguous array, where each node only has a
+ * feature slot, a threshold (or leaf value) and the index of its children.  The two children of a decision node
+ * are always stored side by side (true side first), so only one child index is needed.
+ * The predictions are made in batches of output data rows: the feature values of a block of rows are fetched once
+ * from the data source into a dense buffer, then every tree is applied to the whole block (tree-major traversal),
+ * so the nodes of a tree stay in cache while the rows are classified/estimated.  The blocks are processed in
+ * parallel.
+ * Objects of this class are created by filling it with decision trees via DecisionTree::flatten().
+ */
+class FlatForest
+{
+public:
+
+    /** A node of a flattened decision tree (16 bytes). */
+    struct Node{
+        /** For decision nodes: the split value.  For leaf nodes: the class code (classification)
+         *  or the mean (regression). */
+        double value;
+        /** For decision nodes: the index of the feature in the gathered feature buffer (see getFeatureSlot()).
+         *  For leaf nodes: -1. */
+        int featureSlot;
+        /** For decision nodes: the index of the true-side child (the false-side child is the next node).
+         *  For leaf nodes: the index of the leaf payload (see m_leafPercents and m_leafClassIndexes). */
+        int child;
+    };
+
+    FlatForest( FlatForestLeafType leafType );
+
+    FlatForestLeafType getLeafType() const { return m_leafType; }
+
+    /** Returns the number of trees flattened into this forest. */
+    unsigned int getTreeCount() const { return m_treeRoots.size(); }
+
+    //============ Functions used to fill the forest (see DecisionTree::flatten()) ============
+    /** Starts a new tree.  Returns the index of its root node. */
+    int beginTree();
+
+    /** Appends two adjacent nodes (the true-side and the false-side children of a decision node).
+     *  Returns the index of the first (true-side) one. */
+    int appendChildNodes();
+
+    /** Turns the given node into a decision node.
+     * @param outputColumnID The column index, in the output (or training) data set, of the feature tested by the node.
+     * @param splitValue The feature value used in the test.
+     * @param trueSideChildIndex The index returned by appendChildNodes().
+     */
+    void setDecisionNode( int nodeIndex, int outputColumnID, double splitValue, int trueSideChildIndex );
+
+    /** Turns the given node into a leaf node.
+     * @param value The class code (for classification) or the mean (for regression).
+     * @param percent The proportion of training data rows referred by the leaf (only meaningful for regression).
+     */
+    void setLeafNode( int nodeIndex, double value, double percent );
+
+    /** Must be called after all trees have been flattened and before making predictions. */
+    void finalize();
+
+    //========================== Batch prediction functions ==================================
+    /** Classifies a range of output data rows by majority vote of the trees.  This is the same as calling
+     * RandomForest::classify() for every row in the range, only much faster.  If the forest has no trees,
+     * the classes and uncertainties are set to NaN.
+     * @param classes Receives the most voted class of each row.  Must have at least rowCount elements.
+     * @param uncertainties Receives 1.0 - the ratio between the number of votes of the most voted class and the
+     *                      total number of votes.  Must have at least rowCount elements.
+     * @param nThreads Number of threads to use.  If zero, the number of logical CPUs is used.
+     */
+    void classify( const IAlgorithmDataSource& outputData,
+                   long firstRowIdOutput,
+                   long rowCount,
+                   double* classes,
+                   double* uncertainties,
+                   unsigned int nThreads = 0 ) const;
+
+    /** Estimates a range of output data rows by averaging the trees.  This is the same as calling
+     * RandomForest::regress() for every row in the range, only much faster.  If the forest has no trees,
+     * the means and variances are set to NaN.
+     * @param means Receives the weighted mean of the tree estimates for each row.  Must have at least rowCount elements.
+     * @param variances Receives the variance of the tree estimates for each row.  Must have at least rowCount elements.
+     * @param nThreads Number of threads to use.  If zero, the number of logical CPUs is used.
+     */
+    void regress( const IAlgorithmDataSource& outputData,
+                  long firstRowIdOutput,
+                  long rowCount,
+                  double* means,
+                  double* variances,
+                  unsigned int nThreads = 0 ) const;
+
+    /** Computes the out-of-bag error of the forest, that is, each training data row is predicted only by the trees
+     * that did not use it in training.  The trees must have been flattened with training features
+     * (see DecisionTree::flatten()).
+     * @param inBag The in-bag flags for each tree and each training data row, that is, whether a training
+     *              row was used to build a tree.
+     * @return For classification: the ratio of misclassified rows.  For regression: the mean squared error.
+     *         Only the rows that were left out by at least one tree are considered.
+     */
+    double getOutOfBagError( const IAlgorithmDataSource& trainingData,
+                             int dependentVariableColumnID,
+                             const std::vector< std::vector<bool> >& inBag,
+                             unsigned int nThreads = 0 ) const;
+
+protected:
+
+    /** What the leaves hold. */
+    FlatForestLeafType m_leafType;
+
+    /** The nodes of all trees. */
+    std::vector<Node> m_nodes;
+
+    /** The indexes of the root nodes of each tree in m_nodes. */
+    std::vector<int> m_treeRoots;
+
+    /** For regression: the proportions of training rows of each leaf, indexed by the leaf's Node::child. */
+    std::vector<double> m_leafPercents;
+
+    /** For classification: the dense class index of each leaf, indexed by the leaf's Node::child.
+     *  The class indexes refer to m_classCodes. */
+    std::vector<int> m_leafClassIndexes;
+
+    /** For classification: the unique class codes found in the leaves, in ascending order. */
+    std::vector<int> m_classCodes;
+
+    /** The columns of the output data set (one per feature slot) used by the decision nodes. */
+    std::vector<int> m_slotColumnIDs;
+
+    /** Maps output data set columns to feature slots. */
+    std::map<int,int> m_columnID2slot;
+
+    /** Returns the feature slot for a column in the output data set, creating one if necessary. */
+    int getFeatureSlot( int outputColumnID );
+
+    /** Builds m_classCodes and m_leafClassIndexes from the class codes stored in the leaves. */
+    void buildClassIndexes();
+
+    /** Reads the feature values of a block of output rows into a dense row-major buffer.
+     *  The categorical flags of the features are also returned. */
+    void gatherFeatures( const IAlgorithmDataSource& outputData,
+                         long firstRowIdOutput,
+                         long rowCount,
+                         std::vector<double>& features,
+                         std::vector<char>& isCategorical ) const;
+
+    /** Walks a tree from the given root for a row of gathered features and returns the reached leaf node. */
+    inline const Node& findLeaf( int rootIndex, const double* rowFeatures, const char* isCategorical ) const {
+        const Node* node = &m_nodes[ rootIndex ];
+        while( node->featureSlot >= 0 ){
+            double featureValue = rowFeatures[ node->featureSlot ];
+            //same tests as CARTSplitCriterion::outputMatches(): equality for categorical values and
+            //greater than or equal to for continuous values.
+            bool matches = isCategorical[ node->featureSlot ] ? ( featureValue == node->value ) :
+                                                                 !( featureValue < node->value );
+            node = &m_nodes[ matches ? node->child : node->child + 1 ];
+        }
+        return *node;
+    }
+
+    /** Runs the given block processing function for all blocks of rows in the range in parallel. */
+    template<typename BlockFunction>
+    void forEachBlock( long rowCount, unsigned int nThreads, BlockFunction blockFunction ) const;
+};
+
+#endif // FLATFOREST_H
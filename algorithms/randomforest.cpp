@@ -1,58 +1,12 @@
 #include "randomforest.h"
 #include "CART/cart.h"
 #include "ialgorithmdatasource.h"
+#include "flatforest.h"
+#include "workstealingpool.h"
 #include <limits>
 #include <numeric>
 #include <algorithm>
-#include <thread>
-
-/** A temporary data source to hold bootsrapped training data. */////////////////////////////////////////////
-class TmpDataSource : public IAlgorithmDataSource{
-    // IAlgorithmDataSource interface
-public:
-
-    virtual long getRowCount() const {
-        return m_data.size();
-    }
-    virtual int getColumnCount() const {
-        if( isEmpty() )
-            return 0;
-        return m_data[0].size();
-    }
-    virtual void clear() {
-        m_data.clear();
-    }
-    virtual void reserve(long rowCount, int columnCount) {
-        m_data.assign( rowCount, std::vector<DataValue> ( columnCount, DataValue(std::numeric_limits<double>::quiet_NaN()) ) );
-    }
-    virtual void setDataValue(long rowIndex, int columnIndex, DataValue value) {
-        m_data[rowIndex][columnIndex] = value;
-    }
-    virtual DataValue getDataValue(long rowIndex, int columnIndex) const {
-        return m_data[rowIndex][columnIndex];
-    }
-protected:
-    std::vector< std::vector< DataValue > > m_data;
-};
-
-/** The code for multithreaded decision tree creation *////////////////////////
-void task( const std::vector<IAlgorithmDataSource*>& vBaggedTrainingDS,
-           const IAlgorithmDataSource *outputData,
-           const std::vector<int> &trainingFeatureIDs,
-           const std::vector<int> &outputFeatureIDs,
-           int continuousFeaturesMaxSplits,
-           TreeType treeType,
-           std::vector< DecisionTree* >* decisionTreesOutput
-           ){
-    if( treeType == TreeType::CART ){
-        std::vector<IAlgorithmDataSource*>::const_iterator it = vBaggedTrainingDS.cbegin();
-        for(; it != vBaggedTrainingDS.cend(); ++it )
-            decisionTreesOutput->push_back( new CART( **it, *outputData,
-                                                     trainingFeatureIDs, outputFeatureIDs,
-                                                     continuousFeaturesMaxSplits ) );
-    }
-}
-///////////////////////////////////////////////////////////////////////////////
+#include <atomic>
 
 /////////////////////////////The Random Forest class itself/////////////////////////////////////
 RandomForest::RandomForest(const IAlgorithmDataSource &trainingData,
@@ -63,64 +17,71 @@ RandomForest::RandomForest(const IAlgorithmDataSource &trainingData,
                                  long seed,
                                  ResamplingType bootstrap ,
                                  TreeType treeType,
-                                 int continuousFeaturesMaxSplits) :
+                                 int continuousFeaturesMaxSplits,
+                                 std::function<bool (unsigned int, unsigned int)> progressCallback) :
     m_trainingData( trainingData ),
     m_outputData( outputData ),
     m_B( B ),
-    m_continuousFeaturesMaxSplits( continuousFeaturesMaxSplits )
+    m_continuousFeaturesMaxSplits( continuousFeaturesMaxSplits ),
+    m_cancelled( false )
 {
-    //Create an object to create training subsamples
-    Bootstrap bagger( trainingData, bootstrap, seed );
+    //the tasks deposit the trees and their in-bag flags in the slots corresponding to the tree indexes.
+    m_trees.assign( m_B, nullptr );
+    m_inBag.resize( m_B );
+
+    //the trees vary widely in cost, so they are built by a work-stealing pool (one task per tree, plus
+    //tasks for large branches, see CART::makeCART()) to keep all the logical CPUs busy until the end.
+    WorkStealingPool pool;
+    WorkStealingPool::TaskGroup treeTasks;
+    std::atomic<bool> cancelFlag( false );
+    std::atomic<unsigned int> treesBuilt( 0 );
+    long rowCount = trainingData.getRowCount();
 
-    //For the wanted number of trees.
     for( unsigned int iTree = 0; iTree < m_B; ++iTree ){
-
-        //Create a temporary data storage for the bagged training data
-        TmpDataSource* baggedTrainingData = new TmpDataSource();
-        m_tmpDataSources.push_back( baggedTrainingData );
-
-        //bagg the training set
-        bagger.resample( *baggedTrainingData, trainingData.getRowCount() );
-    }
-
-    //get the number of threads from logical CPUs or number of trees (whichever is the lowest)
-    unsigned int nThreads = std::min( std::thread::hardware_concurrency(), m_B );
-
-    //distribute the bagged training data sources among the n-threads
-    std::vector<IAlgorithmDataSource*> baggedTrainingDataSources[nThreads];
-    std::vector<IAlgorithmDataSource*>::iterator it = m_tmpDataSources.begin();
-    for( unsigned int iThread = 0; it != m_tmpDataSources.end(); ++it, ++iThread)
-        baggedTrainingDataSources[ iThread % nThreads ].push_back( *it );
-
-    //create decision tree vectors for each thread, so they deposit their trees in them.
-    std::vector< DecisionTree* > decisionTreesDepots[nThreads];
-
-    //create and run the decicion tree-creating threads
-    std::thread threads[nThreads];
-    for( unsigned int iThread = 0; iThread < nThreads; ++iThread){
-        std::vector< DecisionTree* >& decisionTreesDepot = decisionTreesDepots[iThread];
-        threads[iThread] = std::thread( task,
-                                        baggedTrainingDataSources[iThread],
-                                        &outputData, //can't pass reference to abstract type because std::thread() creates a tuple internally
-                                        trainingFeatureIDs,
-                                        outputFeatureIDs,
-                                        continuousFeaturesMaxSplits,
-                                        treeType,
-                                        &decisionTreesDepot
-                                        );
-    }
-
-    //wait for the threads to finish.
-    for( unsigned int iThread = 0; iThread < nThreads; ++iThread)
-        threads[iThread].join();
-
-    //collect the decision trees created by the threads:
-    for( unsigned int iThread = 0; iThread < nThreads; ++iThread ){
-        std::vector< DecisionTree* >::iterator it = decisionTreesDepots[ iThread ].begin();
-        for(; it != decisionTreesDepots[ iThread ].end(); ++it)
-            m_trees.push_back( *it );
-    }
-
+        pool.submit( treeTasks, [&, iTree](){
+            if( cancelFlag )
+                return;
+
+            //bagg the training set (only row indexes).  Each tree has its own random number sequence, so
+            //the result does not depend on the number of threads.
+            std::vector<long> baggedRowIDs;
+            Bootstrap bagger( trainingData, bootstrap, seed + iTree );
+            bagger.resample( baggedRowIDs, rowCount );
+
+            //flag the training rows used by this tree
+            std::vector<bool>& inBag = m_inBag[iTree];
+            inBag.assign( rowCount, false );
+            for( long rowID : baggedRowIDs )
+                inBag[ rowID ] = true;
+
+            if( treeType == TreeType::CART )
+                m_trees[iTree] = new CART( trainingData, outputData, baggedRowIDs,
+                                           trainingFeatureIDs, outputFeatureIDs,
+                                           continuousFeaturesMaxSplits, &pool, &cancelFlag );
+            ++treesBuilt;
+        });
+    }
+
+    //this loop allows the calling thread (normally the GUI thread) to report progress
+    //and to cancel the training while the worker threads run.
+    while( ! pool.waitFor( treeTasks, 200 ) )
+        if( progressCallback && ! m_cancelled && ! progressCallback( treesBuilt, m_B ) ){
+            m_cancelled = true;
+            cancelFlag = true;
+        }
+    if( progressCallback && ! m_cancelled )
+        progressCallback( treesBuilt, m_B );
+
+    //trees not built due to cancellation are removed (along with their in-bag flags).
+    unsigned int nTreesBuilt = 0;
+    for( unsigned int iTree = 0; iTree < m_B; ++iTree )
+        if( m_trees[iTree] ){
+            m_trees[nTreesBuilt] = m_trees[iTree];
+            m_inBag[nTreesBuilt].swap( m_inBag[iTree] );
+            ++nTreesBuilt;
+        }
+    m_trees.resize( nTreesBuilt );
+    m_inBag.resize( nTreesBuilt );
 }
 
 RandomForest::~RandomForest()
@@ -130,10 +91,6 @@ RandomForest::~RandomForest()
         delete m_trees.back();
         m_trees.pop_back();
     }
-    while( ! m_tmpDataSources.empty() ){
-        delete m_tmpDataSources.back();
-        m_tmpDataSources.pop_back();
-    }
 }
 
 void RandomForest::classify(long rowIdOutput,
@@ -235,3 +192,61 @@ void RandomForest::regress(long rowIdOutput, int dependentVariableColumnID, Data
     DataValue stdev ( std::sqrt(squaredSum / (double)estimatesFound.size()) );
     variance = stdev * stdev;
 }
+
+void RandomForest::classify(long firstRowIdOutput,
+                            long rowCount,
+                            int dependentVariableColumnID,
+                            std::vector<double> &classes,
+                            std::vector<double> &uncertainties) const
+{
+    //make a compact copy of the trees for fast inference
+    FlatForest flatForest( FlatForestLeafType::CLASS );
+    for( const DecisionTree* tree : m_trees )
+        tree->flatten( flatForest, dependentVariableColumnID, false );
+    flatForest.finalize();
+
+    //classify all the rows in parallel
+    classes.resize( rowCount );
+    uncertainties.resize( rowCount );
+    flatForest.classify( m_outputData, firstRowIdOutput, rowCount, classes.data(), uncertainties.data() );
+}
+
+void RandomForest::regress(long firstRowIdOutput,
+                           long rowCount,
+                           int dependentVariableColumnID,
+                           std::vector<double> &means,
+                           std::vector<double> &variances) const
+{
+    //make a compact copy of the trees for fast inference
+    FlatForest flatForest( FlatForestLeafType::MEAN );
+    for( const DecisionTree* tree : m_trees )
+        tree->flatten( flatForest, dependentVariableColumnID, false );
+    flatForest.finalize();
+
+    //estimate all the rows in parallel
+    means.resize( rowCount );
+    variances.resize( rowCount );
+    flatForest.regress( m_outputData, firstRowIdOutput, rowCount, means.data(), variances.data() );
+}
+
+double RandomForest::getOutOfBagMisclassificationRate(int dependentVariableColumnID) const
+{
+    //make a compact copy of the trees testing the training data features
+    FlatForest flatForest( FlatForestLeafType::CLASS );
+    for( const DecisionTree* tree : m_trees )
+        tree->flatten( flatForest, dependentVariableColumnID, true );
+    flatForest.finalize();
+
+    return flatForest.getOutOfBagError( m_trainingData, dependentVariableColumnID, m_inBag );
+}
+
+double RandomForest::getOutOfBagMeanSquaredError(int dependentVariableColumnID) const
+{
+    //make a compact copy of the trees testing the training data features
+    FlatForest flatForest( FlatForestLeafType::MEAN );
+    for( const DecisionTree* tree : m_trees )
+        tree->flatten( flatForest, dependentVariableColumnID, true );
+    flatForest.finalize();
+
+    return flatForest.getOutOfBagError( m_trainingData, dependentVariableColumnID, m_inBag );
+}
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <list>
+#include <functional>
 #include "bootstrap.h"
 
 class IAlgorithmDataSource;
@@ -34,6 +35,8 @@ public:
 
     /**
      * The constructor creates decision trees from radomly generated sample sets from the original set (bagging).
+     * The bagged sample sets are not copied: each tree is built from a list of row indexes of the training data
+     * generated by the thread building the tree.
      * Since the output data source is read-only, it is up to the calling code to make updates to the output data
      * after calling classify() or regress().
      * @param B The number of trees.  Low values mean faster computation but more overfitting.  Higher values mean
@@ -43,6 +46,9 @@ public:
      * @param treeType Sets the type of the trees in the forest.
      * @param continuousFeaturesMaxSplits Limits the number of splits in the decision trees for continuous features.
      *        A good number is 20.
+     * @param progressCallback If set, it is called periodically from the thread calling this constructor with
+     *        the number of trees built so far and the total number of trees.  It must return false to cancel
+     *        the training (see isCancelled()).  This allows GUI code to update progress dialogs during training.
      */
     RandomForest(const IAlgorithmDataSource& trainingData,
                  const IAlgorithmDataSource &outputData,
@@ -52,10 +58,15 @@ public:
                  long seed,
                  ResamplingType bootstrap,
                  TreeType treeType,
-                 int continuousFeaturesMaxSplits );
+                 int continuousFeaturesMaxSplits,
+                 std::function<bool(unsigned int, unsigned int)> progressCallback = nullptr );
 
     virtual ~RandomForest();
 
+    /** Returns whether the training was cancelled by the progress callback passed to the constructor.
+     *  A cancelled forest is incomplete and should not be used for predictions. */
+    bool isCancelled() const { return m_cancelled; }
+
     /** Uses the underlying decision trees as classifiers to a given output data row, referenced by its row number.
      * @param rowIdOutput Row number of output data to classify.
      * @param dependentVariableColumnID  The column id in the training data of the variable to be predicted.
@@ -77,6 +88,49 @@ public:
                   DataValue& mean,
                   DataValue& variance ) const;
 
+    /** Batch version of classify().  The trees are first flattened into a compact FlatForest, which then
+     * classifies the rows in parallel.  This is much faster than calling classify() for each row.
+     * @param firstRowIdOutput Row number of the first output data row to classify.
+     * @param rowCount Number of output data rows to classify.
+     * @param dependentVariableColumnID  The column id in the training data of the variable to be predicted.
+     * @param classes Receives the predicted values (by majority vote).  It is resized to rowCount.
+     * @param uncertainties Receives 1.0 - the ratio between the number of the most voted class and the total number
+     *                      of votes for each row.  It is resized to rowCount.
+     */
+    void classify( long firstRowIdOutput,
+                   long rowCount,
+                   int dependentVariableColumnID,
+                   std::vector<double>& classes,
+                   std::vector<double>& uncertainties ) const;
+
+    /** Batch version of regress().  The trees are first flattened into a compact FlatForest, which then
+     * estimates the rows in parallel.  This is much faster than calling regress() for each row.
+     * @param firstRowIdOutput Row number of the first output data row to estimate.
+     * @param rowCount Number of output data rows to estimate.
+     * @param dependentVariableColumnID  The column id in the training data of the variable to be predicted.
+     * @param means Receives the regression values.  It is resized to rowCount.
+     * @param variances Receives the variances between the individual estimates given by each decision tree.
+     *                  It is resized to rowCount.
+     */
+    void regress( long firstRowIdOutput,
+                  long rowCount,
+                  int dependentVariableColumnID,
+                  std::vector<double>& means,
+                  std::vector<double>& variances ) const;
+
+    /** Returns the out-of-bag classification error, that is, the ratio of training data rows misclassified by
+     * the trees that did not use them in training.  This is an unbiased estimate of the classification error
+     * that comes at no cost of separate validation data.
+     * @param dependentVariableColumnID  The column id in the training data of the variable to be predicted.
+     */
+    double getOutOfBagMisclassificationRate( int dependentVariableColumnID ) const;
+
+    /** Returns the out-of-bag regression error, that is, the mean squared error of the estimates of the training data
+     * rows made by the trees that did not use them in training.
+     * @param dependentVariableColumnID  The column id in the training data of the variable to be predicted.
+     */
+    double getOutOfBagMeanSquaredError( int dependentVariableColumnID ) const;
+
 protected:
 
     /** The data to be bagged and used to build the decision trees. */
@@ -91,11 +145,15 @@ protected:
     /** The number of trees. */
     unsigned int m_B;
 
-    /** Repository of the data sources created internally so they are garbage collected in the destructor. */
-    std::vector<IAlgorithmDataSource*> m_tmpDataSources;
+    /** The in-bag flags of each tree: whether a training data row was used to build the tree.
+     *  This is used to compute the out-of-bag errors. */
+    std::vector< std::vector<bool> > m_inBag;
 
     /** This value limits the number of splits in the decision trees for continuous features/variables. */
     int m_continuousFeaturesMaxSplits;
+
+    /** Whether the training was cancelled. */
+    bool m_cancelled;
 };
 
 #endif // RANDOMFOREST_H
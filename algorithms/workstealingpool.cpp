@@ -0,0 +1,136 @@
+#include "workstealingpool.h"
+#include <chrono>
+
+/** The pool and the worker index of the calling thread (if it is a worker thread). */
+static thread_local const WorkStealingPool* s_currentPool = nullptr;
+static thread_local unsigned int s_currentWorkerIndex = 0;
+
+WorkStealingPool::WorkStealingPool(unsigned int nThreads) :
+    m_stop( false ),
+    m_queuedCount( 0 ),
+    m_nextQueue( 0 )
+{
+    if( nThreads == 0 )
+        nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    for( unsigned int iThread = 0; iThread < nThreads; ++iThread )
+        m_queues.emplace_back( new WorkerQueue() );
+    for( unsigned int iThread = 0; iThread < nThreads; ++iThread )
+        m_threads.emplace_back( &WorkStealingPool::workerLoop, this, iThread );
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::unique_lock<std::mutex> lock( m_mutexSleep );
+        m_stop = true;
+    }
+    m_wakeUp.notify_all();
+    for( std::thread& thread : m_threads )
+        thread.join();
+}
+
+void WorkStealingPool::submit(WorkStealingPool::TaskGroup &group, WorkStealingPool::Task task)
+{
+    ++group.m_pendingCount;
+
+    //tasks submitted by workers go to their own queues, other tasks are distributed among the queues.
+    int workerIndex = getCurrentWorkerIndex();
+    unsigned int queueIndex = workerIndex >= 0 ? workerIndex : m_nextQueue++ % m_queues.size();
+    {
+        WorkerQueue& queue = *m_queues[ queueIndex ];
+        std::unique_lock<std::mutex> lock( queue.mutex );
+        queue.tasks.emplace_back( std::move( task ), &group );
+    }
+    ++m_queuedCount;
+
+    //wake up a sleeping worker (locking prevents a lost wake up between its check and its wait).
+    {
+        std::unique_lock<std::mutex> lock( m_mutexSleep );
+    }
+    m_wakeUp.notify_one();
+}
+
+void WorkStealingPool::wait(WorkStealingPool::TaskGroup &group)
+{
+    int workerIndex = getCurrentWorkerIndex();
+    if( workerIndex >= 0 ){
+        //a worker waiting for a group helps executing tasks, otherwise the pool could dead lock.
+        while( group.m_pendingCount > 0 )
+            if( ! runOneTask( workerIndex ) )
+                std::this_thread::yield();
+    } else {
+        std::unique_lock<std::mutex> lock( m_mutexGroups );
+        m_groupFinished.wait( lock, [&group]{ return group.m_pendingCount == 0; } );
+    }
+}
+
+bool WorkStealingPool::waitFor(WorkStealingPool::TaskGroup &group, unsigned int milliseconds)
+{
+    std::unique_lock<std::mutex> lock( m_mutexGroups );
+    return m_groupFinished.wait_for( lock, std::chrono::milliseconds( milliseconds ),
+                                     [&group]{ return group.m_pendingCount == 0; } );
+}
+
+void WorkStealingPool::workerLoop(unsigned int workerIndex)
+{
+    s_currentPool = this;
+    s_currentWorkerIndex = workerIndex;
+    while( true ){
+        if( runOneTask( workerIndex ) )
+            continue;
+        std::unique_lock<std::mutex> lock( m_mutexSleep );
+        m_wakeUp.wait( lock, [this]{ return m_stop || m_queuedCount > 0; } );
+        if( m_stop && m_queuedCount == 0 )
+            return;
+    }
+}
+
+bool WorkStealingPool::runOneTask(unsigned int workerIndex)
+{
+    std::pair< Task, TaskGroup* > task;
+    bool found = false;
+
+    //first, try the newest task of the worker's own queue.
+    {
+        WorkerQueue& queue = *m_queues[ workerIndex ];
+        std::unique_lock<std::mutex> lock( queue.mutex );
+        if( ! queue.tasks.empty() ){
+            task = std::move( queue.tasks.back() );
+            queue.tasks.pop_back();
+            found = true;
+        }
+    }
+
+    //then, try to steal the oldest task of the other workers.
+    for( unsigned int i = 1; ! found && i < m_queues.size(); ++i ){
+        WorkerQueue& queue = *m_queues[ ( workerIndex + i ) % m_queues.size() ];
+        std::unique_lock<std::mutex> lock( queue.mutex );
+        if( ! queue.tasks.empty() ){
+            task = std::move( queue.tasks.front() );
+            queue.tasks.pop_front();
+            found = true;
+        }
+    }
+
+    if( ! found )
+        return false;
+    --m_queuedCount;
+
+    task.first();
+
+    //notify the threads waiting for the group if this was its last task.
+    if( --task.second->m_pendingCount == 0 ){
+        {
+            std::unique_lock<std::mutex> lock( m_mutexGroups );
+        }
+        m_groupFinished.notify_all();
+    }
+    return true;
+}
+
+int WorkStealingPool::getCurrentWorkerIndex() const
+{
+    if( s_currentPool == this )
+        return s_currentWorkerIndex;
+    return -1;
+}
@@ -0,0 +1,101 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+/**
+ * The WorkStealingPool class is a thread pool for tasks of unpredictable cost, such as building decision trees.
+ * Each worker thread has its own task queue.  Tasks submitted by a worker (e.g. sub-tasks of a task) go to its
+ * own queue and are executed last-in-first-out, which keeps the data of the parent task in cache.  Idle workers
+ * steal the oldest tasks (normally the largest ones) from the queues of the busy workers, so all threads are kept
+ * busy until the end.
+ * Tasks are grouped in TaskGroup objects so the code submitting them can wait for their completion.  A worker
+ * thread waiting for a group executes other tasks meanwhile, so tasks can safely wait for their sub-tasks.
+ * @note Tasks must not throw exceptions.
+ */
+class WorkStealingPool
+{
+public:
+
+    typedef std::function<void()> Task;
+
+    /** A set of tasks whose completion can be waited for with wait() or waitFor(). */
+    class TaskGroup{
+    public:
+        TaskGroup() : m_pendingCount( 0 ) {}
+        /** Returns the number of tasks of this group not yet finished. */
+        long getPendingCount() const { return m_pendingCount; }
+    private:
+        friend class WorkStealingPool;
+        std::atomic<long> m_pendingCount;
+    };
+
+    /**
+     * @param nThreads The number of worker threads.  If zero, the number of logical CPUs is used.
+     */
+    WorkStealingPool( unsigned int nThreads = 0 );
+
+    /** The destructor waits for the worker threads to finish the queued tasks. */
+    ~WorkStealingPool();
+
+    unsigned int getThreadCount() const { return m_threads.size(); }
+
+    /** Queues a task for execution as part of the given group. */
+    void submit( TaskGroup& group, Task task );
+
+    /** Waits until all the tasks of the given group are finished.  If called from a worker thread of this pool,
+     * the thread executes other queued tasks while waiting. */
+    void wait( TaskGroup& group );
+
+    /** Same as wait() for threads that are not workers of this pool (e.g. the GUI thread), but returns false if
+     * the tasks are not finished after the given time.  This allows the caller to report progress while waiting. */
+    bool waitFor( TaskGroup& group, unsigned int milliseconds );
+
+private:
+
+    /** A task queue of a worker thread. */
+    struct WorkerQueue{
+        std::mutex mutex;
+        std::deque< std::pair< Task, TaskGroup* > > tasks;
+    };
+
+    std::vector< std::unique_ptr< WorkerQueue > > m_queues;
+    std::vector< std::thread > m_threads;
+
+    /** Set in the destructor to tell the workers to end. */
+    bool m_stop;
+
+    /** Number of queued tasks (not yet started). */
+    std::atomic<long> m_queuedCount;
+
+    /** Used by submission to distribute the tasks submitted from non-worker threads. */
+    std::atomic<unsigned int> m_nextQueue;
+
+    /** Used to put idle workers to sleep. */
+    std::mutex m_mutexSleep;
+    std::condition_variable m_wakeUp;
+
+    /** Used to notify the completion of task groups. */
+    std::mutex m_mutexGroups;
+    std::condition_variable m_groupFinished;
+
+    /** The body of the worker threads. */
+    void workerLoop( unsigned int workerIndex );
+
+    /** Executes one queued task, preferably from the given worker's own queue.
+     * Returns false if there were no tasks to execute. */
+    bool runOneTask( unsigned int workerIndex );
+
+    /** Returns the index of the worker running the calling thread or -1 if the calling thread is not a worker
+     * of this pool. */
+    int getCurrentWorkerIndex() const;
+};
+
+#endif // WORKSTEALINGPOOL_H
@@ -13,6 +13,8 @@
 #include "gslib/gslibparameterfiles/gslibparamtypes.h"
 
 #include <QInputDialog>
+#include <QProgressDialog>
+#include <QApplication>
 
 #include <limits>
 
@@ -357,6 +359,15 @@ void MachineLearningDialog::runRandomForestClassify()
     std::vector<int> trainingFeaturesIDList = getTrainingFeaturesIDList();
     std::vector<int> outputFeaturesIDList = getOutputFeaturesIDList();
 
+    //show a progress dialog during the training
+    QProgressDialog progressDialog;
+    progressDialog.show();
+    progressDialog.setLabelText("Training the Random Forest...");
+    progressDialog.setMinimum( 0 );
+    progressDialog.setValue( 0 );
+    progressDialog.setMaximum( B );
+    QApplication::processEvents();
+
     //Build the RandomForest object, containing the Random Forest algorithm.
     RandomForest RF( *trainingDataFile->algorithmDataSource(),
                      *outputDataFile->algorithmDataSource(),
@@ -366,8 +377,21 @@ void MachineLearningDialog::runRandomForestClassify()
                      seed, //seed for the random number generator
                      bootstrap, //how the training data is re-sampled in each RF iteration
                      treeType, //the type of trees used to build the forest
-                     gpf.getParameterByName<GSLibParInt*>("MaxSplitsContinuous")->_value);
+                     gpf.getParameterByName<GSLibParInt*>("MaxSplitsContinuous")->_value,
+                     [&progressDialog]( unsigned int treesBuilt, unsigned int ){ //progress/cancel callback
+                        progressDialog.setValue( treesBuilt );
+                        QApplication::processEvents();
+                        return ! progressDialog.wasCanceled();
+                     });
+    progressDialog.hide();
+    if( RF.isCancelled() ){
+        Application::instance()->logWarn("MachineLearningDialog::runRandomForestClassify(): training cancelled by the user.");
+        return;
+    }
     Application::instance()->logInfo("MachineLearningDialog::runRandomForestClassify(): RandomForest object built.");
+    Application::instance()->logInfo("MachineLearningDialog::runRandomForestClassify(): out-of-bag misclassification rate: " +
+                QString::number( RF.getOutOfBagMisclassificationRate(
+                                    m_trainingDependentVariableSelector->getSelectedVariableGEOEASIndex()-1 ) ) );
 
     //get the number of data rows in the output to be classified
     long outputRowCount = outputDataFile->getDataLineCount();
@@ -377,18 +401,11 @@ void MachineLearningDialog::runRandomForestClassify()
     std::vector<double> classes( outputRowCount, std::numeric_limits<double>::quiet_NaN() );
     std::vector<double> counts( outputRowCount, std::numeric_limits<double>::quiet_NaN() );
 
-    //for each output data
-    for( long outputRow = 0; outputRow < outputRowCount; ++outputRow){
-        //classify the data
-        //First value is the class and the second is uncertainty
-        std::pair< DataValue, double> result( DataValue((int)0), 1.0 );
-        RF.classify( outputRow,
-                     m_trainingDependentVariableSelector->getSelectedVariableGEOEASIndex()-1,
-                     result );
-        //get the result
-        classes[outputRow] = result.first.getCategorical();
-        counts[outputRow] = result.second;
-    }
+    //classify all the output data (multithreaded)
+    RF.classify( 0, outputRowCount,
+                 m_trainingDependentVariableSelector->getSelectedVariableGEOEASIndex()-1,
+                 classes,
+                 counts );
 
     Application::instance()->logInfo("MachineLearningDialog::runRandomForestClassify(): classification completed.");
 
@@ -455,6 +472,15 @@ void MachineLearningDialog::runRandomForestRegression()
     std::vector<int> trainingFeaturesIDList = getTrainingFeaturesIDList();
     std::vector<int> outputFeaturesIDList = getOutputFeaturesIDList();
 
+    //show a progress dialog during the training
+    QProgressDialog progressDialog;
+    progressDialog.show();
+    progressDialog.setLabelText("Training the Random Forest...");
+    progressDialog.setMinimum( 0 );
+    progressDialog.setValue( 0 );
+    progressDialog.setMaximum( B );
+    QApplication::processEvents();
+
     //Build the RandomForest object, containing the Random Forest algorithm.
     RandomForest RF( *trainingDataFile->algorithmDataSource(),
                      *outputDataFile->algorithmDataSource(),
@@ -464,8 +490,21 @@ void MachineLearningDialog::runRandomForestRegression()
                      seed, //seed for the random number generator
                      bootstrap, //how the training data is re-sampled in each RF iteration
                      treeType, //the type of trees used to build the forest
-                     gpf.getParameterByName<GSLibParInt*>("MaxSplitsContinuous")->_value);
+                     gpf.getParameterByName<GSLibParInt*>("MaxSplitsContinuous")->_value,
+                     [&progressDialog]( unsigned int treesBuilt, unsigned int ){ //progress/cancel callback
+                        progressDialog.setValue( treesBuilt );
+                        QApplication::processEvents();
+                        return ! progressDialog.wasCanceled();
+                     });
+    progressDialog.hide();
+    if( RF.isCancelled() ){
+        Application::instance()->logWarn("MachineLearningDialog::runRandomForestRegression(): training cancelled by the user.");
+        return;
+    }
     Application::instance()->logInfo("MachineLearningDialog::runRandomForestRegression(): RandomForest object built.");
+    Application::instance()->logInfo("MachineLearningDialog::runRandomForestRegression(): out-of-bag mean squared error: " +
+                QString::number( RF.getOutOfBagMeanSquaredError(
+                                    m_trainingDependentVariableSelector->getSelectedVariableGEOEASIndex()-1 ) ) );
 
     //get the number of data rows in the output to be estimated
     long outputRowCount = outputDataFile->getDataLineCount();
@@ -475,20 +514,11 @@ void MachineLearningDialog::runRandomForestRegression()
     std::vector<double> means( outputRowCount, std::numeric_limits<double>::quiet_NaN() );
     std::vector<double> variances( outputRowCount, std::numeric_limits<double>::quiet_NaN() );
 
-    //for each output data
-    for( long outputRow = 0; outputRow < outputRowCount; ++outputRow){
-        //estimate the data
-        //First value is the class and the second is uncertainty
-		DataValue mean( 0.0 );
-		DataValue variance( 0.0 );
-        RF.regress( outputRow,
-                    m_trainingDependentVariableSelector->getSelectedVariableGEOEASIndex()-1,
-                    mean,
-                    variance );
-        //get the result
-        means[outputRow] = mean.getContinuous();
-        variances[outputRow] = variance.getContinuous();
-    }
+    //estimate all the output data (multithreaded)
+    RF.regress( 0, outputRowCount,
+                m_trainingDependentVariableSelector->getSelectedVariableGEOEASIndex()-1,
+                means,
+                variances );
 
     Application::instance()->logInfo("MachineLearningDialog::runRandomForestRegression(): regression completed.");
 
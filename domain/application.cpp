@@ -5,6 +5,8 @@
 #include <QDir>
 #include <QSettings>
 #include <QMessageBox>
+#include <QCoreApplication>
+#include <QThread>
 
 //global instance pointer in the heap.
 Application* Application::_instance = nullptr;
@@ -91,9 +93,20 @@ void Application::setMaxGridCellCountFor3DVisualizationSetting(int value)
     qs.setValue("maxcellgrid3dview", value);
 }
 
+bool Application::isGUIThread()
+{
+    return ! QCoreApplication::instance() || QThread::currentThread() == QCoreApplication::instance()->thread();
+}
+
 void Application::logInfo(const QString text, bool showMessageBox)
 {
     Q_ASSERT(_mw != 0);
+    //the log is a widget, so messages from other threads are handed over to the GUI thread
+    if( ! isGUIThread() ){
+        QMetaObject::invokeMethod( _mw, "onLogMessageFromThread", Qt::QueuedConnection,
+                                   Q_ARG( QString, text ), Q_ARG( QString, "information" ), Q_ARG( bool, showMessageBox ) );
+        return;
+    }
     if( _logInfo )
         _mw->log_message( text, "information" );
     else
@@ -105,6 +118,12 @@ void Application::logInfo(const QString text, bool showMessageBox)
 void Application::logWarn(const QString text, bool showMessageBox)
 {
     Q_ASSERT(_mw != 0);
+    //the log is a widget, so messages from other threads are handed over to the GUI thread
+    if( ! isGUIThread() ){
+        QMetaObject::invokeMethod( _mw, "onLogMessageFromThread", Qt::QueuedConnection,
+                                   Q_ARG( QString, text ), Q_ARG( QString, "warning" ), Q_ARG( bool, showMessageBox ) );
+        return;
+    }
     if( _logWarnings )
         _mw->log_message( text, "warning" );
     else
@@ -116,6 +135,12 @@ void Application::logWarn(const QString text, bool showMessageBox)
 void Application::logError(const QString text, bool showMessageBox)
 {
     Q_ASSERT(_mw != 0);
+    //the log is a widget, so messages from other threads are handed over to the GUI thread
+    if( ! isGUIThread() ){
+        QMetaObject::invokeMethod( _mw, "onLogMessageFromThread", Qt::QueuedConnection,
+                                   Q_ARG( QString, text ), Q_ARG( QString, "error" ), Q_ARG( bool, showMessageBox ) );
+        return;
+    }
     if( _logErrors )
         _mw->log_message( text, "error" );
     else
@@ -87,8 +87,12 @@ public:
     void setMaxGridCellCountFor3DVisualizationSetting(int value);
     //!@}
 
+    /** Returns whether the caller runs in the GUI thread.  Widgets can only be created and used in it. */
+    static bool isGUIThread();
+
     /**
      * @brief Treats the text as an information text.
+     * The log functions can be called from any thread: messages from other threads are shown by the GUI thread.
      */
     void logInfo(const QString text, bool showMessageBox = false );
 
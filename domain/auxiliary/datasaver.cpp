@@ -3,11 +3,13 @@
 #include <sstream>    // std::stringstream
 #include <iomanip>      // std::setprecision
 
-DataSaver::DataSaver(std::vector<std::vector<double> > &data, std::ostringstream &out, QObject *parent) :
+DataSaver::DataSaver(std::vector<std::vector<double> > &data, std::ostringstream &out,
+                     const std::vector<bool> *linesToSave, QObject *parent) :
     QObject(parent),
     _finished( false ),
     _data(data),
-    _out(out)
+    _out(out),
+    _linesToSave(linesToSave)
 {
 }
 
@@ -21,6 +23,11 @@ void DataSaver::doSave()
         if( ! ( linesSavedSoFar % 1000 ) ){ //update progress for each 1000 lines to not impact performance much
             emit progress( (int)(linesSavedSoFar) );
         }
+        //skip the data lines filtered out
+        if( _linesToSave && ! (*_linesToSave)[ itDataLine - _data.cbegin() ] ){
+            ++linesSavedSoFar;
+            continue;
+        }
         std::vector<double>::const_iterator itDataColumn = (*itDataLine).cbegin();
         //output the value in the first column
         _out << *itDataColumn;
@@ -12,8 +12,12 @@ class DataSaver : public QObject
 
 public:
 
+    /**
+     * @param linesToSave If not null, only the data lines flagged true are saved (see DataFile::writeFilteredToFS()).
+     */
     explicit DataSaver(std::vector< std::vector<double> >& data,
                        std::ostringstream& out,
+                       const std::vector<bool>* linesToSave = nullptr,
                        QObject *parent = nullptr);
 
     bool isFinished(){ return _finished; }
@@ -27,6 +31,7 @@ private:
     bool _finished;
     std::vector< std::vector<double> >& _data;
     std::ostringstream& _out;
+    const std::vector<bool>* _linesToSave;
 
 };
 
@@ -88,19 +88,15 @@ public:
         //traverse trajectory in steps of size h counting facies transitions
         //from end (early in geologic time) to begining (late in geologic time).
         double trajectoryLength = FTMMakerAdapters::getTrajectoryLength( m_dataFileWithFacies );
-        int previousFaciesCode = -9999; //hopefully no one uses -9999 as code.
+        std::vector< int > faciesString;
         for( double distance = trajectoryLength; distance >= 0.0; distance -= h ){
-            int faciesCode = -9998;
             double readValue = FTMMakerAdapters::getValueInTrajectory
                                ( m_dataFileWithFacies, m_variableIndex, distance, tolerance );
-            if( std::isfinite( readValue ) ){
-                faciesCode = static_cast<int>( readValue );
-                if( /*faciesCode != previousFaciesCode &&*/ previousFaciesCode != -9999 ){
-                    ftm.incrementCount( previousFaciesCode, faciesCode );
-                }
-                previousFaciesCode = faciesCode;
-            }
+            if( std::isfinite( readValue ) )
+                faciesString.push_back( static_cast<int>( readValue ) );
         }
+        //count the transitions between consecutive facies read
+        ftm.incrementCountsAlongSequence( faciesString );
         return ftm;
     }
 
@@ -122,14 +118,8 @@ public:
                 FTMMakerAdapters::getFaciesSequence( m_dataFileWithFacies, m_variableIndex, dataIndexOrder, m_groupByColumn );
 
         //each facies string is treated separately (e.g. traces of a seismic volume)
-        for( const std::vector< int >& faciesString : faciesStrings ){
-            int previousFaciesCode = -9999; //hopefully no one uses -9999 as code.
-            for( int faciesCode : faciesString ){
-                if( previousFaciesCode != -9999 )
-                    ftm.incrementCount( previousFaciesCode, faciesCode );
-                previousFaciesCode = faciesCode;
-            }
-        }
+        for( const std::vector< int >& faciesString : faciesStrings )
+            ftm.incrementCountsAlongSequence( faciesString );
 
         return ftm;
     }
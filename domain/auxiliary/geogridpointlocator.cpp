@@ -0,0 +1,224 @@
+#include "geogridpointlocator.h"
+#include "domain/geogrid.h"
+
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+
+/** The first three vertexes (enough to define the plane) of the faces of a cell, in the order of
+ *  GeoGrid::getFaces(): K-, K+, I-, I+, J-, J+. */
+static const int FACE_VERTEXES[6][3] = { {0, 1, 2}, {4, 7, 6}, {0, 3, 7}, {1, 5, 6}, {0, 4, 5}, {3, 2, 6} };
+
+/** The cell index offsets in I, J and K to the neighbor cell across each face. */
+static const int FACE_NEIGHBORS[6][3] = { {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0} };
+
+/** Maximum number of cells visited by a walk before resorting to the spatial index. */
+static const int MAX_WALK_STEPS = 32;
+
+/** The number of consecutive locations processed by a thread at a time in batches.  Each run starts with
+ *  a spatial index query, then walks from cell to cell. */
+static const size_t LOCATIONS_PER_RUN = 4096;
+
+/** Locations up to this distance outside a face (relative to the distance to the cell's origin) are deemed
+ *  inside, which covers the rounding of the single precision planes. */
+static const double RELATIVE_TOLERANCE = 1e-6;
+
+GeoGridPointLocator::GeoGridPointLocator(GeoGrid *geoGrid, unsigned int nThreads) :
+    m_nI( geoGrid->getNI() ),
+    m_nJ( geoGrid->getNJ() ),
+    m_nK( geoGrid->getNK() ),
+    m_nThreads( nThreads )
+{
+    if( m_nThreads == 0 )
+        m_nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+
+    uint nCells = geoGrid->getMeshNumberOfCells(); //this loads the mesh if necessary
+    m_cellPlanes.resize( nCells );
+    std::vector< BoxAndDataIndex > boxes;
+    boxes.reserve( nCells );
+
+    for( uint iCell = 0; iCell < nCells; ++iCell ){
+        //get the vertexes of the cell
+        uint vIds[8];
+        geoGrid->getMeshCellDefinition( iCell, vIds );
+        double vertexes[8][3];
+        for( int iVertex = 0; iVertex < 8; ++iVertex )
+            geoGrid->getMeshVertexLocation( vIds[iVertex],
+                                            vertexes[iVertex][0], vertexes[iVertex][1], vertexes[iVertex][2] );
+
+        //make the planes relative to the first vertex, with the same normals as Face3D::normal()
+        CellPlanes& planes = m_cellPlanes[iCell];
+        std::copy( vertexes[0], vertexes[0] + 3, planes.origin );
+        for( int iFace = 0; iFace < 6; ++iFace ){
+            const double* a = vertexes[ FACE_VERTEXES[iFace][0] ];
+            const double* b = vertexes[ FACE_VERTEXES[iFace][1] ];
+            const double* c = vertexes[ FACE_VERTEXES[iFace][2] ];
+            double dir1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            double dir2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            double n[3] = { dir2[1] * dir1[2] - dir2[2] * dir1[1],
+                            dir2[2] * dir1[0] - dir2[0] * dir1[2],
+                            dir2[0] * dir1[1] - dir2[1] * dir1[0] };
+            double norm = std::sqrt( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+            if( norm > 0.0 )
+                for( int iAxis = 0; iAxis < 3; ++iAxis )
+                    n[iAxis] /= norm;
+            double offset = 0.0;
+            for( int iAxis = 0; iAxis < 3; ++iAxis ){
+                planes.normals[iFace][iAxis] = n[iAxis];
+                offset += n[iAxis] * ( a[iAxis] - planes.origin[iAxis] );
+            }
+            planes.offsets[iFace] = offset;
+        }
+
+        //make the bounding box of the cell
+        double min[3] = { vertexes[0][0], vertexes[0][1], vertexes[0][2] };
+        double max[3] = { vertexes[0][0], vertexes[0][1], vertexes[0][2] };
+        for( int iVertex = 1; iVertex < 8; ++iVertex )
+            for( int iAxis = 0; iAxis < 3; ++iAxis ){
+                min[iAxis] = std::min( min[iAxis], vertexes[iVertex][iAxis] );
+                max[iAxis] = std::max( max[iAxis], vertexes[iVertex][iAxis] );
+            }
+        boxes.push_back( std::make_pair( Box( Point3D( min[0], min[1], min[2] ),
+                                              Point3D( max[0], max[1], max[2] ) ), iCell ) );
+    }
+
+    //bulk load
+    m_rtree = RStarRtree( boxes );
+}
+
+bool GeoGridPointLocator::XYZtoUVW(double x, double y, double z, double &u, double &v, double &w, int &cellIndex) const
+{
+    cellIndex = locate( x, y, z, cellIndex );
+    if( cellIndex < 0 )
+        return false;
+
+    //the distances between the location and the faces (see GeoGrid::XYZtoUVW())
+    const CellPlanes& planes = m_cellPlanes[cellIndex];
+    double location[3] = { x - planes.origin[0], y - planes.origin[1], z - planes.origin[2] };
+    double distances[6];
+    getSignedDistances( planes, location, distances );
+    double dW0 = std::abs( distances[0] );
+    double dW1 = std::abs( distances[1] );
+    double dU0 = std::abs( distances[2] );
+    double dU1 = std::abs( distances[3] );
+    double dV0 = std::abs( distances[4] );
+    double dV1 = std::abs( distances[5] );
+
+    //compute the UVW within the cell (min = 0.0, max = 1.0)
+    double local_u = dU0 / (dU0 + dU1);
+    double local_v = dV0 / (dV0 + dV1);
+    double local_w = dW0 / (dW0 + dW1);
+
+    //compute the UVW coordinates.
+    int i = cellIndex % m_nI;
+    int j = ( cellIndex / m_nI ) % m_nJ;
+    int k = cellIndex / m_nI / m_nJ;
+    u = ( i + local_u ) / m_nI;
+    v = ( j + local_v ) / m_nJ;
+    w = ( k + local_w ) / m_nK;
+
+    return true;
+}
+
+size_t GeoGridPointLocator::XYZtoUVW(const std::vector<double> &x, const std::vector<double> &y,
+                                     const std::vector<double> &z,
+                                     std::vector<double> &u, std::vector<double> &v, std::vector<double> &w,
+                                     std::vector<int> &cellIndexes) const
+{
+    size_t nLocations = x.size();
+    u.assign( nLocations, -1.0 );
+    v.assign( nLocations, -1.0 );
+    w.assign( nLocations, -1.0 );
+    cellIndexes.assign( nLocations, -1 );
+
+    //the runs of consecutive locations are distributed among the threads
+    size_t nRuns = ( nLocations + LOCATIONS_PER_RUN - 1 ) / LOCATIONS_PER_RUN;
+    std::atomic<size_t> nextRun( 0 );
+    std::atomic<size_t> nLocated( 0 );
+    auto worker = [&](){
+        while( true ){
+            size_t iRun = nextRun++;
+            if( iRun >= nRuns )
+                break;
+            size_t end = std::min( nLocations, ( iRun + 1 ) * LOCATIONS_PER_RUN );
+            size_t count = 0;
+            int cellIndex = -1;
+            for( size_t iLocation = iRun * LOCATIONS_PER_RUN; iLocation < end; ++iLocation ){
+                //the search starts from the cell of the previous location (or from the last cell found)
+                int previousCellIndex = cellIndex;
+                if( XYZtoUVW( x[iLocation], y[iLocation], z[iLocation],
+                              u[iLocation], v[iLocation], w[iLocation], cellIndex ) ){
+                    cellIndexes[iLocation] = cellIndex;
+                    ++count;
+                } else
+                    cellIndex = previousCellIndex;
+            }
+            nLocated += count;
+        }
+    };
+
+    unsigned int nThreads = std::min<size_t>( m_nThreads, nRuns );
+    std::vector< std::thread > threads;
+    for( unsigned int iThread = 1; iThread < nThreads; ++iThread )
+        threads.emplace_back( worker );
+    worker();
+    for( std::thread& thread : threads )
+        thread.join();
+
+    return nLocated;
+}
+
+void GeoGridPointLocator::getSignedDistances(const CellPlanes &planes, const double (&location)[3],
+                                             double (&distances)[6]) const
+{
+    for( int iFace = 0; iFace < 6; ++iFace )
+        distances[iFace] = planes.normals[iFace][0] * location[0] +
+                           planes.normals[iFace][1] * location[1] +
+                           planes.normals[iFace][2] * location[2] - planes.offsets[iFace];
+}
+
+int GeoGridPointLocator::locate(double x, double y, double z, int startCellIndex) const
+{
+    //returns the face the location is farthest outside of or -1 if the location is inside the cell
+    auto farthestFaceOutside = [this, x, y, z]( int cellIndex ){
+        const CellPlanes& planes = m_cellPlanes[cellIndex];
+        double location[3] = { x - planes.origin[0], y - planes.origin[1], z - planes.origin[2] };
+        double distances[6];
+        getSignedDistances( planes, location, distances );
+        double tolerance = RELATIVE_TOLERANCE * std::sqrt( location[0] * location[0] +
+                                                           location[1] * location[1] +
+                                                           location[2] * location[2] );
+        int result = -1;
+        for( int iFace = 0; iFace < 6; ++iFace )
+            if( distances[iFace] > tolerance ){
+                tolerance = distances[iFace];
+                result = iFace;
+            }
+        return result;
+    };
+
+    //walk from the start cell towards the location
+    int cellIndex = startCellIndex;
+    for( int step = 0; cellIndex >= 0 && step < MAX_WALK_STEPS; ++step ){
+        int iFace = farthestFaceOutside( cellIndex );
+        if( iFace < 0 )
+            return cellIndex;
+        int i = cellIndex % m_nI + FACE_NEIGHBORS[iFace][0];
+        int j = ( cellIndex / m_nI ) % m_nJ + FACE_NEIGHBORS[iFace][1];
+        int k = cellIndex / m_nI / m_nJ + FACE_NEIGHBORS[iFace][2];
+        if( i < 0 || i >= m_nI || j < 0 || j >= m_nJ || k < 0 || k >= m_nK )
+            break; //the walk left the grid (the location may still be inside if the grid is not convex)
+        cellIndex = ( k * m_nJ + j ) * m_nI + i;
+    }
+
+    //test the cells whose bounding boxes contain the location
+    std::vector< BoxAndDataIndex > candidates;
+    m_rtree.query( bgi::intersects( Point3D( x, y, z ) ), std::back_inserter( candidates ) );
+    for( const BoxAndDataIndex& candidate : candidates )
+        if( farthestFaceOutside( candidate.second ) < 0 )
+            return candidate.second;
+
+    //the location is outside the grid
+    return -1;
+}
@@ -0,0 +1,80 @@
+#ifndef GEOGRIDPOINTLOCATOR_H
+#define GEOGRIDPOINTLOCATOR_H
+
+#include "spatialindex/spatialindex.h"
+
+#include <vector>
+
+class GeoGrid;
+
+/**
+ * The GeoGridPointLocator class finds the cells of a GeoGrid containing many XYZ locations and computes their
+ * depositional (UVW) coordinates in the same way as GeoGrid::XYZtoUVW(), but much faster:
+ * - The six face planes of every cell are computed once, in the constructor, and stored compactly (see
+ *   CellPlanes), so testing whether a location is inside a cell or computing its distances to the faces
+ *   allocates nothing.
+ * - Consecutive locations are usually close to each other (e.g. samples along drillholes), so the search
+ *   walks from the cell of the previous location towards the new location, crossing the face the location
+ *   is farthest outside of.  The spatial index (R*-tree of the cells' bounding boxes) is only queried when
+ *   the walk leaves the grid or does not converge.  Then all the cells whose bounding boxes contain the
+ *   location are tested (GeoGrid::XYZtoIJK() tests only the five nearest ones).
+ * - Batches of locations are split into runs of consecutive locations processed in parallel.
+ * The locator does not reference the GeoGrid after construction, thus it is not affected by changes to it.
+ */
+class GeoGridPointLocator
+{
+public:
+    /**
+     * @param geoGrid The grid.  Its mesh is loaded if necessary.
+     * @param nThreads Number of threads to use in batches.  If zero, the number of logical CPUs is used.
+     */
+    GeoGridPointLocator( GeoGrid* geoGrid, unsigned int nThreads = 0 );
+
+    /**
+     * Computes the UVW coordinates of a location.  Same as GeoGrid::XYZtoUVW().
+     * @param cellIndex Input: the cell to start the search from (e.g. the one of a nearby location) or -1.
+     *                  Output: the cell containing the location or -1 if the location is outside the grid.
+     * @return False if the location is outside the grid.
+     */
+    bool XYZtoUVW( double x, double y, double z, double& u, double& v, double& w, int& cellIndex ) const;
+
+    /**
+     * Computes the UVW coordinates of several locations in parallel.  The output vectors are resized to
+     * the number of locations.
+     * @param cellIndexes Output: the cell containing each location or -1 if it is outside the grid (the UVW
+     *                    coordinates are then -1.0).
+     * @return The number of locations inside the grid.
+     */
+    size_t XYZtoUVW( const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z,
+                     std::vector<double>& u, std::vector<double>& v, std::vector<double>& w,
+                     std::vector<int>& cellIndexes ) const;
+
+private:
+    /**
+     * The planes of the six faces of a cell, in the order of GeoGrid::getFaces().  The planes are relative to
+     * the cell's first vertex, so single precision suffices even for large (e.g. UTM) coordinates.
+     * A location is inside the cell if dot( normal, location - origin ) <= offset for all faces, which is the
+     * same test as Util::isInside().
+     */
+    struct CellPlanes{
+        double origin[3];
+        float normals[6][3];
+        float offsets[6];
+    };
+
+    /** Returns how far the location (relative to the cell's origin) is outside each face (negative if inside). */
+    void getSignedDistances( const CellPlanes& planes, const double (&location)[3], double (&distances)[6] ) const;
+
+    /** Returns the index of the cell containing the location or -1, walking from the given cell first. */
+    int locate( double x, double y, double z, int startCellIndex ) const;
+
+    std::vector< CellPlanes > m_cellPlanes;
+
+    /** The bounding boxes of the cells, for locations far from the previous one. */
+    RStarRtree m_rtree;
+
+    int m_nI, m_nJ, m_nK;
+    unsigned int m_nThreads;
+};
+
+#endif // GEOGRIDPOINTLOCATOR_H
@@ -3,9 +3,43 @@
 #include <QFileInfo>
 #include <QTextStream>
 
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+
 #include "util.h"
 #include "../application.h"
 
+const char MeshLoader::BINARY_MAGIC[8] = { 'G', 'G', 'M', 'E', 'S', 'H', 'B', 'N' };
+
+/** The number of vertexes or cells converted by a thread at a time. */
+static const size_t RECORDS_PER_BLOCK = 65536;
+
+/** Runs the task (which receives a [first, end) interval) for blocks of records in parallel. */
+static void parallelFor( size_t count, const std::function<void( size_t first, size_t end )>& task )
+{
+	size_t nBlocks = ( count + RECORDS_PER_BLOCK - 1 ) / RECORDS_PER_BLOCK;
+	std::atomic<size_t> nextBlock( 0 );
+	auto worker = [&](){
+		while( true ){
+			size_t iBlock = nextBlock++;
+			if( iBlock >= nBlocks )
+				break;
+			task( iBlock * RECORDS_PER_BLOCK, std::min( count, ( iBlock + 1 ) * RECORDS_PER_BLOCK ) );
+		}
+	};
+
+	unsigned int nThreads = std::min<size_t>( std::max( 1u, std::thread::hardware_concurrency() ), nBlocks );
+	std::vector< std::thread > threads;
+	for( unsigned int iThread = 1; iThread < nThreads; ++iThread )
+		threads.emplace_back( worker );
+	worker();
+	for( std::thread& thread : threads )
+		thread.join();
+}
+
 
 MeshLoader::MeshLoader(QFile & file, std::vector<VertexRecordPtr> & vertexes,
 					   std::vector<CellDefRecordPtr> & cellDefs,
@@ -21,6 +55,142 @@ MeshLoader::MeshLoader(QFile & file, std::vector<VertexRecordPtr> & vertexes,
 }
 
 void MeshLoader::doLoad()
+{
+	if( isBinary( _file ) )
+		loadBinary();
+	else
+		loadText();
+
+	_finished = true;
+}
+
+bool MeshLoader::isBinary(QFile &file)
+{
+	return file.peek( sizeof(BINARY_MAGIC) ) == QByteArray( BINARY_MAGIC, sizeof(BINARY_MAGIC) );
+}
+
+bool MeshLoader::saveBinary(const QString path,
+							const std::vector<VertexRecordPtr> &vertexes,
+							const std::vector<CellDefRecordPtr> &cellDefs)
+{
+	quint32 version = BINARY_VERSION;
+	quint32 byteOrderMark = BYTE_ORDER_MARK;
+	quint64 nVertexes = vertexes.size();
+	quint64 nCells = cellDefs.size();
+	size_t vertexesSize = nVertexes * 3 * sizeof(double);
+	size_t cellDefsSize = nCells * 8 * sizeof(quint32);
+
+	//serialize the header
+	std::vector< char > buffer( BINARY_HEADER_SIZE + vertexesSize + cellDefsSize );
+	char* header = buffer.data();
+	std::memcpy( header,      BINARY_MAGIC,   sizeof(BINARY_MAGIC) );
+	std::memcpy( header + 8,  &version,       sizeof(version) );
+	std::memcpy( header + 12, &byteOrderMark, sizeof(byteOrderMark) );
+	std::memcpy( header + 16, &nVertexes,     sizeof(nVertexes) );
+	std::memcpy( header + 24, &nCells,        sizeof(nCells) );
+
+	//serialize the vertexes and the cells in parallel
+	char* vertexBytes = header + BINARY_HEADER_SIZE;
+	parallelFor( nVertexes, [&]( size_t first, size_t end ){
+		for( size_t iVertex = first; iVertex < end; ++iVertex ){
+			const double coordinates[3] = { vertexes[iVertex]->X, vertexes[iVertex]->Y, vertexes[iVertex]->Z };
+			std::memcpy( vertexBytes + iVertex * sizeof(coordinates), coordinates, sizeof(coordinates) );
+		}
+	});
+	char* cellBytes = vertexBytes + vertexesSize;
+	parallelFor( nCells, [&]( size_t first, size_t end ){
+		for( size_t iCell = first; iCell < end; ++iCell ){
+			quint32 vIds[8];
+			for( int i = 0; i < 8; ++i )
+				vIds[i] = cellDefs[iCell]->vId[i];
+			std::memcpy( cellBytes + iCell * sizeof(vIds), vIds, sizeof(vIds) );
+		}
+	});
+
+	//write to a new file, so the current mesh file is only replaced after a complete write (see DataFile::writeDataToFile())
+	QFile file( QString( path ).append(".new") );
+	if( ! file.open( QFile::WriteOnly | QFile::Truncate ) )
+		return false;
+	bool ok = file.write( buffer.data(), buffer.size() ) == (qint64)buffer.size();
+	ok = file.flush() && ok;
+	file.close();
+	if( ! ok || file.error() != QFileDevice::NoError ){
+		file.remove();
+		return false;
+	}
+
+	// deletes the current file
+	QFile currentFile( path );
+	if( currentFile.exists() && ! currentFile.remove() ){
+		file.remove();
+		return false;
+	}
+	// renames the .new file, effectively replacing the current file.
+	return file.rename( path );
+}
+
+void MeshLoader::loadBinary()
+{
+	//map the file in memory (or read it whole if the file system does not support mapping)
+	qint64 fileSize = _file.size();
+	QByteArray contents;
+	uchar* mapped = _file.map( 0, fileSize );
+	const uchar* bytes = mapped;
+	if( ! bytes ){
+		contents = _file.readAll();
+		bytes = reinterpret_cast<const uchar*>( contents.constData() );
+	}
+
+	//read the header
+	quint32 version = 0, byteOrderMark = 0;
+	quint64 nVertexes = 0, nCells = 0;
+	if( fileSize >= BINARY_HEADER_SIZE ){
+		std::memcpy( &version,       bytes + 8,  sizeof(version) );
+		std::memcpy( &byteOrderMark, bytes + 12, sizeof(byteOrderMark) );
+		std::memcpy( &nVertexes,     bytes + 16, sizeof(nVertexes) );
+		std::memcpy( &nCells,        bytes + 24, sizeof(nCells) );
+	}
+	if( byteOrderMark != BYTE_ORDER_MARK || version > BINARY_VERSION ||
+		nVertexes > (quint64)fileSize || nCells > (quint64)fileSize ||
+		(quint64)fileSize != BINARY_HEADER_SIZE + nVertexes * 3 * sizeof(double) + nCells * 8 * sizeof(quint32) ){
+		Application::instance()->logError( "MeshLoader::loadBinary(): invalid binary mesh file (wrong size, "
+										   "version or byte order)." );
+		if( mapped )
+			_file.unmap( mapped );
+		return;
+	}
+
+	//convert the vertexes and the cells in parallel
+	m_vertexes.resize( nVertexes );
+	m_cellDefs.resize( nCells );
+	const uchar* vertexBytes = bytes + BINARY_HEADER_SIZE;
+	parallelFor( nVertexes, [&]( size_t first, size_t end ){
+		for( size_t iVertex = first; iVertex < end; ++iVertex ){
+			double coordinates[3];
+			std::memcpy( coordinates, vertexBytes + iVertex * sizeof(coordinates), sizeof(coordinates) );
+			m_vertexes[iVertex] = VertexRecordPtr( new VertexRecord{ coordinates[0], coordinates[1], coordinates[2] } );
+		}
+	});
+	const uchar* cellBytes = vertexBytes + nVertexes * 3 * sizeof(double);
+	parallelFor( nCells, [&]( size_t first, size_t end ){
+		for( size_t iCell = first; iCell < end; ++iCell ){
+			quint32 vIds[8];
+			std::memcpy( vIds, cellBytes + iCell * sizeof(vIds), sizeof(vIds) );
+			CellDefRecordPtr cellDef( new CellDefRecord() );
+			for( int i = 0; i < 8; ++i )
+				cellDef->vId[i] = vIds[i];
+			m_cellDefs[iCell] = cellDef;
+		}
+	});
+
+	if( mapped )
+		_file.unmap( mapped );
+
+	_data_line_count += nVertexes + nCells;
+	emit progress( (int)( fileSize / 100 ) );
+}
+
+void MeshLoader::loadText()
 {
 	QTextStream in(&_file);
 	long bytesReadSofar = 0;
@@ -104,6 +274,4 @@ void MeshLoader::doLoad()
 		   ++_data_line_count;
 	   }
 	}
-
-	_finished = true;
 }
@@ -7,6 +7,20 @@
 
 /** This is an auxiliary class used in GeoGrid::loadMesh() to enable the progress dialog.
  * The file is read in a separate thread, so the progress bar updates.
+ *
+ * Two mesh file formats are read:
+ * - Text (legacy): a two-line header, then "VERTEX LOCATIONS:" followed by one X;Y;Z line per vertex,
+ *   then "CELL VERTEX INDEXES:" followed by one line with the eight vertex ids per cell.
+ * - Binary (written by saveBinary()), in the native byte order:
+ *     char[8]  BINARY_MAGIC
+ *     uint32   BINARY_VERSION
+ *     uint32   BYTE_ORDER_MARK (to detect files written with another byte order)
+ *     uint64   number of vertexes (nV)
+ *     uint64   number of cells (nC)
+ *     float64  nV * 3 vertex coordinates (X, Y, Z of the first vertex, then of the second vertex, etc.)
+ *     uint32   nC * 8 vertex ids of the cells (see CellDefRecord)
+ *   The header is 32 bytes long, so the arrays are aligned and the file can be used in place when memory
+ *   mapped.  Binary files are memory mapped and parsed in parallel.
  */
 class MeshLoader : public QObject
 {
@@ -22,12 +36,35 @@ public:
 
 	bool isFinished(){ return _finished; }
 
+	/** Returns whether the given open file is in the binary format (it only peeks at the file). */
+	static bool isBinary( QFile& file );
+
+	/**
+	 * Writes a mesh to a file in the binary format.  The file contents are serialized in parallel.
+	 * The mesh is written to <path>.new, which replaces the file only after a complete write.
+	 * Returns false if the file could not be written (the current file, if any, is then left untouched).
+	 */
+	static bool saveBinary( const QString path,
+							const std::vector< VertexRecordPtr > &vertexes,
+							const std::vector< CellDefRecordPtr > &cellDefs );
+
+	static const char BINARY_MAGIC[8];
+	static const quint32 BINARY_VERSION = 1;
+	static const quint32 BYTE_ORDER_MARK = 0x01020304;
+	static const qint64 BINARY_HEADER_SIZE = 32;
+
 public slots:
 	void doLoad( );
 signals:
 	void progress(int);
 
 private:
+	/** Parses the legacy text format. */
+	void loadText();
+
+	/** Parses the binary format. */
+	void loadBinary();
+
 	QFile &_file;
 	std::vector< VertexRecordPtr > &m_vertexes;
 	std::vector< CellDefRecordPtr > &m_cellDefs;
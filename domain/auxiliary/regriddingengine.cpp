@@ -0,0 +1,477 @@
+#include "regriddingengine.h"
+#include "domain/cartesiangrid.h"
+#include "domain/geogrid.h"
+#include "geometry/vector3d.h"
+
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <array>
+
+/** The number of target cells processed by a thread at a time. */
+static const size_t TARGET_CELLS_PER_BLOCK = 256;
+
+/** The six tetrahedra a hexahedron is split into.  They are the pyramids of Hexahedron (apex at vertex 3)
+ *  with their bases split into two triangles. */
+static const int HEXAHEDRON_TETRAHEDRA[6][4] = { {3, 1, 2, 6}, {3, 1, 6, 5},
+                                                 {3, 4, 5, 6}, {3, 4, 6, 7},
+                                                 {3, 0, 1, 5}, {3, 0, 5, 4} };
+
+/** The triangles of the faces of a hexahedron split as above, each with a vertex of its tetrahedron not in it
+ *  (to tell the inner side). */
+static const int HEXAHEDRON_TRIANGLES[12][4] = { {1, 2, 6, 3}, {1, 6, 5, 3}, {4, 5, 6, 3}, {4, 6, 7, 3},
+                                                 {0, 1, 5, 3}, {0, 5, 4, 3}, {3, 1, 2, 6}, {3, 0, 1, 5},
+                                                 {3, 0, 4, 5}, {3, 4, 7, 6}, {3, 2, 6, 1}, {3, 6, 7, 4} };
+
+/** The vertexes of a tetrahedron. */
+typedef std::array< Vector3D, 4 > TetrahedronVertexes;
+
+/** Returns the volume of a tetrahedron. */
+static double getVolume( const TetrahedronVertexes& v )
+{
+    return std::abs( ( v[1] - v[0] ).dot( ( v[2] - v[0] ).cross( v[3] - v[0] ) ) ) / 6.0;
+}
+
+/** Adds the three tetrahedra a triangular prism is split into (a[i] and b[i] are joined by a side edge). */
+static void addPrism( const Vector3D (&a)[3], const Vector3D (&b)[3], std::vector< TetrahedronVertexes >& result )
+{
+    result.push_back( { a[0], a[1], a[2], b[0] } );
+    result.push_back( { a[1], a[2], b[0], b[1] } );
+    result.push_back( { a[2], b[0], b[1], b[2] } );
+}
+
+/** Clips tetrahedra, keeping the parts where normal . x <= offset, which are split into tetrahedra again. */
+static void clip( std::vector< TetrahedronVertexes >& tetrahedra, const Vector3D& normal, double offset )
+{
+    std::vector< TetrahedronVertexes > result;
+    result.reserve( tetrahedra.size() * 3 );
+    for( const TetrahedronVertexes& v : tetrahedra ){
+        double distances[4];
+        int inside[4], outside[4];
+        int nInside = 0, nOutside = 0;
+        for( int iVertex = 0; iVertex < 4; ++iVertex ){
+            distances[iVertex] = normal.dot( v[iVertex] ) - offset;
+            if( distances[iVertex] > 0.0 )
+                outside[nOutside++] = iVertex;
+            else
+                inside[nInside++] = iVertex;
+        }
+        //the point where the plane cuts the edge between an inside vertex and an outside one
+        auto cut = [&]( int iInside, int iOutside ){
+            double t = distances[iInside] / ( distances[iInside] - distances[iOutside] );
+            return v[iInside] + t * ( v[iOutside] - v[iInside] );
+        };
+        switch( nOutside ){
+        case 0:
+            result.push_back( v );
+            break;
+        case 1: //the tetrahedron minus a corner is a prism
+        {
+            const Vector3D a[3] = { v[inside[0]], v[inside[1]], v[inside[2]] };
+            const Vector3D b[3] = { cut( inside[0], outside[0] ), cut( inside[1], outside[0] ),
+                                    cut( inside[2], outside[0] ) };
+            addPrism( a, b, result );
+            break;
+        }
+        case 2: //a wedge between the two inside vertexes, which is a prism too
+        {
+            const Vector3D a[3] = { v[inside[0]], cut( inside[0], outside[0] ), cut( inside[0], outside[1] ) };
+            const Vector3D b[3] = { v[inside[1]], cut( inside[1], outside[0] ), cut( inside[1], outside[1] ) };
+            addPrism( a, b, result );
+            break;
+        }
+        case 3: //a corner
+            result.push_back( { v[inside[0]], cut( inside[0], outside[0] ), cut( inside[0], outside[1] ),
+                                cut( inside[0], outside[2] ) } );
+            break;
+        default:
+            break;
+        }
+    }
+    tetrahedra.swap( result );
+}
+
+/** Makes the outward plane (normal . x <= offset inside) of a triangle given a point on the inner side. */
+static void makePlane( const Vector3D& a, const Vector3D& b, const Vector3D& c, const Vector3D& inner,
+                       Vector3D& normal, double& offset )
+{
+    normal = ( b - a ).cross( c - a );
+    if( normal.dot( inner - a ) > 0.0 )
+        normal = -1.0 * normal;
+    offset = normal.dot( a );
+}
+
+/** Returns the smallest and the largest values of normal . x over the corners of a box. */
+static void getExtent( const Vector3D& normal, const double (&boxMin)[3], const double (&boxMax)[3],
+                       double& low, double& high )
+{
+    //the corner farthest along the normal has, on each axis, the max coordinate if the normal is positive
+    const double components[3] = { normal.x, normal.y, normal.z };
+    low = high = 0.0;
+    for( int iAxis = 0; iAxis < 3; ++iAxis ){
+        double a = components[iAxis] * boxMin[iAxis];
+        double b = components[iAxis] * boxMax[iAxis];
+        low += std::min( a, b );
+        high += std::max( a, b );
+    }
+}
+
+/** A tetrahedron with the outward planes of its faces (face i is opposite to vertex i) and its bounding box. */
+struct Tetrahedron{
+    Vector3D vertexes[4];
+    Vector3D normals[4];
+    double offsets[4];
+    double min[3];
+    double max[3];
+
+    void set( const Vector3D& a, const Vector3D& b, const Vector3D& c, const Vector3D& d )
+    {
+        vertexes[0] = a; vertexes[1] = b; vertexes[2] = c; vertexes[3] = d;
+        for( int iFace = 0; iFace < 4; ++iFace )
+            makePlane( vertexes[ ( iFace + 1 ) % 4 ], vertexes[ ( iFace + 2 ) % 4 ], vertexes[ ( iFace + 3 ) % 4 ],
+                       vertexes[iFace], normals[iFace], offsets[iFace] );
+        min[0] = min[1] = min[2] = std::numeric_limits<double>::max();
+        max[0] = max[1] = max[2] = std::numeric_limits<double>::lowest();
+        for( const Vector3D& vertex : vertexes ){
+            const double coordinates[3] = { vertex.x, vertex.y, vertex.z };
+            for( int iAxis = 0; iAxis < 3; ++iAxis ){
+                min[iAxis] = std::min( min[iAxis], coordinates[iAxis] );
+                max[iAxis] = std::max( max[iAxis], coordinates[iAxis] );
+            }
+        }
+    }
+};
+
+/** Returns the volume of the intersection between a tetrahedron and a box. */
+static double getOverlap( const Tetrahedron& tetrahedron, const double (&boxMin)[3], const double (&boxMax)[3] )
+{
+    for( int iAxis = 0; iAxis < 3; ++iAxis )
+        if( boxMin[iAxis] >= tetrahedron.max[iAxis] || boxMax[iAxis] <= tetrahedron.min[iAxis] )
+            return 0.0;
+
+    //the box is not clipped if it is entirely inside the tetrahedron or entirely outside a face
+    bool boxInside = true;
+    for( int iFace = 0; iFace < 4; ++iFace ){
+        double low, high;
+        getExtent( tetrahedron.normals[iFace], boxMin, boxMax, low, high );
+        if( low >= tetrahedron.offsets[iFace] )
+            return 0.0;
+        if( high > tetrahedron.offsets[iFace] )
+            boxInside = false;
+    }
+    if( boxInside )
+        return ( boxMax[0] - boxMin[0] ) * ( boxMax[1] - boxMin[1] ) * ( boxMax[2] - boxMin[2] );
+
+    //clip the tetrahedron by the planes of the box it crosses
+    const Vector3D (&v)[4] = tetrahedron.vertexes;
+    std::vector< TetrahedronVertexes > pieces{ { v[0], v[1], v[2], v[3] } };
+    static const Vector3D AXES[3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+    for( int iAxis = 0; iAxis < 3 && ! pieces.empty(); ++iAxis ){
+        if( tetrahedron.max[iAxis] > boxMax[iAxis] )
+            clip( pieces, AXES[iAxis], boxMax[iAxis] );
+        if( tetrahedron.min[iAxis] < boxMin[iAxis] )
+            clip( pieces, -1.0 * AXES[iAxis], -boxMin[iAxis] );
+    }
+    double volume = 0.0;
+    for( const TetrahedronVertexes& piece : pieces )
+        volume += getVolume( piece );
+    return volume;
+}
+
+template<typename Task>
+void RegriddingEngine::computeOverlaps(size_t nTargetCells, Task task)
+{
+    //each block of target cells has its own overlap list, which are concatenated at the end
+    size_t nBlocks = ( nTargetCells + TARGET_CELLS_PER_BLOCK - 1 ) / TARGET_CELLS_PER_BLOCK;
+    std::vector< Overlaps > blockOverlaps( nBlocks );
+    std::vector< size_t > counts( nTargetCells );
+    std::atomic<size_t> nextBlock( 0 );
+    auto worker = [&](){
+        Overlaps overlaps;
+        while( true ){
+            size_t iBlock = nextBlock++;
+            if( iBlock >= nBlocks )
+                break;
+            size_t end = std::min( nTargetCells, ( iBlock + 1 ) * TARGET_CELLS_PER_BLOCK );
+            for( size_t iTarget = iBlock * TARGET_CELLS_PER_BLOCK; iTarget < end; ++iTarget ){
+                overlaps.clear();
+                task( iTarget, overlaps );
+                counts[iTarget] = overlaps.size();
+                blockOverlaps[iBlock].insert( blockOverlaps[iBlock].end(), overlaps.begin(), overlaps.end() );
+            }
+        }
+    };
+
+    unsigned int nThreads = std::min<size_t>( m_nThreads, nBlocks );
+    std::vector< std::thread > threads;
+    for( unsigned int iThread = 1; iThread < nThreads; ++iThread )
+        threads.emplace_back( worker );
+    worker();
+    for( std::thread& thread : threads )
+        thread.join();
+
+    m_offsets.assign( nTargetCells + 1, 0 );
+    for( size_t iTarget = 0; iTarget < nTargetCells; ++iTarget )
+        m_offsets[iTarget + 1] = m_offsets[iTarget] + counts[iTarget];
+    m_sourceIndexes.reserve( m_offsets.back() );
+    m_volumes.reserve( m_offsets.back() );
+    for( Overlaps& overlaps : blockOverlaps ){
+        for( const std::pair< unsigned int, double >& overlap : overlaps ){
+            m_sourceIndexes.push_back( overlap.first );
+            m_volumes.push_back( overlap.second );
+        }
+        Overlaps().swap( overlaps );
+    }
+}
+
+RegriddingEngine::RegriddingEngine(CartesianGrid *source, CartesianGrid *target, unsigned int nThreads) :
+    m_nThreads( nThreads > 0 ? nThreads : std::max( 1u, std::thread::hardware_concurrency() ) )
+{
+    setSource( source );
+
+    //the target cells (boxes)
+    double targetOrigin[3] = { target->getX0() - target->getDX() / 2,
+                               target->getY0() - target->getDY() / 2,
+                               target->getZ0() - target->getDZ() / 2 };
+    double targetCellSize[3] = { target->getDX(), target->getDY(), target->getDZ() };
+    int targetN[3] = { (int)target->getNX(), (int)target->getNY(), (int)target->getNZ() };
+
+    //the overlaps of two boxes are the products of the overlaps along each axis
+    computeOverlaps( (size_t)targetN[0] * targetN[1] * targetN[2], [&]( size_t targetCellIndex, Overlaps& overlaps ){
+        int targetIndex[3] = { (int)( targetCellIndex % targetN[0] ),
+                               (int)( targetCellIndex / targetN[0] % targetN[1] ),
+                               (int)( targetCellIndex / targetN[0] / targetN[1] ) };
+        std::vector< std::pair< int, double > > axisOverlaps[3];
+        for( int iAxis = 0; iAxis < 3; ++iAxis ){
+            double low = targetOrigin[iAxis] + targetIndex[iAxis] * targetCellSize[iAxis];
+            double high = low + targetCellSize[iAxis];
+            int first = std::max( 0, (int)std::floor( ( low - m_source.origin[iAxis] ) / m_source.cellSize[iAxis] ) );
+            int last = std::min( m_source.n[iAxis] - 1,
+                                 (int)std::floor( ( high - m_source.origin[iAxis] ) / m_source.cellSize[iAxis] ) );
+            for( int i = first; i <= last; ++i ){
+                double sourceLow = m_source.origin[iAxis] + i * m_source.cellSize[iAxis];
+                double length = std::min( high, sourceLow + m_source.cellSize[iAxis] ) - std::max( low, sourceLow );
+                if( length > 0.0 )
+                    axisOverlaps[iAxis].push_back( { i, length } );
+            }
+        }
+        for( const std::pair< int, double >& k : axisOverlaps[2] )
+            for( const std::pair< int, double >& j : axisOverlaps[1] )
+                for( const std::pair< int, double >& i : axisOverlaps[0] )
+                    overlaps.push_back( { (unsigned int)( ( k.first * m_source.n[1] + j.first ) * m_source.n[0] + i.first ),
+                                          i.second * j.second * k.second } );
+    });
+}
+
+RegriddingEngine::RegriddingEngine(CartesianGrid *source, GeoGrid *target, unsigned int nThreads) :
+    m_nThreads( nThreads > 0 ? nThreads : std::max( 1u, std::thread::hardware_concurrency() ) )
+{
+    setSource( source );
+
+    //the mesh is only read by the threads
+    uint nTargetCells = target->getMeshNumberOfCells(); //this loads the mesh if necessary
+
+    computeOverlaps( nTargetCells, [&]( size_t targetCellIndex, Overlaps& overlaps ){
+        //get the vertexes of the cell, relative to the first one for numerical accuracy
+        uint vIds[8];
+        target->getMeshCellDefinition( targetCellIndex, vIds );
+        double reference[3];
+        target->getMeshVertexLocation( vIds[0], reference[0], reference[1], reference[2] );
+        Vector3D vertexes[8];
+        for( int iVertex = 0; iVertex < 8; ++iVertex ){
+            double x, y, z;
+            target->getMeshVertexLocation( vIds[iVertex], x, y, z );
+            vertexes[iVertex] = Vector3D{ x - reference[0], y - reference[1], z - reference[2] };
+        }
+
+        //the source cells that may intersect the hexahedron
+        int first[3], last[3];
+        for( int iAxis = 0; iAxis < 3; ++iAxis ){
+            double low = std::numeric_limits<double>::max();
+            double high = std::numeric_limits<double>::lowest();
+            for( const Vector3D& vertex : vertexes ){
+                double coordinate = ( iAxis == 0 ? vertex.x : ( iAxis == 1 ? vertex.y : vertex.z ) ) + reference[iAxis];
+                low = std::min( low, coordinate );
+                high = std::max( high, coordinate );
+            }
+            first[iAxis] = std::max( 0, (int)std::floor( ( low - m_source.origin[iAxis] ) / m_source.cellSize[iAxis] ) );
+            last[iAxis] = std::min( m_source.n[iAxis] - 1,
+                                    (int)std::floor( ( high - m_source.origin[iAxis] ) / m_source.cellSize[iAxis] ) );
+            if( first[iAxis] > last[iAxis] )
+                return; //the cell is outside the source grid
+        }
+        //the outward planes of the faces of the hexahedron: a box inside all of them is inside the hexahedron
+        //(even if it is not convex), so most source cells of a fine grid need no clipping
+        Vector3D normals[12];
+        double offsets[12];
+        for( int iTriangle = 0; iTriangle < 12; ++iTriangle ){
+            const int (&triangle)[4] = HEXAHEDRON_TRIANGLES[iTriangle];
+            makePlane( vertexes[triangle[0]], vertexes[triangle[1]], vertexes[triangle[2]], vertexes[triangle[3]],
+                       normals[iTriangle], offsets[iTriangle] );
+        }
+
+        //the tetrahedra the hexahedron is split into
+        Tetrahedron tetrahedra[6];
+        for( int iTetrahedron = 0; iTetrahedron < 6; ++iTetrahedron ){
+            const int (&tetrahedron)[4] = HEXAHEDRON_TETRAHEDRA[iTetrahedron];
+            tetrahedra[iTetrahedron].set( vertexes[tetrahedron[0]], vertexes[tetrahedron[1]],
+                                          vertexes[tetrahedron[2]], vertexes[tetrahedron[3]] );
+        }
+
+        double boxVolume = m_source.cellSize[0] * m_source.cellSize[1] * m_source.cellSize[2];
+        for( int k = first[2]; k <= last[2]; ++k )
+            for( int j = first[1]; j <= last[1]; ++j ){
+                //along a row, the largest value of normal . x over a box's corners is linear in i, so the range
+                //of boxes inside all the planes is found without testing each box
+                double rowMin[3] = { m_source.origin[0] + first[0] * m_source.cellSize[0] - reference[0],
+                                     m_source.origin[1] + j * m_source.cellSize[1] - reference[1],
+                                     m_source.origin[2] + k * m_source.cellSize[2] - reference[2] };
+                double rowMax[3] = { rowMin[0] + m_source.cellSize[0],
+                                     rowMin[1] + m_source.cellSize[1],
+                                     rowMin[2] + m_source.cellSize[2] };
+                double insideFirst = first[0];
+                double insideLast = last[0];
+                for( int iTriangle = 0; iTriangle < 12; ++iTriangle ){
+                    double low, high;
+                    getExtent( normals[iTriangle], rowMin, rowMax, low, high );
+                    double slope = normals[iTriangle].x * m_source.cellSize[0];
+                    double margin = offsets[iTriangle] - high; //inside if margin - slope * ( i - first ) >= 0
+                    if( slope > 0.0 )
+                        insideLast = std::min( insideLast, first[0] + std::floor( margin / slope ) );
+                    else if( slope < 0.0 )
+                        insideFirst = std::max( insideFirst, first[0] + std::ceil( margin / slope ) );
+                    else if( margin < 0.0 )
+                        insideLast = insideFirst - 1;
+                }
+
+                for( int i = first[0]; i <= last[0]; ++i ){
+                    double volume = 0.0;
+                    if( i >= insideFirst && i <= insideLast )
+                        volume = boxVolume;
+                    else {
+                        double boxMin[3] = { rowMin[0] + ( i - first[0] ) * m_source.cellSize[0], rowMin[1], rowMin[2] };
+                        double boxMax[3] = { boxMin[0] + m_source.cellSize[0], rowMax[1], rowMax[2] };
+                        for( const Tetrahedron& tetrahedron : tetrahedra )
+                            volume += getOverlap( tetrahedron, boxMin, boxMax );
+                    }
+                    if( volume > 0.0 )
+                        overlaps.push_back( { (unsigned int)( ( k * m_source.n[1] + j ) * m_source.n[0] + i ), volume } );
+                }
+            }
+    });
+}
+
+std::vector<double> RegriddingEngine::apply(const std::vector<double> &sourceValues, Average average, double power) const
+{
+    return apply( std::vector< std::vector<double> >{ sourceValues }, average, power ).front();
+}
+
+std::vector<std::vector<double> > RegriddingEngine::apply(const std::vector<std::vector<double> > &sourceValues,
+                                                          Average average, double power) const
+{
+    size_t nTargetCells = getNumberOfTargetCells();
+    std::vector< std::vector<double> > result( sourceValues.size(),
+                                               std::vector<double>( nTargetCells,
+                                                                    std::numeric_limits<double>::quiet_NaN() ) );
+
+    size_t nBlocks = ( nTargetCells + TARGET_CELLS_PER_BLOCK - 1 ) / TARGET_CELLS_PER_BLOCK;
+    std::atomic<size_t> nextBlock( 0 );
+    auto worker = [&](){
+        std::vector< std::pair< double, double > > modeWeights;
+        while( true ){
+            size_t iBlock = nextBlock++;
+            if( iBlock >= nBlocks )
+                break;
+            size_t end = std::min( nTargetCells, ( iBlock + 1 ) * TARGET_CELLS_PER_BLOCK );
+            for( size_t iTarget = iBlock * TARGET_CELLS_PER_BLOCK; iTarget < end; ++iTarget )
+                for( size_t iAttribute = 0; iAttribute < sourceValues.size(); ++iAttribute ){
+                    const std::vector<double>& values = sourceValues[iAttribute];
+                    double sumWeights = 0.0;
+                    double sum = 0.0;
+                    bool hasZero = false;
+                    modeWeights.clear();
+                    for( size_t iOverlap = m_offsets[iTarget]; iOverlap < m_offsets[iTarget + 1]; ++iOverlap ){
+                        double value = values[ m_sourceIndexes[iOverlap] ];
+                        double weight = m_volumes[iOverlap];
+                        if( ! std::isfinite( value ) )
+                            continue;
+                        switch( average ){
+                        case Average::ARITHMETIC:
+                            sum += weight * value;
+                            break;
+                        case Average::HARMONIC:
+                        case Average::GEOMETRIC:
+                            //these are not defined for negative values
+                            if( value < 0.0 )
+                                continue;
+                            if( value == 0.0 )
+                                hasZero = true;
+                            else
+                                sum += average == Average::HARMONIC ? weight / value : weight * std::log( value );
+                            break;
+                        case Average::POWER:
+                        {
+                            double term = std::pow( value, power );
+                            if( ! std::isfinite( term ) )
+                                continue;
+                            sum += weight * term;
+                            break;
+                        }
+                        case Average::MODE:
+                        {
+                            auto it = std::find_if( modeWeights.begin(), modeWeights.end(),
+                                                    [value]( const std::pair< double, double >& valueWeight ){
+                                                        return valueWeight.first == value; } );
+                            if( it == modeWeights.end() )
+                                modeWeights.push_back( { value, weight } );
+                            else
+                                it->second += weight;
+                            break;
+                        }
+                        }
+                        sumWeights += weight;
+                    }
+                    if( sumWeights <= 0.0 )
+                        continue;
+                    double& targetValue = result[iAttribute][iTarget];
+                    switch( average ){
+                    case Average::ARITHMETIC: targetValue = sum / sumWeights; break;
+                    case Average::HARMONIC:   targetValue = hasZero ? 0.0 : sumWeights / sum; break;
+                    case Average::GEOMETRIC:  targetValue = hasZero ? 0.0 : std::exp( sum / sumWeights ); break;
+                    case Average::POWER:      targetValue = std::pow( sum / sumWeights, 1.0 / power ); break;
+                    case Average::MODE:
+                        targetValue = std::max_element( modeWeights.begin(), modeWeights.end(),
+                                                        []( const std::pair< double, double >& a,
+                                                            const std::pair< double, double >& b ){
+                                                            return a.second < b.second; } )->first;
+                        break;
+                    }
+                }
+        }
+    };
+
+    unsigned int nThreads = std::min<size_t>( m_nThreads, nBlocks );
+    std::vector< std::thread > threads;
+    for( unsigned int iThread = 1; iThread < nThreads; ++iThread )
+        threads.emplace_back( worker );
+    worker();
+    for( std::thread& thread : threads )
+        thread.join();
+
+    return result;
+}
+
+void RegriddingEngine::setSource(CartesianGrid *source)
+{
+    m_source.origin[0] = source->getX0() - source->getDX() / 2;
+    m_source.origin[1] = source->getY0() - source->getDY() / 2;
+    m_source.origin[2] = source->getZ0() - source->getDZ() / 2;
+    m_source.cellSize[0] = source->getDX();
+    m_source.cellSize[1] = source->getDY();
+    m_source.cellSize[2] = source->getDZ();
+    m_source.n[0] = source->getNX();
+    m_source.n[1] = source->getNY();
+    m_source.n[2] = source->getNZ();
+}
@@ -0,0 +1,94 @@
+#ifndef REGRIDDINGENGINE_H
+#define REGRIDDINGENGINE_H
+
+#include <vector>
+#include <cstddef>
+
+class CartesianGrid;
+class GeoGrid;
+
+/**
+ * The RegriddingEngine class transfers values from the cells of a Cartesian grid (the source) to the cells of
+ * another grid (the target) by averaging the source cells each target cell overlaps, weighted by the volumes of
+ * the overlaps (e.g. upscaling of a fine geomodel to a flow simulation grid).  The overlaps are computed exactly
+ * and only once, in the constructor, so they can be reused for any number of attributes and realizations:
+ * - Cartesian target: the overlap of two boxes is the product of the overlaps along each axis.
+ * - GeoGrid target: each hexahedron is split into six tetrahedra.  The source cells fully inside the hexahedron
+ *   are found row by row without testing each cell.  Only the remaining ones (near the faces) are intersected
+ *   with the tetrahedra, which are clipped by the planes of the cells' boxes into smaller tetrahedra.
+ *   This is exact for cells with planar faces.  Otherwise the faces are taken as pairs of triangles, like
+ *   in Hexahedron::getVolume().
+ * Both the overlaps and the averages are computed in parallel.  The Cartesian grids must not be rotated (same
+ * as CartesianGrid::XYZtoIJK()).  This class has no GUI dependencies.
+ */
+class RegriddingEngine
+{
+public:
+
+    /** The averages of the values of the source cells overlapped by a target cell. */
+    enum class Average : int {
+        ARITHMETIC, //!< sum( w*v ) / sum( w )
+        HARMONIC,   //!< sum( w ) / sum( w/v ), zero if any v is zero (e.g. permeability across a barrier).
+        GEOMETRIC,  //!< exp( sum( w*ln(v) ) / sum( w ) ), zero if any v is zero.
+        POWER,      //!< ( sum( w*v^p ) / sum( w ) )^(1/p).
+        MODE        //!< the value with the largest sum of weights (for categorical attributes).
+    };
+
+    /**
+     * Computes the overlaps between the cells of a Cartesian grid and the cells of another Cartesian grid.
+     * @param nThreads Number of threads to use.  If zero, the number of logical CPUs is used.
+     */
+    RegriddingEngine( CartesianGrid* source, CartesianGrid* target, unsigned int nThreads = 0 );
+
+    /**
+     * Computes the overlaps between the cells of a Cartesian grid and the cells of a GeoGrid.  The mesh of
+     * the GeoGrid is loaded if necessary.
+     * @param nThreads Number of threads to use.  If zero, the number of logical CPUs is used.
+     */
+    RegriddingEngine( CartesianGrid* source, GeoGrid* target, unsigned int nThreads = 0 );
+
+    /** Returns the number of target cells. */
+    size_t getNumberOfTargetCells() const { return m_offsets.size() - 1; }
+
+    /**
+     * Averages source values into the target cells.
+     * @param sourceValues The values of the source cells, by cell index (data line).  Values that are not
+     *                     finite (e.g. NaN) are ignored, so no-data values must be replaced with NaN.
+     * @param power The exponent of the Average::POWER average.  It must not be zero.
+     * @return The values of the target cells, NaN for cells overlapping no source value.
+     */
+    std::vector<double> apply( const std::vector<double>& sourceValues, Average average, double power = 1.0 ) const;
+
+    /** Same as the other apply(), but for several attributes at once. */
+    std::vector< std::vector<double> > apply( const std::vector< std::vector<double> >& sourceValues,
+                                              Average average, double power = 1.0 ) const;
+
+private:
+    /** The geometry of the source grid (the lower corner of the first cell and the cell sizes). */
+    struct SourceGeometry{
+        double origin[3];
+        double cellSize[3];
+        int n[3];
+    };
+
+    /** The overlaps of a target cell with the source cells. */
+    typedef std::vector< std::pair< unsigned int, double > > Overlaps;
+
+    /** Runs the task for all the target cells in parallel and stores the overlaps in the CSR arrays. */
+    template< typename Task >
+    void computeOverlaps( size_t nTargetCells, Task task );
+
+    /** Sets the source geometry. */
+    void setSource( CartesianGrid* source );
+
+    unsigned int m_nThreads;
+    SourceGeometry m_source;
+
+    //the overlaps in compressed sparse row layout: the overlaps of target cell t are in
+    //[ m_offsets[t], m_offsets[t+1] ) of m_sourceIndexes and m_volumes.
+    std::vector< size_t > m_offsets;
+    std::vector< unsigned int > m_sourceIndexes;
+    std::vector< double > m_volumes;
+};
+
+#endif // REGRIDDINGENGINE_H
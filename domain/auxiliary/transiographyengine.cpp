@@ -0,0 +1,158 @@
+#include "transiographyengine.h"
+#include "domain/segmentset.h"
+#include "domain/categorydefinition.h"
+#include "domain/attribute.h"
+
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+
+/** Category index of segments without a value (they are skipped like gaps). */
+static const int NO_VALUE = -2;
+
+/** Category index of segments whose facies code is not in the CategoryDefinition (transitions from or to them
+ *  are not counted). */
+static const int UNKNOWN_CATEGORY = -1;
+
+/** Category index meaning that no facies has been read yet along a trajectory. */
+static const int NO_PREVIOUS = -3;
+
+/** The number of (separation, trajectory) pairs processed by a thread at a time. */
+static const size_t PAIRS_PER_BLOCK = 16;
+
+TransiographyEngine::TransiographyEngine(int nCategories, unsigned int nThreads) :
+    m_nCategories( nCategories ),
+    m_nThreads( nThreads > 0 ? nThreads : std::max( 1u, std::thread::hardware_concurrency() ) )
+{
+}
+
+bool TransiographyEngine::addTrajectory(SegmentSet *segmentSet, int variableIndex)
+{
+    segmentSet->loadData();
+
+    CategoryDefinition* cd = segmentSet->getCategoryDefinition(
+                                 segmentSet->getAttributeFromGEOEASIndex( variableIndex + 1 ) );
+    if( ! cd )
+        return false;
+    cd->readFromFS();
+    if( cd->getCategoryCount() != m_nCategories )
+        return false;
+
+    //the category index of each facies code found (CategoryDefinition::getCategoryIndex() is a linear search)
+    std::unordered_map< int, int > categoryIndexes;
+
+    Trajectory trajectory;
+    uint nSegments = segmentSet->getDataLineCount();
+    trajectory.starts.reserve( nSegments );
+    trajectory.ends.reserve( nSegments );
+    trajectory.categoryIndexes.reserve( nSegments );
+    //the distances are accumulated in the same order as in the FTMMakerAdapters for SegmentSet, so the
+    //samples fall in the same segments
+    double distanceBeforeCurrentSegment = 0.0;
+    for( uint iSegment = 0; iSegment < nSegments; ++iSegment ){
+        double segmentLength = segmentSet->getSegmentLenght( iSegment );
+        trajectory.starts.push_back( distanceBeforeCurrentSegment );
+        trajectory.ends.push_back( distanceBeforeCurrentSegment + segmentLength );
+        distanceBeforeCurrentSegment += segmentLength + segmentSet->getDistanceToNextSegment( iSegment );
+
+        double value = segmentSet->data( iSegment, variableIndex );
+        int categoryIndex = NO_VALUE;
+        if( std::isfinite( value ) ){
+            int faciesCode = static_cast<int>( value );
+            std::unordered_map< int, int >::iterator it = categoryIndexes.find( faciesCode );
+            if( it == categoryIndexes.end() )
+                it = categoryIndexes.insert( { faciesCode, cd->getCategoryIndex( faciesCode ) } ).first;
+            categoryIndex = it->second < 0 ? UNKNOWN_CATEGORY : it->second;
+        }
+        trajectory.categoryIndexes.push_back( categoryIndex );
+    }
+    trajectory.length = distanceBeforeCurrentSegment;
+
+    m_trajectories.push_back( std::move( trajectory ) );
+    return true;
+}
+
+std::vector<std::vector<long long> > TransiographyEngine::computeCounts(const std::vector<double> &separations,
+                                                                        double toleranceCoefficient) const
+{
+    size_t matrixSize = (size_t)m_nCategories * m_nCategories;
+    size_t nSeparations = separations.size();
+    size_t nPairs = nSeparations * m_trajectories.size();
+    size_t nBlocks = ( nPairs + PAIRS_PER_BLOCK - 1 ) / PAIRS_PER_BLOCK;
+
+    //each thread accumulates its own counts, which are summed at the end
+    unsigned int nThreads = std::max<size_t>( 1, std::min<size_t>( m_nThreads, nBlocks ) );
+    std::vector< std::vector< long long > > threadCounts( nThreads,
+                                                          std::vector< long long >( nSeparations * matrixSize, 0 ) );
+    std::atomic<size_t> nextBlock( 0 );
+    auto worker = [&]( unsigned int iThread ){
+        std::vector< long long >& counts = threadCounts[iThread];
+        while( true ){
+            size_t iBlock = nextBlock++;
+            if( iBlock >= nBlocks )
+                break;
+            size_t end = std::min( nPairs, ( iBlock + 1 ) * PAIRS_PER_BLOCK );
+            for( size_t iPair = iBlock * PAIRS_PER_BLOCK; iPair < end; ++iPair ){
+                size_t iSeparation = iPair / m_trajectories.size();
+                double h = separations[iSeparation];
+                countAlongTrajectory( m_trajectories[ iPair % m_trajectories.size() ], h, toleranceCoefficient * h,
+                                      counts.data() + iSeparation * matrixSize );
+            }
+        }
+    };
+
+    std::vector< std::thread > threads;
+    for( unsigned int iThread = 1; iThread < nThreads; ++iThread )
+        threads.emplace_back( worker, iThread );
+    worker( 0 );
+    for( std::thread& thread : threads )
+        thread.join();
+
+    std::vector< std::vector< long long > > result( nSeparations, std::vector< long long >( matrixSize, 0 ) );
+    for( const std::vector< long long >& counts : threadCounts )
+        for( size_t iSeparation = 0; iSeparation < nSeparations; ++iSeparation )
+            for( size_t i = 0; i < matrixSize; ++i )
+                result[iSeparation][i] += counts[ iSeparation * matrixSize + i ];
+    return result;
+}
+
+int TransiographyEngine::findSegment(const Trajectory &trajectory, double distance, double tolerance) const
+{
+    //the first segment containing a distance is the first one ending at or after it, if it starts before it
+    auto findContaining = [&trajectory]( double distance ){
+        size_t i = std::lower_bound( trajectory.ends.begin(), trajectory.ends.end(), distance ) - trajectory.ends.begin();
+        if( i < trajectory.ends.size() && trajectory.starts[i] <= distance )
+            return (int)i;
+        return -1;
+    };
+    int before = findContaining( distance - tolerance );
+    int after = findContaining( distance + tolerance );
+    if( before < 0 )
+        return after;
+    if( after < 0 )
+        return before;
+    return std::min( before, after );
+}
+
+void TransiographyEngine::countAlongTrajectory(const Trajectory &trajectory, double h, double tolerance,
+                                               long long *counts) const
+{
+    if( h <= 0.0 )
+        return;
+    //traverse trajectory in steps of size h counting facies transitions
+    //from end (early in geologic time) to begining (late in geologic time).
+    int previousCategoryIndex = NO_PREVIOUS;
+    for( double distance = trajectory.length; distance >= 0.0; distance -= h ){
+        int iSegment = findSegment( trajectory, distance, tolerance );
+        if( iSegment < 0 )
+            continue;
+        int categoryIndex = trajectory.categoryIndexes[iSegment];
+        if( categoryIndex == NO_VALUE )
+            continue;
+        if( previousCategoryIndex >= 0 && categoryIndex >= 0 )
+            ++counts[ previousCategoryIndex * m_nCategories + categoryIndex ];
+        previousCategoryIndex = categoryIndex;
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef TRANSIOGRAPHYENGINE_H
+#define TRANSIOGRAPHYENGINE_H
+
+#include <vector>
+
+class SegmentSet;
+
+/**
+ * The TransiographyEngine class counts facies transitions along the trajectories of segment sets (e.g. drill holes)
+ * for many separations (h) at once.  It gives the same counts as FaciesTransitionMatrixMaker::makeAlongTrajectory()
+ * called for each segment set and each separation, but:
+ * - The trajectories are prepared only once, when added: the distances from the beginning of the trajectory to the
+ *   start and to the end of each segment (cumulative lengths) and the category index of each segment.  So sampling
+ *   a trajectory at a distance is a binary search instead of summing the lengths of all the previous segments.
+ * - The counts are accumulated in plain integer matrices indexed by category index (same order as the rows and
+ *   columns of a FaciesTransitionMatrix after FaciesTransitionMatrix::initialize()).
+ * - All the pairs of separation and trajectory are processed in parallel.
+ * Adding trajectories must be done in the GUI thread (data files are loaded and messages may be logged).
+ */
+class TransiographyEngine
+{
+public:
+    /**
+     * @param nCategories The number of categories of the CategoryDefinition of the categorical variables.
+     * @param nThreads Number of threads to use.  If zero, the number of logical CPUs is used.
+     */
+    explicit TransiographyEngine( int nCategories, unsigned int nThreads = 0 );
+
+    /**
+     * Prepares the trajectory formed by the segments of a segment set, in file order.  The data are loaded if
+     * necessary.  Returns false if the variable is not categorical or if its CategoryDefinition does not have
+     * the number of categories passed in the constructor (the trajectory is then ignored).
+     * @param variableIndex The index of the categorical variable (GEO-EAS index - 1).
+     */
+    bool addTrajectory( SegmentSet* segmentSet, int variableIndex );
+
+    /**
+     * Counts the facies transitions at each separation in all the trajectories.  The trajectories are traversed
+     * from their ends (early in geologic time) to their beginnings (late in geologic time), like in
+     * FaciesTransitionMatrixMaker::makeAlongTrajectory().
+     * @param toleranceCoefficient The tolerance used for each separation is this coefficient times the separation.
+     * @return The transition counts for each separation, as row-major nCategories x nCategories matrices (from
+     *         the category of a row to the category of a column).
+     */
+    std::vector< std::vector< long long > > computeCounts( const std::vector<double>& separations,
+                                                           double toleranceCoefficient ) const;
+
+private:
+    /** The geometry and the facies of the segments of a trajectory. */
+    struct Trajectory{
+        std::vector<double> starts; //distances from the beginning of the trajectory to the start of each segment
+        std::vector<double> ends;   //distances from the beginning of the trajectory to the end of each segment
+        std::vector<int> categoryIndexes; //see the constants in the cpp source file
+        double length;
+    };
+
+    /** Returns the index of the first segment containing the distance plus or minus the tolerance or -1. */
+    int findSegment( const Trajectory& trajectory, double distance, double tolerance ) const;
+
+    /** Adds the transitions at separation h along a trajectory to the counts (an nCategories x nCategories matrix). */
+    void countAlongTrajectory( const Trajectory& trajectory, double h, double tolerance, long long* counts ) const;
+
+    int m_nCategories;
+    unsigned int m_nThreads;
+    std::vector< Trajectory > m_trajectories;
+};
+
+#endif // TRANSIOGRAPHYENGINE_H
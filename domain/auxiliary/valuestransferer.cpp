@@ -6,22 +6,33 @@
 #include "domain/geogrid.h"
 #include "domain/cartesiangrid.h"
 #include "domain/pointset.h"
+#include "util.h"
 
 #include <QProgressDialog>
 #include <QApplication>
 #include <iostream>
+#include <limits>
 
 ValuesTransferer::ValuesTransferer(const QString newAttributeName,
                                    DataFile *dfDestination,
                                    const Attribute *atOrigin) :
     m_newAttributeName( newAttributeName ),
     m_dfDestination( dfDestination ),
-    m_atOrigin( atOrigin )
-
+    m_atOrigin( atOrigin ),
+    m_upscaling( false ),
+    m_average( RegriddingEngine::Average::ARITHMETIC ),
+    m_power( 1.0 )
 {
 
 }
 
+void ValuesTransferer::setUpscaling(RegriddingEngine::Average average, double power)
+{
+    m_upscaling = true;
+    m_average = average;
+    m_power = power;
+}
+
 bool ValuesTransferer::transfer()
 {
     DataFile* dfDest = m_dfDestination;
@@ -61,6 +72,15 @@ bool ValuesTransferer::transferFromCGtoGG()
     ggDest->loadData();
     ggDest->loadMesh();
 
+    if( m_upscaling ){
+        if( ! Util::almostEqual2sComplement( cgOrig->getRot(), 0.0, 1 ) ){
+            Application::instance()->logError("ValuesTransferer::transferFromCGtoGG(): rotated Cartesian grids not supported for upscaling.");
+            return false;
+        }
+        RegriddingEngine regriddingEngine( cgOrig, ggDest );
+        return transferByRegridding( cgOrig, regriddingEngine );
+    }
+
     //get some data information
     uint rowCount = ggDest->getDataLineCount();
     uint atIndex = m_atOrigin->getAttributeGEOEASgivenIndex()-1;
@@ -115,6 +135,9 @@ bool ValuesTransferer::transferFromCGtoPS()
     cgOrig->loadData();
     psDest->loadData();
 
+    if( m_upscaling )
+        Application::instance()->logWarn("ValuesTransferer::transferFromCGtoPS(): point sets have no volume.  Transferring collocated values.");
+
     //get some data information
     uint rowCount = psDest->getDataLineCount();
     uint atIndex = m_atOrigin->getAttributeGEOEASgivenIndex()-1;
@@ -174,6 +197,16 @@ bool ValuesTransferer::transferFromCGtoCG()
     cgOrig->loadData();
     cgDest->loadData();
 
+    if( m_upscaling ){
+        if( ! Util::almostEqual2sComplement( cgOrig->getRot(), 0.0, 1 ) ||
+            ! Util::almostEqual2sComplement( cgDest->getRot(), 0.0, 1 ) ){
+            Application::instance()->logError("ValuesTransferer::transferFromCGtoCG(): rotated Cartesian grids not supported for upscaling.");
+            return false;
+        }
+        RegriddingEngine regriddingEngine( cgOrig, cgDest );
+        return transferByRegridding( cgOrig, regriddingEngine );
+    }
+
     //get some data information
     uint rowCount = cgDest->getDataLineCount();
     uint atIndex = m_atOrigin->getAttributeGEOEASgivenIndex()-1;
@@ -219,3 +252,36 @@ bool ValuesTransferer::transferFromCGtoCG()
 
     return true;
 }
+
+bool ValuesTransferer::transferByRegridding(CartesianGrid *cgOrig, const RegriddingEngine &regriddingEngine)
+{
+    //categorical values can only be transferred as the most frequent category
+    Attribute* atOrigin = const_cast<Attribute*>( m_atOrigin );
+    CategoryDefinition* cd = nullptr;
+    RegriddingEngine::Average average = m_average;
+    if( cgOrig->isCategorical( atOrigin ) ){
+        cd = cgOrig->getCategoryDefinition( atOrigin );
+        average = RegriddingEngine::Average::MODE;
+    }
+
+    //the source values, with no-data values as NaN (they are ignored by the averages)
+    uint atIndex = m_atOrigin->getAttributeGEOEASgivenIndex()-1;
+    std::vector< double > sourceValues = cgOrig->getDataColumn( atIndex );
+    sourceValues.resize( (size_t)cgOrig->getNX() * cgOrig->getNY() * cgOrig->getNZ(),
+                         std::numeric_limits<double>::quiet_NaN() );
+    for( double& value : sourceValues )
+        if( cgOrig->isNDV( value ) )
+            value = std::numeric_limits<double>::quiet_NaN();
+
+    //destination cells overlapping no valid source value get the no-data value
+    std::vector< double > averagedValues = regriddingEngine.apply( sourceValues, average, m_power );
+    double NDVofDest = m_dfDestination->getNoDataValueAsDouble();
+    for( double& value : averagedValues )
+        if( ! std::isfinite( value ) )
+            value = NDVofDest;
+
+    //adds the averaged values a new attribute to the destination data file
+    m_dfDestination->addNewDataColumn( m_newAttributeName, averagedValues, cd );
+
+    return true;
+}
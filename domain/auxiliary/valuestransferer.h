@@ -2,15 +2,19 @@
 #define VALUESTRANSFERER_H
 
 #include <QString>
+#include "domain/auxiliary/regriddingengine.h"
 
 class DataFile;
 class Attribute;
 class GeoGrid;
+class CartesianGrid;
 
 /**
  * This class is used to perform a transfer of values between data sets.  The transfer is done in spatial domain (XYZ).
  * Support, accuracy and methods for this operation is heavily dependant on the implementations
  * in the several derived classes.
+ * By default, the values are collocated (the source value at the center of each destination cell or sample).
+ * See setUpscaling() to average the source cells overlapped by each destination cell instead.
  */
 class ValuesTransferer
 {
@@ -19,6 +23,15 @@ public:
                       DataFile* dfDestination,
                       const Attribute* atOrigin );
 
+    /**
+     * Makes the transfer to a grid destination (Cartesian grid or GeoGrid) an average of the source cells
+     * overlapped by each destination cell, weighted by the volumes of the overlaps (see RegriddingEngine).
+     * Categorical attributes are always transferred with RegriddingEngine::Average::MODE.
+     * Transfers to point sets remain collocated.
+     * @param power The exponent of RegriddingEngine::Average::POWER.
+     */
+    void setUpscaling( RegriddingEngine::Average average, double power = 1.0 );
+
     /** Performs the transfer. Returns false if the transfer fails for any reason. */
     bool transfer();
 
@@ -26,10 +39,16 @@ private:
     QString m_newAttributeName;
     DataFile* m_dfDestination;
     const Attribute* m_atOrigin;
+    bool m_upscaling;
+    RegriddingEngine::Average m_average;
+    double m_power;
 
     bool transferFromCGtoGG();
     bool transferFromCGtoPS();
     bool transferFromCGtoCG();
+
+    /** Averages the values of the source grid into the destination with the given overlaps. */
+    bool transferByRegridding( CartesianGrid* cgOrig, const RegriddingEngine& regriddingEngine );
 };
 
 #endif // VALUESTRANSFERER_H
@@ -19,6 +19,7 @@
 #include <QRegularExpression>
 #include <QTextStream>
 #include <QtConcurrent/QtConcurrent>
+#include <algorithm>
 #include <cmath>
 #include <iomanip> // std::setprecision
 #include <limits>
@@ -428,10 +429,43 @@ void DataFile::writeToFS()
         return;
     }
 
+    writeDataToFile( this->getPath(), nullptr );
+
+    // updates properties list so any changes appear in the project tree.
+    updateChildObjectsCollection();
+    // update the project tree in the main window.
+    Application::instance()->refreshProjectTree();
+}
+
+bool DataFile::writeFilteredToFS(const QString path, const std::vector<bool> &linesToWrite)
+{
+    if( _data.size() <= 0 ){
+        Application::instance()->logError("DataFile::writeFilteredToFS(): No data. Save failed.");
+        return false;
+    }
+
+    if( isSetToBePaged() ){
+        Application::instance()->logError("DataFile::writeFilteredToFS(): Paged data files not currently supported in saving operation. Save failed.");
+        return false;
+    }
+
+    if( linesToWrite.size() != _data.size() ){
+        Application::instance()->logError("DataFile::writeFilteredToFS(): filter size differs from data line count. Save failed.");
+        return false;
+    }
+
+    return writeDataToFile( path, &linesToWrite );
+}
+
+bool DataFile::writeDataToFile(const QString path, const std::vector<bool> *linesToWrite)
+{
     //create a new file for output
-    QFile outputFile( QString( this->getPath() ).append(".new") );
-    if( ! outputFile.open( QFile::WriteOnly | QFile::Text | QFile::Truncate ) )
-        assert( false && "DataFile::writeToFS(): Could not open ASCII file for writing.");
+    QFile outputFile( QString( path ).append(".new") );
+    if( ! outputFile.open( QFile::WriteOnly | QFile::Text | QFile::Truncate ) ){
+        assert( false && "DataFile::writeDataToFile(): Could not open ASCII file for writing.");
+        Application::instance()->logError("DataFile::writeDataToFile(): Could not open " + outputFile.fileName() + " for writing.");
+        return false;
+    }
 
     std::ostringstream out;
     out.precision( 12 );
@@ -475,7 +509,7 @@ void DataFile::writeToFS()
     }
 
     if (control != nvars) {
-        Application::instance()->logWarn("WARNING: DataFile::writeToFS(): mismatch "
+        Application::instance()->logWarn("WARNING: DataFile::writeDataToFile(): mismatch "
                                          "between data column count (" + QString::number(nvars) +
                                          ") and Attribute object "
                                          "count (" + QString::number(control) + ").");
@@ -494,7 +528,7 @@ void DataFile::writeToFS()
     progressDialog.setValue( 0 );
     progressDialog.setMaximum( getDataLineCount() );
     QThread* thread = new QThread();  //does it need to set parent (a QObject)?
-    DataSaver* ds = new DataSaver( _data, out );  // Do not set a parent. The object cannot be moved if it has a parent.
+    DataSaver* ds = new DataSaver( _data, out, linesToWrite );  // Do not set a parent. The object cannot be moved if it has a parent.
     ds->moveToThread(thread);
     ds->connect(thread, SIGNAL(finished()), ds, SLOT(deleteLater()));
     ds->connect(thread, SIGNAL(started()), ds, SLOT(doSave()));
@@ -509,20 +543,22 @@ void DataFile::writeToFS()
         QCoreApplication::processEvents(); //let Qt repaint widgets
     }
 
-    outputFile.write( out.str().data(), out.str().length() );
+    const std::string contents = out.str();
+    bool ok = outputFile.write( contents.data(), contents.length() ) == (qint64)contents.length();
 
     // close output file
     outputFile.close();
+    if( ! ok || outputFile.error() != QFileDevice::NoError ){
+        Application::instance()->logError("DataFile::writeDataToFile(): Could not write " + outputFile.fileName() + ".  The current file was kept.");
+        outputFile.remove();
+        return false;
+    }
 
     // deletes the current file
-    QFile currentFile(this->getPath());
+    QFile currentFile(path);
     currentFile.remove();
     // renames the .new file, effectively replacing the current file.
-    outputFile.rename(this->getPath());
-    // updates properties list so any changes appear in the project tree.
-    updateChildObjectsCollection();
-    // update the project tree in the main window.
-    Application::instance()->refreshProjectTree();
+    return outputFile.rename(path);
 }
 
 ICalcProperty *DataFile::getCalcProperty(int index)
@@ -676,22 +712,31 @@ const std::vector<double> &DataFile::getDataRow(int rowIndex) const
     return _data[rowIndex];
 }
 
-std::vector<std::vector<double> > DataFile::getDataFilteredBy(int variableIndex, double value0, double value1) const
+std::vector<bool> DataFile::getDataLinesFilteredBy(int variableIndex, double value0, double value1) const
 {
-    std::vector< std::vector<double> > result;
+    std::vector<bool> result( _data.size(), false );
 
     if( _data.empty() )
-        Application::instance()->logError("DataFile::getDataFilteredBy(): no data to filter.  Perhaps loading data from the filesystem was not performed.");
+        Application::instance()->logError("DataFile::getDataLinesFilteredBy(): no data to filter.  Perhaps loading data from the filesystem was not performed.");
 
-    for( int i = 0; i < getDataLineCount(); ++i ){
-        double value = dataConst( i, variableIndex );
-        if( ! isNDV( value ) ){
-            if( value >= value0 && value <= value1 ){
-                result.push_back( getDataRow( i ) );
-            }
-        }
+    for( size_t i = 0; i < _data.size(); ++i ){
+        double value = _data[i][variableIndex];
+        result[i] = ! isNDV( value ) && value >= value0 && value <= value1;
     }
 
+    return result;
+}
+
+std::vector<std::vector<double> > DataFile::getDataFilteredBy(int variableIndex, double value0, double value1) const
+{
+    std::vector< std::vector<double> > result;
+
+    std::vector<bool> linesToKeep = getDataLinesFilteredBy( variableIndex, value0, value1 );
+    result.reserve( std::count( linesToKeep.begin(), linesToKeep.end(), true ) );
+    for( size_t i = 0; i < _data.size(); ++i )
+        if( linesToKeep[i] )
+            result.push_back( _data[i] );
+
     if( result.empty() )
         Application::instance()->logWarn("DataFile::getDataFilteredBy(): filtering resulted in an empty data frame.");
 
@@ -1336,3 +1381,26 @@ void DataFile::removeDataLine(uint line)
 {
 	_data.erase( _data.begin() + line );
 }
+
+uint DataFile::removeDataLines(const std::vector<bool> &linesToRemove)
+{
+    //compact the data table in one pass, moving (not copying) the kept lines
+    size_t nKept = 0;
+    for( size_t line = 0; line < _data.size(); ++line )
+        if( line >= linesToRemove.size() || ! linesToRemove[line] ){
+            if( nKept != line )
+                _data[nKept] = std::move( _data[line] );
+            ++nKept;
+        }
+    uint nRemoved = _data.size() - nKept;
+    _data.resize( nKept );
+    return nRemoved;
+}
+
+uint DataFile::removeDataLines(const DataLinePredicate &predicate)
+{
+    std::vector< std::vector<double> >::iterator newEnd = std::remove_if( _data.begin(), _data.end(), predicate );
+    uint nRemoved = _data.end() - newEnd;
+    _data.erase( newEnd, _data.end() );
+    return nRemoved;
+}
@@ -9,6 +9,7 @@
 #include <QDateTime>
 #include <complex>
 #include <memory>
+#include <functional>
 
 class Attribute;
 class UnivariateCategoryClassification;
@@ -349,6 +350,20 @@ public:
 	 */
 	void removeDataLine( uint line );
 
+    /** A criterion on a data line (e.g. to select the lines to remove). */
+    typedef std::function<bool( const std::vector<double>& dataLine )> DataLinePredicate;
+
+    /**
+     * Removes the data lines flagged true from the internal data array in a single pass.  Lines beyond the
+     * size of the mask are kept.  Prefer this to repeated calls to removeDataLine(), which moves all the
+     * following lines each time.  Returns the number of removed lines.
+     * It is necessary to call writeToFS() to commit the change to filesystem.
+     */
+    uint removeDataLines( const std::vector<bool>& linesToRemove );
+
+    /** Same as the other removeDataLines(), but removing the data lines for which the predicate is true. */
+    uint removeDataLines( const DataLinePredicate& predicate );
+
     /** Returns the loaded values for a variable given its column index (GEO-EAS index - 1).
      * May return an empty container if data is not loaded or less elements than records in the
      * physical file if it has been paged (e.g. file with multiple simulation realizations, see
@@ -404,6 +419,20 @@ public:
      */
     std::vector< std::vector<double> > getDataFilteredBy( int variableIndex, double value0, double value1 ) const;
 
+    /**
+     * Returns which data lines pass the filter of getDataFilteredBy() (true) without copying them.
+     * The result can be used with writeFilteredToFS() or, negated, with removeDataLines().
+     */
+    std::vector<bool> getDataLinesFilteredBy( int variableIndex, double value0, double value1 ) const;
+
+    /**
+     * Writes the data lines flagged true to a new GEO-EAS file at the given path, with the same variables
+     * as this file.  This object and its data are not changed and the data table is not copied.
+     * The new data file object can then be created from the written file.
+     * Returns false if nothing was written (no data loaded, paged data, filter size mismatch or I/O error).
+     */
+    bool writeFilteredToFS( const QString path, const std::vector<bool>& linesToWrite );
+
     /**
      * Replaces the internal data frame with a copy of the one passed as parameter.
      * ***CAUTION***: No consistency check is made with the collection of child Attribute objects
@@ -471,6 +500,11 @@ protected:
     /** The pointer to the internal interface to the algorithms' data source (see classes in /algorithms subdirectory). */
     std::shared_ptr<IAlgorithmDataSource> _algorithmDataSourceInterface;
 
+private:
+    /** Writes the data lines (all of them if linesToWrite is null) as a GEO-EAS file at the given path.
+     *  Returns false if the file could not be written. */
+    bool writeDataToFile( const QString path, const std::vector<bool>* linesToWrite );
+
 };
 
 #endif // DATAFILE_H
@@ -8,11 +8,17 @@
 #include <QFile>
 #include <QTextStream>
 #include <cassert>
+#include <algorithm>
+#include <cstdint>
+
+/** Facies codes spanning a larger range are looked up by binary search instead of in a dense table. */
+static const int64_t MAX_DENSE_CODE_SPAN = 1 << 16;
 
 FaciesTransitionMatrix::FaciesTransitionMatrix(QString path,
                                                QString associatedCategoryDefinitionName ) :
     File( path ),
-    m_associatedCategoryDefinitionName( associatedCategoryDefinitionName )
+    m_associatedCategoryDefinitionName( associatedCategoryDefinitionName ),
+    m_lookupMinFaciesCode( 0 )
 {
 
 }
@@ -44,6 +50,7 @@ bool FaciesTransitionMatrix::isUsable()
 void FaciesTransitionMatrix::setInfo(QString associatedCategoryDefinitionName)
 {
     m_associatedCategoryDefinitionName = associatedCategoryDefinitionName;
+    invalidateCodeLookup();
 }
 
 void FaciesTransitionMatrix::setInfoFromMetadataFile()
@@ -94,47 +101,75 @@ void FaciesTransitionMatrix::initialize()
         }
         m_transitionCounts.push_back( lineWithValues );
     }
+
+    //build the tables to find rows and columns by facies code
+    buildCodeLookup();
 }
 
 void FaciesTransitionMatrix::incrementCount(int faciesCodeFrom, int faciesCodeTo)
 {
-    CategoryDefinition* cd = getAssociatedCategoryDefinition();
-    if( cd ){
-        //finds the row index corresponding to the "from facies" code
-        int rowIndex = -1;
-        {
-            QString fromFaciesName = cd->getCategoryNameByCode( faciesCodeFrom );
-            int currentRow = 0;
-            for( const QString& faciesName : m_lineHeadersFaciesNames ){
-                if( faciesName == fromFaciesName ){
-                    rowIndex = currentRow;
-                    break;
-                }
-                ++currentRow;
-            }
-            if( rowIndex < 0 )
-                Application::instance()->logWarn( "FaciesTransitionMatrix::incrementCount(): facies [" + fromFaciesName + "] not found in categorical definition." );
-        }
-        //finds the column index corresponding to the "to facies" code
-        int columnIndex = -1;
-        {
-            QString toFaciesName = cd->getCategoryNameByCode( faciesCodeTo );
-            int currentColumn = 0;
-            for( const QString& faciesName : m_columnHeadersFaciesNames ){
-                if( faciesName == toFaciesName ){
-                    columnIndex = currentColumn;
-                    break;
-                }
-                ++currentColumn;
-            }
-            if( columnIndex < 0 )
-                Application::instance()->logWarn( "FaciesTransitionMatrix::incrementCount(): facies [" + toFaciesName + "] not found in categorical definition." );
-        }
-        //increments the count
+    if( m_rowIndexesByCode.empty() && ! buildCodeLookup() ){
+        Application::instance()->logError( "FaciesTransitionMatrix::incrementCount(): categorical definition no found." );
+        return;
+    }
+    //finds the row index corresponding to the "from facies" code
+    int rowIndex = lookupIndex( m_rowIndexesByCode, faciesCodeFrom );
+    if( rowIndex < 0 )
+        Application::instance()->logWarn( "FaciesTransitionMatrix::incrementCount(): facies [" +
+                                          getAssociatedCategoryDefinition()->getCategoryNameByCode( faciesCodeFrom ) +
+                                          "] not found in categorical definition." );
+    //finds the column index corresponding to the "to facies" code
+    int columnIndex = lookupIndex( m_columnIndexesByCode, faciesCodeTo );
+    if( columnIndex < 0 )
+        Application::instance()->logWarn( "FaciesTransitionMatrix::incrementCount(): facies [" +
+                                          getAssociatedCategoryDefinition()->getCategoryNameByCode( faciesCodeTo ) +
+                                          "] not found in categorical definition." );
+    //increments the count
+    if( columnIndex >= 0 && rowIndex >= 0 )
+        m_transitionCounts[ rowIndex ][ columnIndex ] += 1;
+}
+
+void FaciesTransitionMatrix::incrementCounts(const int *faciesCodesFrom, const int *faciesCodesTo, size_t count)
+{
+    if( m_rowIndexesByCode.empty() && ! buildCodeLookup() ){
+        Application::instance()->logError( "FaciesTransitionMatrix::incrementCounts(): categorical definition no found." );
+        return;
+    }
+    size_t nIgnored = 0;
+    for( size_t i = 0; i < count; ++i ){
+        int rowIndex = lookupIndex( m_rowIndexesByCode, faciesCodesFrom[i] );
+        int columnIndex = lookupIndex( m_columnIndexesByCode, faciesCodesTo[i] );
         if( columnIndex >= 0 && rowIndex >= 0 )
             m_transitionCounts[ rowIndex ][ columnIndex ] += 1;
-    } else
-        Application::instance()->logError( "FaciesTransitionMatrix::incrementCount(): categorical definition no found." );
+        else
+            ++nIgnored;
+    }
+    if( nIgnored )
+        Application::instance()->logWarn( "FaciesTransitionMatrix::incrementCounts(): " + QString::number( nIgnored ) +
+                                          " transition(s) ignored: facies code(s) not found in categorical definition." );
+}
+
+void FaciesTransitionMatrix::incrementCounts(const std::vector<std::pair<int, int> > &transitions)
+{
+    std::vector< int > faciesCodesFrom( transitions.size() );
+    std::vector< int > faciesCodesTo( transitions.size() );
+    for( size_t i = 0; i < transitions.size(); ++i ){
+        faciesCodesFrom[i] = transitions[i].first;
+        faciesCodesTo[i] = transitions[i].second;
+    }
+    incrementCounts( faciesCodesFrom.data(), faciesCodesTo.data(), transitions.size() );
+}
+
+void FaciesTransitionMatrix::incrementCountsAlongSequence(const std::vector<int> &faciesCodes)
+{
+    //the "from" codes are the sequence without its last element and the "to" codes, without its first element
+    if( faciesCodes.size() > 1 )
+        incrementCounts( faciesCodes.data(), faciesCodes.data() + 1, faciesCodes.size() - 1 );
+}
+
+void FaciesTransitionMatrix::addCount(int rowIndex, int columnIndex, double count)
+{
+    m_transitionCounts[ rowIndex ][ columnIndex ] += count;
 }
 
 void FaciesTransitionMatrix::add(const FaciesTransitionMatrix &otherFTM)
@@ -422,12 +457,14 @@ void FaciesTransitionMatrix::removeColumn(int j)
     for( int i = 0; i < m_lineHeadersFaciesNames.size(); ++i )
         m_transitionCounts[i].erase( m_transitionCounts[i].begin() + j );
     m_columnHeadersFaciesNames.erase( m_columnHeadersFaciesNames.begin() + j );
+    invalidateCodeLookup();
 }
 
 void FaciesTransitionMatrix::removeRow(int i)
 {
     m_transitionCounts.erase( m_transitionCounts.begin() + i );
     m_lineHeadersFaciesNames.erase( m_lineHeadersFaciesNames.begin() + i );
+    invalidateCodeLookup();
 }
 
 int FaciesTransitionMatrix::getRowIndexOfCategory(const QString &faciesName) const
@@ -622,6 +659,7 @@ void FaciesTransitionMatrix::clearLoadedContents()
     m_columnHeadersFaciesNames.clear();
     m_lineHeadersFaciesNames.clear();
     m_transitionCounts.clear();
+    invalidateCodeLookup();
 }
 
 bool FaciesTransitionMatrix::isDataFile()
@@ -652,3 +690,70 @@ spectral::array FaciesTransitionMatrix::toSpectralArray()
             A(i,j) = m_transitionCounts[i][j];
     return A;
 }
+
+bool FaciesTransitionMatrix::buildCodeLookup()
+{
+    invalidateCodeLookup();
+    CategoryDefinition* cd = getAssociatedCategoryDefinition();
+    if( ! cd )
+        return false;
+    cd->readFromFS();
+    if( cd->getCategoryCount() == 0 )
+        return true;
+
+    //the codes of the category definition, sorted and without repetitions
+    std::vector< int > codes;
+    for( int i = 0; i < cd->getCategoryCount(); ++i )
+        codes.push_back( cd->getCategoryCode( i ) );
+    std::sort( codes.begin(), codes.end() );
+    codes.erase( std::unique( codes.begin(), codes.end() ), codes.end() );
+
+    //the lookup tables span the range of codes if it is small enough, otherwise they follow the sorted codes
+    //(the span is computed in 64 bits, as codes far apart overflow an int)
+    int64_t span = static_cast<int64_t>( codes.back() ) - static_cast<int64_t>( codes.front() ) + 1;
+    m_lookupMinFaciesCode = codes.front();
+    if( span <= MAX_DENSE_CODE_SPAN ){
+        m_rowIndexesByCode.assign( span, -1 );
+        m_columnIndexesByCode.assign( span, -1 );
+    } else {
+        m_lookupSortedFaciesCodes = codes;
+        m_rowIndexesByCode.assign( codes.size(), -1 );
+        m_columnIndexesByCode.assign( codes.size(), -1 );
+    }
+
+    //a facies code maps to the row/column whose header is the name of the facies
+    for( int code : codes ){
+        QString faciesName = cd->getCategoryNameByCode( code );
+        size_t i = getLookupSlot( code );
+        m_rowIndexesByCode[ i ] = getRowIndexOfCategory( faciesName );
+        m_columnIndexesByCode[ i ] = getColumnIndexOfCategory( faciesName );
+    }
+    return true;
+}
+
+void FaciesTransitionMatrix::invalidateCodeLookup()
+{
+    m_rowIndexesByCode.clear();
+    m_columnIndexesByCode.clear();
+    m_lookupSortedFaciesCodes.clear();
+}
+
+size_t FaciesTransitionMatrix::getLookupSlot(int faciesCode) const
+{
+    if( m_lookupSortedFaciesCodes.empty() )
+        //the subtraction is done in unsigned arithmetic so codes below the minimum are also out of range
+        return static_cast<size_t>( static_cast<unsigned int>( faciesCode ) - static_cast<unsigned int>( m_lookupMinFaciesCode ) );
+    std::vector< int >::const_iterator it = std::lower_bound( m_lookupSortedFaciesCodes.begin(),
+                                                               m_lookupSortedFaciesCodes.end(), faciesCode );
+    if( it == m_lookupSortedFaciesCodes.end() || *it != faciesCode )
+        return m_lookupSortedFaciesCodes.size();
+    return it - m_lookupSortedFaciesCodes.begin();
+}
+
+int FaciesTransitionMatrix::lookupIndex(const std::vector<int> &indexesByCode, int faciesCode) const
+{
+    size_t i = getLookupSlot( faciesCode );
+    if( i >= indexesByCode.size() )
+        return -1;
+    return indexesByCode[ i ];
+}
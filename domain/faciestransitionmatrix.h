@@ -4,6 +4,8 @@
 #include "domain/file.h"
 #include "spectral/spectral.h"
 
+#include <vector>
+
 class CategoryDefinition;
 
 /**
@@ -68,9 +70,35 @@ public:
      * An error is printed to the program's message pane if the CategoryDefinition object
      * this FTM refers to cannot be found for some reason.
      * Nothing happens if the passed code does not exist in the CategoryDefinition.
+     * The codes are resolved to a row and a column with the lookup tables built in initialize(), so
+     * this is cheap enough to be called for each transition.
      */
     void incrementCount( int faciesCodeFrom, int faciesCodeTo );
 
+    /**
+     * Does the same as incrementCount() for many transitions at once: increments the value in this matrix
+     * for each pair ( faciesCodesFrom[i], faciesCodesTo[i] ), i = 0..count-1.  Transitions with codes not in
+     * this matrix are ignored and reported in a single warning message.
+     */
+    void incrementCounts( const int* faciesCodesFrom, const int* faciesCodesTo, size_t count );
+
+    /** Same as the other incrementCounts(), but for a vector of ( from, to ) facies code pairs. */
+    void incrementCounts( const std::vector< std::pair< int, int > >& transitions );
+
+    /**
+     * Increments the values in this matrix for each transition between consecutive facies codes
+     * in a sequence ( faciesCodes[i] -> faciesCodes[i+1] ).  Codes not in this matrix are handled like in
+     * the other incrementCounts().
+     */
+    void incrementCountsAlongSequence( const std::vector< int >& faciesCodes );
+
+    /**
+     * Adds a count to the value in this matrix given a row index and a column index (not facies codes).
+     * This is faster than incrementCount() when the counts have already been made elsewhere by
+     * category index (see TransiographyEngine).
+     */
+    void addCount( int rowIndex, int columnIndex, double count );
+
     /**
      * Adds the values of this matrix with those of the passed FTM.
      * Nothing happens if both FTMs are not compatible for addition like mathematical matrices.
@@ -305,6 +333,29 @@ protected:
     //outer vector: each line; inner vector: each value (columns)
     std::vector< std::vector < double > > m_transitionCounts;
 
+    ///-------------lookup tables to count transitions--------------
+    //the row and the column of each facies code or -1 if the facies is not in the matrix.  Empty if they need to be rebuilt.
+    //If the codes span a small range, the code minus m_lookupMinFaciesCode is the index in the tables.  Otherwise
+    //(e.g. codes 1 and 1000000), the index is the position of the code in m_lookupSortedFaciesCodes.
+    std::vector< int > m_rowIndexesByCode;
+    std::vector< int > m_columnIndexesByCode;
+    int m_lookupMinFaciesCode;
+    std::vector< int > m_lookupSortedFaciesCodes;
+
+    /** (Re)builds the tables used to find the row and the column of a facies code in constant time.
+     * Returns false if the associated CategoryDefinition could not be found.
+     */
+    bool buildCodeLookup();
+
+    /** Clears the lookup tables so they are rebuilt on the next count (e.g. when headers change). */
+    void invalidateCodeLookup();
+
+    /** Returns the position of a facies code in the lookup tables (out of range if the code is not in them). */
+    size_t getLookupSlot( int faciesCode ) const;
+
+    /** Returns the row or column index of a facies code with the lookup tables or -1. */
+    int lookupIndex( const std::vector< int >& indexesByCode, int faciesCode ) const;
+
     spectral::array toSpectralArray();
 };
 
@@ -6,6 +6,7 @@
 #include "spatialindex/spatialindex.h"
 #include "domain/application.h"
 #include "auxiliary/meshloader.h"
+#include "auxiliary/geogridpointlocator.h"
 #include "domain/pointset.h"
 #include "domain/segmentset.h"
 #include "util.h"
@@ -259,48 +260,20 @@ void GeoGrid::saveMesh()
 		return;
 	}
 
-	//close mesh file and write header
-	QFile file( this->getMeshFilePath() );
-	file.open( QFile::WriteOnly | QFile::Text );
-	QTextStream out(&file);
-	out << APP_NAME << " GeoGrid mesh file.  This file is generated automatically.  Do not edit this file.\n";
-	out << "version=" << APP_VERSION << '\n';
-
-	out << "VERTEX LOCATIONS:\n";
-	{
-		std::vector< VertexRecordPtr >::iterator it = m_vertexesPart.begin();
-		for( ; it != m_vertexesPart.end(); ++it ){
-			//making sure the values are written in GSLib-like precision
-			std::stringstream ss;
-			ss << std::setprecision( 12 ) << (*it)->X << ';';
-			ss << std::setprecision( 12 ) << (*it)->Y << ';';
-			ss << std::setprecision( 12 ) << (*it)->Z ;
-			out << ss.str().c_str() << '\n';
-		}
-	}
-
-	out << "CELL VERTEX INDEXES:\n";
-	{
-		std::vector< CellDefRecordPtr >::iterator it = m_cellDefsPart.begin();
-		for( ; it != m_cellDefsPart.end(); ++it ){
-			std::stringstream ss;
-			for( int i = 0; i < 7; ++i)
-				ss << (*it)->vId[i] << ';';
-			ss << (*it)->vId[7];
-			out << ss.str().c_str() << "\n";
-		}
+	//write the mesh in binary format (see MeshLoader)
+	if( ! MeshLoader::saveBinary( this->getMeshFilePath(), m_vertexesPart, m_cellDefsPart ) ){
+		Application::instance()->logError("GeoGrid::saveMesh(): Could not write mesh file " + this->getMeshFilePath() + ".");
+		return;
 	}
 
-	//close mesh file
-	file.close();
-
 	Application::instance()->logInfo("GeoGrid::saveMesh(): Mesh saved.");
 }
 
 void GeoGrid::loadMesh()
 {
 	QFile file( this->getMeshFilePath() );
-	file.open(QFile::ReadOnly | QFile::Text);
+	file.open(QFile::ReadOnly); //binary mode: MeshLoader reads both the text and the binary formats
+	bool wasText = ! MeshLoader::isBinary( file );
 	uint data_line_count = 0;
 	QFileInfo info( this->getMeshFilePath() );
 
@@ -360,6 +333,17 @@ void GeoGrid::loadMesh()
 	file.close();
 
 	Application::instance()->logInfo("Finished loading mesh.");
+
+	//migrate meshes in the legacy text format to the much faster to load binary format
+	if( wasText && ! m_vertexesPart.empty() && ! m_cellDefsPart.empty() ){
+		Application::instance()->logInfo("GeoGrid::loadMesh(): converting mesh file to binary format.");
+		//the text file is kept if the binary file cannot be completely written (see MeshLoader::saveBinary())
+		if( MeshLoader::saveBinary( this->getMeshFilePath(), m_vertexesPart, m_cellDefsPart ) )
+			m_lastModifiedDateTimeLastMeshLoad = QFileInfo( this->getMeshFilePath() ).lastModified();
+		else
+			Application::instance()->logWarn("GeoGrid::loadMesh(): Could not convert mesh file " + this->getMeshFilePath() +
+											  " to binary format.  The text file was kept.");
+	}
 }
 
 void GeoGrid::setInfoFromMetadataFile()
@@ -495,31 +479,34 @@ PointSet *GeoGrid::unfold( PointSet *inputPS, QString nameForNewPointSet )
 
 	uint nColumns = result->getDataColumnCount();
 
-    //iterate over the samples in the point set
+    //get the XYZ locations of the samples
     uint xIndex = result->getXindex() - 1; //first GEO-EAS index = 1
     uint yIndex = result->getYindex() - 1;
     uint zIndex = result->getZindex() - 1;
-    std::vector<uint> samplesToRemove;
-	bool empty = true;
+    std::vector<double> x( nSamples ), y( nSamples ), z( nSamples );
     for( uint iSample = 0; iSample < nSamples; ++iSample ){
-        //get the XYZ location of the sample
-        double x = result->data( iSample, xIndex );
-        double y = result->data( iSample, yIndex );
-        double z = result->data( iSample, zIndex );
-        //get the UVW coordinates
-		double u = -1.0;
-		double v = -1.0;
-		double w = -1.0;
-        if( XYZtoUVW( x, y, z, u, v, w ) ){
-			empty = false;
+        x[iSample] = result->data( iSample, xIndex );
+        y[iSample] = result->data( iSample, yIndex );
+        z[iSample] = result->data( iSample, zIndex );
+    }
+
+    //get the UVW coordinates of all samples at once (see GeoGridPointLocator)
+    std::vector<double> u, v, w;
+    std::vector<int> cellIndexes;
+    GeoGridPointLocator locator( this );
+    bool empty = locator.XYZtoUVW( x, y, z, u, v, w, cellIndexes ) == 0;
+
+    std::vector<bool> samplesToRemove( nSamples, false );
+    for( uint iSample = 0; iSample < nSamples; ++iSample ){
+        if( cellIndexes[iSample] >= 0 ){
 			//assign them to the point set
-			result->setData( iSample, nColumns - 3, u );
-			result->setData( iSample, nColumns - 2, v );
-			result->setData( iSample, nColumns - 1, w );
+			result->setData( iSample, nColumns - 3, u[iSample] );
+			result->setData( iSample, nColumns - 2, v[iSample] );
+			result->setData( iSample, nColumns - 1, w[iSample] );
 		} else {
             //a cell was not found (likely the sample is outside the grid)
             //so mark the sample for removal
-            samplesToRemove.push_back( iSample );
+            samplesToRemove[iSample] = true;
         }
     }
 
@@ -528,10 +515,7 @@ PointSet *GeoGrid::unfold( PointSet *inputPS, QString nameForNewPointSet )
                      result->getWeightsVariablesPairs(), result->getNSVarVarTrnTriads(), result->getCategoricalAttributes() );
 
 	//remove the samples with invalid UVW coordinates
-	std::vector<uint>::iterator it = samplesToRemove.begin();
-	uint offset = 0; //adjust for previously deleted lines.
-	for( ; it != samplesToRemove.end(); ++it, ++offset )
-		result->removeDataLine( *it - offset );
+	result->removeDataLines( samplesToRemove );
 
 	//if no data remained
 	if( empty ){
@@ -596,37 +580,40 @@ SegmentSet *GeoGrid::unfold(SegmentSet *inputSS, QString nameForNewSegmentSet)
     uint xFIndex = result->getXFinalIndex() - 1;
     uint yFIndex = result->getYFinalIndex() - 1;
     uint zFIndex = result->getZFinalIndex() - 1;
-    std::vector<uint> samplesToRemove;
+    //the ends of a segment are usually close to each other, so they are interleaved in the batch
+    //(the initial end of each segment is at 2*iSample and the final end is at 2*iSample+1)
+    std::vector<double> x( 2 * nSamples ), y( 2 * nSamples ), z( 2 * nSamples );
+    for( uint iSample = 0; iSample < nSamples; ++iSample ){
+        x[2 * iSample]     = result->data( iSample, xIIndex );
+        y[2 * iSample]     = result->data( iSample, yIIndex );
+        z[2 * iSample]     = result->data( iSample, zIIndex );
+        x[2 * iSample + 1] = result->data( iSample, xFIndex );
+        y[2 * iSample + 1] = result->data( iSample, yFIndex );
+        z[2 * iSample + 1] = result->data( iSample, zFIndex );
+    }
+
+    //get the UVW coordinates of all segment ends at once (see GeoGridPointLocator)
+    std::vector<double> u, v, w;
+    std::vector<int> cellIndexes;
+    GeoGridPointLocator locator( this );
+    locator.XYZtoUVW( x, y, z, u, v, w, cellIndexes );
+
+    std::vector<bool> samplesToRemove( nSamples, false );
     bool empty = true;
     for( uint iSample = 0; iSample < nSamples; ++iSample ){
-        //get the XYZ locations of the sample
-        double xi = result->data( iSample, xIIndex );
-        double yi = result->data( iSample, yIIndex );
-        double zi = result->data( iSample, zIIndex );
-        double xf = result->data( iSample, xFIndex );
-        double yf = result->data( iSample, yFIndex );
-        double zf = result->data( iSample, zFIndex );
-        //get the UVW coordinates
-        double ui = -1.0;
-        double vi = -1.0;
-        double wi = -1.0;
-        double uf = -1.0;
-        double vf = -1.0;
-        double wf = -1.0;
-        if( XYZtoUVW( xi, yi, zi, ui, vi, wi ) &&
-            XYZtoUVW( xf, yf, zf, uf, vf, wf ) ){
+        if( cellIndexes[2 * iSample] >= 0 && cellIndexes[2 * iSample + 1] >= 0 ){
             empty = false;
             //assign them to the point set
-            result->setData( iSample, nColumns - 6, ui );
-            result->setData( iSample, nColumns - 5, vi );
-            result->setData( iSample, nColumns - 4, wi );
-            result->setData( iSample, nColumns - 3, uf );
-            result->setData( iSample, nColumns - 2, vf );
-            result->setData( iSample, nColumns - 1, wf );
+            result->setData( iSample, nColumns - 6, u[2 * iSample] );
+            result->setData( iSample, nColumns - 5, v[2 * iSample] );
+            result->setData( iSample, nColumns - 4, w[2 * iSample] );
+            result->setData( iSample, nColumns - 3, u[2 * iSample + 1] );
+            result->setData( iSample, nColumns - 2, v[2 * iSample + 1] );
+            result->setData( iSample, nColumns - 1, w[2 * iSample + 1] );
         } else {
             //a cell was not found (likely one or both ends of a sample is outside the grid)
             //so mark the sample for removal
-            samplesToRemove.push_back( iSample );
+            samplesToRemove[iSample] = true;
         }
     }
 
@@ -636,10 +623,7 @@ SegmentSet *GeoGrid::unfold(SegmentSet *inputSS, QString nameForNewSegmentSet)
                      result->getWeightsVariablesPairs(), result->getNSVarVarTrnTriads(), result->getCategoricalAttributes() );
 
     //remove the samples with invalid UVW coordinates
-    std::vector<uint>::iterator it = samplesToRemove.begin();
-    uint offset = 0; //adjust for previously deleted lines.
-    for( ; it != samplesToRemove.end(); ++it, ++offset )
-        result->removeDataLine( *it - offset );
+    result->removeDataLines( samplesToRemove );
 
     //if no data remained
     if( empty ){
@@ -108,12 +108,12 @@ public:
 	QString getMeshFilePath();
 
 	/**
-	 * Saves the geometry data to file system.
+	 * Saves the geometry data to file system in binary format (see MeshLoader).
 	 */
 	void saveMesh();
 
 	/**
-	 * Loads the grid's mesh.
+	 * Loads the grid's mesh.  A mesh file in the legacy text format is rewritten in binary format once loaded.
 	 */
 	void loadMesh();
 
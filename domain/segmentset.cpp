@@ -280,20 +280,6 @@ PointSet *SegmentSet::toPointSetMidPoints(const QString& psName ) const
     return new_ps;
 }
 
-SegmentSet* SegmentSet::createSegmentSetByFiltering(uint column, double vMin, double vMax)
-{
-    //Create new empty point set.
-    SegmentSet* newSS = new SegmentSet( "" );
-    //Get filtered data frame.
-    std::vector< std::vector< double > > filteredData = getDataFilteredBy( column, vMin, vMax );
-    //Assign it as the new point set's data.
-    newSS->_data = filteredData;
-    //Set the same metadata.
-    newSS->setInfoFromAnotherSegmentSet( this );
-    //Return the new filtered data set.
-    return newSS;
-}
-
 double SegmentSet::getSegmentHeight(int iRecord) const
 {
     double dz = dataConst( iRecord, getZFinalIndex()-1 ) - dataConst( iRecord, getZindex()-1 );
@@ -30,9 +30,6 @@
 
 std::vector< double > AutomaticVariogramFitting::s_objectiveFunctionValues;
 
-/** This is a mutex to restrict access to the FFTW routines from
- * multiple threads.  Some of its routines are not thread safe.*/
-std::mutex myMutexFFTW; //ATTENTION NAME CLASH: there is a variable called mutexFFTW defined somewhere out there.
 std::mutex myMutexLSRS;
 std::mutex myMutexObjectiveFunction;
 
@@ -453,13 +450,10 @@ double AutomaticVariogramFitting::objectiveFunctionFIM( const IJAbstractCartesia
 
 spectral::array AutomaticVariogramFitting::getInputPhaseMap() const
 {
-    std::unique_lock<std::mutex> FFTWlock ( myMutexFFTW, std::defer_lock );
     spectral::arrayPtr inputGridData( m_cg->createSpectralArray( m_at->getAttributeGEOEASgivenIndex()-1 ) );
     spectral::array tmp( *inputGridData );
     spectral::complex_array inputFFT;
-    FFTWlock.lock();                //
-    spectral::foward( inputFFT, tmp ); // FFTW crashes when called concurrently
-    FFTWlock.unlock();              //
+    spectral::foward( inputFFT, tmp );
     spectral::complex_array inputFFTpolar = spectral::to_polar_form( inputFFT );
     return spectral::imag( inputFFTpolar );
 }
@@ -528,8 +522,6 @@ void AutomaticVariogramFitting::displayGrids(const std::vector<spectral::array>
 spectral::array AutomaticVariogramFitting::computeFIM( const spectral::array &gridWithCovariance,
                                                    const spectral::array &gridWithFFTphases ) const
 {
-    std::unique_lock<std::mutex> FFTWlock ( myMutexFFTW, std::defer_lock );
-
     //get grid dimensions
     size_t nI = gridWithCovariance.M();
     size_t nJ = gridWithCovariance.N();
@@ -544,9 +536,7 @@ spectral::array AutomaticVariogramFitting::computeFIM( const spectral::array &gr
 
     //compute FFT of the variographic surface (into polar form)
     spectral::complex_array variographicSurfaceFFT( nI, nJ, nK );
-    FFTWlock.lock();                                                     //
-    spectral::foward( variographicSurfaceFFT, covarianceDecentralized);  // FFTW crashes when called concurrently
-    FFTWlock.unlock();                                                   //
+    spectral::foward( variographicSurfaceFFT, covarianceDecentralized);
 
     //convert the FFT result (as complex numbers in a + bi form) to polar form (amplitudes and phases)
     spectral::complex_array variographicSurfaceFFTpolar = spectral::to_polar_form( variographicSurfaceFFT );
@@ -565,9 +555,7 @@ spectral::array AutomaticVariogramFitting::computeFIM( const spectral::array &gr
     spectral::complex_array mapFFT = spectral::to_rectangular_form( mapFFTpolar );
 
     //compute the reverse FFT to get "factorial kriging"
-    FFTWlock.lock();                      //
-    spectral::backward( result, mapFFT ); // FFTW crashes when called concurrently
-    FFTWlock.unlock();                    //
+    spectral::backward( result, mapFFT );
 
     //fftw3's reverse FFT requires that the values of output be divided by the number of cells
     result = result / static_cast<double>( nI * nJ * nK );
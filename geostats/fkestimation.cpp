@@ -86,9 +86,9 @@ void FKEstimation::setFactorNumber(int factorNumber)
     m_factorNumber = factorNumber;
 }
 
-DataCellPtrMultiset FKEstimation::getSamples(const GridCell & estimationCell )
+void FKEstimation::getSamples(const GridCell & estimationCell , NeighborList &samples)
 {
-	DataCellPtrMultiset result;
+	samples.clear();
 	if( m_searchStrategy && m_at_input ){
 
         //Fetch the indexes of the samples to be used in the estimation.
@@ -103,37 +103,52 @@ DataCellPtrMultiset FKEstimation::getSamples(const GridCell & estimationCell )
         }
         QList<uint>::iterator it = samplesIndexes.begin();
 
-        //Create and return the sample objects, which depend on the type of the input file.
+        //Collect the samples, whose locations depend on the type of the input file.  The cell objects
+        //are used only to compute the locations and read the values, so they are created on the stack.
+        uint inputColumn = m_at_input->getAttributeGEOEASgivenIndex()-1;
+        Neighbor sample;
         if( m_inputDataFile->isRegular() ){ //TODO: this currently assumes the regular data is a CartesianGrid object.
+			CartesianGrid* cg = static_cast<CartesianGrid*>( m_inputDataFile );
 			for( ; it != samplesIndexes.end(); ++it ){
-				CartesianGrid* cg = static_cast<CartesianGrid*>( m_inputDataFile );
 				uint i, j, k;
 				cg->indexToIJK( *it, i, j, k );
-				DataCellPtr p(new GridCell( cg, m_at_input->getAttributeGEOEASgivenIndex()-1, i, j, k ));
-				p->computeCartesianDistance( estimationCell );
-				result.insert( p );
+				GridCell p( cg, inputColumn, i, j, k );
+				sample._index = *it;
+				sample._center = p._center;
+				sample._indexIJK = p._indexIJK;
+				sample._value = p.readValueFromGrid();
+				sample.computeCartesianDistance( estimationCell._center );
+				samples.push_back( sample );
 			}
         } else { //irregular data sets
             SegmentSet* segmentSet = dynamic_cast<SegmentSet*>( m_inputDataFile );
             if( ! segmentSet ){
                 for( ; it != samplesIndexes.end(); ++it ){
-                    DataCellPtr p(new PointSetCell( static_cast<PointSet*>( m_inputDataFile ), m_at_input->getAttributeGEOEASgivenIndex()-1, *it ));
-                    p->computeCartesianDistance( estimationCell );
-                    result.insert( p );
+                    PointSetCell p( static_cast<PointSet*>( m_inputDataFile ), inputColumn, *it );
+                    sample._index = *it;
+                    sample._center = p._center;
+                    sample._value = p.readValueFromDataSet();
+                    sample.computeCartesianDistance( estimationCell._center );
+                    samples.push_back( sample );
                 }
             } else {
                 for( ; it != samplesIndexes.end(); ++it ){
-                    DataCellPtr p(new SegmentSetCell( static_cast<SegmentSet*>( m_inputDataFile ), m_at_input->getAttributeGEOEASgivenIndex()-1, *it ));
-                    p->computeCartesianDistance( estimationCell );
-                    result.insert( p );
+                    SegmentSetCell p( segmentSet, inputColumn, *it );
+                    sample._index = *it;
+                    sample._center = p._center;
+                    sample._value = p.readValueFromDataSet();
+                    sample.computeCartesianDistance( estimationCell._center );
+                    samples.push_back( sample );
                 }
             }
 		}
 
+        //order the samples by their distance to the estimation cell
+        sortNeighborsByDistance( samples );
+
 	} else {
 		Application::instance()->logError( "FKEstimation::getSamples(): sample search failed.  Search strategy and/or input data not set." );
 	}
-	return result;
 }
 
 std::vector<double> FKEstimation::run( )
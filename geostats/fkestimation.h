@@ -3,6 +3,7 @@
 
 #include "geostatsutils.h"
 #include "datacell.h"
+#include "neighbor.h"
 #include "searchstrategy.h"
 
 class VariogramModel;
@@ -48,12 +49,12 @@ public:
     SearchAlogorithmOption getSearchAlogorithmOption() const;
     //@}
 
-	/** Returns a container with the samples around the estimation cell to be used in the estimation.
-	 * The resulting collection depends on the SearchStrategy object set.  Returns an empty object if any
-	 * required parameter for the search to work (e.g. input data) is missing.  The data cells are ordered
-	 * by their distance to the passed estimation cell.
+	/** Fills a list (cleared first) with the samples around the estimation cell to be used in the estimation.
+	 * The resulting collection depends on the SearchStrategy object set.  The list is left empty if any
+	 * required parameter for the search to work (e.g. input data) is missing.  The samples are ordered
+	 * by their distance to the passed estimation cell and their values are those of the input variable.
 	 */
-	DataCellPtrMultiset getSamples(const GridCell & estimationCell );
+	void getSamples( const GridCell & estimationCell, NeighborList& samples );
 
     /** Performs the factorial kriging. Make sure all parameters have been set properly.
      * @param factorNumber The number of factor to get: -1 (mean); 0 (nugget); 1 and onwards (each variographic structure).
@@ -105,7 +105,9 @@ double FKEstimationRunner::fk(GridCell & estimationCell, double& estimatedMean,
 
 	//collects samples from the input data set ordered by their distance with respect
 	//to the estimation cell.
-	DataCellPtrMultiset vSamples = m_fkEstimation->getSamples( estimationCell );
+	//the list is a member variable so its memory is reused for all the estimation cells.
+	NeighborList& vSamples = m_samples;
+	m_fkEstimation->getSamples( estimationCell, vSamples );
 
 	//register the number of samples to be used in the estimation.
 	nSamples = vSamples.size();
@@ -145,9 +147,8 @@ double FKEstimationRunner::fk(GridCell & estimationCell, double& estimatedMean,
 
 			//Apply the weights (estimate).
 			factor = 0.0; //the mean is a separate factor.
-			DataCellPtrMultiset::iterator itSamples = vSamples.begin();
-			for( uint i = 0; i < vSamples.size(); ++i, ++itSamples){
-				factor += weightsSFK(i,0) * ( (*itSamples)->readValueFromDataSet() - mSK );
+			for( uint i = 0; i < vSamples.size(); ++i ){
+				factor += weightsSFK(i,0) * ( vSamples[i]._value - mSK );
 			}
 		}
 
@@ -178,9 +179,8 @@ double FKEstimationRunner::fk(GridCell & estimationCell, double& estimatedMean,
 			MatrixNXM<double> weightsSansNugget( covMat_inv * gammaMatSansNugget );
 			//Apply the SK weights (estimate).
 			factor = 0.0;
-			DataCellPtrMultiset::iterator itSamples = vSamples.begin();
-			for( uint i = 0; i < vSamples.size(); ++i, ++itSamples){
-				factor += ( weightsSK(i,0) - weightsSansNugget(i,0) ) * ( (*itSamples)->readValueFromDataSet() - mSK );
+			for( uint i = 0; i < vSamples.size(); ++i ){
+				factor += ( weightsSK(i,0) - weightsSansNugget(i,0) ) * ( vSamples[i]._value - mSK );
 			}
 		}
 
@@ -226,9 +226,8 @@ double FKEstimationRunner::fk(GridCell & estimationCell, double& estimatedMean,
 
 			//Apply the weights (estimate).
 			factor = 0.0;
-			DataCellPtrMultiset::iterator itSamples = vSamples.begin();
-			for( uint i = 0; i < vSamples.size(); ++i, ++itSamples){
-				factor += weightsFactor(i,0) * ( (*itSamples)->readValueFromDataSet() );
+			for( uint i = 0; i < vSamples.size(); ++i ){
+				factor += weightsFactor(i,0) * ( vSamples[i]._value );
 			}
 		//To estimate the nugget factor (apply location shift trick)
 		} else {
@@ -256,9 +255,8 @@ double FKEstimationRunner::fk(GridCell & estimationCell, double& estimatedMean,
 												(et_x_CZZ_inv_x_e____inv(0,0) * e_t * CZZ_inv) ).getTranspose()  );
 			//Apply the weights (estimate).
 			factor = 0.0;
-			DataCellPtrMultiset::iterator itSamples = vSamples.begin();
-			for( uint i = 0; i < vSamples.size(); ++i, ++itSamples){
-				factor += ( weightsFactor(i,0) - weightsNugget(i,0) ) * ( (*itSamples)->readValueFromDataSet() );
+			for( uint i = 0; i < vSamples.size(); ++i ){
+				factor += ( weightsFactor(i,0) - weightsNugget(i,0) ) * ( vSamples[i]._value );
 			}
 		}
 
@@ -269,9 +267,8 @@ double FKEstimationRunner::fk(GridCell & estimationCell, double& estimatedMean,
 
 			//Apply the OK weights (estimate the mean).
 			estimatedMean = 0.0;
-			DataCellPtrMultiset::iterator itSamples = vSamples.begin();
-			for( uint i = 0; i < vSamples.size(); ++i, ++itSamples){
-				estimatedMean += weightsMean(i,0) * ( (*itSamples)->readValueFromDataSet() );
+			for( uint i = 0; i < vSamples.size(); ++i ){
+				estimatedMean += weightsMean(i,0) * ( vSamples[i]._value );
 			}
 		}
 	}
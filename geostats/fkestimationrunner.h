@@ -3,6 +3,8 @@
 
 #include <QObject>
 
+#include "geostats/neighbor.h"
+
 class Attribute;
 class GridCell;
 class FKEstimation;
@@ -43,6 +45,9 @@ private:
 	std::vector<uint> m_nSamples;
 	VariogramModel* m_singleStructVModel;
 
+	/** The samples around the current estimation cell (reused for all cells to avoid memory allocations). */
+	NeighborList m_samples;
+
 	/** Perform factorial kriging in a single cell in the output grid according to the formulation at
 	 * https://pubs.geoscienceworld.org/geophysics/article/82/2/G35/520853/data-analysis-of-potential-field-methods-using
 	 * Data analysis of potential field methods using geostatistics - Shamsipour et al, 2017
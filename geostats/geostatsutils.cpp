@@ -162,7 +162,7 @@ double GeostatsUtils::getTransiogramProbability( TransiogramType transiogramType
     return probabilityValue;
 }
 
-MatrixNXM<double> GeostatsUtils::makeCovMatrix(DataCellPtrMultiset &samples,
+MatrixNXM<double> GeostatsUtils::makeCovMatrix(const NeighborList &samples,
 											   VariogramModel *variogramModel,
 											   double variogramSill,
 											   KrigingType kType,
@@ -187,22 +187,14 @@ MatrixNXM<double> GeostatsUtils::makeCovMatrix(DataCellPtrMultiset &samples,
     //Create the cov matrix.
     MatrixNXM<double> covMatrix( samples.size() + append, samples.size() + append );
 
-    //convert the std::multiset into a std::vector for faster traversal
-    //(memory locality and less pointer chasing)
-	std::vector<DataCellPtr> samplesV;
-    samplesV.reserve( samples.size() );
-    std::copy(samples.begin(), samples.end(), std::back_inserter(samplesV));
-
     //For each sample.
-	std::vector<DataCellPtr>::iterator rowsIt = samplesV.begin();
-    for( int i = 0; rowsIt != samplesV.end(); ++rowsIt, ++i ){
-		DataCellPtr rowCell = *rowsIt;
+    for( int i = 0; i < (int)samples.size(); ++i ){
+        const Neighbor& rowSample = samples[i];
         //For each sample.
-		std::vector<DataCellPtr>::iterator colsIt = samplesV.begin();
-        for( int j = 0; colsIt != samplesV.end(); ++colsIt, ++j ){
-			DataCellPtr colCell = *colsIt;
+        for( int j = 0; j < (int)samples.size(); ++j ){
+            const Neighbor& colSample = samples[j];
             //get semi-variance value from the separation between two samples in a pair
-			double gamma = GeostatsUtils::getGamma( variogramModel, rowCell->_center, colCell->_center );
+            double gamma = GeostatsUtils::getGamma( variogramModel, rowSample._center, colSample._center );
             //to remove singularity...
             //TODO: this needs to be verified.
             if( variogramModel->isPureNugget() && i != j )
@@ -241,7 +233,7 @@ MatrixNXM<double> GeostatsUtils::makeCovMatrix(DataCellPtrMultiset &samples,
     return covMatrix;
 }
 
-MatrixNXM<double> GeostatsUtils::makeGammaMatrix(DataCellPtrMultiset &samples,
+MatrixNXM<double> GeostatsUtils::makeGammaMatrix(const NeighborList &samples,
 												 GridCell &estimationLocation,
 												 VariogramModel *variogramModel,
 												 double variogramSill,
@@ -267,18 +259,10 @@ MatrixNXM<double> GeostatsUtils::makeGammaMatrix(DataCellPtrMultiset &samples,
 	//Create the gamma matrix.
     MatrixNXM<double> result( samples.size()+append, 1 );
 
-	//convert the std::multiset into a std::vector for faster traversal
-	//(memory locality and less pointer chasing)
-	std::vector<DataCellPtr> samplesV;
-	samplesV.reserve( samples.size() );
-	std::copy(samples.begin(), samples.end(), std::back_inserter(samplesV));
-
 	//For each sample.
-	std::vector<DataCellPtr>::iterator rowsIt = samplesV.begin();
-	for( int i = 0; rowsIt != samplesV.end(); ++rowsIt, ++i ){
-		DataCellPtr rowCell = *rowsIt;
+	for( int i = 0; i < (int)samples.size(); ++i ){
         //get semi-variance value
-		double gamma = GeostatsUtils::getGamma( variogramModel, rowCell->_center, estimationLocation._center + epsilon );
+		double gamma = GeostatsUtils::getGamma( variogramModel, samples[i]._center, estimationLocation._center + epsilon );
         //get covariance
 		if( returnGamma )
 			result(i, 0) = gamma;
@@ -314,9 +298,11 @@ void GeostatsUtils::getValuedNeighborsTopoOrdered(const GridCell &cell,
                                                         int nSlicesAround,
                                                         bool hasNDV,
                                                         double NDV,
-                                                        GridCellPtrMultiset &list,
+                                                        NeighborList &list,
                                                         const std::vector<double> *simulatedData)
 {
+    list.clear();
+
     CartesianGrid* cg = cell._grid;
     if( ! cg ){
         Application::instance()->logError("GeostatsUtils::getValuedNeighborsTopoOrdered(): null grid.  Returning empty list.");
@@ -371,6 +357,10 @@ void GeostatsUtils::getValuedNeighborsTopoOrdered(const GridCell &cell,
     }
     //////////////////////////////////////////////////
 
+    //get the grid geometry to compute the cell centers
+    double x0 = cg->getX0(), y0 = cg->getY0(), z0 = cg->getZ0();
+    double dx = cg->getDX(), dy = cg->getDY(), dz = cg->getDZ();
+
     //for each delta...
     std::vector<IJKDelta>::const_iterator it = deltasV->cbegin();
     IJKIndex indexes[8]; //eight indexes is the most possible (3 degrees of freedom)
@@ -390,20 +380,27 @@ void GeostatsUtils::getValuedNeighborsTopoOrdered(const GridCell &cell,
                 kk >= 0 && kk < slice_limit ){
                 //...get the value corresponding to the cell index.
                 double value;
-                int dataIndex;
+                uint cellIndex = cg->IJKtoIndex( ii, jj, kk );
                 if ( cell._dataIndex >= 0 ) {  // data column is provided: fetch value from the grid
-                    dataIndex = cell._dataIndex;
-                    value = cg->dataIJK( dataIndex, ii, jj, kk );
+                    value = cg->dataIJK( cell._dataIndex, ii, jj, kk );
                 } else { // data column is NOT provided: fetch value from a client-given data container
-                    dataIndex = cg->IJKtoIndex( ii, jj, kk );
-                    value = (*simulatedData)[ dataIndex ];
+                    value = (*simulatedData)[ cellIndex ];
                 }
                 //if the cell is valued... DataFile::hasNDV() is slow.
                 if( !hasNDV || !Util::almostEqual2sComplement( NDV, value, 1 ) ){
-                    //...it is a valid neighbor.
-                    GridCellPtr currentCell( new GridCell( cg, dataIndex, ii, jj, kk ) );
-                    currentCell->computeTopoDistance( cell );
-                    list.insert( currentCell );
+                    //...it is a valid neighbor.  The deltas are ordered by topological distance, so the
+                    //list is ordered without sorting.
+                    Neighbor neighbor;
+                    neighbor._index = cellIndex;
+                    neighbor._center = SpatialLocation( x0 + ii * dx + dx / 2.0,
+                                                        y0 + jj * dy + dy / 2.0,
+                                                        z0 + kk * dz + dz / 2.0 );
+                    neighbor._value = value;
+                    neighbor._distance = std::abs( ii - cell._indexIJK._i ) +
+                                         std::abs( jj - cell._indexIJK._j ) +
+                                         std::abs( kk - cell._indexIJK._k );
+                    neighbor._indexIJK = IJKIndex( ii, jj, kk );
+                    list.push_back( neighbor );
                     //if the number of neighbors is reached...
                     if( list.size() == (unsigned)numberOfSamples )
                         //...interrupt the search
@@ -6,6 +6,7 @@
 #include "domain/variogrammodel.h"
 #include "geostats/datacell.h"
 #include "geostats/gridcell.h"
+#include "geostats/neighbor.h"
 #include <set>
 
 class SpatialLocation;
@@ -89,7 +90,7 @@ public:
 	 *        default (false) makes the elements be correlogram values (decreases with
 	 *        distance).  The variogram sill value is ignored if this parameter is true.
      */
-	static MatrixNXM<double> makeCovMatrix(DataCellPtrMultiset & samples,
+	static MatrixNXM<double> makeCovMatrix(const NeighborList & samples,
 										   VariogramModel *variogramModel,
 										   double variogramSill,
 										   KrigingType kType = KrigingType::SK,
@@ -105,7 +106,7 @@ public:
 	 * @param epsilon A small value to shift the estimation location a bit.  This trick is used to avoid
 	 *        numerical instabilities in certain operations.  Normally this should be zero.
 	 */
-	static MatrixNXM<double> makeGammaMatrix(DataCellPtrMultiset & samples,
+	static MatrixNXM<double> makeGammaMatrix(const NeighborList & samples,
 											 GridCell& estimationLocation,
 											 VariogramModel *variogramModel,
 											 double variogramSill,
@@ -115,6 +116,8 @@ public:
 
     /**
      *  Returns a list of valued grid cells, ordered by topological proximity to the target cell.
+     *  The list is cleared first.  The _index of the neighbors is the linear index of the cells in the grid
+     *  and their _distance is the topological distance to the target cell.
      * @param simulatedData This should be set if this method is being called by computations that do not
      *                      immediately commit the results to the grid (e.g. simulation routines), otherwise an index
      *                      crash will ensue as the index in cell object parameter is invalid or is -1.
@@ -126,7 +129,7 @@ public:
 															int nSlicesAround,
 															bool hasNDV,
 															double NDV,
-                                                            GridCellPtrMultiset & list,
+                                                            NeighborList & list,
                                                             const std::vector<double> *simulatedData = nullptr );
 	/** Creates the P matrix for Factorial Kriging.
 	 * see theory in Ma et al. (2014) - Factorial kriging for multiscale modelling.
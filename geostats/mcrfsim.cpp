@@ -197,13 +197,18 @@ double MCRFSim::simulateOneCellMT(uint i, uint j, uint k,
     //define a cell object that represents the current simulation cell
     GridCell simulationCell( m_cgSim, -1, i, j, k );
 
+    //the lists of neighbors are reused by all the cells simulated by a thread, so no memory is allocated for them
+    //once they have grown to the size of the search neighborhood.
+    static thread_local NeighborList vSamplesPrimary;
+    static thread_local NeighborList vNeighboringSimGridCells;
+
     //collect samples from the input data set ordered by their distance with respect
     //to the simulation cell.
-    DataCellPtrMultiset vSamplesPrimary = getSamplesFromPrimaryMT( simulationCell );
+    getSamplesFromPrimaryMT( simulationCell, vSamplesPrimary );
 
     //collect neighboring simulation grid cells ordered by their distance with respect
     //to the simulation cell.
-    DataCellPtrMultiset vNeighboringSimGridCells = getNeighboringSimGridCellsMT( simulationCell, simulatedData );
+    getNeighboringSimGridCellsMT( simulationCell, simulatedData, vNeighboringSimGridCells );
 
     //make a local copy of the Tau Model (this is potentially a multi-threaded code)
     TauModel tauModelCopy( *m_tauModel );
@@ -213,11 +218,6 @@ double MCRFSim::simulateOneCellMT(uint i, uint j, uint k,
     double simCellZ                   = m_cgSim->getDataSpatialLocation( simCellLinearIndex, CartesianCoord::Z );
     double simCellGradationFieldValue = m_cgSim->dataIJKConst( m_gradationFieldOfSimGrid->getAttributeGEOEASgivenIndex()-1,
                                                                i, j, k );
-    //get the probabilities from the global PDF, they're the marginal
-    //probabilities for the Tau Model
-    for( int categoryIndex = 0; categoryIndex < cd->getCategoryCount(); ++categoryIndex )
-        tauModelCopy.setMarginalProbability( categoryIndex, m_pdf->get2ndValue( categoryIndex ) );
-
 
     //To compute the facies probabilities for the Monte Carlo draw we only need to collect the codes of the
     //facies found in the search neighborhood along with their distances to the simulation cell.
@@ -225,29 +225,28 @@ double MCRFSim::simulateOneCellMT(uint i, uint j, uint k,
     //found in search neighborhood
     typedef double FaciesCodeFrom;
     typedef double SuccessionSeparation;
-    std::vector< std::pair< FaciesCodeFrom, SuccessionSeparation > > faciesFromCodesAndSuccessionSeparations;
+    static thread_local std::vector< std::pair< FaciesCodeFrom, SuccessionSeparation > > faciesFromCodesAndSuccessionSeparations;
+    faciesFromCodesAndSuccessionSeparations.clear();
     faciesFromCodesAndSuccessionSeparations.reserve( m_commonSimulationParameters->getNumberOfSamples() +
                                                      m_commonSimulationParameters->getNumberOfSimulatedNodesForConditioning() );
 
     ///======================================== PROCESSING OF EACH PRIMARY DATUM  FOUND IN THE SEARCH NEIGHBORHOOD=============================================
-    DataCellPtrMultiset::iterator itSampleCells = vSamplesPrimary.begin();
-    for( uint i = 0; i < vSamplesPrimary.size(); ++i, ++itSampleCells){
-        DataCellPtr sampleDataCell = *itSampleCells;
+    for( const Neighbor& sample : vSamplesPrimary ){
 
         //get the facies value (it is a double due to DataFile API, but it is an integer value).
-        double sampleFaciesValue = sampleDataCell->readValueFromDataSet( m_atPrimary->getAttributeGEOEASgivenIndex()-1 );
+        double sampleFaciesValue = sample._value;
 
         // Sanity check against No-data-values
         // DataFile::isNDV() is non-const and has a slow string-to-double conversion
         if( ! m_primaryDataHasNDV || ! Util::almostEqual2sComplement( m_primaryDataNDV, sampleFaciesValue, 1 ) ){
 
             // get the sample's gradation field value
-            double sampleGradationValue = sampleDataCell->readValueFromDataSet( m_gradationFieldOfPrimaryData->getAttributeGEOEASgivenIndex()-1 );
+            double sampleGradationValue = m_primaryDataFile->data( sample._index, m_gradationFieldOfPrimaryData->getAttributeGEOEASgivenIndex()-1 );
 
             //To preserve Markovian property, we cannot use data ahead in the facies succession.
             bool isAheadInSuccession = false;
             {
-                isAheadInSuccession = isAheadInSuccession || ( sampleDataCell->_center._z > simCellZ ); // a sample location above the current cell is considered ahead (in time)
+                isAheadInSuccession = isAheadInSuccession || ( sample._center._z > simCellZ ); // a sample location above the current cell is considered ahead (in time)
                 //a sampple location ahead in the lateral facies succession should not be computed (Walther's Law)
                 isAheadInSuccession = isAheadInSuccession || ( ! m_invertGradationFieldConvention && sampleGradationValue >  simCellGradationFieldValue );
                 isAheadInSuccession = isAheadInSuccession || (   m_invertGradationFieldConvention && sampleGradationValue <= simCellGradationFieldValue );
@@ -260,7 +259,7 @@ double MCRFSim::simulateOneCellMT(uint i, uint j, uint k,
                 // variation in the gradation field - lateral succession separation )
                 double faciesSuccessionDistance = 0.0;
                 {
-                    double verticalSeparation = ( simCellZ - sampleDataCell->_center._z ) / vertAniso;
+                    double verticalSeparation = ( simCellZ - sample._center._z ) / vertAniso;
                     double lateralSuccessionSeparation = sampleGradationValue - simCellGradationFieldValue;
                     faciesSuccessionDistance = std::sqrt( verticalSeparation*verticalSeparation + lateralSuccessionSeparation*lateralSuccessionSeparation );
                 }
@@ -275,19 +274,15 @@ double MCRFSim::simulateOneCellMT(uint i, uint j, uint k,
     }
 
     ///======================================== PROCESSING OF EACH GRID CELL FOUND IN THE SEARCH NEIGHBORHOOD=============================================
-    DataCellPtrMultiset::iterator itSimGridCells = vNeighboringSimGridCells.begin();
-    for( uint i = 0; i < vNeighboringSimGridCells.size(); ++i, ++itSimGridCells){
-        DataCellPtr neighborDataCell = *itSimGridCells;
-        //we know the data cell is a grid cell
-        const GridCell* neighborGridCellAspect = dynamic_cast<GridCell*>(neighborDataCell.get());
+    for( const Neighbor& neighborCell : vNeighboringSimGridCells ){
 
         //get the topological coordinates of the neighnoring cell
-        uint neighI = neighborGridCellAspect->_indexIJK._i;
-        uint neighJ = neighborGridCellAspect->_indexIJK._j;
-        uint neighK = neighborGridCellAspect->_indexIJK._k;
+        uint neighI = neighborCell._indexIJK._i;
+        uint neighJ = neighborCell._indexIJK._j;
+        uint neighK = neighborCell._indexIJK._k;
 
         //get the realization value (a facies code) in the neighboring cell (may be NDV)
-        double realizationValue = simulatedData( neighI, neighJ, neighK );
+        double realizationValue = neighborCell._value;
 
         //if there is a previously simulated data in the neighboring cell
         // DataFile::isNDV() is non-const and has a slow string-to-double conversion
@@ -313,7 +308,7 @@ double MCRFSim::simulateOneCellMT(uint i, uint j, uint k,
                 // variation in the gradation field - lateral succession separation )
                 double faciesSuccessionDistance = 0.0;
                 {
-                    double verticalSeparation = ( simCellZ - neighborGridCellAspect->_center._z ) / vertAniso;
+                    double verticalSeparation = ( simCellZ - neighborCell._center._z ) / vertAniso;
                     double lateralSuccessionSeparation = neighborGradationFieldValue - simCellGradationFieldValue;
                     faciesSuccessionDistance = std::sqrt( verticalSeparation*verticalSeparation + lateralSuccessionSeparation*lateralSuccessionSeparation );
                 }
@@ -328,52 +323,38 @@ double MCRFSim::simulateOneCellMT(uint i, uint j, uint k,
     //////////////// COMPUTE THE PROBABILITIES OF THIS SIMULATION CELL BEING EACH CANDIDATE FACIES//////////////////////
     /////// FOR THEORY AND FORMULATION, SEE PROGRAM MANUAL IN THE SECTION "MARKOV CHAIN RANDOM FIELD SIMULATION" ///////
 
-    // A lambda function to reuse the multiplaction operator over all the facies found in
-    // samples and previously simulated cells.
-    const VerticalTransiogramModel& transiogramModel = *m_transiogramModel;
-    auto lambdaMultiplicationProbs = [ faciesFromCodesAndSuccessionSeparations, transiogramModel ] ( uint faciesCodeTo ) {
-        double result = 0.0; //assumes zero probability
-        std::vector< std::pair< FaciesCodeFrom, SuccessionSeparation > >::const_iterator it =
-                faciesFromCodesAndSuccessionSeparations.cbegin();
-        //iterate over all "from" facies codes, which reside in the primary data samples and previously simulated nodes
-        //found in the search neighborhood
-        for( ; it != faciesFromCodesAndSuccessionSeparations.cend(); ++it ){
-            uint faciesCodeFrom = (*it).first;
-            double h = (*it).second;
-            double probability = transiogramModel.getTransitionProbability( faciesCodeFrom, faciesCodeTo, h );
-            if( it == faciesFromCodesAndSuccessionSeparations.cbegin() )
-                result = probability; //initialize the resulting probability with the first probability
-            else
-                result *= probability;
-        }
-        return result;
-    };
+    // The products of the transition probabilities from all the facies found in samples and previously simulated
+    // cells to each candidate facies.  They are computed for all the candidate facies at once with the table of
+    // transiograms.
+    uint nCategories = m_transiogramTable->getCategoryCount();
+    double products[nCategories];
+    //assumes zero probability if there are no facies in the neighborhood
+    std::fill( products, products + nCategories, faciesFromCodesAndSuccessionSeparations.empty() ? 0.0 : 1.0 );
+    //iterate over all "from" facies codes, which reside in the primary data samples and previously simulated nodes
+    //found in the search neighborhood
+    for( const std::pair< FaciesCodeFrom, SuccessionSeparation >& faciesFromCodeAndSuccessionSeparation : faciesFromCodesAndSuccessionSeparations )
+        m_transiogramTable->multiplyTransitionProbabilities( static_cast<int>( faciesFromCodeAndSuccessionSeparation.first ),
+                                                             faciesFromCodeAndSuccessionSeparation.second,
+                                                             products );
 
     //compute the denominator (a summation of multiplications) part of the MCRF equation
     double denominator = 0.0;
-    for( uint iFaciesTo = 0; iFaciesTo < cd->getCategoryCount(); ++iFaciesTo ){
-        //get the "to" facies code
-        uint toFaciesCode = cd->getCategoryCode( iFaciesTo );
-        denominator += lambdaMultiplicationProbs( toFaciesCode );
-    }
+    for( uint iFaciesTo = 0; iFaciesTo < nCategories; ++iFaciesTo )
+        denominator += products[ iFaciesTo ];
 
     //for each possible facies that can be assigned to the simulation cell
-    for( uint iCandidateFacies = 0; iCandidateFacies < cd->getCategoryCount(); ++iCandidateFacies ){
-        //get the candidate facies code
-        uint candidateFaciesCode = cd->getCategoryCode( iCandidateFacies );
-        //compute the numerator (a multiplication) part of the MCRF equation
-        double numerator = lambdaMultiplicationProbs( candidateFaciesCode );
+    double probabilitiesFromTransiography[nCategories];
+    for( uint iCandidateFacies = 0; iCandidateFacies < nCategories; ++iCandidateFacies ){
+        //the numerator (a multiplication) part of the MCRF equation is the product of the candidate facies
         //finaly compute the probability according to transiography (primary data and previously simulated cells)
-        double probabilityFromTransiography;
         if( denominator > 0.0 )
-            probabilityFromTransiography = numerator / denominator;
+            probabilitiesFromTransiography[ iCandidateFacies ] = products[ iCandidateFacies ] / denominator;
         else
-            probabilityFromTransiography = 0.0;
-        //set the probability in the Tau Model
-        tauModelCopy.setProbabilityFromSource( iCandidateFacies,
-                                              static_cast<uint>( ProbabilitySource::FROM_TRANSIOGRAM ),
-                                              probabilityFromTransiography );
+            probabilitiesFromTransiography[ iCandidateFacies ] = 0.0;
     }
+    //set the probabilities in the Tau Model
+    tauModelCopy.setProbabilitiesFromSource( static_cast<uint>( ProbabilitySource::FROM_TRANSIOGRAM ),
+                                             probabilitiesFromTransiography );
     //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
     //get the probabilities of facies from secondary data (collocated in simulation grid) for the Tau Model
@@ -394,9 +375,11 @@ double MCRFSim::simulateOneCellMT(uint i, uint j, uint k,
     typedef double CumulativeProbability;
     std::vector< CumulativeProbability > cdf;
     cdf.reserve( cd->getCategoryCount() );
+    double finalProbabilities[nCategories];
+    tauModelCopy.getFinalProbabilities( finalProbabilities );
     double cumulativeProbability = 0.0;
     for( unsigned int categoryIndex = 0; categoryIndex < cd->getCategoryCount(); ++categoryIndex ){
-        double prob = tauModelCopy.getFinalProbability( categoryIndex );
+        double prob = finalProbabilities[ categoryIndex ];
         //assert( prob != 0.0 && "MCRFSim::simulateOneCellMT(): final probabilities are not supposed to be zero!");
         cumulativeProbability += prob;
         cdf.push_back( cumulativeProbability );
@@ -648,8 +631,17 @@ bool MCRFSim::run()
         if( useSecondaryData() )
             m_tauModel->setTauFactor( static_cast<uint>(ProbabilitySource::FROM_SECONDARY_DATA),
                                       m_tauFactorForProbabilityFields );
+        //the probabilities from the global PDF are the marginal probabilities for the Tau Model
+        for( int categoryIndex = 0; categoryIndex < cd->getCategoryCount(); ++categoryIndex )
+            m_tauModel->setMarginalProbability( categoryIndex, m_pdf->get2ndValue( categoryIndex ) );
     }
 
+    // Tabulate the transiograms.  Separations beyond three times the longest range (when the transiograms
+    // are practically at their sills) are rare and are computed with the model.
+    m_transiogramTable = TransiogramTablePtr( new TransiogramTable( *m_transiogramModel,
+                                                                    cd,
+                                                                    3.0 * m_transiogramModel->getLongestRange() ) );
+
     //configure and display a progress bar for the simulation task
     //////////////////////////////////
     m_progressDialog = new QProgressDialog;
@@ -743,27 +735,30 @@ void MCRFSim::updateProgessUI()
     QApplication::processEvents();
 }
 
-DataCellPtrMultiset MCRFSim::getSamplesFromPrimaryMT(const GridCell &simulationCell) const
+void MCRFSim::getSamplesFromPrimaryMT(const GridCell &simulationCell, NeighborList &samples) const
 {
-    DataCellPtrMultiset result;
+    samples.clear();
     if( m_searchStrategyPrimary && m_atPrimary ){
 
         //if the user set the max number of primary data samples to search to zero, returns the empty result.
         if( ! m_searchStrategyPrimary->m_nb_samples )
-            return result;
+            return;
 
         //Fetch the indexes of the samples to be used in the simulation.
         QList<uint> samplesIndexes = m_spatialIndexOfPrimaryData->getNearestWithinGenericRTreeBased( simulationCell, *m_searchStrategyPrimary );
         QList<uint>::iterator it = samplesIndexes.begin();
 
-        //Create and collect the searched sample objects, which depend on the type of the input file.
+        //Collect the searched samples, whose locations depend on the type of the input file.  The cell objects
+        //are used only to compute the locations, so they are created on the stack.
+        uint primaryColumn = m_atPrimary->getAttributeGEOEASgivenIndex()-1;
         for( ; it != samplesIndexes.end(); ++it ){
+            Neighbor sample;
+            sample._index = *it;
             switch ( m_primaryDataType ) {
             case PrimaryDataType::POINTSET:
             {
-                DataCellPtr p(new PointSetCell( static_cast<PointSet*>( m_primaryDataFile ), m_atPrimary->getAttributeGEOEASgivenIndex()-1, *it ));
-                p->computeCartesianDistance( simulationCell );
-                result.insert( p );
+                PointSetCell p( static_cast<PointSet*>( m_primaryDataFile ), primaryColumn, *it );
+                sample._center = p._center;
             }
                 break;
             case PrimaryDataType::CARTESIANGRID:
@@ -771,51 +766,52 @@ DataCellPtrMultiset MCRFSim::getSamplesFromPrimaryMT(const GridCell &simulationC
                 CartesianGrid* cg = static_cast<CartesianGrid*>( m_primaryDataFile );
                 uint i, j, k;
                 cg->indexToIJK( *it, i, j, k );
-                DataCellPtr p(new GridCell( cg, m_atPrimary->getAttributeGEOEASgivenIndex()-1, i, j, k ));
-                p->computeCartesianDistance( simulationCell );
-                result.insert( p );
+                GridCell p( cg, primaryColumn, i, j, k );
+                sample._center = p._center;
+                sample._indexIJK = p._indexIJK;
             }
                 break;
             case PrimaryDataType::GEOGRID:
             {
                 Application::instance()->logError( "MCRFSim::getSamplesFromPrimary(): GeoGrids cannot be used as primary data yet.  Must create a class like GeoGridCell inheriting from DataCell." );
             }
-                break;
+                continue;
             case PrimaryDataType::SEGMENTSET:
             {
-                DataCellPtr p(new SegmentSetCell( static_cast<SegmentSet*>( m_primaryDataFile ), m_atPrimary->getAttributeGEOEASgivenIndex()-1, *it ));
-                p->computeCartesianDistance( simulationCell );
-                result.insert( p );
+                SegmentSetCell p( static_cast<SegmentSet*>( m_primaryDataFile ), primaryColumn, *it );
+                sample._center = p._center;
             }
                 break;
             default:
                 Application::instance()->logError( "MCRFSim::getSamplesFromPrimary(): Primary data file type not recognized or undefined." );
+                continue;
             }
+            sample._value = m_primaryDataFile->data( *it, primaryColumn );
+            sample.computeCartesianDistance( simulationCell._center );
+            samples.push_back( sample );
         }
 
+        //order the samples by their distance to the simulation cell
+        sortNeighborsByDistance( samples );
+
     } else {
         Application::instance()->logError( "MCRFSim::getSamplesFromPrimary(): sample search failed.  Search strategy and/or primary data not set." );
     }
-    return result;
 }
 
-DataCellPtrMultiset MCRFSim::getNeighboringSimGridCellsMT(const GridCell &simulationCell,
-                                                          const spectral::array& simulatedData) const
+void MCRFSim::getNeighboringSimGridCellsMT(const GridCell &simulationCell,
+                                           const spectral::array& simulatedData,
+                                           NeighborList &neighbors) const
 {
-    DataCellPtrMultiset result;
+    neighbors.clear();
     if( m_searchStrategySimGrid && m_cgSim ){
 
         //if the user set the number of cells to search to zero, returns the empty result.
         if( ! m_searchStrategySimGrid->m_nb_samples )
-            return result;
+            return;
 
-        //Fetch the indexes of the samples to be used in the simulation.
-        QList<uint> samplesIndexes;
-        if( m_commonSimulationParameters->getSearchAlgorithmOptionForSimGrid() == 0 )
-            samplesIndexes = m_spatialIndexOfSimGrid->getNearestWithinGenericRTreeBased( simulationCell, *m_searchStrategySimGrid );
-        else if( m_commonSimulationParameters->getSearchAlgorithmOptionForSimGrid() == 1 )
-            samplesIndexes = m_spatialIndexOfSimGrid->getNearestWithinTunedForLargeDataSets( simulationCell, *m_searchStrategySimGrid );
-        else{
+        //Fetch the cells to be used in the simulation.
+        if( m_commonSimulationParameters->getSearchAlgorithmOptionForSimGrid() == 2 ){
             uint nCellsIDirection = m_commonSimulationParameters->getSearchEllipHMin() / m_cgSim->getDX() * 2.0;
             uint nCellsJDirection = m_commonSimulationParameters->getSearchEllipHMax() / m_cgSim->getDY() * 2.0;
             uint nCellsKDirection = m_commonSimulationParameters->getSearchEllipHVert() / m_cgSim->getDZ() * 2.0;
@@ -823,29 +819,45 @@ DataCellPtrMultiset MCRFSim::getNeighboringSimGridCellsMT(const GridCell &simula
             if( nCellsJDirection < 1 ) nCellsJDirection = 1;
             if( nCellsKDirection < 1 ) nCellsKDirection = 1;
             //The simulation grid is necessarily a Cartesian grid
-            samplesIndexes = m_spatialIndexOfSimGrid->getNearestFromCartesianGrid( simulationCell,
-                                                                                   *m_searchStrategySimGrid,
-                                                                                   true,
-                                                                                   m_simGridNDV,
-                                                                                   nCellsIDirection,
-                                                                                   nCellsJDirection,
-                                                                                   nCellsKDirection,
-                                                                                   &simulatedData.d_ );
+            m_spatialIndexOfSimGrid->getNearestFromCartesianGrid( simulationCell,
+                                                                  *m_searchStrategySimGrid,
+                                                                  true,
+                                                                  m_simGridNDV,
+                                                                  nCellsIDirection,
+                                                                  nCellsJDirection,
+                                                                  nCellsKDirection,
+                                                                  neighbors,
+                                                                  &simulatedData.d_ );
+        } else {
+            QList<uint> samplesIndexes;
+            if( m_commonSimulationParameters->getSearchAlgorithmOptionForSimGrid() == 0 )
+                samplesIndexes = m_spatialIndexOfSimGrid->getNearestWithinGenericRTreeBased( simulationCell, *m_searchStrategySimGrid );
+            else
+                samplesIndexes = m_spatialIndexOfSimGrid->getNearestWithinTunedForLargeDataSets( simulationCell, *m_searchStrategySimGrid );
+            QList<uint>::iterator it = samplesIndexes.begin();
+            for( ; it != samplesIndexes.end(); ++it ){
+                uint i, j, k;
+                m_cgSim->indexToIJK( *it, i, j, k );
+                GridCell p( m_cgSim, -1, i, j, k );
+                Neighbor neighbor;
+                neighbor._index = *it;
+                neighbor._center = p._center;
+                neighbor._indexIJK = p._indexIJK;
+                neighbors.push_back( neighbor );
+            }
         }
 
-        QList<uint>::iterator it = samplesIndexes.begin();
-
-        //Create and collect the searched sample objects, which depend on the type of the input file.
-        for( ; it != samplesIndexes.end(); ++it ){
-            uint i, j, k;
-            m_cgSim->indexToIJK( *it, i, j, k );
-            DataCellPtr p(new GridCell( m_cgSim, -1, i, j, k ));
-            p->computeCartesianDistance( simulationCell );
-            result.insert( p );
+        //the searches above give topological distances or none: replace them with the Cartesian distances
+        //and read the previously simulated values.
+        for( Neighbor& neighbor : neighbors ){
+            neighbor.computeCartesianDistance( simulationCell._center );
+            neighbor._value = simulatedData( neighbor._indexIJK._i, neighbor._indexIJK._j, neighbor._indexIJK._k );
         }
 
+        //order the cells by their distance to the simulation cell
+        sortNeighborsByDistance( neighbors );
+
     } else {
         Application::instance()->logError( "MCRFSim::getNeighboringSimGridCellsMT(): simulation grid search failed.  Search strategy and/or simulation grid not set." );
     }
-    return result;
 }
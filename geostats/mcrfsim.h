@@ -9,7 +9,9 @@
 #include "spectral/spectral.h"
 #include "geostats/searchstrategy.h"
 #include "geostats/gridcell.h"
+#include "geostats/neighbor.h"
 #include "geostats/taumodel.h"
+#include "geostats/transiogramtable.h"
 
 class Attribute;
 class CartesianGrid;
@@ -173,6 +175,9 @@ private:
     /** The Tau Model used to integrate different sources of facies probabilities. */
     TauModelPtr m_tauModel;
 
+    /** The transition probabilities of the transiogram model tabulated for fast queries. */
+    TransiogramTablePtr m_transiogramTable;
+
     /** Returns whether the simulation parameters are valid and consistent. */
     bool isOKtoRun();
 
@@ -182,21 +187,23 @@ private:
     /** Causes the progress window to repaint (slows down execution if called many times unnecessarily). */
     void updateProgessUI();
 
-    /** Returns a container with the primary data samples around the estimation cell to be used in the estimation.
-     * The resulting collection depends on the SearchStrategy object set for the primary data.  Returns an empty object if any
-     * required parameter for the search to work (e.g. input data) is missing.  The data cells are ordered
-     * by their distance to the passed simulation cell.
+    /** Fills a list (cleared first) with the primary data samples around the estimation cell to be used in the estimation.
+     * The resulting collection depends on the SearchStrategy object set for the primary data.  The list is left empty if any
+     * required parameter for the search to work (e.g. input data) is missing.  The samples are ordered
+     * by their distance to the passed simulation cell and their values are those of the simulated variable.
      */
-    DataCellPtrMultiset getSamplesFromPrimaryMT( const GridCell& simulationCell ) const;
+    void getSamplesFromPrimaryMT( const GridCell& simulationCell, NeighborList& samples ) const;
 
-    /** Returns a container with the simulation grid cells around the estimation cell.
-     * The resulting collection depends on the SearchStrategy object set for the simulation grid.  Returns an empty object if any
-     * required parameter for the search to work is missing.  The data cells are ordered
+    /** Fills a list (cleared first) with the simulation grid cells around the estimation cell.
+     * The resulting collection depends on the SearchStrategy object set for the simulation grid.  The list is left empty if any
+     * required parameter for the search to work is missing.  The cells are ordered
      * by their distance to the passed simulation cell.
-     * This method also needs to query the previously simulated data, which is passed as a parameter.
+     * This method also needs to query the previously simulated data, which is passed as a parameter.  The values of the
+     * cells are the previously simulated values (may be no-data values).
      */
-    DataCellPtrMultiset getNeighboringSimGridCellsMT(const GridCell& simulationCell ,
-                                                     const spectral::array &simulatedData) const;
+    void getNeighboringSimGridCellsMT( const GridCell& simulationCell,
+                                       const spectral::array &simulatedData,
+                                       NeighborList& neighbors ) const;
 
 };
 
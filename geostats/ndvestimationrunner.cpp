@@ -180,7 +180,8 @@ double NDVEstimationRunner::krige(GridCell cell, double meanSK, bool hasNDV, dou
 
     //collects valued n-neighbors ordered by their topological distance with respect
     //to the target cell
-	GridCellPtrMultiset vCells;
+	//(the list is a member variable so its memory is reused for all the estimated cells)
+	NeighborList& vCells = _neighbors;
 
 	//collects the data samples (depend on the search neighborhood)
     GeostatsUtils::getValuedNeighborsTopoOrdered( cell,
@@ -192,9 +193,6 @@ double NDVEstimationRunner::krige(GridCell cell, double meanSK, bool hasNDV, dou
                                                            NDV,
                                                            vCells);
 
-	//Make a copy of the sample collection but with generic versions of the objects for the methods transparent to grid information.
-	DataCellPtrMultiset vDataCells( vCells.begin(), vCells.end() );
-
     //if no sample was found, either...
 	if( vCells.empty() ){
         if( _ndvEstimation->useDefaultValue() )
@@ -207,12 +205,12 @@ double NDVEstimationRunner::krige(GridCell cell, double meanSK, bool hasNDV, dou
 
 	//get the matrix of the theoretical covariances between the data sample locations and themselves.
 	// TODO PERFORMANCE: the cov matrix needs only to be computed once.
-	MatrixNXM<double> covMat = GeostatsUtils::makeCovMatrix( vDataCells,
+	MatrixNXM<double> covMat = GeostatsUtils::makeCovMatrix( vCells,
 															 _ndvEstimation->vmodel(),
                                                              variogramSill );
 
 	//get the gamma matrix (theoretical covariances between sample locations and estimation location)
-	MatrixNXM<double> gammaMat = GeostatsUtils::makeGammaMatrix( vDataCells, cell, _ndvEstimation->vmodel(), variogramSill );
+	MatrixNXM<double> gammaMat = GeostatsUtils::makeGammaMatrix( vCells, cell, _ndvEstimation->vmodel(), variogramSill );
 
 	//The eta (after greek letter eta) number is the threshold below which the eigenvalues are rounded off to zero
 	//The eta number and the value are both in Mohammadi et al (2016) paper (see complete reference further below).
@@ -252,9 +250,8 @@ double NDVEstimationRunner::krige(GridCell cell, double meanSK, bool hasNDV, dou
 		//make a spectral::array matrix from the data values (response values).
 		spectral::array y( vCells.size() );
 		{ //make the response-value (sample values) vector y.
-			GridCellPtrMultiset::iterator vit = vCells.begin();
-			for( int i = 0; vit != vCells.end(); ++vit, ++i )
-				y(i) = (*vit)->readValueFromGrid() - meanSK; //these values are actually the residuals with respect to the SK mean.
+			for( int i = 0; i < (int)vCells.size(); ++i )
+				y(i) = vCells[i]._value - meanSK; //these values are actually the residuals with respect to the SK mean.
 		}
 		//Compute the kriging weights with the Pseudoinverse Regularization proposed by Mohammadi et al (2016) - Equation 12.
 		// "An analytic comparison of regularization methods for Gaussian Processes" - https://arxiv.org/pdf/1602.00853.pdf
@@ -280,9 +277,8 @@ double NDVEstimationRunner::krige(GridCell cell, double meanSK, bool hasNDV, dou
 			result += (gammaMat.getTranspose() * weightsSK)(0,0); //(0,0) is to get the single element as a scalar and not as a matrix object.
 		} else {
 			//computing SK the normal way.
-			GridCellPtrMultiset::iterator itSamples = vCells.begin();
-			for( uint i = 0; i < vCells.size(); ++i, ++itSamples){
-				result += weightsSK(i,0) * ( (*itSamples)->readValueFromGrid() - meanSK );
+			for( uint i = 0; i < vCells.size(); ++i ){
+				result += weightsSK(i,0) * ( vCells[i]._value - meanSK );
 			}
 		}
     } else {
@@ -290,12 +286,12 @@ double NDVEstimationRunner::krige(GridCell cell, double meanSK, bool hasNDV, dou
 
 		//get the OK gamma matrix (theoretical covariances between sample locations and estimation location)
 		//TODO: improve performance: Just append 1 to gammaMat.
-		MatrixNXM<double> gammaMatOK = GeostatsUtils::makeGammaMatrix( vDataCells, cell, _ndvEstimation->vmodel(), variogramSill, KrigingType::OK );
+		MatrixNXM<double> gammaMatOK = GeostatsUtils::makeGammaMatrix( vCells, cell, _ndvEstimation->vmodel(), variogramSill, KrigingType::OK );
 
 		//make the OK cov matrix (theoretical covariances between sample locations and themselves)
 		//TODO: improve performance: Just expand SK matrices with the 1.0s and 0.0s instead of computing new ones.
 		// TODO PERFORMANCE: the cov matrix needs only to be computed once.
-		MatrixNXM<double> covMatOK = GeostatsUtils::makeCovMatrix( vDataCells,
+		MatrixNXM<double> covMatOK = GeostatsUtils::makeCovMatrix( vCells,
                                                                    _ndvEstimation->vmodel(),
                                                                    variogramSill,
                                                                    KrigingType::OK );
@@ -379,9 +375,8 @@ double NDVEstimationRunner::krige(GridCell cell, double meanSK, bool hasNDV, dou
 
 		//Estimate the OK local mean (use OK weights)
 		double mOK = 0.0;
-		GridCellPtrMultiset::iterator itSamples = vCells.begin();
-		for( int i = 0; i < weightsOK.getN()-1; ++i, ++itSamples){ //the last element in weightsOK is the Lagrangian (mu)
-			mOK += weightsOK(i,0) * (*itSamples)->readValueFromGrid();
+		for( int i = 0; i < weightsOK.getN()-1; ++i ){ //the last element in weightsOK is the Lagrangian (mu)
+			mOK += weightsOK(i,0) * vCells[i]._value;
 		}
 
 		// re-make the SK kriging weights matrix (solve the kriging system)
@@ -392,9 +387,8 @@ double NDVEstimationRunner::krige(GridCell cell, double meanSK, bool hasNDV, dou
 			//make a spectral::array matrix from the data values (response values).
 			spectral::array y( vCells.size() );
 			{ //make the response-value (sample values) vector y.
-				GridCellPtrMultiset::iterator vit = vCells.begin();
-				for( int i = 0; vit != vCells.end(); ++vit, ++i )
-					y(i) = (*vit)->readValueFromGrid() - mOK; //these values are actually the residuals with respect to the SK mean.
+				for( int i = 0; i < (int)vCells.size(); ++i )
+					y(i) = vCells[i]._value - mOK; //these values are actually the residuals with respect to the SK mean.
 			}
 			//Compute the kriging weights with the Pseudoinverse Regularization proposed by Mohammadi et al (2016) - Equation 12.
 			// "An analytic comparison of regularization methods for Gaussian Processes" - https://arxiv.org/pdf/1602.00853.pdf
@@ -420,9 +414,8 @@ double NDVEstimationRunner::krige(GridCell cell, double meanSK, bool hasNDV, dou
 			result += wmOK * mOK;
 		} else {
 			//computing kriging the normal way.
-			GridCellPtrMultiset::iterator itSamples = vCells.begin();
-			for( uint i = 0; i < vCells.size(); ++i, ++itSamples){
-				result += weightsSK(i,0) * ( (*itSamples)->readValueFromGrid() );
+			for( uint i = 0; i < vCells.size(); ++i ){
+				result += weightsSK(i,0) * ( vCells[i]._value );
 			}
 			result += wmOK * mOK;
 		}
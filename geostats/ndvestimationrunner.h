@@ -3,6 +3,8 @@
 
 #include <QObject>
 
+#include "geostats/neighbor.h"
+
 class Attribute;
 class GridCell;
 class NDVEstimation;
@@ -35,6 +37,9 @@ private:
     NDVEstimation* _ndvEstimation;
     std::vector<double> _results;
 
+    /** The valued cells around the current estimation cell (reused for all cells to avoid memory allocations). */
+    NeighborList _neighbors;
+
 	/** Estimate, by kriging, a single cell.
 	 * @param nIllConditioned its value is increased by the number of ill-conditioned kriging matrices encountered.
 	 * @param nFailed its value is increased by the number of kriging operations that failed (resulted in NaN or inifinity).
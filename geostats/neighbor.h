@@ -0,0 +1,63 @@
+#ifndef NEIGHBOR_H
+#define NEIGHBOR_H
+
+#include "spatiallocation.h"
+#include "ijkindex.h"
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+/** Data structure containing information of a neighboring sample or grid cell found around a target location
+ * (e.g. a cell being estimated or simulated).  Unlike the DataCell classes, it is a plain value with
+ * everything the estimation and simulation loops need, so collecting neighbors requires neither heap
+ * allocations nor virtual calls to read the values nor casts to get the topological coordinates back.
+ */
+struct Neighbor
+{
+    /** Data line index of the sample in its data file (or linear cell index for grids). */
+    unsigned int _index;
+
+    /** Spatial coordinates of the sample (or cell center). */
+    SpatialLocation _center;
+
+    /** The value of the searched variable. */
+    double _value;
+
+    /** The distance (Cartesian or topological, depending on the search) to the target location. */
+    double _distance;
+
+    /** Topological coordinates (i,j,k).  Only set for grid cells. */
+    IJKIndex _indexIJK;
+
+    /** Computes the Cartesian distance to the given location, which is also stored in _distance. */
+    inline double computeCartesianDistance( const SpatialLocation& location ){
+        double dx = _center._x - location._x;
+        double dy = _center._y - location._y;
+        double dz = _center._z - location._z;
+        _distance = std::sqrt( dx*dx + dy*dy + dz*dz );
+        return _distance;
+    }
+};
+
+/** A list of neighbors.  Client code should reuse the same list for all target locations (e.g. one per
+ * thread), since clearing an std::vector keeps its storage.
+ */
+typedef std::vector< Neighbor > NeighborList;
+
+/** Sorts the neighbors by distance (ties are sorted by index so the order does not depend on the search) and
+ * keeps at most the n nearest.  Only the n nearest are sorted (std::partial_sort) when there are more than n.
+ */
+inline void sortNeighborsByDistance( NeighborList& neighbors, size_t n = std::numeric_limits<size_t>::max() ){
+    auto isNearer = []( const Neighbor& n1, const Neighbor& n2 ){
+        return n1._distance < n2._distance || ( n1._distance == n2._distance && n1._index < n2._index );
+    };
+    if( n < neighbors.size() ){
+        std::partial_sort( neighbors.begin(), neighbors.begin() + n, neighbors.end(), isNearer );
+        neighbors.resize( n );
+    } else
+        std::sort( neighbors.begin(), neighbors.end(), isNearer );
+}
+
+#endif // NEIGHBOR_H
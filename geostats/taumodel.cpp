@@ -1,5 +1,6 @@
 #include "taumodel.h"
 #include <cmath>
+#include <algorithm>
 
 TauModel::TauModel( unsigned int nCategories , unsigned int nSources ) :
     m_nCategories( nCategories ),
@@ -28,6 +29,12 @@ void TauModel::setTauFactor(unsigned int sourceIndex,
     m_TauFactors[sourceIndex] = tauFactor;
 }
 
+void TauModel::setProbabilitiesFromSource(unsigned int sourceIndex,
+                                          const double *probabilitiesFromSource)
+{
+    std::copy( probabilitiesFromSource, probabilitiesFromSource + m_nCategories, m_probsOtherSources[sourceIndex].begin() );
+}
+
 double TauModel::getFinalProbability(unsigned int categoryIndex) const
 {
     //get marginal ratio
@@ -46,3 +53,35 @@ double TauModel::getFinalProbability(unsigned int categoryIndex) const
     x *= a;
     return 1.0 / ( 1.0 + x );
 }
+
+void TauModel::getFinalProbabilities(double *finalProbabilities) const
+{
+    //get marginal ratios
+    double a[m_nCategories];
+    for( unsigned int categoryIndex = 0; categoryIndex < m_nCategories; ++categoryIndex ){
+        double pa = m_probsMarginal[ categoryIndex ];
+        a[ categoryIndex ] = ( 1.0 - pa ) / pa;
+    }
+
+    //update ratios with the sources of information, one source at a time so the loops run over contiguous values
+    double x[m_nCategories];
+    std::fill( x, x + m_nCategories, 1.0 );
+    for( unsigned int sourceIndex = 0; sourceIndex < m_probsOtherSources.size(); ++sourceIndex ){
+        const double* pb = m_probsOtherSources[sourceIndex].data();
+        double tauFactor = m_TauFactors[sourceIndex];
+        if( tauFactor == 1.0 )
+            for( unsigned int categoryIndex = 0; categoryIndex < m_nCategories; ++categoryIndex ){
+                double b = pb[categoryIndex]==0.0 ? 1000.0 : ( ( 1.0 - pb[categoryIndex] ) / pb[categoryIndex] );
+                x[categoryIndex] *= b / a[categoryIndex];
+            }
+        else
+            for( unsigned int categoryIndex = 0; categoryIndex < m_nCategories; ++categoryIndex ){
+                double b = pb[categoryIndex]==0.0 ? 1000.0 : ( ( 1.0 - pb[categoryIndex] ) / pb[categoryIndex] );
+                x[categoryIndex] *= std::pow( b / a[categoryIndex], tauFactor );
+            }
+    }
+
+    //solving for the final probabilities (see DOxygen comment of this class for the formulation)
+    for( unsigned int categoryIndex = 0; categoryIndex < m_nCategories; ++categoryIndex )
+        finalProbabilities[ categoryIndex ] = 1.0 / ( 1.0 + x[categoryIndex] * a[categoryIndex] );
+}
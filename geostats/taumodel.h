@@ -60,8 +60,17 @@ public:
     void setTauFactor( unsigned int sourceIndex,
                        double tauFactor );
 
+    /** Sets the probabilities of all categories given by a source (an array with one value per category). */
+    void setProbabilitiesFromSource( unsigned int sourceIndex,
+                                     const double* probabilitiesFromSource );
+
     double getFinalProbability( unsigned int categoryIndex ) const;
 
+    /** Same as getFinalProbability() for all categories at once (an array with one value per category).
+     *  This is faster, especially when the Tau Factors are 1.0 (no calls to std::pow()).
+     */
+    void getFinalProbabilities( double* finalProbabilities ) const;
+
 private:
     unsigned int m_nCategories;
     std::vector<double> m_probsMarginal;
@@ -0,0 +1,109 @@
+#include "transiogramtable.h"
+#include "domain/verticaltransiogrammodel.h"
+#include "domain/categorydefinition.h"
+
+#include <algorithm>
+#include <cstdint>
+
+/** Facies codes spanning a larger range are looked up by binary search instead of in a dense table. */
+static const int64_t MAX_DENSE_CODE_SPAN = 1 << 16;
+
+TransiogramTable::TransiogramTable(const VerticalTransiogramModel &transiogramModel,
+                                   CategoryDefinition *cd,
+                                   double maxSeparation,
+                                   unsigned int nSteps) :
+    m_transiogramModel( transiogramModel ),
+    m_nCategories( cd->getCategoryCount() ),
+    m_nSteps( std::max( 1u, nSteps ) ),
+    m_maxSeparation( maxSeparation > 0.0 ? maxSeparation : 0.0 ),
+    m_stepsPerUnitSeparation( maxSeparation > 0.0 ? m_nSteps / maxSeparation : 0.0 ),
+    m_minFaciesCode( 0 )
+{
+    //get the facies codes and build the code-to-index lookup table
+    for( unsigned int i = 0; i < m_nCategories; ++i )
+        m_categoryCodes.push_back( cd->getCategoryCode( i ) );
+    if( m_nCategories > 0 ){
+        m_minFaciesCode = *std::min_element( m_categoryCodes.begin(), m_categoryCodes.end() );
+        int maxFaciesCode = *std::max_element( m_categoryCodes.begin(), m_categoryCodes.end() );
+        //the span is computed in 64 bits, as codes far apart overflow an int
+        int64_t span = static_cast<int64_t>( maxFaciesCode ) - static_cast<int64_t>( m_minFaciesCode ) + 1;
+        if( span <= MAX_DENSE_CODE_SPAN ){
+            m_categoryIndexesByCode.assign( span, -1 );
+            for( unsigned int i = 0; i < m_nCategories; ++i )
+                m_categoryIndexesByCode[ m_categoryCodes[i] - m_minFaciesCode ] = i;
+        } else {
+            for( unsigned int i = 0; i < m_nCategories; ++i )
+                m_sortedCodesAndIndexes.push_back( std::make_pair( m_categoryCodes[i], (int)i ) );
+            std::sort( m_sortedCodesAndIndexes.begin(), m_sortedCodesAndIndexes.end(),
+                       []( const std::pair< int, int >& a, const std::pair< int, int >& b ){ return a.first < b.first; } );
+        }
+    }
+
+    //sample the transiograms
+    if( m_stepsPerUnitSeparation > 0.0 ){
+        m_probabilities.resize( (size_t)m_nCategories * ( m_nSteps + 1 ) * m_nCategories );
+        double* probability = m_probabilities.data();
+        for( unsigned int iFrom = 0; iFrom < m_nCategories; ++iFrom )
+            for( unsigned int iStep = 0; iStep <= m_nSteps; ++iStep ){
+                double h = iStep * ( m_maxSeparation / m_nSteps );
+                for( unsigned int iTo = 0; iTo < m_nCategories; ++iTo, ++probability )
+                    *probability = m_transiogramModel.getTransitionProbability( m_categoryCodes[iFrom],
+                                                                                m_categoryCodes[iTo], h );
+            }
+    }
+}
+
+double TransiogramTable::getTransitionProbability(int fromFaciesCode, int toFaciesCode, double h) const
+{
+    int iFrom = getCategoryIndex( fromFaciesCode );
+    int iTo = getCategoryIndex( toFaciesCode );
+    if( iFrom < 0 || iTo < 0 )
+        return 0.0;
+    if( ! ( h <= m_maxSeparation ) || m_probabilities.empty() )
+        return m_transiogramModel.getTransitionProbability( fromFaciesCode, toFaciesCode, h );
+    double step = std::max( 0.0, h * m_stepsPerUnitSeparation );
+    unsigned int iStep = std::min( static_cast<unsigned int>( step ), m_nSteps - 1 );
+    double weight = step - iStep;
+    const double* probabilities = m_probabilities.data() + ( (size_t)iFrom * ( m_nSteps + 1 ) + iStep ) * m_nCategories;
+    return probabilities[iTo] + weight * ( probabilities[ m_nCategories + iTo ] - probabilities[iTo] );
+}
+
+void TransiogramTable::multiplyTransitionProbabilities(int fromFaciesCode, double h, double *probabilities) const
+{
+    int iFrom = getCategoryIndex( fromFaciesCode );
+    if( iFrom < 0 ){
+        std::fill( probabilities, probabilities + m_nCategories, 0.0 );
+        return;
+    }
+    //separations beyond the table are evaluated with the model
+    if( ! ( h <= m_maxSeparation ) || m_probabilities.empty() ){
+        for( unsigned int iTo = 0; iTo < m_nCategories; ++iTo )
+            probabilities[iTo] *= m_transiogramModel.getTransitionProbability( fromFaciesCode, m_categoryCodes[iTo], h );
+        return;
+    }
+    //interpolate between the two rows of probabilities around h (they are contiguous in the table)
+    double step = std::max( 0.0, h * m_stepsPerUnitSeparation );
+    unsigned int iStep = std::min( static_cast<unsigned int>( step ), m_nSteps - 1 );
+    double weight = step - iStep;
+    const double* before = m_probabilities.data() + ( (size_t)iFrom * ( m_nSteps + 1 ) + iStep ) * m_nCategories;
+    const double* after = before + m_nCategories;
+    for( unsigned int iTo = 0; iTo < m_nCategories; ++iTo )
+        probabilities[iTo] *= before[iTo] + weight * ( after[iTo] - before[iTo] );
+}
+
+int TransiogramTable::getCategoryIndex(int faciesCode) const
+{
+    if( ! m_sortedCodesAndIndexes.empty() ){
+        std::vector< std::pair< int, int > >::const_iterator it =
+                std::lower_bound( m_sortedCodesAndIndexes.begin(), m_sortedCodesAndIndexes.end(), faciesCode,
+                                  []( const std::pair< int, int >& a, int code ){ return a.first < code; } );
+        if( it == m_sortedCodesAndIndexes.end() || it->first != faciesCode )
+            return -1;
+        return it->second;
+    }
+    //the subtraction is done in unsigned arithmetic so codes below the minimum are also out of range
+    size_t i = static_cast<size_t>( static_cast<unsigned int>( faciesCode ) - static_cast<unsigned int>( m_minFaciesCode ) );
+    if( i >= m_categoryIndexesByCode.size() )
+        return -1;
+    return m_categoryIndexesByCode[i];
+}
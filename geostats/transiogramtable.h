@@ -0,0 +1,83 @@
+#ifndef TRANSIOGRAMTABLE_H
+#define TRANSIOGRAMTABLE_H
+
+#include <vector>
+#include <memory>
+#include <utility>
+
+class VerticalTransiogramModel;
+class CategoryDefinition;
+
+/**
+ * The TransiogramTable class holds the transition probabilities of a VerticalTransiogramModel sampled at
+ * regular separations, so they can be read with a linear interpolation instead of evaluating the
+ * transiogram model (code lookups in maps, switch over structure types, exp(), pow(), etc.).
+ * It is meant for performance-critical code such as the MCRF simulation, which queries the transition
+ * probabilities of every candidate facies for every neighbor of every simulated cell.
+ *
+ * The probabilities are stored in a single flat array indexed by [from facies][separation step][to facies],
+ * with the facies in the order of the CategoryDefinition, so the probabilities of all "to" facies at a given
+ * separation are contiguous in memory.  Separations beyond the sampled range are evaluated with the model.
+ * The model and the CategoryDefinition must be loaded before building the table and the model must outlive it.
+ * All the query methods are const and can be called from multiple threads.
+ */
+class TransiogramTable
+{
+public:
+    /**
+     * @param transiogramModel The model whose transiograms will be sampled.
+     * @param cd The facies (and their order) of the table.  Normally, the CategoryDefinition of the model.
+     * @param maxSeparation The separations in [0, maxSeparation] are sampled.  Normally, a few times the
+     *                      longest range of the model (see VerticalTransiogramModel::getLongestRange()).
+     * @param nSteps The number of intervals between the sampled separations.
+     */
+    TransiogramTable( const VerticalTransiogramModel& transiogramModel,
+                      CategoryDefinition* cd,
+                      double maxSeparation,
+                      unsigned int nSteps = 4096 );
+
+    /** Returns the number of facies of the table (the "to" facies of multiplyTransitionProbabilities()). */
+    unsigned int getCategoryCount() const { return m_nCategories; }
+
+    /**
+     * Returns the probability of the transition from one facies to another at a given separation h.
+     * Same as VerticalTransiogramModel::getTransitionProbability(), except for the interpolation.
+     */
+    double getTransitionProbability( int fromFaciesCode, int toFaciesCode, double h ) const;
+
+    /**
+     * Multiplies each probabilities[i] by the probability of the transition from the given facies to the
+     * i-th facies of the CategoryDefinition at the separation h (i = 0..getCategoryCount()-1).
+     * If the "from" facies is not in the table, all the probabilities are set to zero (zero probability of
+     * transition, like in VerticalTransiogramModel::getTransitionProbability()).
+     */
+    void multiplyTransitionProbabilities( int fromFaciesCode, double h, double* probabilities ) const;
+
+private:
+    const VerticalTransiogramModel& m_transiogramModel;
+    unsigned int m_nCategories;
+    unsigned int m_nSteps;
+    double m_maxSeparation;
+    double m_stepsPerUnitSeparation;
+
+    /** The facies codes in CategoryDefinition order. */
+    std::vector< int > m_categoryCodes;
+
+    //the category index of each facies code (the code minus m_minFaciesCode is the index) or -1.
+    //Empty if the codes span too large a range (e.g. codes 1 and 1000000), see m_sortedCodesAndIndexes.
+    std::vector< int > m_categoryIndexesByCode;
+    int m_minFaciesCode;
+
+    //the ( facies code, category index ) pairs sorted by code, for codes spanning too large a range for the table above.
+    std::vector< std::pair< int, int > > m_sortedCodesAndIndexes;
+
+    /** The sampled probabilities: [from facies][separation step][to facies]. */
+    std::vector< double > m_probabilities;
+
+    /** Returns the category index of a facies code or -1 if it is not in the table. */
+    int getCategoryIndex( int faciesCode ) const;
+};
+
+typedef std::shared_ptr< TransiogramTable > TransiogramTablePtr;
+
+#endif // TRANSIOGRAMTABLE_H
@@ -13,6 +13,7 @@
 #include <vtkPolyData.h>
 #include <vtkPointData.h>
 #include <QMessageBox>
+#include <thread>
 #include "imagejockey/ijabstractvariable.h"
 
 EMDAnalysisDialog::EMDAnalysisDialog(IJAbstractCartesianGrid *inputGrid, uint inputVariableIndex, QWidget *parent) :
@@ -98,34 +99,33 @@ void EMDAnalysisDialog::onPerformEMD()
 
         //initialize the extrema envelopes with the extrema points
         // Step (1) in Linderhed (2009)
-        if( ui->cmbExtremaType->currentText() == "points" ){
-            localMaximaEnvelope = spectral::get_extrema_cells( *currentSignal,
-                                                               spectral::ExtremumType::MAXIMUM,
-                                                               halfWindowSize,
-                                                               extremaThresholdAbs,
-                                                               localMaximaCount );
-            localMinimaEnvelope = spectral::get_extrema_cells( *currentSignal,
-                                                               spectral::ExtremumType::MINIMUM,
-                                                               halfWindowSize,
-                                                               extremaThresholdAbs,
-                                                               localMinimaCount );
-        } else {
-            localMaximaEnvelope = spectral::get_ridges_or_valleys( *currentSignal,
-                                                                   spectral::ExtremumType::MAXIMUM,
-                                                                   halfWindowSize,
-                                                                   extremaThresholdAbs,
-                                                                   localMaximaCount );
-            localMinimaEnvelope = spectral::get_ridges_or_valleys( *currentSignal,
-                                                                   spectral::ExtremumType::MINIMUM,
-                                                                   halfWindowSize,
-                                                                   extremaThresholdAbs,
-                                                                   localMinimaCount );
-            //getting the ridges and valleys often result in thick lines, which means way more
-            //samples than necessary to interpolate them.  These excess samples unnecessarily
-            //increase the matrices in the interpolation steps.  Thus we need to get the center
-            //lines of the valeys and ridges.
-            localMaximaEnvelope = ImageJockeyUtils::skeletonize( localMaximaEnvelope );
-            localMinimaEnvelope = ImageJockeyUtils::skeletonize( localMinimaEnvelope );
+        //the maxima and the minima are searched for in parallel.
+        bool extremaArePoints = ui->cmbExtremaType->currentText() == "points";
+        auto getExtrema = [&]( spectral::ExtremumType extremumType, spectral::array& envelope, int& count ){
+            if( extremaArePoints ){
+                envelope = spectral::get_extrema_cells( *currentSignal,
+                                                        extremumType,
+                                                        halfWindowSize,
+                                                        extremaThresholdAbs,
+                                                        count );
+            } else {
+                envelope = spectral::get_ridges_or_valleys( *currentSignal,
+                                                            extremumType,
+                                                            halfWindowSize,
+                                                            extremaThresholdAbs,
+                                                            count );
+                //getting the ridges and valleys often result in thick lines, which means way more
+                //samples than necessary to interpolate them.  These excess samples unnecessarily
+                //increase the matrices in the interpolation steps.  Thus we need to get the center
+                //lines of the valeys and ridges.
+                envelope = ImageJockeyUtils::skeletonize( envelope );
+            }
+        };
+        {
+            std::thread minimaThread( getExtrema, spectral::ExtremumType::MINIMUM,
+                                      std::ref( localMinimaEnvelope ), std::ref( localMinimaCount ) );
+            getExtrema( spectral::ExtremumType::MAXIMUM, localMaximaEnvelope, localMaximaCount );
+            minimaThread.join();
         }
 
         //perform some checks before proceeding to interpolation of the extrema points
@@ -164,40 +164,53 @@ void EMDAnalysisDialog::onPerformEMD()
         // Step (2) in Linderhed (2009)
         spectral::array interpolatedMaximaEnvelope;
         spectral::array interpolatedMinimaEnvelope;
-        if( ui->cmbInterpolationMethod->currentText() == "Shepard" ){
-            interpolatedMaximaEnvelope = ImageJockeyUtils::interpolateNullValuesShepard( localMaximaEnvelope,
-                                                            *m_inputGrid,
-                                                            ui->dblSpinPowerParameter->value(),
-                                                            ui->dblSpinMaxDistance->value(),
-                                                            NDV );
-
-            interpolatedMinimaEnvelope = ImageJockeyUtils::interpolateNullValuesShepard( localMinimaEnvelope,
-                                                            *m_inputGrid,
-                                                            ui->dblSpinPowerParameter->value(),
-                                                            ui->dblSpinMaxDistance->value(),
-                                                            NDV );
-        } else {
-            int status;
-            interpolatedMaximaEnvelope = ImageJockeyUtils::interpolateNullValuesThinPlateSpline( localMaximaEnvelope,
-                                                            *m_inputGrid,
-                                                            ui->dblSpinLambda->value(),
-                                                            status );
-            if( status ){
-                QMessageBox::critical( this, "Error",
-                                       "EMD terminated because interpolation with Thin Plate Spline terminated prematurely. termination code = " +
-                                       QString::number( status ));
-                return;
-            }
-            interpolatedMinimaEnvelope = ImageJockeyUtils::interpolateNullValuesThinPlateSpline( localMinimaEnvelope,
-                                                            *m_inputGrid,
-                                                            ui->dblSpinLambda->value(),
-                                                            status );
-            if( status ){
-                QMessageBox::critical( this, "Error",
-                                       "EMD terminated because interpolation with Thin Plate Spline terminated prematurely. termination code = " +
-                                       QString::number( status ));
-                return;
-            }
+        //the two envelopes are interpolated in parallel.
+        QString interpolationMethod = ui->cmbInterpolationMethod->currentText();
+        double powerParameter = ui->dblSpinPowerParameter->value();
+        double maxDistance = ui->dblSpinMaxDistance->value();
+        int maxNeighbors = ui->spinMaxNeighbors->value();
+        double diagonalLength = m_inputGrid->getDiagonalLength();
+        double lambda = ui->dblSpinLambda->value();
+        auto interpolate = [&]( const spectral::array& extrema, spectral::array& envelope, int& status ){
+            status = 0;
+            if( interpolationMethod == "Shepard" )
+                envelope = ImageJockeyUtils::interpolateNullValuesShepard( extrema,
+                                                                           *m_inputGrid,
+                                                                           powerParameter,
+                                                                           maxDistance,
+                                                                           NDV );
+            else if( interpolationMethod == "Shepard (nearest neighbors)" )
+                //the max. distance is a fraction of the grid's diagonal, as in vtkShepardMethod (1.0 means no limit).
+                envelope = ImageJockeyUtils::interpolateNullValuesShepardNeighborhood( extrema,
+                                                                                       *m_inputGrid,
+                                                                                       powerParameter,
+                                                                                       maxNeighbors,
+                                                                                       maxDistance < 1.0 ?
+                                                                                           maxDistance * diagonalLength : 0.0,
+                                                                                       NDV );
+            else if( interpolationMethod == "Multilevel B-Spline" )
+                envelope = ImageJockeyUtils::interpolateNullValuesMBA( extrema,
+                                                                       *m_inputGrid,
+                                                                       0,
+                                                                       NDV );
+            else
+                envelope = ImageJockeyUtils::interpolateNullValuesThinPlateSpline( extrema,
+                                                                                   *m_inputGrid,
+                                                                                   lambda,
+                                                                                   status );
+        };
+        int statusMaxima, statusMinima;
+        {
+            std::thread minimaThread( interpolate, std::cref( localMinimaEnvelope ),
+                                      std::ref( interpolatedMinimaEnvelope ), std::ref( statusMinima ) );
+            interpolate( localMaximaEnvelope, interpolatedMaximaEnvelope, statusMaxima );
+            minimaThread.join();
+        }
+        if( statusMaxima || statusMinima ){
+            QMessageBox::critical( this, "Error",
+                                   "EMD terminated because interpolation with Thin Plate Spline terminated prematurely. termination code = " +
+                                   QString::number( statusMaxima ? statusMaxima : statusMinima ));
+            return;
         }
         //Debug the interpolated envelopes
 //        IJGridViewerWidget* ijgw = new IJGridViewerWidget( true, false, true, nullptr );
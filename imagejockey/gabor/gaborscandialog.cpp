@@ -1,41 +1,10 @@
 #include "gaborscandialog.h"
 #include "ui_gaborscandialog.h"
-#include "imagejockey/gabor/gaborutils.h"
+#include "imagejockey/gabor/gaborscanengine.h"
 #include "imagejockey/widgets/ijgridviewerwidget.h"
 #include "imagejockey/svd/svdfactor.h"
 #include "spectral/spectral.h"
-#include <itkStatisticsImageFilter.h>
-#include <itkAbsImageFilter.h>
 #include <QProgressDialog>
-#include <thread>
-
-/** The code for multithreaded convolution *////////////////////////
-void taskConvolution( double frequency,
-             double azimuth,
-             double meanMajorAxis,
-             double meanMinorAxis,
-             double sigmaMajorAxis,
-             double sigmaMinorAxis,
-             int kernelSizeI,
-             int kernelSizeJ,
-             const spectral::array &inputGrid,
-             bool imaginaryPart,
-             GaborUtils::ImageTypePtr* response
-           ){
-             *response =
-                GaborUtils::computeGaborResponse( frequency,
-                                                  azimuth,
-                                                  meanMajorAxis,
-                                                  meanMinorAxis,
-                                                  sigmaMajorAxis,
-                                                  sigmaMinorAxis,
-                                                  kernelSizeI,
-                                                  kernelSizeJ,
-                                                  inputGrid,
-                                                  imaginaryPart );
-}
-///////////////////////////////////////////////////////////////////////////////
-
 
 GaborScanDialog::GaborScanDialog(IJAbstractCartesianGrid *inputGrid,
                                  uint inputVariableIndex,
@@ -55,7 +24,8 @@ GaborScanDialog::GaborScanDialog(IJAbstractCartesianGrid *inputGrid,
     m_sigmaMajorAxis( sigmaMajorAxis ),
     m_sigmaMinorAxis( sigmaMinorAxis ),
     m_kernelSizeI( kernelSizeI ),
-    m_kernelSizeJ( kernelSizeJ )
+    m_kernelSizeJ( kernelSizeJ ),
+    m_scanEngine( nullptr )
 {
     ui->setupUi(this);
 
@@ -71,6 +41,7 @@ GaborScanDialog::GaborScanDialog(IJAbstractCartesianGrid *inputGrid,
 
 GaborScanDialog::~GaborScanDialog()
 {
+    delete m_scanEngine;
     delete ui;
 }
 
@@ -95,23 +66,27 @@ void GaborScanDialog::updateFrequAzSelectionDisplay()
 
 void GaborScanDialog::onScan()
 {
-    typedef itk::StatisticsImageFilter<GaborUtils::ImageType> StatisticsImageFilterType;
-    typedef itk::AbsImageFilter <GaborUtils::ImageType, GaborUtils::ImageType> AbsImageFilterType;
-
     double az0 = 0.0;
     double az1 = 180.0;
 
-    int nI = m_inputGrid->getNI();
-    int nJ = m_inputGrid->getNJ();
-
     //get the user settings
     double azStep = ui->txtAzStep->text().toDouble();
     double fStep = ui->txtFStep->text().toDouble();
     double f0 = ui->txtF0->text().toDouble();
     double f1 = ui->txtF1->text().toDouble();
 
-    //convert the input data to spectral::array
-    spectral::arrayPtr inputImage( m_inputGrid->createSpectralArray( m_inputVariableIndex ) );
+    //the scan engine keeps the FFT of the input and the Gabor kernels already computed between scans
+    if( ! m_scanEngine ){
+        //convert the input data to spectral::array
+        spectral::arrayPtr inputImage( m_inputGrid->createSpectralArray( m_inputVariableIndex ) );
+        m_scanEngine = new GaborScanEngine( *inputImage,
+                                            m_meanMajorAxis,
+                                            m_meanMinorAxis,
+                                            m_sigmaMajorAxis,
+                                            m_sigmaMinorAxis,
+                                            m_kernelSizeI,
+                                            m_kernelSizeJ );
+    }
 
     //define the list of azimuths to scan
     std::vector<double> azSchedule;
@@ -123,6 +98,10 @@ void GaborScanDialog::onScan()
     for( double frequency = f0; frequency <= f1; frequency += fStep )
         fSchedule.push_back( frequency );
 
+    GaborScanEngine::Metric metric = GaborScanEngine::Metric::MEAN;
+    if( ui->cmbMetric->currentText() == "maximum" )
+        metric = GaborScanEngine::Metric::MAXIMUM;
+
     //////////////////////////////////
     QProgressDialog progressDialog;
     progressDialog.show();
@@ -132,96 +111,27 @@ void GaborScanDialog::onScan()
     progressDialog.show();
     /////////////////////////////////
 
-    //create a grid object to receive the metric values during the scan
-    spectral::array gridData( static_cast<spectral::index>(fSchedule.size()),
-                              static_cast<spectral::index>(azSchedule.size()) );
-
-
-    //scan frequencies and azimuths
-    spectral::index iAz = 0;
-    const int MEAN = 0;
-    const int MAX = 1;
-    int whichMetric = 2;
-    if( ui->cmbMetric->currentText() == "mean" )
-        whichMetric = MEAN;
-    if( ui->cmbMetric->currentText() == "maximum" )
-        whichMetric = MAX;
-    for( const double& azimuth : azSchedule ){
-        spectral::index iF = 0;
-        for( const double& frequency : fSchedule ){
-            //update the progress dialog
-            progressDialog.setValue( progressDialog.value()+1 );
+    //scan frequencies and azimuths (rows are frequencies and columns are azimuths),
+    //showing the partial results as they come.
+    SVDFactor* partialGrid = nullptr;
+    spectral::array gridData = m_scanEngine->scan( fSchedule, azSchedule, metric,
+        [&]( const spectral::array& partialResult, unsigned int done, unsigned int total ){
+            Q_UNUSED( total );
+            progressDialog.setValue( done );
+            SVDFactor* grid = new SVDFactor( spectral::array( partialResult ),
+                                             1, 0.42, f0, az0, 0.0, fStep, azStep, 1.0, 0.0 );
+            m_ijgv->setFactor( grid );
+            delete partialGrid;
+            partialGrid = grid;
             QApplication::processEvents();
-            //compute the Gabor responses of a given frequency-azimuth pair
-
-            //run the imaginary part in a separate thread
-            GaborUtils::ImageTypePtr responseImagPart;
-            std::thread thread = std::thread( taskConvolution,
-                                  frequency,
-                                  azimuth,
-                                    m_meanMajorAxis,
-                                    m_meanMinorAxis,
-                                    m_sigmaMajorAxis,
-                                    m_sigmaMinorAxis,
-                                    m_kernelSizeI,
-                                    m_kernelSizeJ,
-                                    *inputImage,
-                                    true,
-                                    &responseImagPart
-                                  );
-
-            GaborUtils::ImageTypePtr responseRealPart =
-                    GaborUtils::computeGaborResponse( frequency,
-                                                      azimuth,
-                                                      m_meanMajorAxis,
-                                                      m_meanMinorAxis,
-                                                      m_sigmaMajorAxis,
-                                                      m_sigmaMinorAxis,
-                                                      m_kernelSizeI,
-                                                      m_kernelSizeJ,
-                                                      *inputImage,
-                                                      false);
-
-            //wait for the imaginary part thread to finish.
-            thread.join();
-
-            //compute the metrics
-            GaborUtils::realType max = std::numeric_limits<GaborUtils::realType>::min();
-            GaborUtils::realType mean = 0.0;
-            for(unsigned int j = 0; j < nJ; ++j)
-                for(unsigned int i = 0; i < nI; ++i){
-                    itk::Index<GaborUtils::gridDim> index;
-                    index[0] = i;
-                    index[1] = j;
-                    GaborUtils::realType rValue = responseRealPart->GetPixel( index );
-                    GaborUtils::realType iValue = responseImagPart->GetPixel( index );
-                    std::complex<GaborUtils::realType> cValue( rValue, iValue );
-                    GaborUtils::realType amplitude = std::abs( cValue );
-                    if( amplitude > max )
-                        max = amplitude;
-                    mean += amplitude;
-                }
-            mean /= ( nI * nJ );
-
-            //get the metric
-            double metric;
-            switch( whichMetric ){
-            case MEAN: metric = mean; break;
-            case MAX: metric = max; break;
-            default: metric = 0.0;
-            }
-
-            //assing the metric to the frequency/azimuth space
-            gridData(iF, iAz) = metric;
-            ++iF;
-        }
-        ++iAz;
-    }
+            return ! progressDialog.wasCanceled();
+        });
 
     //show the scan result
     SVDFactor* grid = new SVDFactor( std::move(gridData),
                                      1, 0.42, f0, az0, 0.0, fStep, azStep, 1.0, 0.0 );
     m_ijgv->setFactor( grid );
+    delete partialGrid;
 }
 
 void GaborScanDialog::onAddSelection()
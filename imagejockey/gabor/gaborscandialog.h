@@ -6,6 +6,7 @@
 
 class IJAbstractCartesianGrid;
 class IJGridViewerWidget;
+class GaborScanEngine;
 
 namespace Ui {
 class GaborScanDialog;
@@ -47,6 +48,9 @@ private:
 
     GaborFrequencyAzimuthSelections m_freqAzSelections;
 
+    /** Created in the first scan and reused by the next ones. */
+    GaborScanEngine* m_scanEngine;
+
     void updateFrequAzSelectionDisplay();
 
 private Q_SLOTS:
@@ -0,0 +1,234 @@
+#include "gaborscanengine.h"
+#include "imagejockey/gabor/gaborutils.h"
+#include "spectral/fftservice.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+GaborScanEngine::GaborScanEngine(const spectral::array &inputGrid,
+                                 double meanMajorAxis,
+                                 double meanMinorAxis,
+                                 double sigmaMajorAxis,
+                                 double sigmaMinorAxis,
+                                 int kernelSizeI,
+                                 int kernelSizeJ) :
+    m_input( inputGrid ),
+    m_meanMajorAxis( meanMajorAxis ),
+    m_meanMinorAxis( meanMinorAxis ),
+    m_sigmaMajorAxis( sigmaMajorAxis ),
+    m_sigmaMinorAxis( sigmaMinorAxis ),
+    m_kernelSizeI( kernelSizeI ),
+    m_kernelSizeJ( kernelSizeJ ),
+    m_paddedM( inputGrid.M() + kernelSizeI - 1 ),
+    m_paddedN( inputGrid.N() + kernelSizeJ - 1 ),
+    m_inputSpectrum( nullptr )
+{
+}
+
+GaborScanEngine::~GaborScanEngine()
+{
+    if( m_inputSpectrum )
+        fftw_free( m_inputSpectrum );
+}
+
+spectral::array GaborScanEngine::scan(const std::vector<double> &frequencies,
+                                      const std::vector<double> &azimuths,
+                                      GaborScanEngine::Metric metric,
+                                      GaborScanEngine::ProgressCallback progressCallback,
+                                      unsigned int nThreads)
+{
+    unsigned int nAzimuths = azimuths.size();
+    unsigned int total = frequencies.size() * nAzimuths;
+
+    spectral::array result( static_cast<spectral::index>( frequencies.size() ),
+                            static_cast<spectral::index>( nAzimuths ),
+                            std::numeric_limits<double>::quiet_NaN() );
+    if( total == 0 )
+        return result;
+
+    if( ! m_inputSpectrum )
+        computeInputSpectrum();
+
+    if( nThreads == 0 )
+        nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    nThreads = std::min( nThreads, total );
+
+    //the kernels not yet in the bank are made by the tasks and added to the bank at the end
+    //(the bank is read-only during the scan).
+    std::vector< Kernel > newKernels( total );
+
+    std::atomic<unsigned int> nextTask( 0 );
+    std::atomic<bool> cancelled( false );
+
+    //the metrics computed by the threads waiting to be collected by the calling thread.
+    std::vector< std::pair<unsigned int, double> > finished;
+    unsigned int finishedCount = 0;
+    std::mutex mutexFinished;
+    std::condition_variable allFinished;
+
+    auto worker = [&](){
+        spectral::index paddedSize = m_paddedM * m_paddedN;
+        fftw_complex* work1 = fftw_alloc_complex( paddedSize );
+        fftw_complex* work2 = fftw_alloc_complex( paddedSize );
+        while( ! cancelled ){
+            unsigned int iTask = nextTask++;
+            if( iTask >= total )
+                break;
+            double frequency = frequencies[ iTask / nAzimuths ];
+            double azimuth = azimuths[ iTask % nAzimuths ];
+            const Kernel* kernel;
+            std::map< std::pair<double, double>, Kernel >::const_iterator it =
+                    m_kernelBank.find( std::make_pair( frequency, azimuth ) );
+            if( it != m_kernelBank.end() )
+                kernel = &it->second;
+            else {
+                newKernels[ iTask ] = makeKernel( frequency, azimuth );
+                kernel = &newKernels[ iTask ];
+            }
+            double value = computeMetric( *kernel, metric, work1, work2 );
+            {
+                std::unique_lock<std::mutex> lock( mutexFinished );
+                finished.emplace_back( iTask, value );
+                if( ++finishedCount == total )
+                    allFinished.notify_one();
+            }
+        }
+        fftw_free( work1 );
+        fftw_free( work2 );
+    };
+
+    std::vector< std::thread > threads;
+    for( unsigned int iThread = 0; iThread < nThreads; ++iThread )
+        threads.emplace_back( worker );
+
+    //collect the results periodically, so the caller can report progress and show partial results.
+    unsigned int done = 0;
+    while( done < total ){
+        {
+            std::unique_lock<std::mutex> lock( mutexFinished );
+            allFinished.wait_for( lock, std::chrono::milliseconds( 200 ),
+                                  [&finishedCount, total]{ return finishedCount == total; } );
+            for( const std::pair<unsigned int, double>& taskResult : finished )
+                result( taskResult.first / nAzimuths, taskResult.first % nAzimuths ) = taskResult.second;
+            done += finished.size();
+            finished.clear();
+        }
+        if( progressCallback && ! progressCallback( result, done, total ) ){
+            cancelled = true;
+            break;
+        }
+    }
+
+    for( std::thread& thread : threads )
+        thread.join();
+
+    //collect the results finished after a cancellation.
+    for( const std::pair<unsigned int, double>& taskResult : finished )
+        result( taskResult.first / nAzimuths, taskResult.first % nAzimuths ) = taskResult.second;
+
+    //keep the new kernels for the next scans.
+    for( unsigned int iTask = 0; iTask < total; ++iTask )
+        if( ! newKernels[ iTask ].empty() )
+            m_kernelBank[ std::make_pair( frequencies[ iTask / nAzimuths ], azimuths[ iTask % nAzimuths ] ) ] =
+                    std::move( newKernels[ iTask ] );
+
+    return result;
+}
+
+GaborScanEngine::Kernel GaborScanEngine::makeKernel(double frequency, double azimuth) const
+{
+    //the real and imaginary part kernels are normalized separately, as in GaborUtils::computeGaborResponse().
+    spectral::array kernelParts[2];
+    for( int iPart = 0; iPart < 2; ++iPart ){
+        GaborUtils::ImageTypePtr kernel = GaborUtils::createGaborKernel( frequency,
+                                                                         azimuth,
+                                                                         m_meanMajorAxis,
+                                                                         m_meanMinorAxis,
+                                                                         m_sigmaMajorAxis,
+                                                                         m_sigmaMinorAxis,
+                                                                         m_kernelSizeI,
+                                                                         m_kernelSizeJ,
+                                                                         iPart == 1 );
+        kernelParts[iPart] = GaborUtils::convertITKImageToSpectralArray( *kernel );
+        spectral::normalize( kernelParts[iPart] );
+    }
+
+    Kernel result( m_kernelSizeI * m_kernelSizeJ );
+    for( spectral::index i = 0; i < (spectral::index)result.size(); ++i )
+        result[i] = std::complex<double>( kernelParts[0][i], kernelParts[1][i] );
+    return result;
+}
+
+void GaborScanEngine::computeInputSpectrum()
+{
+    spectral::index paddedSize = m_paddedM * m_paddedN;
+    fftw_complex* padded = fftw_alloc_complex( paddedSize );
+    std::memset( padded, 0, sizeof(fftw_complex) * paddedSize );
+    //NaNs and infinities are treated as zeros, as in spectral::conv2d().
+    for( spectral::index i = 0; i < m_input.M(); ++i )
+        for( spectral::index j = 0; j < m_input.N(); ++j ){
+            double value = m_input( i, j );
+            padded[ i * m_paddedN + j ][0] = std::isfinite( value ) ? value : 0.0;
+        }
+    m_inputSpectrum = fftw_alloc_complex( paddedSize );
+    spectral::FFTService::instance().c2c( padded, m_inputSpectrum, FFTW_FORWARD, 2, m_paddedM, m_paddedN );
+    fftw_free( padded );
+}
+
+double GaborScanEngine::computeMetric(const GaborScanEngine::Kernel &kernel,
+                                      GaborScanEngine::Metric metric,
+                                      fftw_complex *work1,
+                                      fftw_complex *work2) const
+{
+    spectral::index paddedSize = m_paddedM * m_paddedN;
+
+    //the FT of the zero-padded kernel
+    std::memset( work1, 0, sizeof(fftw_complex) * paddedSize );
+    for( spectral::index i = 0; i < m_kernelSizeI; ++i )
+        for( spectral::index j = 0; j < m_kernelSizeJ; ++j ){
+            const std::complex<double>& value = kernel[ i * m_kernelSizeJ + j ];
+            work1[ i * m_paddedN + j ][0] = value.real();
+            work1[ i * m_paddedN + j ][1] = value.imag();
+        }
+    spectral::FFTService::instance().c2c( work1, work2, FFTW_FORWARD, 2, m_paddedM, m_paddedN );
+
+    //convolution is a product in frequency domain
+    for( spectral::index i = 0; i < paddedSize; ++i ){
+        double re = work2[i][0] * m_inputSpectrum[i][0] - work2[i][1] * m_inputSpectrum[i][1];
+        double im = work2[i][0] * m_inputSpectrum[i][1] + work2[i][1] * m_inputSpectrum[i][0];
+        work2[i][0] = re;
+        work2[i][1] = im;
+    }
+
+    //the response: real part + i * imaginary part
+    spectral::FFTService::instance().c2c( work2, work1, FFTW_BACKWARD, 2, m_paddedM, m_paddedN );
+
+    //the metric is computed in the part of the full convolution that corresponds to the input grid
+    //(same as spectral::project()).  The division by paddedSize is due to FFTW's scaling.
+    spectral::index nI = m_input.M();
+    spectral::index nJ = m_input.N();
+    spectral::index offsetI = m_paddedM / 2 - nI / 2;
+    spectral::index offsetJ = m_paddedN / 2 - nJ / 2;
+    double max = std::numeric_limits<double>::min();
+    double mean = 0.0;
+    for( spectral::index i = 0; i < nI; ++i )
+        for( spectral::index j = 0; j < nJ; ++j ){
+            const fftw_complex& value = work1[ ( i + offsetI ) * m_paddedN + j + offsetJ ];
+            double amplitude = std::sqrt( value[0] * value[0] + value[1] * value[1] ) / paddedSize;
+            if( amplitude > max )
+                max = amplitude;
+            mean += amplitude;
+        }
+    mean /= ( nI * nJ );
+
+    switch( metric ){
+    case Metric::MEAN: return mean;
+    case Metric::MAXIMUM: return max;
+    }
+    return 0.0;
+}
@@ -0,0 +1,101 @@
+#ifndef GABORSCANENGINE_H
+#define GABORSCANENGINE_H
+
+#include "spectral/spectral.h"
+#include <map>
+#include <complex>
+#include <functional>
+
+/**
+ * The GaborScanEngine class computes the Gabor response of an image for a grid of frequency x azimuth pairs
+ * (e.g. to find the frequencies and azimuths of the features in the image).  It replaces running
+ * GaborUtils::computeGaborResponse() twice (real and imaginary parts) for every pair:
+ * - The real and imaginary Gabor kernels of a pair are combined in a single complex kernel, so both parts
+ *   of the response are computed by a single convolution.
+ * - The convolutions are done in the frequency domain, with the Fourier transform of the (padded) input
+ *   computed only once.
+ * - The kernels are computed once and kept in a kernel bank, so subsequent scans with the same or overlapping
+ *   frequency and azimuth schedules do not recompute them.
+ * - The frequency x azimuth pairs are evaluated in parallel.
+ */
+class GaborScanEngine
+{
+public:
+
+    /** The statistic of the response amplitudes used as the response metric of a frequency x azimuth pair. */
+    enum class Metric : int {
+        MEAN,
+        MAXIMUM
+    };
+
+    /** Called periodically during a scan.
+     * @param partialResult The result so far, with NaNs for the frequency x azimuth pairs not computed yet.
+     * @param done The number of frequency x azimuth pairs computed so far.
+     * @param total The total number of frequency x azimuth pairs.
+     * @return false to cancel the scan.
+     */
+    typedef std::function<bool( const spectral::array& partialResult, unsigned int done, unsigned int total )>
+            ProgressCallback;
+
+    /** The parameters are the same as those of GaborUtils::computeGaborResponse(). */
+    GaborScanEngine( const spectral::array& inputGrid,
+                     double meanMajorAxis,
+                     double meanMinorAxis,
+                     double sigmaMajorAxis,
+                     double sigmaMinorAxis,
+                     int kernelSizeI,
+                     int kernelSizeJ );
+    ~GaborScanEngine();
+
+    /**
+     * Computes the response metric for all frequency x azimuth pairs.
+     * @param progressCallback Called from the calling thread (e.g. the GUI thread) about every 200ms.
+     * @param nThreads Number of threads to use.  If zero, the number of logical CPUs is used.
+     * @return An array with one row per frequency and one column per azimuth.  Pairs not computed
+     *         due to cancellation have NaN as value.
+     */
+    spectral::array scan( const std::vector<double>& frequencies,
+                          const std::vector<double>& azimuths,
+                          Metric metric,
+                          ProgressCallback progressCallback = nullptr,
+                          unsigned int nThreads = 0 );
+
+private:
+
+    GaborScanEngine( const GaborScanEngine& ) = delete;
+    GaborScanEngine& operator=( const GaborScanEngine& ) = delete;
+
+    /** A complex Gabor kernel (real part kernel + i * imaginary part kernel, both normalized),
+     * with kernelSizeI x kernelSizeJ values. */
+    typedef std::vector< std::complex<double> > Kernel;
+
+    /** Makes the kernel for a frequency-azimuth pair. */
+    Kernel makeKernel( double frequency, double azimuth ) const;
+
+    /** Computes the Fourier transform of the padded input (done once). */
+    void computeInputSpectrum();
+
+    /** Computes the response metric of the given kernel.
+     * @param work1 and work2 Working arrays with m_paddedM * m_paddedN elements. */
+    double computeMetric( const Kernel& kernel, Metric metric, fftw_complex* work1, fftw_complex* work2 ) const;
+
+    spectral::array m_input;
+    double m_meanMajorAxis;
+    double m_meanMinorAxis;
+    double m_sigmaMajorAxis;
+    double m_sigmaMinorAxis;
+    int m_kernelSizeI;
+    int m_kernelSizeJ;
+
+    /** The dimensions of the padded grids (those of the full linear convolution). */
+    spectral::index m_paddedM;
+    spectral::index m_paddedN;
+
+    /** The Fourier transform of the padded input.  It is null until the first scan. */
+    fftw_complex* m_inputSpectrum;
+
+    /** The kernels computed so far, keyed by frequency and azimuth. */
+    std::map< std::pair<double, double>, Kernel > m_kernelBank;
+};
+
+#endif // GABORSCANENGINE_H
@@ -1,9 +1,6 @@
 #include "gaborutils.h"
 #include "imagejockey/imagejockeyutils.h"
 #include <itkImageDuplicator.h>
-#include <mutex>
-
-std::mutex mutexFFTW; //spectral::conv2d calls FFTW, which crashes when called concurrently
 
 GaborUtils::GaborUtils()
 {
@@ -121,7 +118,6 @@ GaborUtils::ImageTypePtr GaborUtils::computeGaborResponse(double frequency,
                                                           const spectral::array &inputGrid,
                                                           bool imaginaryPart)
 {
-    std::unique_lock<std::mutex> lck (mutexFFTW, std::defer_lock);
     GaborUtils::ImageTypePtr kernel = GaborUtils::createGaborKernel( frequency,
                                                                      azimuth,
                                                                      meanMajorAxis,
@@ -136,9 +132,7 @@ GaborUtils::ImageTypePtr GaborUtils::computeGaborResponse(double frequency,
     spectral::normalize( kernelA );
 
     spectral::array temp;
-    lck.lock(); //spectral::conv2d calls FFTW, which crashes when called concurrently
-    spectral::conv2d( temp, inputGrid, kernelA );
-    lck.unlock();
+    spectral::conv2d( temp, inputGrid, kernelA ); //thread-safe (see spectral::FFTService)
 
     //Remove padding from the convolution result.
     spectral::array result = spectral::project( temp, inputGrid.M(), inputGrid.N(), 1 );
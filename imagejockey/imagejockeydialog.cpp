@@ -385,6 +385,16 @@ void ImageJockeyDialog::onSVD()
         return;
     }
 
+    //User enters the number of leading SVD factors to compute (computing all of them is too
+    //costly for large grids)
+    long numberOfFactorsToCompute;
+    {
+        SVDParametersDialog svdpd( this );
+        if( svdpd.exec() != QDialog::Accepted )
+            return;
+        numberOfFactorsToCompute = svdpd.getNumberOfFactors();
+    }
+
 	//Get the data
     long selectedAttributeIndex = m_varAmplitudeSelector->getSelectedVariableIndex();
     spectral::array* a = cg->createSpectralArray( selectedAttributeIndex );
@@ -403,11 +413,11 @@ void ImageJockeyDialog::onSVD()
 	progressDialog.setLabelText("Computing SVD factors...");
 	progressDialog.show();
 	QCoreApplication::processEvents();
-	spectral::SVD svd = spectral::svd( *a );
+	spectral::SVD svd = spectral::svd_truncated( *a, numberOfFactorsToCompute );
 	progressDialog.hide();
 
     //get the list with the factor weights (information quantity)
-    spectral::array weights = svd.factor_weights();
+    spectral::array weights = svd.factor_energy_fractions();
     emit infoOccurred("ImageJockeyDialog::onSVD(): " + QString::number( weights.data().size() ) + " factor(s) were found.");
 
     //User enters number of SVD factors
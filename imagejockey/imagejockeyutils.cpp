@@ -4,6 +4,8 @@
 #include <cstdlib>
 #include <cmath>
 #include <complex>
+#include <thread>
+#include <atomic>
 #include <QList>
 #include <QProgressDialog>
 #include <QCoreApplication>
@@ -771,6 +773,189 @@ spectral::array ImageJockeyUtils::interpolateNullValuesShepard(const spectral::a
     return result;
 }
 
+spectral::array ImageJockeyUtils::interpolateNullValuesShepardNeighborhood(const spectral::array &inputData,
+                                                                           IJAbstractCartesianGrid &gridMesh,
+                                                                           double powerParameter,
+                                                                           int maxNeighbors,
+                                                                           double maxDistance,
+                                                                           double nullValue,
+                                                                           unsigned int nThreads)
+{
+    //get array dimensions
+    int n[3] = { (int)inputData.M(), (int)inputData.N(), (int)inputData.K() };
+    spectral::index nCells = (spectral::index)n[0] * n[1] * n[2];
+
+    //get grid mesh geometry
+    double cellSize[3] = { gridMesh.getCellSizeI(), gridMesh.getCellSizeJ(), gridMesh.getCellSizeK() };
+
+    //the valid values are kept as is
+    spectral::array result( inputData );
+
+    spectral::index nSamples = 0;
+    for( spectral::index i = 0; i < nCells; ++i )
+        if( std::isfinite( inputData.d_[i] ) )
+            ++nSamples;
+    if( nSamples == 0 )
+        return spectral::array( (spectral::index)n[0], (spectral::index)n[1], (spectral::index)n[2], nullValue );
+    if( nSamples == nCells )
+        return result;
+
+    //the spatial index: a coarse grid of buckets sized so each bucket holds about 8 valid values on average.
+    int nDimensions = ( n[0] > 1 ) + ( n[1] > 1 ) + ( n[2] > 1 );
+    int cellsPerBucketAxis = std::max( 1, (int)std::ceil( std::pow( 8.0 * nCells / nSamples, 1.0 / nDimensions ) ) );
+    int bucketSize[3];   //bucket size in cells per axis
+    int nBuckets[3];     //number of buckets per axis
+    double minBucketExtent = std::numeric_limits<double>::infinity();
+    for( int axis = 0; axis < 3; ++axis ){
+        bucketSize[axis] = std::min( cellsPerBucketAxis, n[axis] );
+        nBuckets[axis] = ( n[axis] + bucketSize[axis] - 1 ) / bucketSize[axis];
+        if( nBuckets[axis] > 1 )
+            minBucketExtent = std::min( minBucketExtent, bucketSize[axis] * cellSize[axis] );
+    }
+    int maxRing = std::max( { nBuckets[0], nBuckets[1], nBuckets[2] } ) - 1;
+    auto bucketIndex = [&nBuckets]( int bi, int bj, int bk ){
+        return ( (spectral::index)bi * nBuckets[1] + bj ) * nBuckets[2] + bk;
+    };
+
+    //the valid values sorted by bucket (counting sort), in the grid's local frame (first cell center at the origin).
+    struct Sample {
+        double u[3];
+        double value;
+    };
+    std::vector< spectral::index > bucketStart( (spectral::index)nBuckets[0] * nBuckets[1] * nBuckets[2] + 1, 0 );
+    for( int i = 0; i < n[0]; ++i )
+        for( int j = 0; j < n[1]; ++j )
+            for( int k = 0; k < n[2]; ++k )
+                if( std::isfinite( inputData( i, j, k ) ) )
+                    ++bucketStart[ bucketIndex( i / bucketSize[0], j / bucketSize[1], k / bucketSize[2] ) + 1 ];
+    for( size_t iBucket = 1; iBucket < bucketStart.size(); ++iBucket )
+        bucketStart[iBucket] += bucketStart[iBucket - 1];
+    std::vector< Sample > samples( nSamples );
+    {
+        std::vector< spectral::index > fill( bucketStart.begin(), bucketStart.end() - 1 );
+        for( int i = 0; i < n[0]; ++i )
+            for( int j = 0; j < n[1]; ++j )
+                for( int k = 0; k < n[2]; ++k ){
+                    double inputValue = inputData( i, j, k );
+                    if( std::isfinite( inputValue ) )
+                        samples[ fill[ bucketIndex( i / bucketSize[0], j / bucketSize[1], k / bucketSize[2] ) ]++ ] =
+                                { { i * cellSize[0], j * cellSize[1], k * cellSize[2] }, inputValue };
+                }
+    }
+
+    double maxDistance2 = maxDistance > 0.0 ? maxDistance * maxDistance : std::numeric_limits<double>::infinity();
+    bool isPowerOf2 = ( powerParameter == 2.0 );
+
+    //interpolates one cell by visiting the rings of buckets around the cell's bucket, nearest first.
+    //the search stops when the buckets not visited yet cannot hold nearer valid values.
+    //neighbors: working max-heap of (squared distance, value) pairs of the nearest valid values found so far.
+    auto interpolateCell = [&]( int i, int j, int k, std::vector< std::pair<double, double> >& neighbors ){
+        double u[3] = { i * cellSize[0], j * cellSize[1], k * cellSize[2] };
+        int center[3] = { i / bucketSize[0], j / bucketSize[1], k / bucketSize[2] };
+        neighbors.clear();
+        double sumWeights = 0.0;
+        double sumWeightedValues = 0.0;
+        auto weightOf = [isPowerOf2, powerParameter]( double distance2 ){
+            return isPowerOf2 ? 1.0 / distance2 : std::pow( distance2, -powerParameter / 2.0 );
+        };
+        auto visitBucket = [&]( int bi, int bj, int bk ){
+            spectral::index iBucket = bucketIndex( bi, bj, bk );
+            for( spectral::index iSample = bucketStart[iBucket]; iSample < bucketStart[iBucket + 1]; ++iSample ){
+                const Sample& sample = samples[iSample];
+                double dx = sample.u[0] - u[0];
+                double dy = sample.u[1] - u[1];
+                double dz = sample.u[2] - u[2];
+                double distance2 = dx * dx + dy * dy + dz * dz;
+                if( distance2 > maxDistance2 )
+                    continue;
+                if( maxNeighbors <= 0 ){
+                    double weight = weightOf( distance2 );
+                    sumWeights += weight;
+                    sumWeightedValues += weight * sample.value;
+                } else if( (int)neighbors.size() < maxNeighbors ){
+                    neighbors.emplace_back( distance2, sample.value );
+                    std::push_heap( neighbors.begin(), neighbors.end() );
+                } else if( distance2 < neighbors.front().first ){
+                    std::pop_heap( neighbors.begin(), neighbors.end() );
+                    neighbors.back() = std::make_pair( distance2, sample.value );
+                    std::push_heap( neighbors.begin(), neighbors.end() );
+                }
+            }
+        };
+        for( int ring = 0; ring <= maxRing; ++ring ){
+            int lo[3], hi[3];
+            for( int axis = 0; axis < 3; ++axis ){
+                lo[axis] = std::max( center[axis] - ring, 0 );
+                hi[axis] = std::min( center[axis] + ring, nBuckets[axis] - 1 );
+            }
+            //visit only the buckets on the surface of the ring's box.
+            for( int bi = lo[0]; bi <= hi[0]; ++bi )
+                for( int bj = lo[1]; bj <= hi[1]; ++bj ){
+                    bool onSurface = std::abs( bi - center[0] ) == ring || std::abs( bj - center[1] ) == ring;
+                    if( onSurface )
+                        for( int bk = lo[2]; bk <= hi[2]; ++bk )
+                            visitBucket( bi, bj, bk );
+                    else {
+                        if( center[2] - ring >= 0 )
+                            visitBucket( bi, bj, center[2] - ring );
+                        if( ring > 0 && center[2] + ring < nBuckets[2] )
+                            visitBucket( bi, bj, center[2] + ring );
+                    }
+                }
+            //the buckets beyond this ring are at least this far from the cell.
+            double bound = ring * minBucketExtent;
+            if( bound * bound > maxDistance2 )
+                break;
+            if( maxNeighbors > 0 && (int)neighbors.size() == maxNeighbors && neighbors.front().first <= bound * bound )
+                break;
+        }
+        for( const std::pair<double, double>& neighbor : neighbors ){
+            double weight = weightOf( neighbor.first );
+            sumWeights += weight;
+            sumWeightedValues += weight * neighbor.second;
+        }
+        return sumWeights > 0.0 ? sumWeightedValues / sumWeights : nullValue;
+    };
+
+    //the grid is processed in tiles (good locality in the bucket grid), which are distributed among the threads.
+    const int TILE_SIZE = 32;
+    int nTiles[3];
+    for( int axis = 0; axis < 3; ++axis )
+        nTiles[axis] = ( n[axis] + TILE_SIZE - 1 ) / TILE_SIZE;
+    int totalTiles = nTiles[0] * nTiles[1] * nTiles[2];
+
+    std::atomic<int> nextTile( 0 );
+    auto worker = [&](){
+        std::vector< std::pair<double, double> > neighbors;
+        neighbors.reserve( std::max( maxNeighbors, 0 ) );
+        while( true ){
+            int iTile = nextTile++;
+            if( iTile >= totalTiles )
+                break;
+            int ti = iTile / ( nTiles[1] * nTiles[2] );
+            int tj = ( iTile / nTiles[2] ) % nTiles[1];
+            int tk = iTile % nTiles[2];
+            for( int i = ti * TILE_SIZE; i < std::min( ( ti + 1 ) * TILE_SIZE, n[0] ); ++i )
+                for( int j = tj * TILE_SIZE; j < std::min( ( tj + 1 ) * TILE_SIZE, n[1] ); ++j )
+                    for( int k = tk * TILE_SIZE; k < std::min( ( tk + 1 ) * TILE_SIZE, n[2] ); ++k )
+                        if( ! std::isfinite( inputData( i, j, k ) ) )
+                            result( i, j, k ) = interpolateCell( i, j, k, neighbors );
+        }
+    };
+
+    if( nThreads == 0 )
+        nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    nThreads = std::min<unsigned int>( nThreads, totalTiles );
+    std::vector< std::thread > threads;
+    for( unsigned int iThread = 1; iThread < nThreads; ++iThread )
+        threads.emplace_back( worker );
+    worker();
+    for( std::thread& thread : threads )
+        thread.join();
+
+    return result;
+}
+
 spectral::array ImageJockeyUtils::interpolateNullValuesThinPlateSpline(const spectral::array &inputData,
                                                                         IJAbstractCartesianGrid &gridMesh,
                                                                         double lambda, int &status )
@@ -912,6 +1097,172 @@ spectral::array ImageJockeyUtils::interpolateNullValuesThinPlateSpline(const spe
     return result;
 }
 
+spectral::array ImageJockeyUtils::interpolateNullValuesMBA(const spectral::array &inputData,
+                                                          IJAbstractCartesianGrid &gridMesh,
+                                                          int nLevels,
+                                                          double nullValue,
+                                                          unsigned int nThreads )
+{
+    //get array dimensions
+    int n[3] = { (int)inputData.M(), (int)inputData.N(), (int)inputData.K() };
+
+    //get grid mesh geometry
+    double cellSize[3] = { gridMesh.getCellSizeI(), gridMesh.getCellSizeJ(), gridMesh.getCellSizeK() };
+
+    //collect the samples in the grid's local frame (first cell center at the origin).
+    //the residuals are the parts of the sample values not yet approximated by the coarser levels.
+    struct Sample {
+        double u[3];
+        double residual;
+    };
+    std::vector< Sample > samples;
+    for( int i = 0; i < n[0]; ++i )
+        for( int j = 0; j < n[1]; ++j )
+            for( int k = 0; k < n[2]; ++k ){
+                double inputValue = inputData( i, j, k );
+                if( std::isfinite( inputValue ) )
+                    samples.push_back( { { i * cellSize[0], j * cellSize[1], k * cellSize[2] }, inputValue } );
+            }
+
+    if( samples.empty() )
+        return spectral::array( (spectral::index)n[0], (spectral::index)n[1], (spectral::index)n[2], nullValue );
+
+    //the number of levels needed for the finest lattice to have the spacing of the grid cells.
+    int maxCellsPerAxis = std::max( { n[0], n[1], n[2] } ) - 1;
+    int nLevelsForCellSpacing = 1;
+    while( ( 1 << ( nLevelsForCellSpacing - 1 ) ) < maxCellsPerAxis )
+        ++nLevelsForCellSpacing;
+    if( nLevels <= 0 || nLevels > nLevelsForCellSpacing )
+        nLevels = nLevelsForCellSpacing;
+
+    //a control lattice of uniform cubic B-splines.  Axes with a single grid cell (e.g. the K axis of 2D grids)
+    //have a single control point with unit weight.
+    struct Lattice {
+        int m[3];        //number of lattice intervals per axis
+        double h[3];     //lattice spacing per axis
+        int size[3];     //number of control points per axis (m+3 or 1)
+        std::vector< double > phi;
+    };
+
+    //computes the (up to) 4 control point indexes and B-spline weights affecting a location along an axis.
+    auto getTaps = [&n]( const Lattice& lattice, int axis, double u, int& first, int& nTaps, double weights[4] ){
+        if( n[axis] == 1 ){
+            first = 0;
+            nTaps = 1;
+            weights[0] = 1.0;
+            return;
+        }
+        double s = u / lattice.h[axis];
+        int c = std::min( std::max( (int)std::floor( s ), 0 ), lattice.m[axis] - 1 );
+        double t = s - c;
+        double t2 = t * t;
+        double t3 = t2 * t;
+        double omt = 1.0 - t;
+        weights[0] = omt * omt * omt / 6.0;
+        weights[1] = ( 3.0 * t3 - 6.0 * t2 + 4.0 ) / 6.0;
+        weights[2] = ( -3.0 * t3 + 3.0 * t2 + 3.0 * t + 1.0 ) / 6.0;
+        weights[3] = t3 / 6.0;
+        first = c;
+        nTaps = 4;
+    };
+
+    //evaluates a lattice at a location.
+    auto evaluate = [&getTaps]( const Lattice& lattice, const double u[3] ){
+        int first[3], nTaps[3];
+        double w[3][4];
+        for( int axis = 0; axis < 3; ++axis )
+            getTaps( lattice, axis, u[axis], first[axis], nTaps[axis], w[axis] );
+        double result = 0.0;
+        for( int a = 0; a < nTaps[0]; ++a )
+            for( int b = 0; b < nTaps[1]; ++b )
+                for( int c = 0; c < nTaps[2]; ++c )
+                    result += w[0][a] * w[1][b] * w[2][c] *
+                              lattice.phi[ ( ( first[0] + a ) * lattice.size[1] + first[1] + b ) * lattice.size[2] + first[2] + c ];
+        return result;
+    };
+
+    //the multilevel B-spline approximation (Lee, Wolberg and Shin, 1997): each level is a B-spline approximation
+    //of the residuals left by the coarser levels, with a lattice twice as fine as the previous one's.
+    //unlike global RBF interpolators, there is no linear system to solve: cost is linear in the number of samples.
+    std::vector< Lattice > lattices( nLevels );
+    for( int level = 0; level < nLevels; ++level ){
+        Lattice& lattice = lattices[level];
+        for( int axis = 0; axis < 3; ++axis ){
+            if( n[axis] == 1 ){
+                lattice.m[axis] = 1;
+                lattice.h[axis] = 1.0;
+                lattice.size[axis] = 1;
+            } else {
+                lattice.m[axis] = std::min( 1 << level, n[axis] - 1 );
+                lattice.h[axis] = ( n[axis] - 1 ) * cellSize[axis] / lattice.m[axis];
+                lattice.size[axis] = lattice.m[axis] + 3;
+            }
+        }
+        int latticeSize = lattice.size[0] * lattice.size[1] * lattice.size[2];
+        std::vector< double > delta( latticeSize, 0.0 );
+        std::vector< double > omega( latticeSize, 0.0 );
+
+        //each sample proposes values for the control points around it; the proposals are then
+        //blended by their squared weights.
+        for( const Sample& sample : samples ){
+            int first[3], nTaps[3];
+            double w[3][4];
+            for( int axis = 0; axis < 3; ++axis )
+                getTaps( lattice, axis, sample.u[axis], first[axis], nTaps[axis], w[axis] );
+            double sumW2 = 0.0;
+            for( int a = 0; a < nTaps[0]; ++a )
+                for( int b = 0; b < nTaps[1]; ++b )
+                    for( int c = 0; c < nTaps[2]; ++c ){
+                        double wabc = w[0][a] * w[1][b] * w[2][c];
+                        sumW2 += wabc * wabc;
+                    }
+            for( int a = 0; a < nTaps[0]; ++a )
+                for( int b = 0; b < nTaps[1]; ++b )
+                    for( int c = 0; c < nTaps[2]; ++c ){
+                        double wabc = w[0][a] * w[1][b] * w[2][c];
+                        int index = ( ( first[0] + a ) * lattice.size[1] + first[1] + b ) * lattice.size[2] + first[2] + c;
+                        double proposal = wabc * sample.residual / sumW2;
+                        delta[index] += wabc * wabc * proposal;
+                        omega[index] += wabc * wabc;
+                    }
+        }
+        lattice.phi.resize( latticeSize );
+        for( int index = 0; index < latticeSize; ++index )
+            lattice.phi[index] = omega[index] > 0.0 ? delta[index] / omega[index] : 0.0;
+
+        //update the residuals for the next level
+        if( level < nLevels - 1 )
+            for( Sample& sample : samples )
+                sample.residual -= evaluate( lattice, sample.u );
+    }
+
+    //evaluate the sum of all levels at the grid cells.  The I-slices are evaluated in parallel.
+    spectral::array result( (spectral::index)n[0], (spectral::index)n[1], (spectral::index)n[2] );
+    std::atomic<int> nextSlice( 0 );
+    auto evaluateSlices = [&](){
+        for( int i = nextSlice++; i < n[0]; i = nextSlice++ )
+            for( int j = 0; j < n[1]; ++j )
+                for( int k = 0; k < n[2]; ++k ){
+                    double u[3] = { i * cellSize[0], j * cellSize[1], k * cellSize[2] };
+                    double value = 0.0;
+                    for( const Lattice& lattice : lattices )
+                        value += evaluate( lattice, u );
+                    result( i, j, k ) = value;
+                }
+    };
+    if( nThreads == 0 )
+        nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    nThreads = std::min<unsigned int>( nThreads, n[0] );
+    std::vector< std::thread > threads;
+    for( unsigned int iThread = 1; iThread < nThreads; ++iThread )
+        threads.emplace_back( evaluateSlices );
+    evaluateSlices();
+    for( std::thread& thread : threads )
+        thread.join();
+
+    return result;
+}
+
 spectral::array ImageJockeyUtils::skeletonize(const spectral::array &inputData){
     //get data array dimensions
     int nI = inputData.M();
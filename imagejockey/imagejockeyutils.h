@@ -317,6 +317,32 @@ public:
                                                         double maxDistanceFactor = 1.0,
                                                         double nullValue = std::numeric_limits<double>::quiet_NaN() );
 
+    /**
+     * Interpolates invalid values ( std::isfinite() returns false ) from valid values in the passed array.
+     * The returned array has the same dimensions of the input array.  Valid values are copied as is.
+     * Interpolation method is Shepard's (inverse distance weighted), but, unlike interpolateNullValuesShepard(),
+     * only the nearest valid values contribute to each cell.  The valid values are indexed in a coarse grid
+     * of buckets, so each cell visits only the buckets around it, and the cells are processed in parallel
+     * tiles.  Cost is nearly linear in the number of cells, which makes it suitable for gap-filling large
+     * 2D and 3D grids.
+     * @param inputData array of data values.  Number of data elements must be nI * nJ * nK (see gridMesh parameter).
+     * @param gridMesh an object containing grid mesh definition, that is,
+     *        origin (X0, Y0, Z0), cell sizes (dX, dY, dZ) and cell count (nI, nJ, nK).
+     * @param powerParameter The inverse distance power.  The algorithm is optimized for 2.0.
+     * @param maxNeighbors The maximum number of nearest valid values used for each cell.  Zero means no limit
+     *                     (all valid values within maxDistance are used).
+     * @param maxDistance The maximum distance beyond which no valid values are considered.  Zero means no limit.
+     * @param nullValue Value to be used in places impossible to interpolate due to lack of valid values within maxDistance.
+     * @param nThreads Number of threads to use.  Zero means the number of logical CPUs.
+     */
+    static spectral::array interpolateNullValuesShepardNeighborhood( const spectral::array& inputData,
+                                                                     IJAbstractCartesianGrid& gridMesh,
+                                                                     double powerParameter = 2.0,
+                                                                     int maxNeighbors = 16,
+                                                                     double maxDistance = 0.0,
+                                                                     double nullValue = std::numeric_limits<double>::quiet_NaN(),
+                                                                     unsigned int nThreads = 0 );
+
 
     /**
     * Interpolates invalid values ( std::isfinite() returns false ) from valid values in the passed array.
@@ -339,6 +365,28 @@ public:
                                                                  double lambda,
                                                                  int& status );
 
+    /**
+     * Interpolates invalid values ( std::isfinite() returns false ) from valid values in the passed array.
+     * The returned array has the same dimensions of the input array.
+     * Interpolation method is Multilevel B-Spline Approximation ("Scattered Data Interpolation with Multilevel
+     * B-Splines" (Lee S, Wolberg G and Shin SY, 1997)).  It works with 1D, 2D and 3D grids and, unlike the
+     * Thin Plate Spline, there is no linear system to solve: the cost is linear in the number of valid values,
+     * which makes it suitable for large grids.  The finest level has the resolution of the grid cells, so the
+     * result nearly honors the valid values.
+     * @param inputData array of data values.  Number of data elements must be nI * nJ * nK (see gridMesh parameter).
+     * @param gridMesh an object containing grid mesh definition, that is,
+     *        origin (X0, Y0, Z0), cell sizes (dX, dY, dZ) and cell count (nI, nJ, nK).
+     * @param nLevels Number of levels of the B-Spline hierarchy.  Fewer levels result in smoother surfaces.
+     *                Zero means as many levels as needed for the finest level to have the resolution of the grid.
+     * @param nullValue Value to be used in all cells if there are no valid values.
+     * @param nThreads Number of threads used to evaluate the result.  Zero means the number of logical CPUs.
+     */
+    static spectral::array interpolateNullValuesMBA( const spectral::array& inputData,
+                                                     IJAbstractCartesianGrid& gridMesh,
+                                                     int nLevels = 0,
+                                                     double nullValue = std::numeric_limits<double>::quiet_NaN(),
+                                                     unsigned int nThreads = 0 );
+
     /** Skeletonizes gridded data so only values along thin lines remain. */
     static spectral::array skeletonize( const spectral::array& inputData );
 };
@@ -8,6 +8,7 @@
 #include <QProgressDialog>
 #include <QtCore>
 #include "svdfactorsel/svdfactorsselectiondialog.h"
+#include "svdparametersdialog.h"
 #include "../widgets/ijgridviewerwidget.h"
 #include "../imagejockeyutils.h"
 #include "../imagejockeydialog.h"
@@ -171,13 +172,23 @@ void SVDAnalysisDialog::onFactorContextMenu(const QPoint &mouse_location)
 
 void SVDAnalysisDialog::onFactorizeFurther()
 {
+    //User enters the number of leading SVD factors to compute (computing all of them is too
+    //costly for large grids)
+    long numberOfFactorsToCompute;
+    {
+        SVDParametersDialog svdpd( this );
+        if( svdpd.exec() != QDialog::Accepted )
+            return;
+        numberOfFactorsToCompute = svdpd.getNumberOfFactors();
+    }
+
     //Compute SVD
     QProgressDialog progressDialog;
     progressDialog.setRange(0,0);
     progressDialog.setLabelText("Computing SVD factors...");
     progressDialog.show();
     QCoreApplication::processEvents();
-	spectral::SVD svd = spectral::svd( m_right_clicked_factor->getFactorData() );
+	spectral::SVD svd = spectral::svd_truncated( m_right_clicked_factor->getFactorData(), numberOfFactorsToCompute );
     progressDialog.hide();
 
 	//get the grid geometry parameters (useful for displaying)
@@ -189,7 +200,7 @@ void SVDAnalysisDialog::onFactorizeFurther()
 	double dz = m_right_clicked_factor->getDZ();
 
 	//get the list with the factor weights (information quantity)
-	spectral::array weights = svd.factor_weights();
+	spectral::array weights = svd.factor_energy_fractions();
 
     //tests whether the factor is factorizable (not fundamental)
     if( weights[0] > 0.999999 ){
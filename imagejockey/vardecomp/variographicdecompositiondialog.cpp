@@ -12,6 +12,7 @@
 #include "../widgets/ijquick3dviewer.h"
 #include "imagejockey/gabor/gaborutils.h"
 #include "imagejockey/ijvariographicmodel2d.h"
+#include "variographicdecompositionengine.h"
 
 #include <QMessageBox>
 #include <QProgressDialog>
@@ -533,158 +534,6 @@ double F2(const spectral::array &originalGrid,
             std::pow( ratio_mean_variance,       off.f7 ) ;
 }
 
-/** Utilitary function that encapsulates variographic surface generation from
- * variogram model parameters.
- * @param gridWithGeometry A grid object whose geometry will be copied to the generated grid.
- * @param vectorOfParameters The column-vector with the free paramateres.
- * @param m The desired number of geological factors.
- */
-spectral::array generateVariographicSurface(IJAbstractCartesianGrid& gridWithGeometry,
-                                            const spectral::array &vectorOfParameters,
-                                            const int m ){
-    //get grid parameters
-    int nI = gridWithGeometry.getNI();
-    int nJ = gridWithGeometry.getNJ();
-    int nK = gridWithGeometry.getNK();
-    //create a grid compatible with the input varmap
-    spectral::array variographicSurface( nI, nJ, nK, 0.0 );
-    //for each geological factor
-    for( int i = 0, iGeoFactor = 0; iGeoFactor < m; ++iGeoFactor ){
-        //create a variographic structure
-        IJVariographicStructure2D varEllip(0.0, 0.0, 0.0, 0.0);
-        //for each variographic parameter
-        for( int iPar = 0; iPar < IJVariographicStructure2D::getNumberOfParameters(); ++iPar, ++i ){
-            //set it to the variographic ellipse
-            varEllip.setParameter( iPar, vectorOfParameters[i] );
-        }
-        //make the variographic surface
-        varEllip.addContributionToModelGrid( gridWithGeometry,
-                                             variographicSurface,
-                                             IJVariogramPermissiveModel::SPHERIC,
-                                             true );
-    }
-    return variographicSurface;
-}
-
-/** The objective function for the optimization process (direct variographic fitting).
- * See complete theory in the program manual for in-depth explanation of the method's parameters below.
- * @param gridWithGeometry A grid object whose geometry will be copied to the generated grid with the varmap for objective function evaluation.
- * @param varmapOfInput The grid with the varmap of inpit data for comparison.
- * @param vectorOfParameters The column-vector with the free paramateres.
- * @param m The desired number of geological factors.
- * @return A distance/difference measure.
- */
-double F3( IJAbstractCartesianGrid& gridWithGeometry,
-           const spectral::array &varmapOfInput,
-           const spectral::array &vectorOfParameters,
-           const int m ){
-
-    //get grid parameters
-    int nI = gridWithGeometry.getNI();
-    int nJ = gridWithGeometry.getNJ();
-    int nK = gridWithGeometry.getNK();
-
-    //generate the variogram model surface
-    spectral::array variographicSurface = generateVariographicSurface( gridWithGeometry,
-                                                                       vectorOfParameters,
-                                                                       m );
-
-    //compute the objective function metric
-    double sum = 0.0;
-    for( int k = 0; k < nK; ++k )
-        for( int j = 0; j < nJ; ++j )
-            for( int i = 0; i < nI; ++i )
-//                if( std::abs( varmapOfInput(i,j,k) - variographicSurface(i,j,k) ) > 10.0 )
-//                    sum += 1.0;
-
-//                if( ! ImageJockeyUtils::almostEqual2sComplement( varmapOfInput(i,j,k), 0.0, 1 ) )
-//                    sum += std::abs( ( varmapOfInput(i,j,k) - variographicSurface(i,j,k) ) / varmapOfInput(i,j,k) );
-
-                  sum += std::abs( ( varmapOfInput(i,j,k) - variographicSurface(i,j,k) ) );
-
-    sum /= varmapOfInput.size();
-
-    // Finally, return the objective function value.
-    return sum;
-}
-
-/** The objective function for the optimization process (indirect variographic fitting).
- * See complete theory in the program manual for in-depth explanation of the method's parameters below.
- * @param gridWithGeometry A grid object whose geometry will be copied to the generated grid with the varmap for objective function evaluation.
- * @param inputData The grid data for comparison.
- * @param vectorOfParameters The column-vector with the free paramateres (variogram parameters).
- * @param m The desired number of variographic nested structures.
- * @return A distance/difference measure.
- */
-double F4( IJAbstractCartesianGrid& gridWithGeometry,
-           const spectral::array &inputGridData,
-           const spectral::array &vectorOfParameters,
-           const int m ){
-
-    //get grid parameters
-    int nI = gridWithGeometry.getNI();
-    int nJ = gridWithGeometry.getNJ();
-    int nK = gridWithGeometry.getNK();
-
-    //generate the variogram model surface
-    spectral::array theoreticalVariographicSurface = generateVariographicSurface( gridWithGeometry,
-                                                                       vectorOfParameters,
-                                                                       m );
-
-    //Compute FFT of input to get its phase map
-    spectral::array inputFFTimagPhase;
-    {
-        spectral::array tmp( inputGridData );
-        spectral::complex_array inputFFT;
-        spectral::foward( inputFFT, tmp );
-        spectral::complex_array inputFFTpolar = spectral::to_polar_form( inputFFT );
-        inputFFTimagPhase = spectral::imag( inputFFTpolar );
-    }
-
-    //Apply the principle of the Fourier Integral Method to obtain what would the map be
-    //if it actually had the theoretical variogram model
-    spectral::array mapFromTheoreticalVariogramModel( nI, nJ, nK, 0.0 );
-    {
-        //compute FFT of the theoretical varmap (into polar form)
-        spectral::complex_array theoreticalVarMapFFT( nI, nJ, nK );
-        spectral::array tmp = spectral::shiftByHalf( theoreticalVariographicSurface );
-        spectral::foward( theoreticalVarMapFFT, tmp );
-        spectral::complex_array theoreticalVarMapFFTpolar = spectral::to_polar_form( theoreticalVarMapFFT );
-        spectral::array theoreticalVarMapFFTamplitudes = spectral::real( theoreticalVarMapFFTpolar );
-
-        //get the square root of the amplitudes of the varmap FFT
-        spectral::array theoreticalVarmapFFTamplitudesSQRT = theoreticalVarMapFFTamplitudes.sqrt();
-
-        //convert sqrt(varmap) and the phases of the input to rectangular form
-        spectral::complex_array mapFFTpolar = spectral::to_complex_array(
-                                                       theoreticalVarmapFFTamplitudesSQRT,
-                                                       inputFFTimagPhase
-                                                    );
-        spectral::complex_array mapFFT = spectral::to_rectangular_form( mapFFTpolar );
-
-        //compute the reverse FFT to get the geological factor
-        spectral::backward( mapFromTheoreticalVariogramModel, mapFFT );
-
-        //fftw3's reverse FFT requires that the values of output be divided by the number of cells
-        mapFromTheoreticalVariogramModel = mapFromTheoreticalVariogramModel / (double)( nI * nJ * nK );
-    }
-
-    //compute the objective function metric
-    double sum = 0.0;
-    for( int k = 0; k < nK; ++k )
-        for( int j = 0; j < nJ; ++j )
-            for( int i = 0; i < nI; ++i )
-                sum += std::abs( ( inputGridData(i,j,k) - mapFromTheoreticalVariogramModel(i,j,k) ) );
-//    sum /= inputGridData.size();
-
-//    VariographicDecompositionDialog::displayGrid( inputGridData, "input data", false );
-//    VariographicDecompositionDialog::displayGrid( mapFromTheoreticalVariogramModel, "FIM", false );
-
-    // Finally, return the objective function value.
-    return sum;
-}
-
-
 /**
  * The code for multithreaded gradient vector calculation for objective function F().
  */
@@ -764,37 +613,6 @@ void taskOnePartialDerivative2(
 	}
 }
 
-/**
- * The code for multithreaded gradient vector calculation for objective function F3().
- */
-void taskOnePartialDerivative3(
-                               const spectral::array& vw,
-                               const std::vector< int >& parameterIndexBin,
-                               const double epsilon,
-                               IJAbstractCartesianGrid* gridWithGeometry,
-                               const spectral::array& varMap,
-                               const int m,
-                               spectral::array* gradient //output object: for some reason, the thread object constructor does not compile with non-const references.
-                               ){
-    std::vector< int >::const_iterator it = parameterIndexBin.cbegin();
-    for(; it != parameterIndexBin.cend(); ++it ){
-        int iParameter = *it;
-        //Make a set of parameters slightly shifted to the right (more positive) along one parameter.
-        spectral::array vwFromRight( vw );
-        vwFromRight(iParameter) = vwFromRight(iParameter) + epsilon;
-        //Make a set of parameters slightly shifted to the left (more negative) along one parameter.
-        spectral::array vwFromLeft( vw );
-        vwFromLeft(iParameter) = vwFromLeft(iParameter) - epsilon;
-        //Compute (numerically) the partial derivative with respect to one parameter.
-        (*gradient)(iParameter) = (F3( *gridWithGeometry, varMap, vwFromRight, m )
-                                     -
-                                   F3( *gridWithGeometry, varMap, vwFromLeft , m ))
-                                     /
-                                   ( 2 * epsilon );
-    }
-}
-
-
 VariographicDecompositionDialog::VariographicDecompositionDialog(const std::vector<IJAbstractCartesianGrid *> &&grids, QWidget *parent) :
     QDialog(parent),
 	ui(new Ui::VariographicDecompositionDialog),
@@ -2104,52 +1922,20 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_SA_AND_G
 
     //========================= GET VARMAP OF THE INPUT DATA =====================================
 
-    //make an array full of zeroes (useful for certain steps in the workflow)
-    spectral::array zeros( nI, nJ, nK, 0.0 );
-
     // Get the input data as a spectral::array object
     spectral::arrayPtr inputData( inputGrid->createSpectralArray( variable->getIndexInParentGrid() ) );
 
-    //Compute FFT of input
-    spectral::array inputFFTrealPart;
-    spectral::array inputFFTimagPart;
-    spectral::array inputFFTimagPhase;
-    {
-        spectral::complex_array inputFFT;
-        spectral::foward( inputFFT, *inputData );
-        inputFFTrealPart = spectral::real( inputFFT );
-        inputFFTimagPart = spectral::imag( inputFFT );
-        spectral::complex_array inputFFTpolar = spectral::to_polar_form( inputFFT );
-        inputFFTimagPhase = spectral::imag( inputFFTpolar );
-    }
-
-    //do a^2 + b^2
-    // where a = real part of FFT; b = imaginary part of FFT.
-    spectral::array inputMagSquared = spectral::hadamard( inputFFTrealPart, inputFFTrealPart ) +
-                                      spectral::hadamard( inputFFTimagPart, inputFFTimagPart );
-
-    //make a complex array from a^2 + b^2 as magnitude and zeros as phase (polar form)
-    //this corresponds to the FFT of a variographic map
-    spectral::complex_array inputVarmapFFTPolarForm = spectral::to_complex_array( inputMagSquared, zeros );
-    inputMagSquared = spectral::array(); //garbage collection
+    //the engine computes the FFT and the varmap of the input only once
+    VariographicDecompositionEngine engine( *inputGrid, *inputData, m,
+                                            VariographicDecompositionEngine::Objective::FIM_FITTING,
+                                            ui->spinNumberOfThreads->value() );
+    const spectral::array& inputVarmap = engine.getInputVarmap();
 
-    //convert the previous complex array to the rectangular form
-    spectral::complex_array inputVarmapFFTRectangularForm = spectral::to_rectangular_form( inputVarmapFFTPolarForm );
-    inputVarmapFFTPolarForm = spectral::complex_array(); //garbage collection
-
-    //get the varmap of the input data by reverse FFT
-    spectral::array inputVarmap( nI, nJ, nK, 0.0 );
-    spectral::backward( inputVarmap, inputVarmapFFTRectangularForm );
-    inputVarmapFFTRectangularForm = spectral::complex_array(); //garbage collection
-
-    //fftw requires that the values of r-FFT be divided by the number of cells
-    inputVarmap = inputVarmap / (double)( nI * nJ * nK );
-
-    //put h=0 of the varmap at the center of the grid
-    {
-        spectral::array ffVarMapTMP = spectral::shiftByHalf( inputVarmap );
-        inputVarmap = ffVarMapTMP;
-    }
+    //the gradient is taken from the varmap fitting objective, which is much cheaper to evaluate (no
+    //Fourier Integral Method), while the FIM objective is used for the SA energies and to check descent.
+    VariographicDecompositionEngine varmapEngine( *inputGrid, *inputData, m,
+                                                  VariographicDecompositionEngine::Objective::VARMAP_FITTING,
+                                                  ui->spinNumberOfThreads->value() );
 
     //================================== PREPARE OPTIMIZATION STEPS ==========================
 
@@ -2274,12 +2060,10 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_SA_AND_G
             //Computes the “energy” of the current state (set of parameters).
             //The “energy” in this case is how different the image as given the parameters is with respect
             //the data grid, considered the reference image.
-            //double f_eCurrent = F3( *inputGrid, inputVarmap, L_wCurrent, m );
-            double f_eCurrent = F4( *inputGrid, *inputData, L_wCurrent, m );
+            double f_eCurrent = engine.evaluate( L_wCurrent );
 
             //Computes the “energy” of the neighboring state.
-            //f_eNew = F3( *inputGrid, inputVarmap, L_wNew, m );
-            f_eNew = F4( *inputGrid, *inputData, L_wNew, m );
+            f_eNew = engine.evaluate( L_wNew );
             //Changes states stochastically.  There is a probability of acceptance of a more energetic state so
             //the optimization search starts near the global minimum and is not trapped in local minima (hopefully).
             double f_probMov = probAcceptance( f_eCurrent, f_eNew, f_T );
@@ -2306,7 +2090,6 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_SA_AND_G
     //---------------------------------------------------------------------------------------------------------
     //--------------------------------------OPTIMIZATION LOOP (GRADIENT DESCENT)-------------------------------
     //---------------------------------------------------------------------------------------------------------
-    unsigned int nThreads = ui->spinNumberOfThreads->value();
     QProgressDialog progressDialog;
     progressDialog.setRange(0,0);
     progressDialog.show();
@@ -2316,34 +2099,9 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_SA_AND_G
 
         emit info( "Commencing GD step #" + QString::number( iOptStep ) );
 
-        //Compute the gradient vector of objective function F with the current [w] parameters.
-        spectral::array gradient( vw.size() );
-        {
-
-            //distribute the parameter indexes among the n-threads
-            std::vector<int> parameterIndexBins[nThreads];
-            int parameterIndex = 0;
-            for( unsigned int iThread = 0; parameterIndex < vw.size(); ++parameterIndex, ++iThread)
-                parameterIndexBins[ iThread % nThreads ].push_back( parameterIndex );
-
-            //create and run the partial derivative calculation threads
-            std::thread threads[nThreads];
-            for( unsigned int iThread = 0; iThread < nThreads; ++iThread){
-                threads[iThread] = std::thread( taskOnePartialDerivative3,
-                                                vw,
-                                                parameterIndexBins[iThread],
-                                                epsilon,
-                                                inputGrid,
-                                                inputVarmap,
-                                                m,
-                                                &gradient);
-            }
-
-            //wait for the threads to finish.
-            for( unsigned int iThread = 0; iThread < nThreads; ++iThread)
-                threads[iThread].join();
-
-        }
+        //Compute the gradient vector of the varmap fitting objective function with the current [w] parameters
+        //(the partial derivatives are computed in parallel by the engine).
+        spectral::array gradient = varmapEngine.gradient( vw, epsilon );
 
         //Update the system's parameters according to gradient descent.
         double currentF = std::numeric_limits<double>::max();
@@ -2351,6 +2109,7 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_SA_AND_G
         {
             spectral::array *gridData = inputGrid->createSpectralArray( variable->getIndexInParentGrid() );
             double alpha = initialAlpha;
+            currentF = engine.evaluate( vw );
             //halves alpha until we get a descent (current gradient vector may result in overshooting)
             int iAlphaReductionStep = 0;
             for( ; iAlphaReductionStep < maxNumberOfAlphaReductionSteps; ++iAlphaReductionStep ){
@@ -2362,10 +2121,7 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_SA_AND_G
                     if( new_vw.d_[i] > 1.0 )
                         new_vw.d_[i] = 1.0;
                 }
-//                currentF = F3( *inputGrid, inputVarmap, vw, m );
-//                nextF = F3( *inputGrid, inputVarmap, new_vw, m );
-                currentF = F4( *inputGrid, *inputData, vw, m );
-                nextF = F4( *inputGrid, *inputData, new_vw, m );
+                nextF = engine.evaluate( new_vw );
                 if( nextF < currentF ){
                     vw = new_vw;
                     break;
@@ -2389,11 +2145,6 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_SA_AND_G
     }
     progressDialog.hide();
 
-    //Read the optimized variogram model parameters back to the variographic structures
-    for( int i = 0, iGeoFactor = 0; iGeoFactor < m; ++iGeoFactor )
-        for( int iPar = 0; iPar < IJVariographicStructure2D::getNumberOfParameters(); ++iPar, ++i )
-            variographicEllipses[iGeoFactor].setParameter( iPar, vw[i] );
-
 //    ///Visualizing the results on the fly is optional/////////////
 //    {
 //        spectral::array finalVariogramModelSurface( nI, nJ, nK, 0.0 );
@@ -2415,47 +2166,19 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_SA_AND_G
     //use a variographic map as the magnitudes and the FFT phases of
     //the original data to a reverse FFT in polar form to achieve a
     //Factorial Kriging-like separation
+    std::vector< spectral::array > structureVarmaps;
+    std::vector< spectral::array > geologicalFactors;
+    engine.getResults( vw, structureVarmaps, geologicalFactors );
     std::vector< spectral::array > geoFactors;
     std::vector< std::string > titles;
     std::vector< bool > shiftFlags;
     for( int iGeoFactor = 0; iGeoFactor < m; ++iGeoFactor ) {
-        //compute the varmap of the theoretical varmap for one geologic factor
-        spectral::array geoFactorVarMap( nI, nJ, nK, 0.0 );
-        variographicEllipses[iGeoFactor].addContributionToModelGrid( *inputGrid,
-                                                                     geoFactorVarMap,
-                                                                     IJVariogramPermissiveModel::SPHERIC,
-                                                                     true );
-
         //collect the theoretical varmap for display
-        geoFactors.push_back( geoFactorVarMap );
+        geoFactors.push_back( structureVarmaps[iGeoFactor] );
         titles.push_back( QString( "Varmap " + QString::number( iGeoFactor ) ).toStdString() );
         shiftFlags.push_back( false );
 
-        //compute FFT of the theoretical varmap (into polar form)
-        spectral::complex_array geoFactorVarMapFFT( nI, nJ, nK );
-        spectral::array tmp = spectral::shiftByHalf( geoFactorVarMap );
-        spectral::foward( geoFactorVarMapFFT, tmp );
-        spectral::complex_array geoFactorVarMapFFTpolar = spectral::to_polar_form( geoFactorVarMapFFT );
-        spectral::array geoFactorVarMapFFTamplitudes = spectral::real( geoFactorVarMapFFTpolar );
-
-        //get the square root of the amplitudes of the varmap FFT
-        spectral::array geoFactorVarmapFFTamplitudesSQRT = geoFactorVarMapFFTamplitudes.sqrt();
-
-        //convert sqrt(varmap) and the phases of the input to rectangular form
-        spectral::complex_array geoFactorFFTpolar = spectral::to_complex_array(
-                                                       geoFactorVarmapFFTamplitudesSQRT,
-                                                       inputFFTimagPhase
-                                                    );
-        spectral::complex_array geoFactorFFT = spectral::to_rectangular_form( geoFactorFFTpolar );
-
-        //compute the reverse FFT to get the geological factor
-        spectral::array geoFactor( nI, nJ, nK, 0.0 );
-        spectral::backward( geoFactor, geoFactorFFT );
-
-        //fftw3's reverse FFT requires that the values of output be divided by the number of cells
-        geoFactor = geoFactor / (double)( nI * nJ * nK );
-
-        geoFactors.push_back( geoFactor );
+        geoFactors.push_back( geologicalFactors[iGeoFactor] );
         titles.push_back( QString( "Factor " + QString::number( iGeoFactor ) ).toStdString() );
         shiftFlags.push_back( false );
     }
@@ -2529,52 +2252,14 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_LSRS()
 
     //========================= GET VARMAP OF THE INPUT DATA =====================================
 
-    //make an array full of zeroes (useful for certain steps in the workflow)
-    spectral::array zeros( nI, nJ, nK, 0.0 );
-
     // Get the input data as a spectral::array object
     spectral::arrayPtr inputData( inputGrid->createSpectralArray( variable->getIndexInParentGrid() ) );
 
-    //Compute FFT of input
-    spectral::array inputFFTrealPart;
-    spectral::array inputFFTimagPart;
-    spectral::array inputFFTimagPhase;
-    {
-        spectral::complex_array inputFFT;
-        spectral::foward( inputFFT, *inputData );
-        inputFFTrealPart = spectral::real( inputFFT );
-        inputFFTimagPart = spectral::imag( inputFFT );
-        spectral::complex_array inputFFTpolar = spectral::to_polar_form( inputFFT );
-        inputFFTimagPhase = spectral::imag( inputFFTpolar );
-    }
-
-    //do a^2 + b^2
-    // where a = real part of FFT; b = imaginary part of FFT.
-    spectral::array inputMagSquared = spectral::hadamard( inputFFTrealPart, inputFFTrealPart ) +
-                                      spectral::hadamard( inputFFTimagPart, inputFFTimagPart );
-
-    //make a complex array from a^2 + b^2 as magnitude and zeros as phase (polar form)
-    //this corresponds to the FFT of a variographic map
-    spectral::complex_array inputVarmapFFTPolarForm = spectral::to_complex_array( inputMagSquared, zeros );
-    inputMagSquared = spectral::array(); //garbage collection
-
-    //convert the previous complex array to the rectangular form
-    spectral::complex_array inputVarmapFFTRectangularForm = spectral::to_rectangular_form( inputVarmapFFTPolarForm );
-    inputVarmapFFTPolarForm = spectral::complex_array(); //garbage collection
-
-    //get the varmap of the input data by reverse FFT
-    spectral::array inputVarmap( nI, nJ, nK, 0.0 );
-    spectral::backward( inputVarmap, inputVarmapFFTRectangularForm );
-    inputVarmapFFTRectangularForm = spectral::complex_array(); //garbage collection
-
-    //fftw requires that the values of r-FFT be divided by the number of cells
-    inputVarmap = inputVarmap / (double)( nI * nJ * nK );
-
-    //put h=0 of the varmap at the center of the grid
-    {
-        spectral::array ffVarMapTMP = spectral::shiftByHalf( inputVarmap );
-        inputVarmap = ffVarMapTMP;
-    }
+    //the engine computes the FFT and the varmap of the input only once
+    VariographicDecompositionEngine engine( *inputGrid, *inputData, m,
+                                            VariographicDecompositionEngine::Objective::FIM_FITTING,
+                                            ui->spinNumberOfThreads->value() );
+    const spectral::array& inputVarmap = engine.getInputVarmap();
 
     //================================== PREPARE OPTIMIZATION STEPS ==========================
 
@@ -2691,10 +2376,8 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_LSRS()
 
                 }
                 //evaluate the objective function for the current point and for the candidate point
-//                double fCurrent = F3( *inputGrid, inputVarmap, startingPoints[i], m );
-//                double fCandidate = F3( *inputGrid, inputVarmap, vw_candidate, m );
-                double fCurrent = F4( *inputGrid, *inputData, startingPoints[i], m );
-                double fCandidate = F4( *inputGrid, *inputData, vw_candidate, m );
+                double fCurrent = engine.evaluate( startingPoints[i] );
+                double fCandidate = engine.evaluate( vw_candidate );
                 //if the candidate point improves the objective function...
                 if( fCandidate < fCurrent ){
                     //...make it the current point.
@@ -2710,25 +2393,12 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_LSRS()
         } // search for best solution
         //---------------------------------------------------------------------------
 
+        //compute the partial derivatives at the best solution
+        spectral::array gradient = engine.gradient( vw_bestSolution, epsilon );
+
         //for each parameter of the best solution
         for( int iParameter = 0; iParameter < vw.size(); ++iParameter ){
-            //Make a set of parameters slightly shifted to the right (more positive) along one parameter.
-            spectral::array vwFromRight = vw_bestSolution;
-            vwFromRight(iParameter) = vw_bestSolution(iParameter) + epsilon;
-            //Make a set of parameters slightly shifted to the left (more negative) along one parameter.
-            spectral::array vwFromLeft = vw_bestSolution;
-            vwFromLeft(iParameter) = vw_bestSolution(iParameter) - epsilon;
-            //compute the partial derivative along one parameter
-//            double partialDerivative =  (F3( *inputGrid, inputVarmap, vwFromRight, m )
-//                                         -
-//                                         F3( *inputGrid, inputVarmap, vwFromLeft, m ))
-//                                         /
-//                                         ( 2 * epsilon );
-            double partialDerivative =  (F4( *inputGrid, *inputData, vwFromRight, m )
-                                         -
-                                         F4( *inputGrid, *inputData, vwFromLeft, m ))
-                                         /
-                                         ( 2 * epsilon );
+            double partialDerivative = gradient[ iParameter ];
             //update the domain limits depending on the partial derivative result
             //this usually reduces the size of the domain so the next set of starting
             //points have a higher probability to be drawn near a global optimum.
@@ -2741,57 +2411,24 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_LSRS()
     } //restart loop
     progressDialog.hide();
 
-    //Read the optimized variogram model parameters back to the variographic structures
-    for( int i = 0, iGeoFactor = 0; iGeoFactor < m; ++iGeoFactor )
-        for( int iPar = 0; iPar < IJVariographicStructure2D::getNumberOfParameters(); ++iPar, ++i )
-            variographicEllipses[iGeoFactor].setParameter( iPar, vw_bestSolution[i] );
-
 
     //Apply the principle of the Fourier Integral Method
     //use a variographic map as the magnitudes and the FFT phases of
     //the original data to a reverse FFT in polar form to achieve a
     //Factorial Kriging-like separation
+    std::vector< spectral::array > structureVarmaps;
+    std::vector< spectral::array > geologicalFactors;
+    engine.getResults( vw_bestSolution, structureVarmaps, geologicalFactors );
     std::vector< spectral::array > geoFactors;
     std::vector< std::string > titles;
     std::vector< bool > shiftFlags;
     for( int iGeoFactor = 0; iGeoFactor < m; ++iGeoFactor ) {
-        //compute the varmap of the theoretical varmap for one geologic factor
-        spectral::array geoFactorVarMap( nI, nJ, nK, 0.0 );
-        variographicEllipses[iGeoFactor].addContributionToModelGrid( *inputGrid,
-                                                                     geoFactorVarMap,
-                                                                     IJVariogramPermissiveModel::SPHERIC,
-                                                                     true );
-
         //collect the theoretical varmap for display
-        geoFactors.push_back( geoFactorVarMap );
+        geoFactors.push_back( structureVarmaps[iGeoFactor] );
         titles.push_back( QString( "Varmap " + QString::number( iGeoFactor ) ).toStdString() );
         shiftFlags.push_back( false );
 
-        //compute FFT of the theoretical varmap (into polar form)
-        spectral::complex_array geoFactorVarMapFFT( nI, nJ, nK );
-        spectral::array tmp = spectral::shiftByHalf( geoFactorVarMap );
-        spectral::foward( geoFactorVarMapFFT, tmp );
-        spectral::complex_array geoFactorVarMapFFTpolar = spectral::to_polar_form( geoFactorVarMapFFT );
-        spectral::array geoFactorVarMapFFTamplitudes = spectral::real( geoFactorVarMapFFTpolar );
-
-        //get the square root of the amplitudes of the varmap FFT
-        spectral::array geoFactorVarmapFFTamplitudesSQRT = geoFactorVarMapFFTamplitudes.sqrt();
-
-        //convert sqrt(varmap) and the phases of the input to rectangular form
-        spectral::complex_array geoFactorFFTpolar = spectral::to_complex_array(
-                                                       geoFactorVarmapFFTamplitudesSQRT,
-                                                       inputFFTimagPhase
-                                                    );
-        spectral::complex_array geoFactorFFT = spectral::to_rectangular_form( geoFactorFFTpolar );
-
-        //compute the reverse FFT to get the geological factor
-        spectral::array geoFactor( nI, nJ, nK, 0.0 );
-        spectral::backward( geoFactor, geoFactorFFT );
-
-        //fftw3's reverse FFT requires that the values of output be divided by the number of cells
-        geoFactor = geoFactor / (double)( nI * nJ * nK );
-
-        geoFactors.push_back( geoFactor );
+        geoFactors.push_back( geologicalFactors[iGeoFactor] );
         titles.push_back( QString( "Factor " + QString::number( iGeoFactor ) ).toStdString() );
         shiftFlags.push_back( false );
     }
@@ -2830,62 +2467,19 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_PSO()
     IJAbstractCartesianGrid* inputGrid = m_gridSelector->getSelectedGrid();
     IJAbstractVariable* variable = m_variableSelector->getSelectedVariable();
 
-    // Get the grid's dimensions.
-    unsigned int nI = inputGrid->getNI();
-    unsigned int nJ = inputGrid->getNJ();
-    unsigned int nK = inputGrid->getNK();
-
     // Fetch data from the data source.
     inputGrid->dataWillBeRequested();
 
     //========================= GET VARMAP OF THE INPUT DATA =====================================
 
-    //make an array full of zeroes (useful for certain steps in the workflow)
-    spectral::array zeros( nI, nJ, nK, 0.0 );
-
     // Get the input data as a spectral::array object
     spectral::arrayPtr inputData( inputGrid->createSpectralArray( variable->getIndexInParentGrid() ) );
 
-    //Compute FFT of input
-    spectral::array inputFFTrealPart;
-    spectral::array inputFFTimagPart;
-    spectral::array inputFFTimagPhase;
-    {
-        spectral::complex_array inputFFT;
-        spectral::foward( inputFFT, *inputData );
-        inputFFTrealPart = spectral::real( inputFFT );
-        inputFFTimagPart = spectral::imag( inputFFT );
-        spectral::complex_array inputFFTpolar = spectral::to_polar_form( inputFFT );
-        inputFFTimagPhase = spectral::imag( inputFFTpolar );
-    }
-
-    //do a^2 + b^2
-    // where a = real part of FFT; b = imaginary part of FFT.
-    spectral::array inputMagSquared = spectral::hadamard( inputFFTrealPart, inputFFTrealPart ) +
-                                      spectral::hadamard( inputFFTimagPart, inputFFTimagPart );
-
-    //make a complex array from a^2 + b^2 as magnitude and zeros as phase (polar form)
-    //this corresponds to the FFT of a variographic map
-    spectral::complex_array inputVarmapFFTPolarForm = spectral::to_complex_array( inputMagSquared, zeros );
-    inputMagSquared = spectral::array(); //garbage collection
-
-    //convert the previous complex array to the rectangular form
-    spectral::complex_array inputVarmapFFTRectangularForm = spectral::to_rectangular_form( inputVarmapFFTPolarForm );
-    inputVarmapFFTPolarForm = spectral::complex_array(); //garbage collection
-
-    //get the varmap of the input data by reverse FFT
-    spectral::array inputVarmap( nI, nJ, nK, 0.0 );
-    spectral::backward( inputVarmap, inputVarmapFFTRectangularForm );
-    inputVarmapFFTRectangularForm = spectral::complex_array(); //garbage collection
-
-    //fftw requires that the values of r-FFT be divided by the number of cells
-    inputVarmap = inputVarmap / (double)( nI * nJ * nK );
-
-    //put h=0 of the varmap at the center of the grid
-    {
-        spectral::array ffVarMapTMP = spectral::shiftByHalf( inputVarmap );
-        inputVarmap = ffVarMapTMP;
-    }
+    //the engine computes the FFT and the varmap of the input only once
+    VariographicDecompositionEngine engine( *inputGrid, *inputData, m,
+                                            VariographicDecompositionEngine::Objective::VARMAP_FITTING,
+                                            ui->spinNumberOfThreads->value() );
+    const spectral::array& inputVarmap = engine.getInputVarmap();
 
     //================================== PREPARE OPTIMIZATION STEPS ==========================
 
@@ -2989,7 +2583,7 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_PSO()
             //get the best postition of a particle
             spectral::array& pbw = pbests_pbw[ iParticle ] ;
             //evaluate the objective function with the best position of a particle
-            double f = F3( *inputGrid, inputVarmap, pbw, m );
+            double f = engine.evaluate( pbw );
             //if it improves the value so far...
             if( f < fOfBest ){
                 //...updates the best value record
@@ -3037,8 +2631,8 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_PSO()
             }
 
             //evaluate the objective function for current and candidate positions
-            double fCurrent = F3( *inputGrid, inputVarmap, pw, m );
-            double fCandidate = F3( *inputGrid, inputVarmap, candidate_particle, m );
+            double fCurrent = engine.evaluate( pw );
+            double fCandidate = engine.evaluate( candidate_particle );
 
             //if the candidate position improves the objective function
             if( fCandidate < fCurrent ){
@@ -3074,57 +2668,24 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_PSO()
     //-------------------------------------------------------------------------------------------------------------
     progressDialog.hide();
 
-    //Read the optimized variogram model parameters back to the variographic structures
-    for( int i = 0, iGeoFactor = 0; iGeoFactor < m; ++iGeoFactor )
-        for( int iPar = 0; iPar < IJVariographicStructure2D::getNumberOfParameters(); ++iPar, ++i )
-            variographicEllipses[iGeoFactor].setParameter( iPar, gbest_pw[i] );
-
 
     //Apply the principle of the Fourier Integral Method
     //use a variographic map as the magnitudes and the FFT phases of
     //the original data to a reverse FFT in polar form to achieve a
     //Factorial Kriging-like separation
+    std::vector< spectral::array > structureVarmaps;
+    std::vector< spectral::array > geologicalFactors;
+    engine.getResults( gbest_pw, structureVarmaps, geologicalFactors );
     std::vector< spectral::array > geoFactors;
     std::vector< std::string > titles;
     std::vector< bool > shiftFlags;
     for( int iGeoFactor = 0; iGeoFactor < m; ++iGeoFactor ) {
-        //compute the varmap of the theoretical varmap for one geologic factor
-        spectral::array geoFactorVarMap( nI, nJ, nK, 0.0 );
-        variographicEllipses[iGeoFactor].addContributionToModelGrid( *inputGrid,
-                                                                     geoFactorVarMap,
-                                                                     IJVariogramPermissiveModel::SPHERIC,
-                                                                     true );
-
         //collect the theoretical varmap for display
-        geoFactors.push_back( geoFactorVarMap );
+        geoFactors.push_back( structureVarmaps[iGeoFactor] );
         titles.push_back( QString( "Varmap " + QString::number( iGeoFactor ) ).toStdString() );
         shiftFlags.push_back( false );
 
-        //compute FFT of the theoretical varmap (into polar form)
-        spectral::complex_array geoFactorVarMapFFT( nI, nJ, nK );
-        spectral::array tmp = spectral::shiftByHalf( geoFactorVarMap );
-        spectral::foward( geoFactorVarMapFFT, tmp );
-        spectral::complex_array geoFactorVarMapFFTpolar = spectral::to_polar_form( geoFactorVarMapFFT );
-        spectral::array geoFactorVarMapFFTamplitudes = spectral::real( geoFactorVarMapFFTpolar );
-
-        //get the square root of the amplitudes of the varmap FFT
-        spectral::array geoFactorVarmapFFTamplitudesSQRT = geoFactorVarMapFFTamplitudes.sqrt();
-
-        //convert sqrt(varmap) and the phases of the input to rectangular form
-        spectral::complex_array geoFactorFFTpolar = spectral::to_complex_array(
-                                                       geoFactorVarmapFFTamplitudesSQRT,
-                                                       inputFFTimagPhase
-                                                    );
-        spectral::complex_array geoFactorFFT = spectral::to_rectangular_form( geoFactorFFTpolar );
-
-        //compute the reverse FFT to get the geological factor
-        spectral::array geoFactor( nI, nJ, nK, 0.0 );
-        spectral::backward( geoFactor, geoFactorFFT );
-
-        //fftw3's reverse FFT requires that the values of output be divided by the number of cells
-        geoFactor = geoFactor / (double)( nI * nJ * nK );
-
-        geoFactors.push_back( geoFactor );
+        geoFactors.push_back( geologicalFactors[iGeoFactor] );
         titles.push_back( QString( "Factor " + QString::number( iGeoFactor ) ).toStdString() );
         shiftFlags.push_back( false );
     }
@@ -3180,58 +2741,19 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_Genetic(
 
     //========================= GET VARMAP OF THE INPUT DATA =====================================
 
-    //make an array full of zeroes (useful for certain steps in the workflow)
-    spectral::array zeros( nI, nJ, nK, 0.0 );
-
     // Get the input data as a spectral::array object
     spectral::arrayPtr inputData( inputGrid->createSpectralArray( variable->getIndexInParentGrid() ) );
 
-    //Compute FFT of input
-    spectral::array inputFFTrealPart;
-    spectral::array inputFFTimagPart;
-    spectral::array inputFFTimagPhase;
-    {
-        spectral::complex_array inputFFT;
-        spectral::foward( inputFFT, *inputData );
-        inputFFTrealPart = spectral::real( inputFFT );
-        inputFFTimagPart = spectral::imag( inputFFT );
-        spectral::complex_array inputFFTpolar = spectral::to_polar_form( inputFFT );
-        inputFFTimagPhase = spectral::imag( inputFFTpolar );
-    }
-
-    //do a^2 + b^2
-    // where a = real part of FFT; b = imaginary part of FFT.
-    spectral::array inputMagSquared = spectral::hadamard( inputFFTrealPart, inputFFTrealPart ) +
-                                      spectral::hadamard( inputFFTimagPart, inputFFTimagPart );
-
-    //make a complex array from a^2 + b^2 as magnitude and zeros as phase (polar form)
-    //this corresponds to the FFT of a variographic map
-    spectral::complex_array inputVarmapFFTPolarForm = spectral::to_complex_array( inputMagSquared, zeros );
-    inputMagSquared = spectral::array(); //garbage collection
-
-    //convert the previous complex array to the rectangular form
-    spectral::complex_array inputVarmapFFTRectangularForm = spectral::to_rectangular_form( inputVarmapFFTPolarForm );
-    inputVarmapFFTPolarForm = spectral::complex_array(); //garbage collection
+    //the engine computes the FFT and the varmap of the input only once
+    VariographicDecompositionEngine engine( *inputGrid, *inputData, m,
+                                            VariographicDecompositionEngine::Objective::FIM_FITTING,
+                                            ui->spinNumberOfThreads->value() );
+    spectral::array inputVarmap( engine.getInputVarmap() );
 
-    //get the varmap of the input data by reverse FFT
-    spectral::array inputVarmap( nI, nJ, nK, 0.0 );
-    spectral::backward( inputVarmap, inputVarmapFFTRectangularForm );
-    inputVarmapFFTRectangularForm = spectral::complex_array(); //garbage collection
-
-    //fftw requires that the values of r-FFT be divided by the number of cells
-    inputVarmap =  inputVarmap / (double)( nI * nJ * nK );
-
-    ///////////////////////////////////////////////////
+    //zero out negative variance values
     for( int i = 0; i < inputVarmap.size(); ++i )
         if( inputVarmap[i] < 0.0 )
             inputVarmap[i] = 0.0;
-    ///////////////////////////////////////////////////
-
-    //put h=0 of the varmap at the center of the grid
-    {
-        spectral::array ffVarMapTMP = spectral::shiftByHalf( inputVarmap );
-        inputVarmap = ffVarMapTMP;
-    }
 
     //================================== PREPARE OPTIMIZATION STEPS ==========================
 
@@ -3315,11 +2837,14 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_Genetic(
             population.push_back( ind );
         }
 
-        //evaluate the individuals of current population
-        for( uint iInd = 0; iInd < population.size(); ++iInd ){
-            Individual& ind = population[iInd];
-            //ind.fValue = F3( *inputGrid, inputVarmap, ind.parameters, m );
-            ind.fValue = F4( *inputGrid, *inputData, ind.parameters, m );
+        //evaluate the individuals of current population (in parallel)
+        {
+            std::vector< spectral::array > parameterSets;
+            for( const Individual& ind : population )
+                parameterSets.push_back( ind.parameters );
+            std::vector<double> fValues = engine.evaluate( parameterSets );
+            for( uint iInd = 0; iInd < population.size(); ++iInd )
+                population[iInd].fValue = fValues[iInd];
         }
 
         //sort the population in ascending order (lower value == better fitness)
@@ -3410,8 +2935,7 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_Genetic(
 //        ind.parameters[6] = - ImageJockeyUtils::PI * 41 / 180.0 ;
 //        ind.parameters[7] = inputVarmap.max();
         //////////////////////////////
-        //ind.fValue = F3( *inputGrid, inputVarmap, ind.parameters, m );
-        ind.fValue = F4( *inputGrid, *inputData, ind.parameters, m );
+        ind.fValue = engine.evaluate( ind.parameters );
     }
 
     //sort the population in ascending order (lower value == better fitness)
@@ -3422,56 +2946,23 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_Genetic(
 
     std::cout << population[0].fValue << std::endl;
 
-    //Read the optimized variogram model parameters back to the variographic structures
-    for( int i = 0, iGeoFactor = 0; iGeoFactor < m; ++iGeoFactor )
-        for( int iPar = 0; iPar < IJVariographicStructure2D::getNumberOfParameters(); ++iPar, ++i )
-            variographicEllipses[iGeoFactor].setParameter( iPar, gbest_pw[i] );
-
     //Apply the principle of the Fourier Integral Method
     //use a variographic map as the magnitudes and the FFT phases of
     //the original data to a reverse FFT in polar form to achieve a
     //Factorial Kriging-like separation
+    std::vector< spectral::array > structureVarmaps;
+    std::vector< spectral::array > geologicalFactors;
+    engine.getResults( gbest_pw, structureVarmaps, geologicalFactors );
     std::vector< spectral::array > geoFactors;
     std::vector< std::string > titles;
     std::vector< bool > shiftFlags;
     for( int iGeoFactor = 0; iGeoFactor < m; ++iGeoFactor ) {
-        //compute the varmap of the theoretical varmap for one geologic factor
-        spectral::array geoFactorVarMap( nI, nJ, nK, 0.0 );
-        variographicEllipses[iGeoFactor].addContributionToModelGrid( *inputGrid,
-                                                                     geoFactorVarMap,
-                                                                     IJVariogramPermissiveModel::SPHERIC,
-                                                                     true );
-
         //collect the theoretical varmap for display
-        geoFactors.push_back( geoFactorVarMap );
+        geoFactors.push_back( structureVarmaps[iGeoFactor] );
         titles.push_back( QString( "Varmap " + QString::number( iGeoFactor ) ).toStdString() );
         shiftFlags.push_back( false );
 
-        //compute FFT of the theoretical varmap (into polar form)
-        spectral::complex_array geoFactorVarMapFFT( nI, nJ, nK );
-        spectral::array tmp = spectral::shiftByHalf( geoFactorVarMap );
-        spectral::foward( geoFactorVarMapFFT, tmp );
-        spectral::complex_array geoFactorVarMapFFTpolar = spectral::to_polar_form( geoFactorVarMapFFT );
-        spectral::array geoFactorVarMapFFTamplitudes = spectral::real( geoFactorVarMapFFTpolar );
-
-        //get the square root of the amplitudes of the varmap FFT
-        spectral::array geoFactorVarmapFFTamplitudesSQRT = geoFactorVarMapFFTamplitudes.sqrt();
-
-        //convert sqrt(varmap) and the phases of the input to rectangular form
-        spectral::complex_array geoFactorFFTpolar = spectral::to_complex_array(
-                                                       geoFactorVarmapFFTamplitudesSQRT,
-                                                       inputFFTimagPhase
-                                                    );
-        spectral::complex_array geoFactorFFT = spectral::to_rectangular_form( geoFactorFFTpolar );
-
-        //compute the reverse FFT to get the geological factor
-        spectral::array geoFactor( nI, nJ, nK, 0.0 );
-        spectral::backward( geoFactor, geoFactorFFT );
-
-        //fftw3's reverse FFT requires that the values of output be divided by the number of cells
-        geoFactor = geoFactor / (double)( nI * nJ * nK );
-
-        geoFactors.push_back( geoFactor );
+        geoFactors.push_back( geologicalFactors[iGeoFactor] );
         titles.push_back( QString( "Factor " + QString::number( iGeoFactor ) ).toStdString() );
         shiftFlags.push_back( false );
     }
@@ -3506,62 +2997,19 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_BruteFor
     IJAbstractCartesianGrid* inputGrid = m_gridSelector->getSelectedGrid();
     IJAbstractVariable* variable = m_variableSelector->getSelectedVariable();
 
-    // Get the grid's dimensions.
-    unsigned int nI = inputGrid->getNI();
-    unsigned int nJ = inputGrid->getNJ();
-    unsigned int nK = inputGrid->getNK();
-
     // Fetch data from the data source.
     inputGrid->dataWillBeRequested();
 
     //========================= GET VARMAP OF THE INPUT DATA =====================================
 
-    //make an array full of zeroes (useful for certain steps in the workflow)
-    spectral::array zeros( nI, nJ, nK, 0.0 );
-
     // Get the input data as a spectral::array object
     spectral::arrayPtr inputData( inputGrid->createSpectralArray( variable->getIndexInParentGrid() ) );
 
-    //Compute FFT of input
-    spectral::array inputFFTrealPart;
-    spectral::array inputFFTimagPart;
-    spectral::array inputFFTimagPhase;
-    {
-        spectral::complex_array inputFFT;
-        spectral::foward( inputFFT, *inputData );
-        inputFFTrealPart = spectral::real( inputFFT );
-        inputFFTimagPart = spectral::imag( inputFFT );
-        spectral::complex_array inputFFTpolar = spectral::to_polar_form( inputFFT );
-        inputFFTimagPhase = spectral::imag( inputFFTpolar );
-    }
-
-    //do a^2 + b^2
-    // where a = real part of FFT; b = imaginary part of FFT.
-    spectral::array inputMagSquared = spectral::hadamard( inputFFTrealPart, inputFFTrealPart ) +
-                                      spectral::hadamard( inputFFTimagPart, inputFFTimagPart );
-
-    //make a complex array from a^2 + b^2 as magnitude and zeros as phase (polar form)
-    //this corresponds to the FFT of a variographic map
-    spectral::complex_array inputVarmapFFTPolarForm = spectral::to_complex_array( inputMagSquared, zeros );
-    inputMagSquared = spectral::array(); //garbage collection
-
-    //convert the previous complex array to the rectangular form
-    spectral::complex_array inputVarmapFFTRectangularForm = spectral::to_rectangular_form( inputVarmapFFTPolarForm );
-    inputVarmapFFTPolarForm = spectral::complex_array(); //garbage collection
-
-    //get the varmap of the input data by reverse FFT
-    spectral::array inputVarmap( nI, nJ, nK, 0.0 );
-    spectral::backward( inputVarmap, inputVarmapFFTRectangularForm );
-    inputVarmapFFTRectangularForm = spectral::complex_array(); //garbage collection
-
-    //fftw requires that the values of r-FFT be divided by the number of cells
-    inputVarmap = inputVarmap / (double)( nI * nJ * nK );
-
-    //put h=0 of the varmap at the center of the grid
-    {
-        spectral::array ffVarMapTMP = spectral::shiftByHalf( inputVarmap );
-        inputVarmap = ffVarMapTMP;
-    }
+    //the engine computes the FFT and the varmap of the input only once
+    VariographicDecompositionEngine engine( *inputGrid, *inputData, m,
+                                            VariographicDecompositionEngine::Objective::VARMAP_FITTING,
+                                            ui->spinNumberOfThreads->value() );
+    const spectral::array& inputVarmap = engine.getInputVarmap();
 
     //================================== PREPARE OPTIMIZATION STEPS ==========================
 
@@ -3645,10 +3093,14 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_BruteFor
             solutions.push_back( Solution( parameters ) );
         }
 
-        //evaluate the solutions of current set
-        for( uint iSol = 0; iSol < solutions.size(); ++iSol ){
-            Solution& solution = solutions[iSol];
-            solution.fValue = F3( *inputGrid, inputVarmap, solution.parameters, m );
+        //evaluate the solutions of current set (in parallel)
+        {
+            std::vector< spectral::array > parameterSets;
+            for( const Solution& solution : solutions )
+                parameterSets.push_back( solution.parameters );
+            std::vector<double> fValues = engine.evaluate( parameterSets );
+            for( uint iSol = 0; iSol < solutions.size(); ++iSol )
+                solutions[iSol].fValue = fValues[iSol];
         }
 
         //sort the solution set in ascending order (lower value == better fitness)
@@ -3668,56 +3120,23 @@ void VariographicDecompositionDialog::doVariographicDecomposition5_WITH_BruteFor
     //get the parameters of the best solution (set of parameters)
     spectral::array gbest_pw = bestSolution.parameters;
 
-    //Read the optimized variogram model parameters back to the variographic structures
-    for( int i = 0, iGeoFactor = 0; iGeoFactor < m; ++iGeoFactor )
-        for( int iPar = 0; iPar < IJVariographicStructure2D::getNumberOfParameters(); ++iPar, ++i )
-            variographicEllipses[iGeoFactor].setParameter( iPar, gbest_pw[i] );
-
     //Apply the principle of the Fourier Integral Method
     //use a variographic map as the magnitudes and the FFT phases of
     //the original data to a reverse FFT in polar form to achieve a
     //Factorial Kriging-like separation
+    std::vector< spectral::array > structureVarmaps;
+    std::vector< spectral::array > geologicalFactors;
+    engine.getResults( gbest_pw, structureVarmaps, geologicalFactors );
     std::vector< spectral::array > geoFactors;
     std::vector< std::string > titles;
     std::vector< bool > shiftFlags;
     for( int iGeoFactor = 0; iGeoFactor < m; ++iGeoFactor ) {
-        //compute the varmap of the theoretical varmap for one geologic factor
-        spectral::array geoFactorVarMap( nI, nJ, nK, 0.0 );
-        variographicEllipses[iGeoFactor].addContributionToModelGrid( *inputGrid,
-                                                                     geoFactorVarMap,
-                                                                     IJVariogramPermissiveModel::SPHERIC,
-                                                                     true );
-
         //collect the theoretical varmap for display
-        geoFactors.push_back( geoFactorVarMap );
+        geoFactors.push_back( structureVarmaps[iGeoFactor] );
         titles.push_back( QString( "Varmap " + QString::number( iGeoFactor ) ).toStdString() );
         shiftFlags.push_back( false );
 
-        //compute FFT of the theoretical varmap (into polar form)
-        spectral::complex_array geoFactorVarMapFFT( nI, nJ, nK );
-        spectral::array tmp = spectral::shiftByHalf( geoFactorVarMap );
-        spectral::foward( geoFactorVarMapFFT, tmp );
-        spectral::complex_array geoFactorVarMapFFTpolar = spectral::to_polar_form( geoFactorVarMapFFT );
-        spectral::array geoFactorVarMapFFTamplitudes = spectral::real( geoFactorVarMapFFTpolar );
-
-        //get the square root of the amplitudes of the varmap FFT
-        spectral::array geoFactorVarmapFFTamplitudesSQRT = geoFactorVarMapFFTamplitudes.sqrt();
-
-        //convert sqrt(varmap) and the phases of the input to rectangular form
-        spectral::complex_array geoFactorFFTpolar = spectral::to_complex_array(
-                                                       geoFactorVarmapFFTamplitudesSQRT,
-                                                       inputFFTimagPhase
-                                                    );
-        spectral::complex_array geoFactorFFT = spectral::to_rectangular_form( geoFactorFFTpolar );
-
-        //compute the reverse FFT to get the geological factor
-        spectral::array geoFactor( nI, nJ, nK, 0.0 );
-        spectral::backward( geoFactor, geoFactorFFT );
-
-        //fftw3's reverse FFT requires that the values of output be divided by the number of cells
-        geoFactor = geoFactor / (double)( nI * nJ * nK );
-
-        geoFactors.push_back( geoFactor );
+        geoFactors.push_back( geologicalFactors[iGeoFactor] );
         titles.push_back( QString( "Factor " + QString::number( iGeoFactor ) ).toStdString() );
         shiftFlags.push_back( false );
     }
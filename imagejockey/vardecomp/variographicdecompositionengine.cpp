@@ -0,0 +1,287 @@
+#include "variographicdecompositionengine.h"
+#include "imagejockey/ijabstractcartesiangrid.h"
+#include "imagejockey/ijvariographicmodel2d.h"
+#include "spectral/fftservice.h"
+#include <cmath>
+#include <algorithm>
+
+VariographicDecompositionEngine::VariographicDecompositionEngine(const IJAbstractCartesianGrid &gridWithGeometry,
+                                                                 const spectral::array &inputData,
+                                                                 int nStructures,
+                                                                 VariographicDecompositionEngine::Objective objective,
+                                                                 unsigned int nThreads) :
+    m_gridWithGeometry( gridWithGeometry ),
+    m_inputData( inputData ),
+    m_nStructures( nStructures ),
+    m_objective( objective ),
+    m_nI( gridWithGeometry.getNI() ),
+    m_nJ( gridWithGeometry.getNJ() ),
+    m_nK( gridWithGeometry.getNK() ),
+    m_nSpectrum( m_nI * m_nJ * ( m_nK / 2 + 1 ) ),
+    m_pool( nThreads )
+{
+    spectral::index nCells = m_nI * m_nJ * m_nK;
+
+    //Compute FFT of input (half spectrum)
+    spectral::complex_array inputFFT( m_nI, m_nJ, m_nK / 2 + 1 );
+    {
+        spectral::array tmp( m_inputData );
+        spectral::FFTService::instance().r2c( tmp.data().data(), inputFFT.data(), 3, m_nI, m_nJ, m_nK );
+    }
+
+    //the phases of the input are kept as unit phasors, so the FIM needs only products.
+    //the varmap of the input is the reverse FFT of a^2 + b^2 (with zero phase),
+    //where a = real part of FFT; b = imaginary part of FFT.
+    m_inputPhasors = spectral::complex_array( m_nI, m_nJ, m_nK / 2 + 1 );
+    spectral::complex_array inputVarmapFFT( m_nI, m_nJ, m_nK / 2 + 1 );
+    for( spectral::index i = 0; i < m_nSpectrum; ++i ){
+        double a = inputFFT.d_[i][0];
+        double b = inputFFT.d_[i][1];
+        double phase = std::atan2( b, a );
+        m_inputPhasors.d_[i][0] = std::cos( phase );
+        m_inputPhasors.d_[i][1] = std::sin( phase );
+        inputVarmapFFT.d_[i][0] = a * a + b * b;
+        inputVarmapFFT.d_[i][1] = 0.0;
+    }
+
+    //get the varmap of the input data by reverse FFT
+    spectral::array inputVarmap( m_nI, m_nJ, m_nK, 0.0 );
+    spectral::FFTService::instance().c2r( inputVarmapFFT.data(), inputVarmap.data().data(), 3, m_nI, m_nJ, m_nK );
+
+    //fftw requires that the values of r-FFT be divided by the number of cells
+    inputVarmap = inputVarmap / (double)nCells;
+
+    //put h=0 of the varmap at the center of the grid
+    m_inputVarmap = spectral::shiftByHalf( inputVarmap );
+}
+
+int VariographicDecompositionEngine::getNumberOfParameters() const
+{
+    return m_nStructures * IJVariographicStructure2D::getNumberOfParameters();
+}
+
+double VariographicDecompositionEngine::evaluate(const spectral::array &parameters)
+{
+    updateState( parameters );
+    return objective( m_state, nullptr, nullptr );
+}
+
+std::vector<double> VariographicDecompositionEngine::evaluate(const std::vector<spectral::array> &parameterSets)
+{
+    std::vector<double> result( parameterSets.size() );
+    if( parameterSets.empty() )
+        return result;
+
+    //the first set becomes the current state, so the sets differing from it in a single structure
+    //(e.g. a population converging to a solution) are evaluated incrementally.
+    result[0] = evaluate( parameterSets[0] );
+
+    int nParameters = IJVariographicStructure2D::getNumberOfParameters();
+    bool withSpectrum = ( m_objective == Objective::FIM_FITTING );
+    WorkStealingPool::TaskGroup tasks;
+    for( size_t iSet = 1; iSet < parameterSets.size(); ++iSet ){
+        m_pool.submit( tasks, [this, &parameterSets, &result, iSet, nParameters, withSpectrum](){
+            const double* parameters = parameterSets[ iSet ].d_.data();
+            //find the structures that differ from the current state
+            std::vector<int> changed;
+            for( int iStructure = 0; iStructure < m_nStructures; ++iStructure ){
+                const std::vector<double>& current = m_state.structures[iStructure].parameters;
+                if( ! std::equal( current.begin(), current.end(), parameters + iStructure * nParameters ) )
+                    changed.push_back( iStructure );
+            }
+            if( changed.empty() )
+                result[ iSet ] = objective( m_state, nullptr, nullptr );
+            else if( changed.size() == 1 ){
+                Structure added = makeStructure( parameters + changed[0] * nParameters, withSpectrum );
+                result[ iSet ] = objective( m_state, &m_state.structures[ changed[0] ], &added );
+            } else {
+                State state;
+                for( int iStructure = 0; iStructure < m_nStructures; ++iStructure )
+                    state.structures.push_back( makeStructure( parameters + iStructure * nParameters, withSpectrum ) );
+                sumStructures( state );
+                result[ iSet ] = objective( state, nullptr, nullptr );
+            }
+        });
+    }
+    m_pool.wait( tasks );
+    return result;
+}
+
+spectral::array VariographicDecompositionEngine::gradient(const spectral::array &parameters, double epsilon)
+{
+    updateState( parameters );
+
+    int nParameters = IJVariographicStructure2D::getNumberOfParameters();
+    bool withSpectrum = ( m_objective == Objective::FIM_FITTING );
+    spectral::array result( (spectral::index)parameters.size() );
+
+    //each partial derivative changes a single structure, so it is evaluated from the current state.
+    WorkStealingPool::TaskGroup tasks;
+    for( int iParameter = 0; iParameter < parameters.size(); ++iParameter ){
+        m_pool.submit( tasks, [this, &result, iParameter, epsilon, nParameters, withSpectrum](){
+            const Structure& current = m_state.structures[ iParameter / nParameters ];
+            std::vector<double> shifted( current.parameters );
+            double& parameter = shifted[ iParameter % nParameters ];
+            double value = parameter;
+            //Make a set of parameters slightly shifted to the right (more positive) along one parameter.
+            parameter = value + epsilon;
+            Structure fromRight = makeStructure( shifted.data(), withSpectrum );
+            //Make a set of parameters slightly shifted to the left (more negative) along one parameter.
+            parameter = value - epsilon;
+            Structure fromLeft = makeStructure( shifted.data(), withSpectrum );
+            //Compute (numerically) the partial derivative with respect to one parameter.
+            result[ iParameter ] = ( objective( m_state, &current, &fromRight ) -
+                                     objective( m_state, &current, &fromLeft ) )
+                                   / ( 2 * epsilon );
+        });
+    }
+    m_pool.wait( tasks );
+    return result;
+}
+
+void VariographicDecompositionEngine::getResults(const spectral::array &parameters,
+                                                 std::vector<spectral::array> &structureVarmaps,
+                                                 std::vector<spectral::array> &geologicalFactors)
+{
+    int nParameters = IJVariographicStructure2D::getNumberOfParameters();
+    structureVarmaps = std::vector< spectral::array >( m_nStructures );
+    geologicalFactors = std::vector< spectral::array >( m_nStructures );
+
+    //Apply the principle of the Fourier Integral Method to each structure
+    //(the spectra are needed regardless of the objective).
+    WorkStealingPool::TaskGroup tasks;
+    for( int iStructure = 0; iStructure < m_nStructures; ++iStructure ){
+        m_pool.submit( tasks, [this, &parameters, &structureVarmaps, &geologicalFactors, iStructure, nParameters](){
+            Structure structure = makeStructure( &parameters.d_[ iStructure * nParameters ], true );
+            geologicalFactors[ iStructure ] = fourierIntegralMap( structure.spectrum );
+            structureVarmaps[ iStructure ] = std::move( structure.surface );
+        });
+    }
+    m_pool.wait( tasks );
+}
+
+VariographicDecompositionEngine::Structure VariographicDecompositionEngine::makeStructure(const double *parameters,
+                                                                                          bool withSpectrum) const
+{
+    Structure structure;
+    IJVariographicStructure2D varEllip( 0.0, 0.0, 0.0, 0.0 );
+    for( int iPar = 0; iPar < IJVariographicStructure2D::getNumberOfParameters(); ++iPar ){
+        varEllip.setParameter( iPar, parameters[iPar] );
+        structure.parameters.push_back( parameters[iPar] );
+    }
+
+    //make the variographic surface
+    structure.surface = spectral::array( m_nI, m_nJ, m_nK, 0.0 );
+    varEllip.addContributionToModelGrid( m_gridWithGeometry,
+                                         structure.surface,
+                                         IJVariogramPermissiveModel::SPHERIC,
+                                         true );
+
+    //compute the FFT of the surface with h=0 at the origin
+    if( withSpectrum ){
+        spectral::array tmp = spectral::shiftByHalf( structure.surface );
+        structure.spectrum = spectral::complex_array( m_nI, m_nJ, m_nK / 2 + 1 );
+        spectral::FFTService::instance().r2c( tmp.data().data(), structure.spectrum.data(), 3, m_nI, m_nJ, m_nK );
+    }
+    return structure;
+}
+
+void VariographicDecompositionEngine::sumStructures(State &state) const
+{
+    state.surfaceSum = spectral::array( m_nI, m_nJ, m_nK, 0.0 );
+    for( const Structure& structure : state.structures )
+        state.surfaceSum += structure.surface;
+    if( m_objective == Objective::FIM_FITTING ){
+        state.spectrumSum = spectral::complex_array( m_nI, m_nJ, m_nK / 2 + 1 );
+        for( spectral::index i = 0; i < m_nSpectrum; ++i ){
+            state.spectrumSum.d_[i][0] = 0.0;
+            state.spectrumSum.d_[i][1] = 0.0;
+            for( const Structure& structure : state.structures ){
+                state.spectrumSum.d_[i][0] += structure.spectrum.d_[i][0];
+                state.spectrumSum.d_[i][1] += structure.spectrum.d_[i][1];
+            }
+        }
+    }
+}
+
+void VariographicDecompositionEngine::updateState(const spectral::array &parameters)
+{
+    int nParameters = IJVariographicStructure2D::getNumberOfParameters();
+    bool withSpectrum = ( m_objective == Objective::FIM_FITTING );
+    if( m_state.structures.empty() )
+        m_state.structures.resize( m_nStructures );
+
+    //recompute the structures whose parameters changed in parallel
+    bool changed = false;
+    WorkStealingPool::TaskGroup tasks;
+    for( int iStructure = 0; iStructure < m_nStructures; ++iStructure ){
+        const double* structureParameters = &parameters.d_[ iStructure * nParameters ];
+        Structure& structure = m_state.structures[iStructure];
+        if( ! structure.parameters.empty() &&
+                std::equal( structure.parameters.begin(), structure.parameters.end(), structureParameters ) )
+            continue;
+        changed = true;
+        m_pool.submit( tasks, [this, &structure, structureParameters, withSpectrum](){
+            structure = makeStructure( structureParameters, withSpectrum );
+        });
+    }
+    m_pool.wait( tasks );
+
+    //the sums are recomputed from the structures, so rounding errors do not build up.
+    if( changed )
+        sumStructures( m_state );
+}
+
+double VariographicDecompositionEngine::objective(const State &state,
+                                                  const Structure *removed,
+                                                  const Structure *added) const
+{
+    if( m_objective == Objective::VARMAP_FITTING ){
+        //the variogram model surface is the sum of the surfaces of the structures.
+        double result = 0.0;
+        for( spectral::index i = 0; i < (spectral::index)state.surfaceSum.d_.size(); ++i ){
+            double model = state.surfaceSum.d_[i];
+            if( removed )
+                model += added->surface.d_[i] - removed->surface.d_[i];
+            result += std::abs( m_inputVarmap.d_[i] - model );
+        }
+        return result / m_inputVarmap.size();
+    }
+
+    //Apply the principle of the Fourier Integral Method to obtain what would the map be
+    //if it actually had the theoretical variogram model
+    spectral::complex_array spectrum( m_nI, m_nJ, m_nK / 2 + 1 );
+    for( spectral::index i = 0; i < m_nSpectrum; ++i ){
+        spectrum.d_[i][0] = state.spectrumSum.d_[i][0];
+        spectrum.d_[i][1] = state.spectrumSum.d_[i][1];
+        if( removed ){
+            spectrum.d_[i][0] += added->spectrum.d_[i][0] - removed->spectrum.d_[i][0];
+            spectrum.d_[i][1] += added->spectrum.d_[i][1] - removed->spectrum.d_[i][1];
+        }
+    }
+    spectral::array map = fourierIntegralMap( spectrum );
+
+    //compute the objective function metric
+    double result = 0.0;
+    for( spectral::index i = 0; i < (spectral::index)map.d_.size(); ++i )
+        result += std::abs( m_inputData.d_[i] - map.d_[i] );
+    return result;
+}
+
+spectral::array VariographicDecompositionEngine::fourierIntegralMap(spectral::complex_array &spectrum) const
+{
+    //use the square roots of the amplitudes of the variogram model FFT and the phases of the input
+    for( spectral::index i = 0; i < m_nSpectrum; ++i ){
+        double amplitudeSQRT = std::sqrt( std::sqrt( spectrum.d_[i][0] * spectrum.d_[i][0] +
+                                                     spectrum.d_[i][1] * spectrum.d_[i][1] ) );
+        spectrum.d_[i][0] = amplitudeSQRT * m_inputPhasors.d_[i][0];
+        spectrum.d_[i][1] = amplitudeSQRT * m_inputPhasors.d_[i][1];
+    }
+
+    //compute the reverse FFT to get the map
+    spectral::array map( m_nI, m_nJ, m_nK, 0.0 );
+    spectral::FFTService::instance().c2r( spectrum.data(), map.data().data(), 3, m_nI, m_nJ, m_nK );
+
+    //fftw3's reverse FFT requires that the values of output be divided by the number of cells
+    return map / (double)( m_nI * m_nJ * m_nK );
+}
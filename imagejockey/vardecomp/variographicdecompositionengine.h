@@ -0,0 +1,135 @@
+#ifndef VARIOGRAPHICDECOMPOSITIONENGINE_H
+#define VARIOGRAPHICDECOMPOSITIONENGINE_H
+
+#include "spectral/spectral.h"
+#include "algorithms/workstealingpool.h"
+#include <vector>
+
+class IJAbstractCartesianGrid;
+
+/**
+ * The VariographicDecompositionEngine class evaluates the objective functions of the variographic decomposition
+ * (the fitting of m nested variographic structures to a grid, see the program manual for the theory) for the
+ * optimizers of VariographicDecompositionDialog.  It has no GUI dependencies, so it can be used headless
+ * (e.g. in batch runs or tests).  Compared to evaluating the objective from scratch every time:
+ * - The FFT of the input, its phases and its varmap are computed only once, in the constructor.
+ * - The variographic surface and its FFT are kept per structure.  Between evaluations, only the structures
+ *   whose parameters changed are recomputed.  Since the FFT is linear, the spectrum of the model is the sum of
+ *   the spectra of the structures, so a change in one structure costs one surface, one forward FFT and
+ *   one reverse FFT.
+ * - The partial derivatives change one parameter of one structure each, thus they are computed incrementally
+ *   from the current state and in parallel.  Sets of parameters (e.g. particles, individuals) can also be
+ *   evaluated in parallel.
+ * - The worker threads are kept in a pool for the whole lifetime of the engine.
+ *
+ * The vectors of parameters are laid out as [axis0,ratio0,az0,cc0,axis1,ratio1,...] (see
+ * IJVariographicStructure2D::getParameter()).
+ */
+class VariographicDecompositionEngine
+{
+public:
+
+    /** The objective functions. */
+    enum class Objective : int {
+        VARMAP_FITTING, //!< mean absolute difference between the varmap of the input and the variogram model surface.
+        FIM_FITTING     //!< sum of absolute differences between the input and the map obtained by the Fourier
+                        //!< Integral Method from the variogram model surface and the phases of the input.
+    };
+
+    /**
+     * @param gridWithGeometry The grid whose geometry is used to generate the variographic surfaces.  It must
+     *                         outlive the engine.
+     * @param inputData The input data, with the same dimensions as the grid.
+     * @param nStructures The number of variographic structures (geological factors).
+     * @param objective The objective function to evaluate.
+     * @param nThreads Number of threads to use.  If zero, the number of logical CPUs is used.
+     */
+    VariographicDecompositionEngine( const IJAbstractCartesianGrid& gridWithGeometry,
+                                     const spectral::array& inputData,
+                                     int nStructures,
+                                     Objective objective,
+                                     unsigned int nThreads = 0 );
+
+    /** Returns the size of the vectors of parameters. */
+    int getNumberOfParameters() const;
+
+    /** Returns the varmap of the input data with h=0 at the center of the grid. */
+    const spectral::array& getInputVarmap() const { return m_inputVarmap; }
+
+    /** Evaluates the objective function.  Consecutive calls recompute only the structures that changed. */
+    double evaluate( const spectral::array& parameters );
+
+    /** Evaluates the objective function for several sets of parameters in parallel. */
+    std::vector<double> evaluate( const std::vector< spectral::array >& parameterSets );
+
+    /** Computes the gradient of the objective function with central differences. */
+    spectral::array gradient( const spectral::array& parameters, double epsilon );
+
+    /**
+     * Computes the results of a decomposition.
+     * @param structureVarmaps Output: the variographic surface of each structure (h=0 at the center).
+     * @param geologicalFactors Output: the geological factor of each structure, obtained with the Fourier
+     *                          Integral Method (sqrt of the amplitudes of the surface's FFT with the input's phases).
+     */
+    void getResults( const spectral::array& parameters,
+                     std::vector< spectral::array >& structureVarmaps,
+                     std::vector< spectral::array >& geologicalFactors );
+
+private:
+
+    VariographicDecompositionEngine( const VariographicDecompositionEngine& ) = delete;
+    VariographicDecompositionEngine& operator=( const VariographicDecompositionEngine& ) = delete;
+
+    /** A variographic structure with its surface and the FFT of the (unshifted) surface. */
+    struct Structure{
+        std::vector<double> parameters;
+        spectral::array surface;
+        spectral::complex_array spectrum;
+    };
+
+    /** A set of structures and the sums of their surfaces and spectra. */
+    struct State{
+        std::vector< Structure > structures;
+        spectral::array surfaceSum;
+        spectral::complex_array spectrumSum;
+    };
+
+    /** Makes the surface of a structure and, if withSpectrum is true, its spectrum. */
+    Structure makeStructure( const double* parameters, bool withSpectrum ) const;
+
+    /** Recomputes the sums of the surfaces and spectra of a state. */
+    void sumStructures( State& state ) const;
+
+    /** Recomputes the structures of m_state whose parameters differ from the given ones. */
+    void updateState( const spectral::array& parameters );
+
+    /** Evaluates the objective for a state given by its sums.  If removed and added are not null, the state
+     * is evaluated with the structure removed replaced by the structure added. */
+    double objective( const State& state, const Structure* removed, const Structure* added ) const;
+
+    /** Computes the map with the given variogram model spectrum and the phases of the input (FIM).
+     * @param spectrum The spectrum.  It is overwritten. */
+    spectral::array fourierIntegralMap( spectral::complex_array& spectrum ) const;
+
+    const IJAbstractCartesianGrid& m_gridWithGeometry;
+    spectral::array m_inputData;
+    int m_nStructures;
+    Objective m_objective;
+    spectral::index m_nI, m_nJ, m_nK;
+
+    /** The number of values in the half spectra of r2c transforms. */
+    spectral::index m_nSpectrum;
+
+    /** The varmap of the input, with h=0 at the center. */
+    spectral::array m_inputVarmap;
+
+    /** The unit phasors (e^(i*phase)) of the input's FFT (half spectrum). */
+    spectral::complex_array m_inputPhasors;
+
+    /** The structures of the last evaluation. */
+    State m_state;
+
+    WorkStealingPool m_pool;
+};
+
+#endif // VARIOGRAPHICDECOMPOSITIONENGINE_H
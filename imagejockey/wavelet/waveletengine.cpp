@@ -0,0 +1,269 @@
+#include "waveletengine.h"
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+/** Steps with less than this number of values are run in the calling thread only (spawning threads would
+ *  cost more than the step itself). */
+static const spectral::index MIN_VALUES_FOR_MULTITHREADING = 1 << 16;
+
+WaveletEngine::WaveletEngine(WaveletFamily waveletFamily, int waveletType, bool centered, unsigned int nThreads) :
+    m_wavelet( nullptr ),
+    m_nThreads( nThreads )
+{
+    //WaveletUtils::makeWavelet() is private, thus the wavelet is made here in the same way.
+    switch ( waveletFamily ) {
+    case WaveletFamily::DAUBECHIES:
+        m_wavelet = gsl_wavelet_alloc( centered ? gsl_wavelet_daubechies_centered : gsl_wavelet_daubechies,
+                                       waveletType );
+        break;
+    case WaveletFamily::HAAR:
+        m_wavelet = gsl_wavelet_alloc( centered ? gsl_wavelet_haar_centered : gsl_wavelet_haar,
+                                       waveletType );
+        break;
+    case WaveletFamily::B_SPLINE:
+        m_wavelet = gsl_wavelet_alloc( centered ? gsl_wavelet_bspline_centered : gsl_wavelet_bspline,
+                                       waveletType );
+        break;
+    default:
+        break;
+    }
+    if( m_nThreads == 0 )
+        m_nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+}
+
+WaveletEngine::~WaveletEngine()
+{
+    if( m_wavelet )
+        gsl_wavelet_free( m_wavelet );
+}
+
+spectral::array WaveletEngine::transform(const spectral::array &input, bool interleaved, int nLevels) const
+{
+    spectral::index nI = input.M();
+    spectral::index nJ = input.N();
+    spectral::index nK = input.K();
+    spectral::index n[3] = { paddedSize( nI ), paddedSize( nJ ), paddedSize( nK ) };
+
+    //mirror pad each axis to its own power-of-2 size (the input is placed at the origin).
+    spectral::array result = mirrorPad( input, n[0], n[1], n[2] );
+
+    if( ! m_wavelet )
+        return result;
+
+    int levels[3] = { levelsOfAxis( n[0], nLevels ), levelsOfAxis( n[1], nLevels ), levelsOfAxis( n[2], nLevels ) };
+
+    if( interleaved ){
+        //one step per axis per level, each level operating on the approximation sub-grid of the previous one.
+        int maxLevels = std::max( { levels[0], levels[1], levels[2] } );
+        for( int level = 0; level < maxLevels; ++level ){
+            spectral::index extent[3];
+            for( int axis = 0; axis < 3; ++axis )
+                extent[axis] = n[axis] >> std::min( level, levels[axis] );
+            for( int axis = 0; axis < 3; ++axis )
+                if( level < levels[axis] )
+                    stepAxis( result, axis, extent[axis], extent[0], extent[1], extent[2], true );
+        }
+    } else {
+        //full 1D DWT along each axis in turn.
+        for( int axis = 0; axis < 3; ++axis )
+            for( int level = 0; level < levels[axis]; ++level )
+                stepAxis( result, axis, n[axis] >> level, n[0], n[1], n[2], true );
+    }
+
+    return result;
+}
+
+spectral::array WaveletEngine::backtrans(const spectral::array &coefficients,
+                                         spectral::index nI, spectral::index nJ, spectral::index nK,
+                                         bool interleaved, int nLevels) const
+{
+    spectral::array grid( coefficients );
+    spectral::index n[3] = { grid.M(), grid.N(), grid.K() };
+
+    if( m_wavelet ){
+        int levels[3] = { levelsOfAxis( n[0], nLevels ), levelsOfAxis( n[1], nLevels ), levelsOfAxis( n[2], nLevels ) };
+        //the steps of transform() in reverse order.
+        if( interleaved ){
+            int maxLevels = std::max( { levels[0], levels[1], levels[2] } );
+            for( int level = maxLevels - 1; level >= 0; --level ){
+                spectral::index extent[3];
+                for( int axis = 0; axis < 3; ++axis )
+                    extent[axis] = n[axis] >> std::min( level, levels[axis] );
+                for( int axis = 2; axis >= 0; --axis )
+                    if( level < levels[axis] )
+                        stepAxis( grid, axis, extent[axis], extent[0], extent[1], extent[2], false );
+            }
+        } else {
+            for( int axis = 2; axis >= 0; --axis )
+                for( int level = levels[axis] - 1; level >= 0; --level )
+                    stepAxis( grid, axis, n[axis] >> level, n[0], n[1], n[2], false );
+        }
+    }
+
+    //crop the padding off
+    spectral::array result( nI, nJ, nK );
+    for( spectral::index i = 0; i < nI; ++i )
+        for( spectral::index j = 0; j < nJ; ++j )
+            for( spectral::index k = 0; k < nK; ++k )
+                result( i, j, k ) = grid( i, j, k );
+    return result;
+}
+
+spectral::array WaveletEngine::denoise(const spectral::array &input, double threshold, bool soft,
+                                       bool interleaved, int nLevels) const
+{
+    spectral::array coefficients = transform( input, interleaved, nLevels );
+    spectral::index n[3] = { coefficients.M(), coefficients.N(), coefficients.K() };
+
+    //the approximation coefficients are in the corner sub-grid left by the last level of each axis.
+    spectral::index nApprox[3];
+    for( int axis = 0; axis < 3; ++axis )
+        nApprox[axis] = m_wavelet ? n[axis] >> levelsOfAxis( n[axis], nLevels ) : n[axis];
+
+    for( spectral::index i = 0; i < n[0]; ++i )
+        for( spectral::index j = 0; j < n[1]; ++j )
+            for( spectral::index k = 0; k < n[2]; ++k ){
+                if( i < nApprox[0] && j < nApprox[1] && k < nApprox[2] )
+                    continue;
+                double& value = coefficients( i, j, k );
+                if( std::abs( value ) < threshold )
+                    value = 0.0;
+                else if( soft )
+                    value -= std::copysign( threshold, value );
+            }
+
+    return backtrans( coefficients, input.M(), input.N(), input.K(), interleaved, nLevels );
+}
+
+spectral::array WaveletEngine::mirrorPad(const spectral::array &input,
+                                         spectral::index nI, spectral::index nJ, spectral::index nK)
+{
+    //a padded cell at n + p takes the value at n - 1 - p, the same as itk::MirrorPadImageFilter.
+    //paddings longer than the input are reflected back and forth (the reflections have a period of 2n).
+    auto reflect = []( spectral::index p, spectral::index n ){
+        if( n < 2 )
+            return spectral::index( 0 );
+        spectral::index q = p % ( 2 * n );
+        return q < n ? q : 2 * n - 1 - q;
+    };
+    spectral::array result( nI, nJ, nK );
+    for( spectral::index i = 0; i < nI; ++i ){
+        spectral::index iSrc = reflect( i, input.M() );
+        for( spectral::index j = 0; j < nJ; ++j ){
+            spectral::index jSrc = reflect( j, input.N() );
+            for( spectral::index k = 0; k < nK; ++k )
+                result( i, j, k ) = input( iSrc, jSrc, reflect( k, input.K() ) );
+        }
+    }
+    return result;
+}
+
+spectral::index WaveletEngine::paddedSize(spectral::index n)
+{
+    spectral::index nPowerOf2 = 1;
+    while( nPowerOf2 < n )
+        nPowerOf2 <<= 1;
+    return nPowerOf2;
+}
+
+void WaveletEngine::stepAxis(spectral::array &grid, int axis, spectral::index n,
+                             spectral::index extentI, spectral::index extentJ, spectral::index extentK,
+                             bool forward) const
+{
+    //the strides of the axes in the spectral::array storage ( d_[(i*N+j)*K+k] ).
+    spectral::index strides[3] = { grid.N() * grid.K(), grid.K(), 1 };
+    spectral::index extents[3] = { extentI, extentJ, extentK };
+
+    //the lines are enumerated over the other two axes.
+    int axisA = ( axis + 1 ) % 3;
+    int axisB = ( axis + 2 ) % 3;
+    spectral::index nLines = extents[axisA] * extents[axisB];
+    spectral::index stride = strides[axis];
+    double* data = grid.data().data();
+
+    std::atomic<spectral::index> nextLine( 0 );
+    auto worker = [&](){
+        std::vector<double> line( n );
+        std::vector<double> scratch( n );
+        while( true ){
+            spectral::index iLine = nextLine++;
+            if( iLine >= nLines )
+                break;
+            spectral::index a = iLine / extents[axisB];
+            spectral::index b = iLine % extents[axisB];
+            double* start = data + a * strides[axisA] + b * strides[axisB];
+            //the line is transformed in a contiguous buffer, since the strides of the I and J axes
+            //are usually large.
+            for( spectral::index i = 0; i < n; ++i )
+                line[i] = start[ i * stride ];
+            stepLine( line.data(), n, forward, scratch.data() );
+            for( spectral::index i = 0; i < n; ++i )
+                start[ i * stride ] = line[i];
+        }
+    };
+
+    unsigned int nThreads = m_nThreads;
+    if( nLines * n < MIN_VALUES_FOR_MULTITHREADING )
+        nThreads = 1;
+    nThreads = std::min<spectral::index>( nThreads, nLines );
+
+    std::vector< std::thread > threads;
+    for( unsigned int iThread = 1; iThread < nThreads; ++iThread )
+        threads.emplace_back( worker );
+    worker();
+    for( std::thread& thread : threads )
+        thread.join();
+}
+
+void WaveletEngine::stepLine(double *line, spectral::index n, bool forward, double *scratch) const
+{
+    //this is the same as GSL's dwt_step() (periodic boundaries), which is not part of its public API.
+    const size_t nc = m_wavelet->nc;
+    const size_t n1 = n - 1;
+    const size_t nh = n >> 1;
+    const size_t nmod = nc * n - m_wavelet->offset;
+
+    std::fill( scratch, scratch + n, 0.0 );
+
+    if( forward ){
+        for( size_t ii = 0, i = 0; i < (size_t)n; i += 2, ++ii ){
+            double h = 0.0;
+            double g = 0.0;
+            size_t ni = i + nmod;
+            for( size_t k = 0; k < nc; ++k ){
+                size_t jf = n1 & ( ni + k );
+                h += m_wavelet->h1[k] * line[jf];
+                g += m_wavelet->g1[k] * line[jf];
+            }
+            scratch[ii] += h;
+            scratch[ii + nh] += g;
+        }
+    } else {
+        for( size_t ii = 0, i = 0; i < (size_t)n; i += 2, ++ii ){
+            double ai = line[ii];
+            double ai1 = line[ii + nh];
+            size_t ni = i + nmod;
+            for( size_t k = 0; k < nc; ++k ){
+                size_t jf = n1 & ( ni + k );
+                scratch[jf] += m_wavelet->h2[k] * ai + m_wavelet->g2[k] * ai1;
+            }
+        }
+    }
+
+    std::copy( scratch, scratch + n, line );
+}
+
+int WaveletEngine::levelsOfAxis(spectral::index n, int nLevels)
+{
+    //the DWT steps halve the length down to 2 (lengths of 1 are not transformed).
+    int maxLevels = 0;
+    for( spectral::index length = n; length >= 2; length >>= 1 )
+        ++maxLevels;
+    if( nLevels < 0 )
+        return maxLevels;
+    return std::min( nLevels, maxLevels );
+}
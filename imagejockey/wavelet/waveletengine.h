@@ -0,0 +1,91 @@
+#ifndef WAVELETENGINE_H
+#define WAVELETENGINE_H
+
+#include "imagejockey/wavelet/waveletutils.h"
+#include "spectral/spectral.h"
+
+/**
+ * The WaveletEngine class performs multi-level separable Discrete Wavelet Transforms on 1D, 2D or 3D grids
+ * of any extents.  Unlike WaveletUtils::transform(), the grid is not squared and there is no round trip
+ * through ITK images: each axis is mirror-padded to its own power-of-2 size, so a 300x200x50 grid is
+ * transformed as a 512x256x64 grid instead of a 512x512 square one.
+ * The 1D DWT steps use the same filter coefficients and periodic boundaries as GSL's, thus the results are
+ * identical to those of gsl_wavelet_transform() and gsl_wavelet2d_(ns)transform() for power-of-2 grids.
+ * The rows, columns and traces of each step are transformed in parallel.
+ */
+class WaveletEngine
+{
+public:
+    /**
+     * @param waveletFamily The wavelet family (see WaveletFamily enum for valid wavelet families).
+     * @param waveletType The wavelet type of the selected family (see WaveletTransformDialog::onWaveletFamilySelected()
+     *                    for valid type values ).
+     * @param centered If true, the wavelet is centered.
+     * @param nThreads Number of threads to use.  If zero, the number of logical CPUs is used.
+     */
+    WaveletEngine( WaveletFamily waveletFamily, int waveletType, bool centered, unsigned int nThreads = 0 );
+    ~WaveletEngine();
+
+    /** Returns false if the wavelet family/type combination is invalid. */
+    bool isValid() const { return m_wavelet != nullptr; }
+
+    /**
+     * Performs the forward DWT of the given grid.
+     * @param interleaved If true, one DWT step is performed on each axis alternately per level (non-standard
+     *                    transform), otherwise the full 1D DWT is performed on each axis in turn (standard transform).
+     * @param nLevels Number of decomposition levels.  If negative, the grid is fully decomposed.
+     * @return The DWT coefficients in a grid with the padded dimensions (see paddedSize()).
+     */
+    spectral::array transform( const spectral::array& input, bool interleaved, int nLevels = -1 ) const;
+
+    /**
+     * Performs the inverse DWT of coefficients computed with transform().  The parameters must be the same ones
+     * used in the forward transform.
+     * @param nI, nJ, nK Dimensions of the original grid, used to crop the padding off.
+     */
+    spectral::array backtrans( const spectral::array& coefficients,
+                               spectral::index nI, spectral::index nJ, spectral::index nK,
+                               bool interleaved, int nLevels = -1 ) const;
+
+    /**
+     * Denoises a grid by shrinking its detail DWT coefficients (all but the approximation ones).
+     * @param threshold Coefficients with absolute values below this are zeroed out.
+     * @param soft If true, the remaining coefficients are shrunk towards zero by the threshold (soft thresholding),
+     *             otherwise they are kept as is (hard thresholding).
+     */
+    spectral::array denoise( const spectral::array& input, double threshold, bool soft,
+                             bool interleaved, int nLevels = -1 ) const;
+
+    /**
+     * Returns a copy of the input grid enlarged to the given dimensions (which must not be smaller than the
+     * input's) by mirror-padding.  The input is placed at the origin.  transform() pads each axis to paddedSize(),
+     * but grids padded further (e.g. to a square) can also be passed to it, since their dimensions are powers of 2.
+     */
+    static spectral::array mirrorPad( const spectral::array& input,
+                                      spectral::index nI, spectral::index nJ, spectral::index nK );
+
+    /** Returns the smallest power of 2 that is greater than or equal to n. */
+    static spectral::index paddedSize( spectral::index n );
+
+private:
+    WaveletEngine( const WaveletEngine& ) = delete;
+    WaveletEngine& operator=( const WaveletEngine& ) = delete;
+
+    /** Performs one DWT step on the first n elements of every line along the given axis (0, 1 or 2) in
+     *  the sub-grid [0,extentI)x[0,extentJ)x[0,extentK). */
+    void stepAxis( spectral::array& grid, int axis, spectral::index n,
+                   spectral::index extentI, spectral::index extentJ, spectral::index extentK,
+                   bool forward ) const;
+
+    /** Performs one DWT step on a contiguous line of n elements (n must be a power of 2).
+     * @param scratch A working array of at least n elements. */
+    void stepLine( double* line, spectral::index n, bool forward, double* scratch ) const;
+
+    /** Returns the number of levels effectively performed along an axis of the given (padded) length. */
+    static int levelsOfAxis( spectral::index n, int nLevels );
+
+    gsl_wavelet* m_wavelet;
+    unsigned int m_nThreads;
+};
+
+#endif // WAVELETENGINE_H
@@ -10,6 +10,7 @@ VTK_MODULE_INIT(vtkRenderingFreeType)
 
 #include "wavelettransformdialog.h"
 #include "ui_wavelettransformdialog.h"
+#include "waveletengine.h"
 
 #include "spectral/spectral.h"
 #include "imagejockey/svd/svdfactor.h"
@@ -19,6 +20,7 @@ VTK_MODULE_INIT(vtkRenderingFreeType)
 
 #include <QMessageBox>
 #include <QVTKOpenGLWidget.h>
+#include <algorithm>
 #include <vtkRenderer.h>
 #include <vtkGenericOpenGLRenderWindow.h>
 #include <vtkAxesActor.h>
@@ -146,18 +148,36 @@ WaveletFamily WaveletTransformDialog::getSelectedWaveletFamily()
     return waveletFamily;
 }
 
+spectral::array WaveletTransformDialog::makePaddedInput()
+{
+    //load the input data as an array
+    m_inputGrid->dataWillBeRequested();
+    spectral::arrayPtr inputAsArray( m_inputGrid->createSpectralArray( m_inputVariableIndex ) );
+
+    //3D grids are padded per axis by WaveletEngine::transform() itself.
+    if( inputAsArray->K() > 1 )
+        return *inputAsArray;
+
+    //2D grids are mirror padded to a square with power-of-2 dimensions, which is the layout
+    //expected by the scalogram display.
+    spectral::index nPowerOf2 = std::max( WaveletEngine::paddedSize( inputAsArray->M() ),
+                                          WaveletEngine::paddedSize( inputAsArray->N() ) );
+    return WaveletEngine::mirrorPad( *inputAsArray, nPowerOf2, nPowerOf2, 1 );
+}
+
 void WaveletTransformDialog::onPerformTransform()
 {
     int waveletType = ui->cmbWaveletType->itemData( ui->cmbWaveletType->currentIndex() ).toInt();
     bool interleaved = ( ui->cmbMethod->currentIndex() == 0 );
     bool centered = ui->chkWaveletCentered->isChecked();
 
-    m_DWTbuffer = WaveletUtils::transform( m_inputGrid,
-                                           m_inputVariableIndex,
-                                           getSelectedWaveletFamily(),
-                                           waveletType,
-                                           centered,
-                                           interleaved );
+    WaveletEngine waveletEngine( getSelectedWaveletFamily(), waveletType, centered );
+    if( ! waveletEngine.isValid() ){
+        QMessageBox::critical( this, "Error", "Invalid wavelet family/type combination.");
+        return;
+    }
+
+    m_DWTbuffer = waveletEngine.transform( makePaddedInput(), interleaved );
     debugGrid( m_DWTbuffer );
 
     // set the color scale form fields to suitable initial values
@@ -170,8 +190,8 @@ void WaveletTransformDialog::onPerformTransform()
     ui->txtThresholdMin2->setText( "0.0" );
     ui->txtThresholdMax2->setText( QString::number( m_DWTbuffer.max() ) );
 
-    // determine the number of levels (assumes the DWT transform is square).
-    int numberOfLevels = std::log2( m_DWTbuffer.M() );
+    // determine the number of levels (that of the longest axis).
+    int numberOfLevels = std::log2( std::max( { m_DWTbuffer.M(), m_DWTbuffer.N(), m_DWTbuffer.K() } ) );
 
     // reconfigure the level spin boxes accoring to the number of levels.
     ui->spinLevelMin->setMinimum( 0 );
@@ -220,30 +240,47 @@ void WaveletTransformDialog::onSaveDWTResultAsGrid()
 {
     int nI = m_DWTbuffer.M();
     int nJ = m_DWTbuffer.N();
-    spectral::array scaleField( nI, nJ, 1, 0.0 );
-    spectral::array orientationField( nI, nJ, 1, 0.0 );
-    for( int j = 0; j < nJ; ++j)
-        for( int i = 0; i < nI; ++i){
-            if( i == 0 && j == 0 ){ //the value at i=0;j=0 is the smooth factor (global mean)
-                scaleField      ( i, j, 0 ) = -1.0;
-                orientationField( i, j, 0 ) = -1.0;
-            } else {
-                //set the level value
-                double intpart;
-                std::modf ( std::log2( i ), &intpart );
-                int levelI = static_cast<int>( intpart );
-                std::modf ( std::log2( j ), &intpart );
-                int levelJ = static_cast<int>( intpart );
-                scaleField( i, j, 0 ) = std::max( levelI, levelJ );
-                //set the orientation field (vertical, diagonals, horizontal)
-                int orientation = 1;
-                if( levelI == levelJ )
-                    orientation = 2;
-                if( levelI > levelJ )
-                    orientation = 3;
-                orientationField( i, j, 0 ) = orientation;
+    int nK = m_DWTbuffer.K();
+    spectral::array scaleField( nI, nJ, nK, 0.0 );
+    spectral::array orientationField( nI, nJ, nK, 0.0 );
+    //the level of a coefficient index along an axis is the integer part of its log2 (-1 for the index 0).
+    auto levelOfIndex = []( int index ){
+        int level = -1;
+        for( ; index > 0; index >>= 1 )
+            ++level;
+        return level;
+    };
+    for( int k = 0; k < nK; ++k)
+        for( int j = 0; j < nJ; ++j)
+            for( int i = 0; i < nI; ++i){
+                if( i == 0 && j == 0 && k == 0 ){ //the value at i=0;j=0;k=0 is the smooth factor (global mean)
+                    scaleField      ( i, j, k ) = -1.0;
+                    orientationField( i, j, k ) = -1.0;
+                } else {
+                    //set the level value
+                    int levelI = levelOfIndex( i );
+                    int levelJ = levelOfIndex( j );
+                    int levelK = levelOfIndex( k );
+                    int level = std::max( { levelI, levelJ, levelK } );
+                    scaleField( i, j, k ) = level;
+                    int orientation;
+                    if( nK == 1 ){
+                        //set the orientation field (vertical, diagonals, horizontal)
+                        orientation = 1;
+                        if( levelI == levelJ )
+                            orientation = 2;
+                        if( levelI > levelJ )
+                            orientation = 3;
+                    } else {
+                        //in 3D, the orientation is the sum of 1 (I), 2 (J) and 4 (K) for the axes
+                        //at the coefficient's level
+                        orientation = ( levelI == level ? 1 : 0 ) +
+                                      ( levelJ == level ? 2 : 0 ) +
+                                      ( levelK == level ? 4 : 0 );
+                    }
+                    orientationField( i, j, k ) = orientation;
+                }
             }
-        }
 
     if( m_DWTbuffer.size() > 0 && ! ui->txtCoeffVariableName->text().trimmed().isEmpty() )
         emit saveDWTTransform( ui->txtCoeffVariableName->text(), m_DWTbuffer, scaleField, orientationField );
@@ -263,28 +300,34 @@ void WaveletTransformDialog::onReadDWTResultFromGrid()
         //read the requested data
         int nI = pointerToRequestedGrid->getNI();
         int nJ = pointerToRequestedGrid->getNJ();
+        int nK = pointerToRequestedGrid->getNK();
         for( int i = 0; i < nI; ++i )
             for( int j = 0; j < nJ; ++j )
-                m_DWTbuffer( i, j, 0 ) = pointerToRequestedGrid->getData( 0, i, j, 0 );
+                for( int k = 0; k < nK; ++k )
+                    m_DWTbuffer( i, j, k ) = pointerToRequestedGrid->getData( 0, i, j, k );
         //update the 3D viewer
         updateDisplay();
     }else
         QMessageBox::critical( this, "Error", "No array to receive the data or grid name not given.");
 }
 
-void WaveletTransformDialog::onPreviewBacktransformedResult()
+spectral::array WaveletTransformDialog::backtransDWTbuffer()
 {
     int waveletType = ui->cmbWaveletType->itemData( ui->cmbWaveletType->currentIndex() ).toInt();
     bool interleaved = ( ui->cmbMethod->currentIndex() == 0 );
     bool centered = ui->chkWaveletCentered->isChecked();
 
-    spectral::array backtrans = WaveletUtils::backtrans( m_inputGrid,
-                                                         m_DWTbuffer,
-                                                         getSelectedWaveletFamily(),
-                                                         waveletType,
-                                                         centered,
-                                                         interleaved );
-    debugGrid( backtrans );
+    WaveletEngine waveletEngine( getSelectedWaveletFamily(), waveletType, centered );
+    return waveletEngine.backtrans( m_DWTbuffer,
+                                    m_inputGrid->getNI(),
+                                    m_inputGrid->getNJ(),
+                                    m_inputGrid->getNK(),
+                                    interleaved );
+}
+
+void WaveletTransformDialog::onPreviewBacktransformedResult()
+{
+    debugGrid( backtransDWTbuffer() );
 }
 
 void WaveletTransformDialog::updateDisplay()
@@ -305,22 +348,10 @@ void WaveletTransformDialog::updateDisplay()
     /////-----------------code to render the input grid (aid in interpretation) -------------------
     vtkSmartPointer<vtkActor> gridActor = vtkSmartPointer<vtkActor>::New();
     {
-        //load the input data as an array
-        m_inputGrid->dataWillBeRequested();
-        spectral::arrayPtr inputAsArray( m_inputGrid->createSpectralArray( m_inputVariableIndex ) );
-
-        //convert the array into an ITK image object
-        GaborUtils::ImageTypePtr inputAsITK = GaborUtils::convertSpectralArrayToITKImage( *inputAsArray );
+        //load the input data mirror padded the same way it is for the transform
+        spectral::array inputMirrorPaddedAsArray = makePaddedInput();
 
-        //mirror pad the image to the needed dimension (power of 2)
-        int nPowerOf2;
-        GaborUtils::ImageTypePtr inputMirrorPadded = WaveletUtils::squareAndMirrorPad( inputAsITK, nPowerOf2 );
-
-        //convert the padded square image to array object.
-        spectral::array inputMirrorPaddedAsArray =
-                GaborUtils::convertITKImageToSpectralArray( *inputMirrorPadded );
-
-        //convert the padded square image array into VTK grid.
+        //convert the padded image array into VTK grid.
         vtkSmartPointer<vtkImageData> out = vtkSmartPointer<vtkImageData>::New();
         ImageJockeyUtils::makeVTKImageDataFromSpectralArray( out, inputMirrorPaddedAsArray );
 
@@ -368,7 +399,9 @@ void WaveletTransformDialog::updateDisplay()
     /////--------------------code to render the scalogram cubes-----------------------
     vtkSmartPointer<vtkActor> scalogramActor = vtkSmartPointer<vtkActor>::New();
     vtkSmartPointer<vtkScalarBarActor> scalarBarActor = vtkSmartPointer<vtkScalarBarActor>::New();
-    {
+    //the scalograms are only rendered for 2D transforms (which are square, see makePaddedInput()).
+    bool renderScalograms = m_DWTbuffer.size() > 0 && m_DWTbuffer.K() == 1 && m_DWTbuffer.M() == m_DWTbuffer.N();
+    if( renderScalograms ){
         //  GSL's wavelet transform outputs the data of the 3D scalogram reusing the original
         //  2D grid like this (example is 16 x 16 cells):
         //  |----------------|----------------|
@@ -598,10 +631,12 @@ void WaveletTransformDialog::updateDisplay()
 
 
     //Update the graphics system.
-    _renderer->AddActor( scalogramActor );
-    _currentActors.push_back( scalogramActor );
-    _renderer->AddActor2D( scalarBarActor );
-    _scaleBarActor = scalarBarActor;
+    if( renderScalograms ){
+        _renderer->AddActor( scalogramActor );
+        _currentActors.push_back( scalogramActor );
+        _renderer->AddActor2D( scalarBarActor );
+        _scaleBarActor = scalarBarActor;
+    }
     _renderer->AddActor( gridActor );
     _currentActors.push_back( gridActor );
     _renderer->ResetCamera();
@@ -638,16 +673,7 @@ void WaveletTransformDialog::onUpdateWaveletDisplays()
 
 void WaveletTransformDialog::onSaveBacktransformedResult()
 {
-    int waveletType = ui->cmbWaveletType->itemData( ui->cmbWaveletType->currentIndex() ).toInt();
-    bool interleaved = ( ui->cmbMethod->currentIndex() == 0 );
-    bool centered = ui->chkWaveletCentered->isChecked();
-
-    spectral::array backtrans = WaveletUtils::backtrans( m_inputGrid,
-                                                         m_DWTbuffer,
-                                                         getSelectedWaveletFamily(),
-                                                         waveletType,
-                                                         centered,
-                                                         interleaved );
+    spectral::array backtrans = backtransDWTbuffer();
 
     QString proposed_name = m_inputGrid->getVariableByIndex( m_inputVariableIndex )->getVariableName();
     proposed_name += "_filtered";
@@ -664,6 +690,48 @@ void WaveletTransformDialog::onSaveBacktransformedResult()
     m_inputGrid->saveData();
 }
 
+void WaveletTransformDialog::onDenoise()
+{
+    int waveletType = ui->cmbWaveletType->itemData( ui->cmbWaveletType->currentIndex() ).toInt();
+    bool interleaved = ( ui->cmbMethod->currentIndex() == 0 );
+    bool centered = ui->chkWaveletCentered->isChecked();
+
+    bool ok;
+    double threshold = ui->txtDenoiseThreshold->text().toDouble( &ok );
+    if( ! ok || threshold < 0.0 ){
+        QMessageBox::critical( this, "Error", "The denoising threshold must be a non-negative number.");
+        return;
+    }
+
+    WaveletEngine waveletEngine( getSelectedWaveletFamily(), waveletType, centered );
+    if( ! waveletEngine.isValid() ){
+        QMessageBox::critical( this, "Error", "Invalid wavelet family/type combination.");
+        return;
+    }
+
+    //load the input data as an array (the engine pads each axis as needed)
+    m_inputGrid->dataWillBeRequested();
+    spectral::arrayPtr inputAsArray( m_inputGrid->createSpectralArray( m_inputVariableIndex ) );
+
+    spectral::array denoised = waveletEngine.denoise( *inputAsArray,
+                                                      threshold,
+                                                      ui->chkDenoiseSoft->isChecked(),
+                                                      interleaved );
+
+    QString proposed_name = m_inputGrid->getVariableByIndex( m_inputVariableIndex )->getVariableName();
+    proposed_name += "_denoised";
+
+    //open file rename dialog
+    QString new_name = QInputDialog::getText(this, "Name the variable",
+                                             "New variable with denoised results:", QLineEdit::Normal,
+                                             proposed_name, &ok);
+    if( ! ok )
+        return;
+
+    m_inputGrid->appendAsNewVariable( new_name , denoised );
+    m_inputGrid->saveData();
+}
+
 void WaveletTransformDialog::debugGrid(const spectral::array &grid)
 {
     spectral::array result ( grid );
@@ -43,7 +43,8 @@ Q_SIGNALS:
      * Signal emitted when the user wants to save a grid with the DWT result.
      * @param DWTtransform The coefficients.
      * @param scaleField The scale values (0 through log2(grid_size)).
-     * @param orientationField The orientation values (1=N-S, 2=diagonals, 3=E-W).
+     * @param orientationField The orientation values (1=N-S, 2=diagonals, 3=E-W).  For 3D grids, it is the sum
+     *                         of 1 (I), 2 (J) and 4 (K) for the axes at the scale of the coefficient.
      */
     void saveDWTTransform( const QString name,
                            const spectral::array& DWTtransform,
@@ -62,6 +63,10 @@ private:
     uint m_inputVariableIndex;
     spectral::array m_DWTbuffer;
     WaveletFamily getSelectedWaveletFamily();
+    /** Returns the input variable mirror padded for the transform (2D grids are squared for the scalogram display). */
+    spectral::array makePaddedInput();
+    /** Returns the inverse DWT of the current coefficients, cropped to the input grid dimensions. */
+    spectral::array backtransDWTbuffer();
     static void debugGrid( const spectral::array &grid );
 
     ////////-----members used for 3D display-------------------
@@ -98,6 +103,7 @@ private Q_SLOTS:
     void updateDisplay();
     void onUpdateWaveletDisplays();
     void onSaveBacktransformedResult();
+    void onDenoise();
 };
 
 #endif // WAVELETTRANSFORMDIALOG_H
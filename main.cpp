@@ -1,6 +1,9 @@
 #include <QApplication>
+#include <QStandardPaths>
+#include <QDir>
 
 #include "mainwindow.h"
+#include "spectral/fftservice.h"
 
 int main(int argc, char *argv[])
 {
@@ -8,8 +11,20 @@ int main(int argc, char *argv[])
     QApplication::setOrganizationName(APP_NAME);
     QApplication::setOrganizationDomain("geostats.gammaray.com");
     QApplication::setApplicationName(APP_NAME_VER);
+
+    //FFTW planning knowledge (wisdom) persists between sessions, so FFTs of previously seen grid sizes
+    //are planned instantly.
+    QString appDataDir = QStandardPaths::writableLocation( QStandardPaths::AppDataLocation );
+    QDir().mkpath( appDataDir );
+    std::string fftwWisdomPath = QDir( appDataDir ).filePath( "fftw.wisdom" ).toStdString();
+    spectral::FFTService::instance().loadWisdom( fftwWisdomPath );
+
     MainWindow w;
     w.show();
 
-    return a.exec();
+    int exitCode = a.exec();
+
+    spectral::FFTService::instance().saveWisdom( fftwWisdomPath );
+
+    return exitCode;
 }
@@ -92,6 +92,7 @@
 #include "imagejockey/svd/svdfactorsel/svdfactorsselectiondialog.h"
 #include "imagejockey/svd/svdfactortree.h"
 #include "imagejockey/svd/svdanalysisdialog.h"
+#include "imagejockey/svd/svdparametersdialog.h"
 #include "calculator/calculatordialog.h"
 #include "imagejockey/widgets/ijgridviewerwidget.h"
 #include "imagejockey/vardecomp/variographicdecompositiondialog.h"
@@ -235,6 +236,16 @@ void MainWindow::log_message(const QString message, const QString style)
     //ui->txtedMessages->append( "\n" );
 }
 
+void MainWindow::onLogMessageFromThread(const QString message, const QString style, bool showMessageBox)
+{
+    if( style == "information" )
+        Application::instance()->logInfo( message, showMessageBox );
+    else if( style == "warning" )
+        Application::instance()->logWarn( message, showMessageBox );
+    else
+        Application::instance()->logError( message, showMessageBox );
+}
+
 void MainWindow::dragEnterEvent(QDragEnterEvent *e)
 {
     if (e->mimeData()->hasUrls()) {
@@ -1560,51 +1571,45 @@ void MainWindow::onFilterBy()
     //make the path for the file.
     QString new_file_path = Application::instance()->getProject()->getPath() + "/" + new_file_name;
 
-    //Make a new data set from the filtered data.
-    if( ps->getFileType() == "POINTSET" ) {
-        PointSet* filteredPS = ps->createPointSetByFiltering( _right_clicked_attribute->getAttributeGEOEASgivenIndex()-1, filtMin, filtMax );
-
-        filteredPS->setPath( ps->getPath() );
-        filteredPS->updateChildObjectsCollection();
-        filteredPS->setPath( new_file_path );
-
-        //the necessary steps to register the new object as a project member.
-        {
-            //save data to file system
-            filteredPS->writeToFS();
-            //save its metadata file
-            filteredPS->updateMetaDataFile();
-            //causes an update to the child objects in the project tree
-            filteredPS->setInfoFromMetadataFile();
-            //attach the object to the project tree
-            Application::instance()->getProject()->addDataFile( filteredPS );
-            //show the newly created object in main window's project tree
-            Application::instance()->refreshProjectTree();
-        }
-    } else if( ps->getFileType() == "SEGMENTSET" ){
-        SegmentSet* ss = dynamic_cast<SegmentSet*>( ps );
-
-        SegmentSet* filteredSS = ss->createSegmentSetByFiltering( _right_clicked_attribute->getAttributeGEOEASgivenIndex()-1, filtMin, filtMax );
+    if( ps->getFileType() != "POINTSET" && ps->getFileType() != "SEGMENTSET" ){
+        Application::instance()->logError( "MainWindow::onFilterBy(): data set type not supported: " + ps->getFileType() );
+        return;
+    }
 
-        filteredSS->setPath( ps->getPath() );
-        filteredSS->updateChildObjectsCollection();
-        filteredSS->setPath( new_file_path );
+    //write the filtered data directly to the new file (the data table is not copied)
+    if( ! ps->writeFilteredToFS( new_file_path,
+                                 ps->getDataLinesFilteredBy( _right_clicked_attribute->getAttributeGEOEASgivenIndex()-1,
+                                                             filtMin, filtMax ) ) ){
+        Application::instance()->logError( "MainWindow::onFilterBy(): could not write the filtered data to " + new_file_path + "." );
+        return;
+    }
 
-        //the necessary steps to register the new object as a project member.
-        {
-            //save data to file system
-            filteredSS->writeToFS();
-            //save its metadata file
-            filteredSS->updateMetaDataFile();
-            //causes an update to the child objects in the project tree
-            filteredSS->setInfoFromMetadataFile();
-            //attach the object to the project tree
-            Application::instance()->getProject()->addDataFile( filteredSS );
-            //show the newly created object in main window's project tree
-            Application::instance()->refreshProjectTree();
-        }
+    //Make a new data set from the filtered data file.
+    DataFile* filteredDF;
+    if( ps->getFileType() == "POINTSET" ) {
+        PointSet* filteredPS = new PointSet( new_file_path );
+        filteredPS->setInfoFromOtherPointSet( ps );
+        //save its metadata file
+        filteredPS->updateMetaDataFile();
+        //causes an update to the child objects in the project tree
+        filteredPS->setInfoFromMetadataFile();
+        filteredDF = filteredPS;
     } else {
-        Application::instance()->logError( "MainWindow::onFilterBy(): data set type not supported: " + ps->getFileType() );
+        SegmentSet* filteredSS = new SegmentSet( new_file_path );
+        filteredSS->setInfoFromAnotherSegmentSet( dynamic_cast<SegmentSet*>( ps ) );
+        //save its metadata file
+        filteredSS->updateMetaDataFile();
+        //causes an update to the child objects in the project tree
+        filteredSS->setInfoFromMetadataFile();
+        filteredDF = filteredSS;
+    }
+
+    //the necessary steps to register the new object as a project member.
+    {
+        //attach the object to the project tree
+        Application::instance()->getProject()->addDataFile( filteredDF );
+        //show the newly created object in main window's project tree
+        Application::instance()->refreshProjectTree();
     }
 
 }
@@ -1663,8 +1668,11 @@ void MainWindow::onFFT()
     //the parent file is surely a CartesianGrid.
     CartesianGrid *cg = (CartesianGrid*)_right_clicked_attribute->getContainingFile();
 
-    //get the array containing the data
-    std::vector< std::complex<double> > array = cg->getArray( _right_clicked_attribute->getAttributeGEOEASgivenIndex()-1 );
+    //get the real values of the variable
+    std::vector<double> values = cg->getDataColumn( _right_clicked_attribute->getAttributeGEOEASgivenIndex()-1 );
+
+    //the array that will contain the FFT image
+    std::vector< std::complex<double> > array;
 
     {
         QProgressDialog progressDialog;
@@ -1677,8 +1685,8 @@ void MainWindow::onFFT()
         Util::fft3D( cg->getNX(),
                      cg->getNY(),
                      cg->getNZ(),
+                     values,
                      array,
-                     FFTComputationMode::DIRECT,
                      FFTImageType::POLAR_FORM );
     }
 
@@ -2055,6 +2063,16 @@ void MainWindow::onSVD()
         return;
     }
 
+    //User enters the number of leading SVD factors to compute (computing all of them is too
+    //costly for large grids)
+    long numberOfFactorsToCompute;
+    {
+        SVDParametersDialog svdpd( this );
+        if( svdpd.exec() != QDialog::Accepted )
+            return;
+        numberOfFactorsToCompute = svdpd.getNumberOfFactors();
+    }
+
     //Get the data
     long selectedAttributeIndex = _right_clicked_attribute->getAttributeGEOEASgivenIndex()-1;
     spectral::array* a = cg->createSpectralArray( selectedAttributeIndex );
@@ -2073,11 +2091,11 @@ void MainWindow::onSVD()
     progressDialog.setLabelText("Computing SVD factors...");
     progressDialog.show();
     QCoreApplication::processEvents();
-    spectral::SVD svd = spectral::svd( *a );
+    spectral::SVD svd = spectral::svd_truncated( *a, numberOfFactorsToCompute );
     progressDialog.hide();
 
     //get the list with the factor weights (information quantity)
-    spectral::array weights = svd.factor_weights();
+    spectral::array weights = svd.factor_energy_fractions();
     Application::instance()->logInfo("MainWindow::onSVD(): " + QString::number( weights.data().size() ) + " factor(s) were found.");
 
     //User enters number of SVD factors
@@ -2476,11 +2494,6 @@ void MainWindow::onWavelet()
         return;
     }
 
-    if( cg->getNK() > 1 ){
-        QMessageBox::critical( this, "Error", QString("3D grids are impractical."));
-        return;
-    }
-
     //get the index of the selected variable in the grid
     int varIndex = cg->getVariableIndexByName( _right_clicked_attribute->getName() );
     if( varIndex < 0 ){
@@ -2519,13 +2532,15 @@ void MainWindow::onSaveDWTTransform(const QString name,
     cg->addEmptyDataColumn( "orientation", DWTtransform.size() );
 
     int nI = DWTtransform.M();
-    for( int j = 0; j < DWTtransform.N(); ++j )
-        for( int i = 0; i < nI; ++i ){
-            int index = j * nI + i;
-            cg->setData( index, 0, DWTtransform( i, j, 0 ) );
-            cg->setData( index, 1, scaleField( i, j, 0 ) );
-            cg->setData( index, 2, orientationField( i, j, 0 ) );
-        }
+    int nJ = DWTtransform.N();
+    for( int k = 0; k < DWTtransform.K(); ++k )
+        for( int j = 0; j < nJ; ++j )
+            for( int i = 0; i < nI; ++i ){
+                int index = k * nJ * nI + j * nI + i;
+                cg->setData( index, 0, DWTtransform( i, j, k ) );
+                cg->setData( index, 1, scaleField( i, j, k ) );
+                cg->setData( index, 2, orientationField( i, j, k ) );
+            }
 
     //save the data as a GEO-EAS grid file
     cg->writeToFS();
@@ -2776,6 +2791,40 @@ void MainWindow::onTransferProperty()
         return;
 
     ValuesTransferer vt( new_attribute_name, _right_clicked_data_file, _right_clicked_attribute );
+
+    //grid destinations can be upscaled (averages of the overlapped source cells)
+    if( _right_clicked_data_file->getFileType() == "CARTESIANGRID" ||
+        _right_clicked_data_file->getFileType() == "GEOGRID" ){
+        QStringList methods;
+        methods << "Collocated (nearest)" << "Arithmetic mean" << "Harmonic mean" << "Geometric mean"
+                << "Power mean" << "Mode (categorical)";
+        QString method = QInputDialog::getItem(this, "Transfer method",
+                                               "Method (averages are weighted by the volumes of cell overlaps):",
+                                               methods, 0, false, &ok);
+        if( ! ok )
+            return;
+        if( method == "Arithmetic mean" )
+            vt.setUpscaling( RegriddingEngine::Average::ARITHMETIC );
+        else if( method == "Harmonic mean" )
+            vt.setUpscaling( RegriddingEngine::Average::HARMONIC );
+        else if( method == "Geometric mean" )
+            vt.setUpscaling( RegriddingEngine::Average::GEOMETRIC );
+        else if( method == "Mode (categorical)" )
+            vt.setUpscaling( RegriddingEngine::Average::MODE );
+        else if( method == "Power mean" ){
+            double power = QInputDialog::getDouble(this, "Power mean",
+                                                   "Enter the exponent (must not be zero):",
+                                                   0.5, -10.0, 10.0, 3, &ok);
+            if( ! ok )
+                return;
+            if( Util::almostEqual2sComplement( power, 0.0, 1 ) ){
+                QMessageBox::critical( this, "Error", "The exponent of the power mean must not be zero.");
+                return;
+            }
+            vt.setUpscaling( RegriddingEngine::Average::POWER, power );
+        }
+    }
+
     ok = vt.transfer();
 
     if( ! ok )
@@ -121,6 +121,8 @@ private:
     DataFile* _right_clicked_data_file;
 
 private slots:
+    /** Logs a message sent from another thread (see Application::logInfo()). */
+    void onLogMessageFromThread( const QString message, const QString style, bool showMessageBox );
     void onProjectContextMenu(const QPoint &mouse_location);
     void onProjectHeaderContextMenu(const QPoint &mouse_location);
     void onAddDataFile();
@@ -474,6 +474,32 @@ QList<uint> SpatialIndex::getNearestFromCartesianGrid(const GridCell &gridCell,
                                                       uint nCellsJDirection,
                                                       uint nCellsKDirection,
                                                       const std::vector<double> *simulatedData) const
+{
+    //collects valued n-neighbors ordered by their topological distance with respect
+    //to the target cell
+    NeighborList vCells;
+    getNearestFromCartesianGrid( gridCell, searchStrategy, hasNDV, NDVvalue,
+                                 nCellsIDirection, nCellsJDirection, nCellsKDirection,
+                                 vCells, simulatedData );
+
+    //collect the data row indexes of the valued samples found.
+    QList<uint> result;
+    result.reserve( vCells.size() );
+    for( const Neighbor& vCell : vCells )
+        result.push_back( vCell._index );
+
+    return result;
+}
+
+void SpatialIndex::getNearestFromCartesianGrid(const GridCell &gridCell,
+                                               const SearchStrategy &searchStrategy,
+                                               bool hasNDV,
+                                               double NDVvalue,
+                                               uint nCellsIDirection,
+                                               uint nCellsJDirection,
+                                               uint nCellsKDirection,
+                                               NeighborList &result,
+                                               const std::vector<double> *simulatedData) const
 {
     assert( m_dataFile && "SpatialIndex::getNearestFromCartesianGrid(): No data file.  "
                           "Make sure you have made a call to fill() prior to making queries.");
@@ -482,42 +508,23 @@ QList<uint> SpatialIndex::getNearestFromCartesianGrid(const GridCell &gridCell,
                                                              "the data index of gridCell is -1, but no "
                                                              "separate computed data was provided (simulatedData == nullptr).");
 
-    //get the desired number of samples.
-    uint n = searchStrategy.m_nb_samples;
-
-    //prepare the result container.
-    QList<uint> result;
-    result.reserve( n );
-
     //for this search mode, the data set must be a Cartesian grid
     CartesianGrid* cg = dynamic_cast< CartesianGrid* >( m_dataFile );
     if( cg ){
-
-        //collects valued n-neighbors ordered by their topological distance with respect
-        //to the target cell
-        GridCellPtrMultiset vCells;
-
         //collects the data samples (depend on the search neighborhood)
         GeostatsUtils::getValuedNeighborsTopoOrdered( gridCell,
-                                                               n,
-                                                               nCellsIDirection,
-                                                               nCellsJDirection,
-                                                               nCellsKDirection,
-                                                               hasNDV,
-                                                               NDVvalue,
-                                                               vCells,
-                                                               simulatedData );
-
-        //collect the data row indexes of the valued samples found.
-        for( const GridCellPtr& vCell : vCells ){
-            assert( vCell->_dataIndex >= 0 && "SpatialIndex::getNearestFromCartesianGrid(): tried to return invalid data index." );
-            result.push_back( vCell->_dataIndex );
-        }
-
-    } else
+                                                      searchStrategy.m_nb_samples,
+                                                      nCellsIDirection,
+                                                      nCellsJDirection,
+                                                      nCellsKDirection,
+                                                      hasNDV,
+                                                      NDVvalue,
+                                                      result,
+                                                      simulatedData );
+    } else {
+        result.clear();
         assert( false && "SpatialIndex::getNearestFromCartesianGrid(): Searched data set is not a Cartesian grid.");
-
-    return result;
+    }
 }
 
 void SpatialIndex::clear()
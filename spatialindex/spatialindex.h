@@ -5,6 +5,7 @@
 #include <vector>
 #include <boost/geometry.hpp>
 #include <boost/geometry/index/rtree.hpp>
+#include "geostats/neighbor.h"
 
 class PointSet;
 class CartesianGrid;
@@ -120,6 +121,22 @@ public:
                                             const std::vector<double> *simulatedData = nullptr
                                             ) const;
 
+    /**
+     * Does the same as the other getNearestFromCartesianGrid(), but fills a list of neighbors (cleared first) instead
+     * of returning the data line indexes, so a client can reuse the same list for many queries and use the neighbors'
+     * values and coordinates without reading them again.  The neighbors are ordered by topological distance.
+     */
+    void getNearestFromCartesianGrid(const GridCell &gridCell,
+                                     const SearchStrategy & searchStrategy,
+                                     bool hasNDV,
+                                     double NDVvalue,
+                                     uint nCellsIDirection,
+                                     uint nCellsJDirection,
+                                     uint nCellsKDirection,
+                                     NeighborList& result,
+                                     const std::vector<double> *simulatedData = nullptr
+                                     ) const;
+
     /** Clears the spatial index. */
 	void clear();
 
@@ -0,0 +1,185 @@
+/*
+Spectral primitives - FFT service
+
+With contributions by Paulo R. M. Carvalho (paulo.r.m.carvalho@gmail.com)
+*/
+
+#include "fftservice.h"
+#include <thread>
+#include <tuple>
+#include <algorithm>
+
+namespace spectral
+{
+
+/** Maximum number of plans kept in the cache.  Plans of large grids hold sizeable twiddle factor tables. */
+static const size_t MAX_CACHED_PLANS = 64;
+
+/** Grids with at least this number of elements are transformed with multiple threads. */
+static const index MIN_SIZE_FOR_MULTITHREADING = 1 << 18;
+
+/** Grids with at most this number of elements are planned with FFTW_MEASURE, which finds faster plans but takes
+ *  longer to plan.  Larger grids are planned with FFTW_ESTIMATE, unless there is wisdom for them. */
+static const index MAX_SIZE_FOR_MEASURED_PLANS = 1 << 20;
+
+bool FFTService::PlanKey::operator<(const FFTService::PlanKey &other) const
+{
+    return std::tie( kind, ndim, M, N, K, aligned ) <
+           std::tie( other.kind, other.ndim, other.M, other.N, other.K, other.aligned );
+}
+
+FFTService &FFTService::instance()
+{
+    //thread-safe initialization since C++11
+    static FFTService service;
+    return service;
+}
+
+FFTService::FFTService() :
+    m_maxThreads( 0 )
+{
+    fftw_init_threads();
+}
+
+FFTService::~FFTService()
+{
+    clear();
+    fftw_cleanup_threads();
+}
+
+void FFTService::r2c(double *in, fftw_complex *out, int ndim, index M, index N, index K)
+{
+    bool aligned = fftw_alignment_of( in ) == 0 && fftw_alignment_of( (double*)out ) == 0;
+    PlanPtr plan = getPlan( { FFTKind::REAL_TO_COMPLEX, ndim, M, N, K, aligned } );
+    //the new-array execute functions are thread-safe.
+    fftw_execute_dft_r2c( plan.get(), in, out );
+}
+
+void FFTService::c2r(fftw_complex *in, double *out, int ndim, index M, index N, index K)
+{
+    bool aligned = fftw_alignment_of( (double*)in ) == 0 && fftw_alignment_of( out ) == 0;
+    PlanPtr plan = getPlan( { FFTKind::COMPLEX_TO_REAL, ndim, M, N, K, aligned } );
+    fftw_execute_dft_c2r( plan.get(), in, out );
+}
+
+void FFTService::c2c(fftw_complex *in, fftw_complex *out, int sign, int ndim, index M, index N, index K)
+{
+    bool aligned = fftw_alignment_of( (double*)in ) == 0 && fftw_alignment_of( (double*)out ) == 0;
+    FFTKind kind = ( sign == FFTW_FORWARD ) ? FFTKind::COMPLEX_FORWARD : FFTKind::COMPLEX_BACKWARD;
+    PlanPtr plan = getPlan( { kind, ndim, M, N, K, aligned } );
+    fftw_execute_dft( plan.get(), in, out );
+}
+
+bool FFTService::loadWisdom(const std::string &path)
+{
+    std::unique_lock<std::recursive_mutex> lock( m_mutexPlanner );
+    return fftw_import_wisdom_from_filename( path.c_str() ) != 0;
+}
+
+bool FFTService::saveWisdom(const std::string &path)
+{
+    std::unique_lock<std::recursive_mutex> lock( m_mutexPlanner );
+    return fftw_export_wisdom_to_filename( path.c_str() ) != 0;
+}
+
+void FFTService::setMaxThreads(unsigned int nThreads)
+{
+    std::unique_lock<std::recursive_mutex> lock( m_mutexPlanner );
+    m_maxThreads = nThreads;
+}
+
+void FFTService::clear()
+{
+    std::unique_lock<std::recursive_mutex> lock( m_mutexPlanner );
+    //plans still being executed by other threads are destroyed when they finish (see getPlan()).
+    m_plans.clear();
+    m_plansOrder.clear();
+}
+
+FFTService::PlanPtr FFTService::getPlan(const FFTService::PlanKey &key)
+{
+    std::unique_lock<std::recursive_mutex> lock( m_mutexPlanner );
+
+    std::map< PlanKey, PlanPtr >::iterator it = m_plans.find( key );
+    if( it != m_plans.end() )
+        return it->second;
+
+    //the plan is destroyed when it leaves the cache and no thread is executing it anymore.
+    //destroying a plan is not thread-safe either, hence the locking.
+    PlanPtr plan( makePlan( key ), [this]( fftw_plan p ){
+        std::unique_lock<std::recursive_mutex> lock( m_mutexPlanner );
+        fftw_destroy_plan( p );
+    });
+
+    //evict the oldest plan if the cache is full.
+    if( m_plansOrder.size() >= MAX_CACHED_PLANS ){
+        m_plans.erase( m_plansOrder.front() );
+        m_plansOrder.pop_front();
+    }
+    m_plans[ key ] = plan;
+    m_plansOrder.push_back( key );
+    return plan;
+}
+
+fftw_plan FFTService::makePlan(const FFTService::PlanKey &key)
+{
+    index size = key.M * key.N * key.K;
+
+    //the complex array of r2c/c2r transforms holds only the non-redundant half of the spectrum.
+    index complexSize = size;
+    if( key.kind == FFTKind::REAL_TO_COMPLEX || key.kind == FFTKind::COMPLEX_TO_REAL ){
+        if( key.ndim == 1 )
+            complexSize = key.M / 2 + 1;
+        else if( key.ndim == 2 )
+            complexSize = key.M * ( key.N / 2 + 1 );
+        else
+            complexSize = key.M * key.N * ( key.K / 2 + 1 );
+    }
+
+    //set FFTW multithreading for large grids.
+    unsigned int nThreads = 1;
+    if( size >= MIN_SIZE_FOR_MULTITHREADING ){
+        nThreads = m_maxThreads ? m_maxThreads : std::max( 1u, std::thread::hardware_concurrency() );
+    }
+    fftw_plan_with_nthreads( nThreads );
+
+    unsigned flags = ( size <= MAX_SIZE_FOR_MEASURED_PLANS ) ? FFTW_MEASURE : FFTW_ESTIMATE;
+    if( ! key.aligned )
+        flags |= FFTW_UNALIGNED;
+
+    //FFTW_MEASURE overwrites the arrays while planning, so the plans are made with scratch arrays.
+    //The plans are later executed with the actual arrays via the new-array execute functions.
+    double* realScratch = nullptr;
+    fftw_complex* complexScratchIn = nullptr;
+    fftw_complex* complexScratchOut = nullptr;
+    int n[] = { (int)key.M, (int)key.N, (int)key.K };
+    fftw_plan plan = nullptr;
+    switch( key.kind ){
+    case FFTKind::REAL_TO_COMPLEX:
+        realScratch = (double*)fftw_malloc( sizeof(double) * size );
+        complexScratchOut = (fftw_complex*)fftw_malloc( sizeof(fftw_complex) * complexSize );
+        plan = fftw_plan_dft_r2c( key.ndim, n, realScratch, complexScratchOut, flags );
+        break;
+    case FFTKind::COMPLEX_TO_REAL:
+        complexScratchIn = (fftw_complex*)fftw_malloc( sizeof(fftw_complex) * complexSize );
+        realScratch = (double*)fftw_malloc( sizeof(double) * size );
+        plan = fftw_plan_dft_c2r( key.ndim, n, complexScratchIn, realScratch, flags );
+        break;
+    case FFTKind::COMPLEX_FORWARD:
+    case FFTKind::COMPLEX_BACKWARD:
+        complexScratchIn = (fftw_complex*)fftw_malloc( sizeof(fftw_complex) * size );
+        complexScratchOut = (fftw_complex*)fftw_malloc( sizeof(fftw_complex) * size );
+        plan = fftw_plan_dft( key.ndim, n, complexScratchIn, complexScratchOut,
+                              key.kind == FFTKind::COMPLEX_FORWARD ? FFTW_FORWARD : FFTW_BACKWARD, flags );
+        break;
+    }
+    if( realScratch )
+        fftw_free( realScratch );
+    if( complexScratchIn )
+        fftw_free( complexScratchIn );
+    if( complexScratchOut )
+        fftw_free( complexScratchOut );
+    return plan;
+}
+
+} // namespace spectral
@@ -0,0 +1,112 @@
+/*
+Spectral primitives - FFT service
+
+With contributions by Paulo R. M. Carvalho (paulo.r.m.carvalho@gmail.com)
+*/
+
+#pragma once
+
+#include <fftw3.h>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+
+namespace spectral
+{
+
+using index = long long;
+
+/** The kinds of transform served by FFTService. */
+enum class FFTKind : int {
+    REAL_TO_COMPLEX,    /*! Forward transform of real data (Hermitian half of the spectrum is output). */
+    COMPLEX_TO_REAL,    /*! Backward transform to real data (input is destroyed). */
+    COMPLEX_FORWARD,    /*! Forward transform of complex data. */
+    COMPLEX_BACKWARD    /*! Backward transform of complex data. */
+};
+
+/**
+ * The FFTService is the central point to run FFTW transforms.  It caches the FFTW plans by transform kind and grid
+ * shape so repeated transforms of grids with the same dimensions (varmaps, convolutions, Gabor scans, etc.) do not
+ * pay the planning cost every time.  Planning is the only part of FFTW that is not thread-safe, so it is serialized
+ * internally: the transforms themselves can be run concurrently from any number of threads without locking.
+ * Large grids are transformed with FFTW's own multithreading.  Plans are found with FFTW_MEASURE for grids of
+ * moderate size, and the knowledge accumulated by FFTW (wisdom) can be saved to and loaded from a file so it
+ * carries over to the next sessions.
+ * All transforms are out-of-place (input and output arrays must not overlap) and unnormalized, just like the FFTW
+ * routines.
+ */
+class FFTService
+{
+public:
+
+    /** Returns the single FFTService object. */
+    static FFTService& instance();
+
+    ~FFTService();
+
+    /** Real-to-complex forward transform of an M x N x K grid (N and/or K equal to 1 for 1D/2D grids).
+     *  The output has M x N x (K/2+1) elements (M/2+1 for 1D, M x (N/2+1) for 2D).
+     *  @param ndim Number of dimensions of the grid (1, 2 or 3). */
+    void r2c( double *in, fftw_complex *out, int ndim, index M, index N = 1, index K = 1 );
+
+    /** Complex-to-real backward transform to an M x N x K grid (see r2c() for the input layout).
+     *  @note The input array is destroyed, as with FFTW's c2r transforms. */
+    void c2r( fftw_complex *in, double *out, int ndim, index M, index N = 1, index K = 1 );
+
+    /** Complex-to-complex transform of an M x N x K grid.
+     *  @param sign FFTW_FORWARD or FFTW_BACKWARD. */
+    void c2c( fftw_complex *in, fftw_complex *out, int sign, int ndim, index M, index N = 1, index K = 1 );
+
+    /** Loads FFTW wisdom previously saved with saveWisdom().  Returns false if the file could not be read. */
+    bool loadWisdom( const std::string& path );
+
+    /** Saves the FFTW wisdom accumulated so far, so plans are found faster in the next sessions.
+     *  Returns false if the file could not be written. */
+    bool saveWisdom( const std::string& path );
+
+    /** Sets the maximum number of threads used by FFTW to transform large grids.
+     *  Zero (default) means the number of logical CPUs.  Only plans made afterwards are affected. */
+    void setMaxThreads( unsigned int nThreads );
+
+    /** Destroys all the cached plans. */
+    void clear();
+
+private:
+
+    FFTService();
+    FFTService( const FFTService& ) = delete;
+    FFTService& operator=( const FFTService& ) = delete;
+
+    /** The attributes that make a plan reusable. */
+    struct PlanKey {
+        FFTKind kind;
+        int ndim;
+        index M, N, K;
+        bool aligned; //whether both arrays are SIMD-aligned (as those allocated with fftw_malloc())
+        bool operator<( const PlanKey& other ) const;
+    };
+
+    typedef std::shared_ptr< fftw_plan_s > PlanPtr;
+
+    /** Returns a plan for the given key, making it if it is not in the cache. */
+    PlanPtr getPlan( const PlanKey& key );
+
+    /** Makes a new plan.  Must be called with m_mutexPlanner locked. */
+    fftw_plan makePlan( const PlanKey& key );
+
+    /** Serializes all calls to the FFTW planner (it is recursive because the plan deleter locks it and
+     *  may run during cache eviction). */
+    std::recursive_mutex m_mutexPlanner;
+
+    /** The cached plans. */
+    std::map< PlanKey, PlanPtr > m_plans;
+
+    /** The keys of the cached plans in insertion order (used to evict the oldest plans). */
+    std::deque< PlanKey > m_plansOrder;
+
+    unsigned int m_maxThreads;
+};
+
+} // namespace spectral
@@ -7,6 +7,7 @@ With contributions by Paulo R. M. Carvalho (paulo.r.m.carvalho@gmail.com)
 */
 
 #include "spectral.h"
+#include "fftservice.h"
 #include <cmath>
 #include <Eigen/Dense>
 #include <complex>
@@ -370,14 +371,6 @@ array &array::operator+=(const array &other)
     return *this;
 }
 
-array array::operator*(double scalar) const
-{
-    array result( M_, N_, K_ );
-	for (size_t i = 0; i < d_.size(); ++i)
-        result.d_[i] = d_[i] * scalar;
-    return result;
-}
-
 array array::operator*(const array &other) const
 {
     Eigen::MatrixXd tmpMe = to_2d( *this );
@@ -385,36 +378,13 @@ array array::operator*(const array &other) const
     return to_array( tmpMe * tmpOther );
 }
 
-array array::operator/(double scalar) const
-{
-	array result( M_, N_, K_ );
-	for (size_t i = 0; i < d_.size(); ++i)
-		result.d_[i] = d_[i] / scalar;
-	return result;
-}
-
-array array::operator-(double scalar) const
-{
-	array result( M_, N_, K_ );
-	for (size_t i = 0; i < d_.size(); ++i)
-		result.d_[i] = d_[i] - scalar;
-	return result;
-}
-
-array array::operator-(const array &other) const
-{
-    array result( M_, N_, K_ );
-	for (size_t i = 0; i < d_.size(); ++i)
-        result.d_[i] = d_[i] - other.d_[i];
-    return result;
-}
-
-array array::operator+(const array &other) const
+array::array(const_array_view v)
+    : d_(v.size()), ndim_(3), M_(v.M()), N_(v.N()), K_(v.K())
 {
-    array result( M_, N_, K_ );
-    for (size_t i = 0; i < d_.size(); ++i)
-        result.d_[i] = d_[i] + other.d_[i];
-    return result;
+    for (index i = 0; i < M_; ++i)
+        for (index j = 0; j < N_; ++j)
+            for (index k = 0; k < K_; ++k)
+                d_[(i * N_ + j) * K_ + k] = v(i, j, k);
 }
 
 array array::getVectorColumn(index j) const
@@ -427,52 +397,6 @@ array array::getVectorColumn(index j) const
 
 array::~array() {}
 
-double &array::operator()(index i, index j, index k)
-{
-
-    if (i < 0)
-        i = (i + M_) % M_;
-    if (j < 0)
-        j = (j + N_) % N_;
-    if (k < 0)
-        k = (k + K_) % K_;
-
-    return d_[(i * N_ + j) * K_ + k];
-}
-
-double &array::operator()(index i, index j)
-{
-
-    if (i < 0)
-        i = (i + M_) % M_;
-    if (j < 0)
-        j = (j + N_) % N_;
-
-    return d_[i * N_ + j];
-}
-
-double &array::operator()(index i)
-{
-
-    if (i < 0)
-        i = (i + M_) % M_;
-
-    return d_[i];
-}
-
-const double &array::operator()(index i, index j, index k) const
-{
-
-    if (i < 0)
-        i = (i + M_) % M_;
-    if (j < 0)
-        j = (j + N_) % N_;
-    if (k < 0)
-        k = (k + K_) % K_;
-
-    return d_.at((i * N_ + j) * K_ + k);
-}
-
 void array::set_size(index M, index N, index K)
 {
     ndim_ = 3;
@@ -515,22 +439,6 @@ double array::avg() const
     return std::accumulate( d_.begin(), d_.end(), 0.0) / d_.size();
 }
 
-array array::sqrt() const
-{
-    array result( M_, N_, K_ );
-    for (size_t i = 0; i < d_.size(); ++i)
-        result.d_[i] = std::sqrt( d_[i] );
-    return result;
-}
-
-array array::sqr() const
-{
-    array result( M_, N_, K_ );
-    for (size_t i = 0; i < d_.size(); ++i)
-        result.d_[i] = d_[i] * d_[i];
-    return result;
-}
-
 double array::euclideanLength() const
 {
     return std::sqrt( spectral::dot( *this, *this ) );
@@ -572,19 +480,12 @@ void array::updateMax(const array &other)
             d_[i] = other.d_[i];
 }
 
-const double &array::operator()(index i, index j) const { return d_.at(i * N_ + j); }
-
-const double &array::operator()(index i) const { return d_.at(i); }
-
 void foward(complex_array &out, double *in, index M)
 {
     index out_fft_size = M / 2 + 1;
     fftw_array_raw out_fft
         = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * out_fft_size);
-    fftw_plan p_fft;
-    p_fft = fftw_plan_dft_r2c_1d(M, in, out_fft, FFTW_ESTIMATE_PATIENT);
-    fftw_execute(p_fft);
-    fftw_destroy_plan(p_fft);
+    FFTService::instance().r2c(in, out_fft, 1, M);
     out.set_data(out_fft, M / 2 + 1);
 }
 
@@ -593,10 +494,7 @@ void foward(complex_array &out, double *in, index M, index N)
     index out_fft_size = (N / 2 + 1) * M;
     fftw_array_raw out_fft
         = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * out_fft_size);
-    fftw_plan p_fft;
-    p_fft = fftw_plan_dft_r2c_2d(M, N, in, out_fft, FFTW_ESTIMATE_PATIENT);
-    fftw_execute(p_fft);
-    fftw_destroy_plan(p_fft);
+    FFTService::instance().r2c(in, out_fft, 2, M, N);
     out.set_data(out_fft, M, N / 2 + 1);
 }
 
@@ -615,10 +513,7 @@ void foward(complex_array &out, double *in, index M, index N, index K)
     index out_fft_size = (K / 2 + 1) * N * M;
     fftw_array_raw out_fft
         = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * out_fft_size);
-    fftw_plan p_fft;
-    p_fft = fftw_plan_dft_r2c_3d(M, N, K, in, out_fft, FFTW_ESTIMATE_PATIENT);
-    fftw_execute(p_fft);
-    fftw_destroy_plan(p_fft);
+    FFTService::instance().r2c(in, out_fft, 3, M, N, K);
     out.set_data(out_fft, M, N, K / 2 + 1);
 }
 
@@ -639,26 +534,17 @@ void foward(complex_array &out, array &in)
 
 void backward(std::vector<double> &out, complex_array &in, index M)
 {
-    fftw_plan p_fft;
-    p_fft = fftw_plan_dft_c2r_1d(M, in.data(), out.data(), FFTW_ESTIMATE_PATIENT);
-    fftw_execute(p_fft);
-    fftw_destroy_plan(p_fft);
+    FFTService::instance().c2r(in.data(), out.data(), 1, M);
 }
 
 void backward(std::vector<double> &out, complex_array &in, index M, index N)
 {
-    fftw_plan p_fft;
-    p_fft = fftw_plan_dft_c2r_2d(M, N, in.data(), out.data(), FFTW_ESTIMATE_PATIENT);
-    fftw_execute(p_fft);
-    fftw_destroy_plan(p_fft);
+    FFTService::instance().c2r(in.data(), out.data(), 2, M, N);
 }
 
 void backward(std::vector<double> &out, complex_array &in, index M, index N, index K)
 {
-    fftw_plan p_fft;
-    p_fft = fftw_plan_dft_c2r_3d(M, N, K, in.data(), out.data(), FFTW_ESTIMATE_PATIENT);
-    fftw_execute(p_fft);
-    fftw_destroy_plan(p_fft);
+    FFTService::instance().c2r(in.data(), out.data(), 3, M, N, K);
 }
 
 void backward(array &out, complex_array &in)
@@ -1412,31 +1298,22 @@ void normalize(array &in, double K)
 
 void foward(complex_array &out, complex_array &in, index M)
 {
-    fftw_plan p;
     fftw_complex *fout = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * M);
-    p = fftw_plan_dft_1d(M, in.data(), fout, FFTW_FORWARD, FFTW_ESTIMATE);
-    fftw_execute(p);
-    fftw_destroy_plan(p);
+    FFTService::instance().c2c(in.data(), fout, FFTW_FORWARD, 1, M);
     out.set_data(fout, M);
 }
 
 void foward(complex_array &out, complex_array &in, index M, index N)
 {
-    fftw_plan p;
     fftw_complex *fout = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * M * N);
-    p = fftw_plan_dft_2d(M, N, in.data(), fout, FFTW_FORWARD, FFTW_ESTIMATE);
-    fftw_execute(p);
-    fftw_destroy_plan(p);
+    FFTService::instance().c2c(in.data(), fout, FFTW_FORWARD, 2, M, N);
     out.set_data(fout, M, N);
 }
 
 void foward(complex_array &out, complex_array &in, index M, index N, index K)
 {
-    fftw_plan p;
     fftw_complex *fout = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * M * N * K);
-    p = fftw_plan_dft_3d(M, N, K, in.data(), fout, FFTW_FORWARD, FFTW_ESTIMATE);
-    fftw_execute(p);
-    fftw_destroy_plan(p);
+    FFTService::instance().c2c(in.data(), fout, FFTW_FORWARD, 3, M, N, K);
     out.set_data(fout, M, N, K);
 }
 
@@ -1462,31 +1339,22 @@ void backward(complex_array &out, complex_array &in)
 
 void backward(complex_array &out, complex_array &in, index M, index N, index K)
 {
-    fftw_plan p;
     fftw_complex *fout = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * M * N * K);
-    p = fftw_plan_dft_3d(M, N, K, in.data(), fout, FFTW_BACKWARD, FFTW_ESTIMATE);
-    fftw_execute(p);
-    fftw_destroy_plan(p);
+    FFTService::instance().c2c(in.data(), fout, FFTW_BACKWARD, 3, M, N, K);
     out.set_data(fout, M, N, K);
 }
 
 void backward(complex_array &out, complex_array &in, index M, index N)
 {
-    fftw_plan p;
     fftw_complex *fout = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * M * N);
-    p = fftw_plan_dft_2d(M, N, in.data(), fout, FFTW_BACKWARD, FFTW_ESTIMATE);
-    fftw_execute(p);
-    fftw_destroy_plan(p);
+    FFTService::instance().c2c(in.data(), fout, FFTW_BACKWARD, 2, M, N);
     out.set_data(fout, M, N);
 }
 
 void backward(complex_array &out, complex_array &in, index M)
 {
-    fftw_plan p;
     fftw_complex *fout = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * M);
-    p = fftw_plan_dft_1d(M, in.data(), fout, FFTW_BACKWARD, FFTW_ESTIMATE);
-    fftw_execute(p);
-    fftw_destroy_plan(p);
+    FFTService::instance().c2c(in.data(), fout, FFTW_BACKWARD, 1, M);
     out.set_data(fout, M);
 }
 
@@ -1691,13 +1559,6 @@ double sumOfAbsDifference(const array &one, const array &other)
     return result;
 }
 
-array operator-(double theValue, const array & theArray){
-	array result( theArray.M(), theArray.N(), theArray.K() );
-	for( int i = 0; i < theArray.size(); ++i )
-		result.d_[i] = theValue - theArray.d_[i];
-	return result;
-}
-
 void standardize(array &in)
 {
 	double min = in.min();
@@ -1725,14 +1586,6 @@ double angle(const array & one, const array & other)
 	return std::acos( argument );
 }
 
-array hadamard(const array &one, const array &other)
-{
-    array result( one.M(), one.N(), one.K() );
-    for( int i = 0; i < one.size(); ++i )
-        result.d_[i] = one.d_[i] * other.d_[i];
-    return result;
-}
-
 array joinColumnVectors(const std::vector<const array *> &columnVectors)
 {
     // Convert the spectral::array's to Eigen matrices.
@@ -1827,14 +1680,6 @@ complex_array to_rectangular_form(const complex_array & in)
 	return out;
 }
 
-array operator*(double theValue, const array & theArray)
-{
-	array result( theArray.M(), theArray.N(), theArray.K() );
-	for( int i = 0; i < theArray.size(); ++i )
-		result.d_[i] = theValue * theArray.d_[i];
-    return result;
-}
-
 array get_extrema_cells( const array &in,
                          ExtremumType extremaType,
                          int halfWindowSize,
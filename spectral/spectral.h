@@ -17,6 +17,10 @@ With contributions by Paulo R. M. Carvalho (paulo.r.m.carvalho@gmail.com)
 #include <omp.h>
 #include <vector>
 #include <memory>
+#include <cassert>
+#include <limits>
+#include <type_traits>
+#include <algorithm>
 
 namespace spectral
 {
@@ -94,6 +98,168 @@ struct complex_array {
 	fftw_array_raw d_ = nullptr;
 };
 
+//================================ element-wise array expressions ================================
+// The element-wise arithmetic of spectral::array (+ and - between arrays, +, -, * and / with scalars, sqr(), sqrt()
+// and hadamard()) returns lightweight expression objects instead of new arrays.  A chain of such operations is
+// evaluated in a single loop, without temporary arrays, when it is assigned to an array or passed to a function
+// taking an array.  For example, c = hadamard( a - b, a - b ) / 2.0; runs one loop and allocates nothing but c.
+// NOTE: expression objects refer to their operands, so they must not be kept beyond the statement that creates
+//       them (do not write auto e = a - b;).
+// NOTE: array * array is the matrix product, use hadamard() for the element-wise product.
+
+struct array;
+template<typename Op, typename E> struct unary_expr;
+
+/** The functors of the element-wise operations. */
+namespace expr_op {
+struct plus   { static double apply( double a, double b ) { return a + b; } };
+struct minus  { static double apply( double a, double b ) { return a - b; } };
+struct times  { static double apply( double a, double b ) { return a * b; } };
+struct divide { static double apply( double a, double b ) { return a / b; } };
+struct square      { static double apply( double a ) { return a * a; } };
+struct square_root { static double apply( double a ) { return std::sqrt( a ); } };
+}
+
+/** Base of the element-wise array expressions (CRTP).  The expression types E implement operator[](index),
+ * size(), M(), N() and K(). */
+template<typename E>
+struct array_expr {
+    const E& self() const { return static_cast<const E&>( *this ); }
+    unary_expr< expr_op::square, E > sqr() const { return unary_expr< expr_op::square, E >( self() ); }
+    unary_expr< expr_op::square_root, E > sqrt() const { return unary_expr< expr_op::square_root, E >( self() ); }
+};
+
+/** An array as an operand of an expression. */
+struct array_ref : array_expr<array_ref> {
+    explicit array_ref( const array &a ) : a_( &a ) {}
+    inline double operator[]( index i ) const;
+    inline index size() const;
+    inline index M() const;
+    inline index N() const;
+    inline index K() const;
+    const array *a_;
+};
+
+/** An element-wise operation between two expressions.  The result has the dimensions of the left operand. */
+template<typename Op, typename L, typename R>
+struct binary_expr : array_expr< binary_expr<Op, L, R> > {
+    binary_expr( const L &l, const R &r ) : l_( l ), r_( r ) {}
+    double operator[]( index i ) const { return Op::apply( l_[i], r_[i] ); }
+    index size() const { return l_.size(); }
+    index M() const { return l_.M(); }
+    index N() const { return l_.N(); }
+    index K() const { return l_.K(); }
+    L l_;
+    R r_;
+};
+
+/** An element-wise operation between an expression and a scalar (or between a scalar and an expression,
+ * if scalarFirst is true). */
+template<typename Op, typename E, bool scalarFirst>
+struct scalar_expr : array_expr< scalar_expr<Op, E, scalarFirst> > {
+    scalar_expr( const E &e, double scalar ) : e_( e ), scalar_( scalar ) {}
+    double operator[]( index i ) const {
+        return scalarFirst ? Op::apply( scalar_, e_[i] ) : Op::apply( e_[i], scalar_ );
+    }
+    index size() const { return e_.size(); }
+    index M() const { return e_.M(); }
+    index N() const { return e_.N(); }
+    index K() const { return e_.K(); }
+    E e_;
+    double scalar_;
+};
+
+/** An element-wise function of an expression. */
+template<typename Op, typename E>
+struct unary_expr : array_expr< unary_expr<Op, E> > {
+    explicit unary_expr( const E &e ) : e_( e ) {}
+    double operator[]( index i ) const { return Op::apply( e_[i] ); }
+    index size() const { return e_.size(); }
+    index M() const { return e_.M(); }
+    index N() const { return e_.N(); }
+    index K() const { return e_.K(); }
+    E e_;
+};
+
+/** Whether T is an array or an array expression. */
+template<typename T>
+struct is_array_operand : std::integral_constant< bool, std::is_same<T, array>::value ||
+                                                        std::is_base_of<array_expr<T>, T>::value > {};
+
+/** The expression type of an operand (arrays are wrapped in array_ref). */
+template<typename T>
+struct expr_of {
+    typedef T type;
+    static const T &get( const T &e ) { return e; }
+};
+template<>
+struct expr_of<array> {
+    typedef array_ref type;
+    static array_ref get( const array &a ) { return array_ref( a ); }
+};
+
+//================================ strided array views ================================
+
+/**
+ * A non-owning view of the values of an array, or of part of them, such as a plane or a sub-grid taken every n
+ * cells (strided slice).  Element access is not checked, except with assert() in debug builds, and, unlike with
+ * spectral::array, negative indexes are not wrapped around.  Changing the values of an array_view changes the
+ * values of the viewed array.  Views must not outlive the viewed array or be used after it is resized.
+ */
+template<typename T>
+struct basic_array_view {
+    basic_array_view( T *d, index M, index N, index K, index strideM, index strideN, index strideK ) :
+        d_( d ), M_( M ), N_( N ), K_( K ), strideM_( strideM ), strideN_( strideN ), strideK_( strideK ) {}
+
+    /** Allows array_view to const_array_view conversions. */
+    template<typename U>
+    basic_array_view( const basic_array_view<U> &other ) :
+        d_( other.d_ ), M_( other.M_ ), N_( other.N_ ), K_( other.K_ ),
+        strideM_( other.strideM_ ), strideN_( other.strideN_ ), strideK_( other.strideK_ ) {}
+
+    T &operator()( index i, index j, index k ) const {
+        assert( i >= 0 && i < M_ && j >= 0 && j < N_ && k >= 0 && k < K_ && "spectral::array_view: index out of bounds." );
+        return d_[ i * strideM_ + j * strideN_ + k * strideK_ ];
+    }
+
+    index M() const { return M_; }
+    index N() const { return N_; }
+    index K() const { return K_; }
+    index size() const { return M_ * N_ * K_; }
+
+    /** Returns the view of nI x nJ x nK cells starting at (i0, j0, k0) and taken every stepI, stepJ and stepK
+     * cells in each direction. */
+    basic_array_view slice( index i0, index nI, index j0, index nJ, index k0, index nK,
+                            index stepI = 1, index stepJ = 1, index stepK = 1 ) const {
+        assert( nI >= 0 && nJ >= 0 && nK >= 0 && stepI > 0 && stepJ > 0 && stepK > 0 &&
+                "spectral::array_view: invalid slice." );
+        assert( ( nI == 0 || ( i0 >= 0 && i0 + ( nI - 1 ) * stepI < M_ ) ) &&
+                ( nJ == 0 || ( j0 >= 0 && j0 + ( nJ - 1 ) * stepJ < N_ ) ) &&
+                ( nK == 0 || ( k0 >= 0 && k0 + ( nK - 1 ) * stepK < K_ ) ) &&
+                "spectral::array_view: slice out of bounds." );
+        return basic_array_view( d_ + i0 * strideM_ + j0 * strideN_ + k0 * strideK_, nI, nJ, nK,
+                                 strideM_ * stepI, strideN_ * stepJ, strideK_ * stepK );
+    }
+
+    /** Returns the plane (a 1 x N x K view) at the given i.  planeJ() and planeK() are analogous. */
+    basic_array_view planeI( index i ) const { return slice( i, 1, 0, N_, 0, K_ ); }
+    basic_array_view planeJ( index j ) const { return slice( 0, M_, j, 1, 0, K_ ); }
+    basic_array_view planeK( index k ) const { return slice( 0, M_, 0, N_, k, 1 ); }
+
+    /** Returns whether the view elements are contiguous in memory (in that case, data() can be used as a
+     * plain buffer of size() elements). */
+    bool contiguous() const { return strideK_ == 1 && strideN_ == K_ && strideM_ == N_ * K_; }
+
+    T *data() const { return d_; }
+
+    T *d_;
+    index M_, N_, K_;
+    index strideM_, strideN_, strideK_;
+};
+
+typedef basic_array_view<double> array_view;
+typedef basic_array_view<const double> const_array_view;
+
 struct array {
     array();
     array(index M, double default_value = 0.0);
@@ -106,31 +272,72 @@ struct array {
     array &operator=(array &&other);
     array &operator=(const array &other);
 
-    array &operator+=(const array &other);
+    /** Evaluates an element-wise expression (e.g. a - b) into a new array. */
+    template<typename E>
+    array( const array_expr<E> &e ) : d_( e.self().size() ), ndim_( 3 ),
+                                      M_( e.self().M() ), N_( e.self().N() ), K_( e.self().K() )
+    {
+        const E &expr = e.self();
+        double *d = d_.data();
+        for (index i = 0, n = d_.size(); i < n; ++i)
+            d[i] = expr[i];
+    }
+
+    /** Materializes the values of a view (e.g. a slice of another array) into a new array. */
+    explicit array( const_array_view v );
+
+    /** Evaluates an element-wise expression into this array.  The expression may refer to this array
+     * (e.g. a = a.max() - a). */
+    template<typename E>
+    array &operator=( const array_expr<E> &e )
+    {
+        const E &expr = e.self();
+        //the expression may refer to this array, thus it is evaluated aside if a reallocation is needed.
+        if ( expr.size() != size() )
+            return *this = array( e );
+        ndim_ = 3;
+        M_ = expr.M();
+        N_ = expr.N();
+        K_ = expr.K();
+        //element-wise operations only read the i-th elements of their operands, so evaluating in place is safe.
+        double *d = d_.data();
+        for (index i = 0, n = d_.size(); i < n; ++i)
+            d[i] = expr[i];
+        return *this;
+    }
 
-    array operator*( double scalar ) const;
+    array &operator+=(const array &other);
 
+    template<typename E>
+    array &operator+=( const array_expr<E> &e )
+    {
+        const E &expr = e.self();
+        double *d = d_.data();
+        for (index i = 0, n = d_.size(); i < n; ++i)
+            d[i] += expr[i];
+        return *this;
+    }
+
+    /** Matrix product (see hadamard() for the element-wise product). */
     array operator*( const array &other ) const;
 
-    array operator/( double scalar ) const;
-
-    array operator-( double scalar ) const;
-
-    array operator-( const array &other ) const;
-
-    array operator+( const array &other ) const;
-
 	array getVectorColumn( index j ) const;
 
     virtual ~array();
 
-    double &operator()(index i);
-    double &operator()(index i, index j);
-    double &operator()(index i, index j, index k);
+    /** Element access.  Negative indexes wrap around (e.g. -1 is the last element in the direction).
+     * Indexes are not checked, except with assert() in debug builds. */
+    double &operator()(index i) { return d_[ position( i ) ]; }
+    double &operator()(index i, index j) { return d_[ position( i, j ) ]; }
+    double &operator()(index i, index j, index k) { return d_[ position( i, j, k ) ]; }
 
-    const double &operator()(index i) const;
-    const double &operator()(index i, index j) const;
-    const double &operator()(index i, index j, index k) const;
+    const double &operator()(index i) const { return d_[ position( i ) ]; }
+    const double &operator()(index i, index j) const { return d_[ position( i, j ) ]; }
+    const double &operator()(index i, index j, index k) const { return d_[ position( i, j, k ) ]; }
+
+    /** Returns a view of all the values of this array (see array_view). */
+    array_view view() { return array_view( d_.data(), M_, N_, K_, N_ * K_, K_, 1 ); }
+    const_array_view view() const { return const_array_view( d_.data(), M_, N_, K_, N_ * K_, K_, 1 ); }
 
     index ndim() const { return ndim_; }
     index M() const { return M_; }
@@ -150,8 +357,8 @@ struct array {
 	double max() const;
 	double min() const;
     double avg() const; //average or mean value
-    array sqrt() const; //square root of each element of this array
-    array sqr() const;  //square of each element of this array
+    inline unary_expr< expr_op::square_root, array_ref > sqrt() const; //square root of each element of this array
+    inline unary_expr< expr_op::square, array_ref > sqr() const;  //square of each element of this array
 
 	double euclideanLength() const;
 
@@ -172,13 +379,120 @@ struct array {
     index M_ = 1; // dim 1
     index N_ = 1; // dim 2
     index K_ = 1; // dim 3
+
+private:
+    /** These wrap negative indexes around and return the position of the element in d_.
+     * NOTE: the single-index access is a linear access to all the elements, whatever the dimension. */
+    index position( index i ) const
+    {
+        if (i < 0)
+            i = (i + M_) % M_;
+        assert( i < (index)d_.size() && "spectral::array: index out of bounds." );
+        return i;
+    }
+    index position( index i, index j ) const
+    {
+        if (i < 0)
+            i = (i + M_) % M_;
+        if (j < 0)
+            j = (j + N_) % N_;
+        assert( i * N_ + j < (index)d_.size() && "spectral::array: index out of bounds." );
+        return i * N_ + j;
+    }
+    index position( index i, index j, index k ) const
+    {
+        if (i < 0)
+            i = (i + M_) % M_;
+        if (j < 0)
+            j = (j + N_) % N_;
+        if (k < 0)
+            k = (k + K_) % K_;
+        assert( (i * N_ + j) * K_ + k < (index)d_.size() && "spectral::array: index out of bounds." );
+        return (i * N_ + j) * K_ + k;
+    }
 };
 
+inline double array_ref::operator[]( index i ) const { return a_->d_[i]; }
+inline index array_ref::size() const { return a_->size(); }
+inline index array_ref::M() const { return a_->M(); }
+inline index array_ref::N() const { return a_->N(); }
+inline index array_ref::K() const { return a_->K(); }
+
+inline unary_expr< expr_op::square_root, array_ref > array::sqrt() const
+{
+    return unary_expr< expr_op::square_root, array_ref >( array_ref( *this ) );
+}
+
+inline unary_expr< expr_op::square, array_ref > array::sqr() const
+{
+    return unary_expr< expr_op::square, array_ref >( array_ref( *this ) );
+}
+
 typedef std::shared_ptr< array > arrayPtr;
 
-array operator-( double theValue, const array& theArray );
+//======================= operators building element-wise array expressions =======================
+
+template<typename L, typename R>
+typename std::enable_if< is_array_operand<L>::value && is_array_operand<R>::value,
+                         binary_expr< expr_op::plus, typename expr_of<L>::type, typename expr_of<R>::type > >::type
+operator+( const L &l, const R &r )
+{
+    return binary_expr< expr_op::plus, typename expr_of<L>::type, typename expr_of<R>::type >(
+                expr_of<L>::get( l ), expr_of<R>::get( r ) );
+}
+
+template<typename L, typename R>
+typename std::enable_if< is_array_operand<L>::value && is_array_operand<R>::value,
+                         binary_expr< expr_op::minus, typename expr_of<L>::type, typename expr_of<R>::type > >::type
+operator-( const L &l, const R &r )
+{
+    return binary_expr< expr_op::minus, typename expr_of<L>::type, typename expr_of<R>::type >(
+                expr_of<L>::get( l ), expr_of<R>::get( r ) );
+}
 
-array operator*( double theValue, const array& theArray );
+/** Performs the Hadamard product, also known as Schur product or element-wise product.
+ * Both operands must have the same dimension and the result is another
+ * array with the same dimension of the operands. */
+template<typename L, typename R>
+typename std::enable_if< is_array_operand<L>::value && is_array_operand<R>::value,
+                         binary_expr< expr_op::times, typename expr_of<L>::type, typename expr_of<R>::type > >::type
+hadamard( const L &l, const R &r )
+{
+    return binary_expr< expr_op::times, typename expr_of<L>::type, typename expr_of<R>::type >(
+                expr_of<L>::get( l ), expr_of<R>::get( r ) );
+}
+
+/** Matrix product with at least one operand being an expression (it is evaluated first). */
+template<typename L, typename R>
+typename std::enable_if< is_array_operand<L>::value && is_array_operand<R>::value &&
+                         !( std::is_same<L, array>::value && std::is_same<R, array>::value ), array >::type
+operator*( const L &l, const R &r )
+{
+    return array( l ) * array( r );
+}
+
+#define SPECTRAL_SCALAR_OPERATOR( OP, FUNCTOR )                                                             \
+template<typename E>                                                                                        \
+typename std::enable_if< is_array_operand<E>::value,                                                        \
+                         scalar_expr< expr_op::FUNCTOR, typename expr_of<E>::type, false > >::type          \
+operator OP( const E &e, double scalar )                                                                    \
+{                                                                                                           \
+    return scalar_expr< expr_op::FUNCTOR, typename expr_of<E>::type, false >( expr_of<E>::get( e ), scalar ); \
+}                                                                                                           \
+template<typename E>                                                                                        \
+typename std::enable_if< is_array_operand<E>::value,                                                        \
+                         scalar_expr< expr_op::FUNCTOR, typename expr_of<E>::type, true > >::type           \
+operator OP( double scalar, const E &e )                                                                    \
+{                                                                                                           \
+    return scalar_expr< expr_op::FUNCTOR, typename expr_of<E>::type, true >( expr_of<E>::get( e ), scalar ); \
+}
+
+SPECTRAL_SCALAR_OPERATOR( +, plus )
+SPECTRAL_SCALAR_OPERATOR( -, minus )
+SPECTRAL_SCALAR_OPERATOR( *, times )
+SPECTRAL_SCALAR_OPERATOR( /, divide )
+
+#undef SPECTRAL_SCALAR_OPERATOR
 
 // fft 1D
 void foward(complex_array &out, double *in, index M);
@@ -311,10 +625,6 @@ double dot( const array &one, const array &other );
  */
 double angle( const array &one, const array &other );
 
-/** Performs the Hadamard product, also known as Schur product or element-wise product.
- * Both operands must have the same dimension and the result is another
- * array with the same dimension of the operands. */
-array hadamard( const array &one, const array &other );
 
 /** Makes a new array by joining the passed column vectors in a container.
  * All the input vectors must have the same number of elements.
@@ -6,14 +6,24 @@ Year: 2017
 
 #include <Eigen/Dense>
 #include <Eigen/SVD>
+#include <Eigen/QR>
+#include <random>
+#include <thread>
+#include <vector>
+#include <algorithm>
 
 namespace spectral
 {
 
 SVD::SVD(const array &A, array &&U, array &&S, array &&V)
     : U_(std::move(U)), S_(std::move(S)), V_(std::move(V)), M_(A.M()), N_(A.N()),
-      K_(A.K()), A_(A)
+      K_(A.K()), energy_(0.0), A_(A)
 {
+    //the total energy (squared Frobenius norm) equals the sum of the squares of all singular values,
+    //including those not computed by svd_truncated().
+    for (const double &value : A.d_) {
+        energy_ += value * value;
+    }
     if (M_ < 1)
         M_ = 1;
     if (N_ < 1)
@@ -35,19 +45,13 @@ size_t SVD::n_factors() { return S_.M(); }
 void SVD::factor(array &f, size_t i)
 {
 	if ((index)i < S_.M()) {
-        Eigen::MatrixXd u = to_2d(U_);
-
-        Eigen::MatrixXd s = Eigen::MatrixXd::Zero(M_, N_ * K_);
-
-        s(i, i) = S_(0, i);
-
-        Eigen::MatrixXd v = to_2d(V_).transpose();
-        Eigen::MatrixXd c = u * s * v;
-
+        //the i-th factor is the rank-1 matrix s_i * u_i * v_i^T.
+        double s = S_(i);
         for (size_t m = 0; m < M_; ++m) {
+            double su = s * U_(m, i);
             for (size_t n = 0; n < N_; ++n) {
                 for (size_t k = 0; k < K_; ++k) {
-                    f(m, n, k) += c(m, n * K_ + k);
+                    f(m, n, k) += su * V_(n * K_ + k, i);
                 }
             }
         }
@@ -129,6 +133,21 @@ array SVD::factor_weights()
     return w;
 }
 
+array SVD::factor_energy_fractions()
+{
+    array w(S_.M(), 1, 1, 0);
+
+    if (energy_ <= 0.0) {
+        return w;
+    }
+
+	for (index i = 0; i < S_.M(); ++i) {
+        w(i) = S_(i) * S_(i) / energy_;
+    }
+
+    return w;
+}
+
 SVD SVD::compute(const array &A) { return svd(A); }
 
 array SVD::solve(const array &A, const array &b) { return svd_lsq_solve(A, b); }
@@ -145,6 +164,84 @@ SVD svd(const array &A)
     return SVD(A, std::move(U), std::move(S), std::move(V));
 }
 
+/** Matrix products with fewer multiply-adds than this are computed in a single thread. */
+static const double MIN_FLOPS_FOR_MULTITHREADING = 1e7;
+
+/** Computes op(a) * b, where op(a) is a or its transpose, with the rows of the result split among threads. */
+static Eigen::MatrixXd parallel_product(const Eigen::MatrixXd &a, bool transposeA, const Eigen::MatrixXd &b)
+{
+    index rows = transposeA ? a.cols() : a.rows();
+    Eigen::MatrixXd result(rows, b.cols());
+
+    unsigned int nThreads = std::max(1u, std::thread::hardware_concurrency());
+    if ((double)rows * b.rows() * b.cols() < MIN_FLOPS_FOR_MULTITHREADING)
+        nThreads = 1;
+    nThreads = std::min<index>(nThreads, rows);
+
+    auto multiply = [&](index firstRow, index nRows) {
+        if (transposeA)
+            result.middleRows(firstRow, nRows).noalias() = a.middleCols(firstRow, nRows).transpose() * b;
+        else
+            result.middleRows(firstRow, nRows).noalias() = a.middleRows(firstRow, nRows) * b;
+    };
+
+    std::vector<std::thread> threads;
+    index rowsPerThread = rows / nThreads;
+    for (unsigned int t = 1; t < nThreads; ++t)
+        threads.emplace_back(multiply, t * rowsPerThread,
+                             t == nThreads - 1 ? rows - t * rowsPerThread : rowsPerThread);
+    multiply(0, nThreads == 1 ? rows : rowsPerThread);
+    for (std::thread &thread : threads)
+        thread.join();
+
+    return result;
+}
+
+/** Returns an orthonormal basis for the column space of y (the thin Q of its QR decomposition). */
+static Eigen::MatrixXd orthonormalize(const Eigen::MatrixXd &y)
+{
+    Eigen::HouseholderQR<Eigen::MatrixXd> qr(y);
+    return qr.householderQ() * Eigen::MatrixXd::Identity(y.rows(), y.cols());
+}
+
+SVD svd_truncated(const array &A, index nFactors, index nOversamples, int nPowerIterations)
+{
+    Eigen::MatrixXd a = to_2d(A);
+    index m = a.rows();
+    index n = a.cols();
+    index minDim = std::min(m, n);
+
+    if (nFactors <= 0 || nFactors >= minDim)
+        return svd(A);
+
+    index l = std::min(nFactors + nOversamples, minDim);
+
+    //sample the range of A with random directions (fixed seed, so results are reproducible).
+    std::mt19937 generator(42);
+    std::normal_distribution<double> normal;
+    Eigen::MatrixXd omega(n, l);
+    for (index j = 0; j < l; ++j)
+        for (index i = 0; i < n; ++i)
+            omega(i, j) = normal(generator);
+    Eigen::MatrixXd q = orthonormalize(parallel_product(a, false, omega));
+
+    //power iterations (re-orthonormalizing at each product for numerical stability).
+    for (int iteration = 0; iteration < nPowerIterations; ++iteration) {
+        Eigen::MatrixXd z = orthonormalize(parallel_product(a, true, q));
+        q = orthonormalize(parallel_product(a, false, z));
+    }
+
+    //the SVD of the small matrix B = Q^T * A (l x n) gives the leading singular triplets of A.
+    Eigen::MatrixXd b = parallel_product(q, true, a);
+    Eigen::BDCSVD<Eigen::MatrixXd> svdB(b, Eigen::ComputeThinU | Eigen::ComputeThinV);
+
+    auto S = to_array(svdB.singularValues().head(nFactors));
+    auto U = to_array(parallel_product(q, false, svdB.matrixU().leftCols(nFactors)));
+    auto V = to_array(svdB.matrixV().leftCols(nFactors));
+
+    return SVD(A, std::move(U), std::move(S), std::move(V));
+}
+
 array svd_lsq_solve(const array &A, const array &B)
 {
     auto a = to_2d(A);
@@ -32,6 +32,13 @@ public:
 
     array factor_weights();
 
+    /**
+     * Returns the fraction of the total energy (squared Frobenius norm of A) of each computed factor, that is,
+     * s_i^2 / ||A||^2.  Unlike factor_weights(), which are relative to the computed factors only, the fractions
+     * of the factors computed by svd_truncated() sum up to the share of the information they actually hold.
+     */
+    array factor_energy_fractions();
+
     static SVD compute(const array &A);
     static array solve(const array &A, const array &b);
 
@@ -44,10 +51,26 @@ private:
     size_t N_;
     size_t K_;
 
+    double energy_;
+
     const array &A_;
 };
 
 SVD svd(const array &A);
+
+/**
+ * Computes only the leading nFactors singular triplets of A (truncated SVD) with the randomized range finder
+ * of Halko, Martinsson and Tropp (2011).  This is much faster and uses much less memory than svd() for large
+ * grids when only a few factors are needed, since the full U and V matrices are never formed.  The large
+ * matrix products are computed with multiple threads.
+ * If nFactors is not less than the smallest dimension of the unfolded grid matrix, this falls back to svd().
+ * @note Since the trailing singular values are not computed, factor_weights() of the result are relative
+ *       to the leading factors only.  Use factor_energy_fractions() to weigh them against the whole of A.
+ * @param nOversamples Number of extra random directions sampled to improve accuracy.
+ * @param nPowerIterations Number of power iterations, which improve accuracy when the singular values decay slowly.
+ */
+SVD svd_truncated(const array &A, index nFactors, index nOversamples = 10, int nPowerIterations = 2);
+
 array svd_lsq_solve(const array &A, const array &b);
 
 } // namespace spectral
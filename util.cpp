@@ -23,6 +23,7 @@
 #include "domain/variogrammodel.h"
 #include "domain/segmentset.h"
 #include "domain/auxiliary/faciestransitionmatrixmaker.h"
+#include "domain/auxiliary/transiographyengine.h"
 #include "gslib/gslibparameterfiles/gslibparameterfile.h"
 #include "gslib/gslibparameterfiles/gslibparamtypes.h"
 #include "gslib/gslibparams/gslibparinputdata.h"
@@ -37,11 +38,10 @@
 #include <cmath>
 #include <vtkSmartPointer.h>
 #include <vtkImageData.h>
-#include <vtkImageFFT.h>
-#include <vtkImageRFFT.h>
 #include <vtkLookupTable.h>
 #include <QProgressDialog>
 #include "spectral/spectral.h"
+#include "spectral/fftservice.h"
 #include <QStringBuilder>
 
 //includes for getPhysicalRAMusage()
@@ -1301,249 +1301,59 @@ void Util::saveText(const QString filePath, const QStringList lines)
 
 void Util::fft1D(int lx, std::vector< std::complex<double> > &cx, int startingElement, FFTComputationMode isig )
 {
-    int i, j, l, m, istep;
-    std::complex<double> carg, /*cexp,*/ cw, ctemp;
-    double pii, sc;
-    pii = 4.*std::atan(1.); //c++ has pi defined as constant
-
-    int iisig = 0;
-    switch( isig ){
-        case FFTComputationMode::DIRECT: iisig = 0; break;
-        case FFTComputationMode::REVERSE: iisig = 1;
-    }
-
-    j = 1;
-    sc = std::sqrt(1./lx);
-    for( i = 1; i <= lx; ++i){
-        if(i <= j){
-            int pi = startingElement + i;
-            int pj = startingElement + j;
-            ctemp = cx[pj-1]*sc;
-            cx[pj-1] = cx[pi-1]*sc;
-            cx[pi-1] = ctemp;
-        }
-        m = lx/2;
-        while (m >= 1 && j > m){
-            j = j-m;
-            m = m/2;
-        }
-        j = j + m;
+    if( startingElement < 0 || startingElement + lx > (int)cx.size() ){
+        Application::instance()->logError("Util::fft1D: Index out of bounds.  Computation not done.");
+        return;
     }
-
-    l = 1;
-
-    std::complex<double> im(0, 1); //Fortran's cmplx(0.,1.) == i
-
-    while ( l < lx ){
-        istep = 2*l;
-        for( m = 1; m <= l; ++m ){
-            carg = im *(pii*iisig*(m-1))/(double)(l);
-            cw = std::exp(carg);
-            for( i = m; i+l < lx; i = i + istep ){
-                int pi = startingElement + i;
-                if( pi+l-1 < 0 || pi+l-1 >= (int)cx.size() || pi-1 < 0 || pi-1 >= (int)cx.size()){
-                    Application::instance()->logError("Util::fft1D: Index out of bounds.  Computation not done.");
-                    continue;
-                }
-                ctemp = (cw*cx[pi+l-1]);
-                cx[pi+l-1] = (cx[pi-1]-ctemp);
-                cx[pi-1] = (cx[pi-1]+ctemp);
-            }
-        }
-        l = istep;
-    }
-
-    /////////////////original code in Fortran/////////////////////////////
- /* !----------------------------------------------------------------------
-    ! 1-D Fast Fourier Transform (FFT) by Jon Claerbout (1985)
-    !----------------------------------------------------------------------
-    ! Input and output parameters:
-    !
-    !   LX=   dimension of the data array (integer)
-    !   CX=   data array (complex, dim=LX) with input values in real part
-    !   ISIG= integer flag = 0 for forward FFT and = 1 for inverse FFT
-    !
-    ! Note that this soubroutine deletes the original data in the CX array
-    ! and after this subroutine the data array needs to be swapped around
-    ! the origin (see Press et al. Numerical recipes, for example).
-    !
-    ! Original reference: Claerbout, J., 1976. Fundamentals of geophysical
-    ! data processing. With applications to petroleum prospecting: McGraw-
-    ! Hill Book Co.
-    !----------------------------------------------------------------------
-    ! Markku Pirttijärvi, 2003
-
-      subroutine fork(lx,cx,isig)
-
-        implicit none
-        integer :: lx,isig,i,j,l,m,istep
-        complex :: cx(lx),carg,cexp,cw,ctemp
-        real :: pii,sc
-        pii= 4.*atan(1.)
-
-        j= 1
-        sc= sqrt(1./lx)
-        do i= 1,lx
-          if(i <= j) then
-            ctemp= cx(j)*sc
-            cx(j)= cx(i)*sc
-            cx(i)= ctemp
-          end if
-          m= lx/2
-          do while (m >= 1 .and. j > m)
-            j= j-m
-            m= m/2
-          end do
-          j= j+m
-        end do
-        l= 1
-        do while (l < lx)
-          istep= 2*l
-          do m= 1,l
-            carg= cmplx(0.,1.)*(pii*isig*(m-1))/l
-            cw= cexp(carg)
-            do i= m,lx,istep
-              ctemp= cw*cx(i+l)
-              cx(i+l)= cx(i)-ctemp
-              cx(i)= cx(i)+ctemp
-            end do
-          end do
-          l= istep
-        end do
-        return
-      end subroutine fork
-*/
+    //the transforms are out-of-place.
+    std::vector< std::complex<double> > result( lx );
+    //std::complex<double> is binary-compatible with fftw_complex (double[2]).
+    spectral::FFTService::instance().c2c( reinterpret_cast<fftw_complex*>( cx.data() + startingElement ),
+                                          reinterpret_cast<fftw_complex*>( result.data() ),
+                                          isig == FFTComputationMode::DIRECT ? FFTW_FORWARD : FFTW_BACKWARD,
+                                          1, lx );
+    //symmetric scaling (1/sqrt(n) both ways), so a transform followed by a back-transform yields the input.
+    double sc = std::sqrt( 1.0 / lx );
+    for( int i = 0; i < lx; ++i )
+        cx[ startingElement + i ] = result[i] * sc;
 }
 
 void Util::fft1DPPP(int dir, long m, std::vector<std::complex<double> > &x, long startingElement)
 {
-    long i, i1, i2,j, k, l, l1, l2, n;
-    std::complex <double> t1, u, c;
-
-    /*Calculate the number of points */
-    n = 1;
-    for(i = 0; i < m; i++)
-        n <<= 1;
-
-    /* Do the bit reversal */
-    i2 = n >> 1;
-    j = 0;
-
-    for (i = 0; i < n-1 ; i++)
-    {
-        if (i < j)
-            std::swap(x[i+startingElement],
-                      x[j+startingElement]);
-
-        k = i2;
-
-        while (k <= j)
-        {
-            j -= k;
-            k >>= 1;
-        }
-
-        j += k;
-    }
-
-    /* Compute the FFT */
-    c.real(-1.0);
-    c.imag(0.0);
-    l2 = 1;
-    for (l = 0; l < m; l++)
-    {
-        l1 = l2;
-        l2 <<= 1;
-        u.real(1.0);
-        u.imag(0.0);
-
-        for (j = 0; j < l1; j++)
-        {
-            for (i = j; i < n; i += l2)
-            {
-                i1 = i + l1;
-                t1 = u * x[i1+startingElement];
-                x[i1+startingElement] = x[i+startingElement] - t1;
-                x[i+startingElement] += t1;
-            }
-
-            u = u * c;
-        }
-
-        c.imag(std::sqrt((1.0 - c.real()) / 2.0));
-        if (dir == 1)
-            c.imag(-c.imag());
-        c.real(std::sqrt((1.0 + c.real()) / 2.0));
-    }
-
-    /* Scaling for forward transform */
-    if (dir == 1)
-    {
-        for (i = 0; i < n; i++)
-            x[i+startingElement] /= n;
+    long n = 1L << m;
+    if( startingElement < 0 || startingElement + n > (long)x.size() ){
+        Application::instance()->logError("Util::fft1DPPP: Index out of bounds.  Computation not done.");
+        return;
     }
-    return;
+    std::vector< std::complex<double> > result( n );
+    spectral::FFTService::instance().c2c( reinterpret_cast<fftw_complex*>( x.data() + startingElement ),
+                                          reinterpret_cast<fftw_complex*>( result.data() ),
+                                          dir == 1 ? FFTW_FORWARD : FFTW_BACKWARD,
+                                          1, n );
+    //only the forward transform is scaled.
+    double sc = ( dir == 1 ) ? 1.0 / n : 1.0;
+    for( long i = 0; i < n; ++i )
+        x[ startingElement + i ] = result[i] * sc;
 }
 
 
 void Util::fft2D(int n1, int n2, std::vector< std::complex<double> > &cp, FFTComputationMode isig)
 {
-    int i1,i2;
-    std::vector< std::complex<double> > cw( n2 );
-
-    for( i2 = 0; i2 < n2; ++i2){
-        fft1D(n1, cp, i2*n1, isig); //cp[i2*n1] is supposed to mean cp[0][i2] (Fortran: cp(1,i2))
-        //fft1DPPP( 1, (long)std::log2(n2), cp, i2*n1);
-    }
-
-    for( i1 = 0; i1 < n1; ++i1){
-        for( i2 = 0; i2 < n2; ++i2) {
-            cw[i2] = cp[i1+i2*n1];       //cp[i1+i2*n1] is supposed to mean cp[i1][i2] (Fortran: cp(i1,i2))
-        }
-        fft1D(n2, cw, 0, isig);
-        //fft1DPPP( 1, (long)std::log2(n2), cw, 0);
-        for( i2 = 0; i2 < n2; ++i2){
-            cp[i1+i2*n1] = cw[i2];       //cp[i1+i2*n1] is supposed to mean cp[i1][i2] (Fortran: cp(i1,i2))
-        }
+    long n = (long)n1 * n2;
+    if( n > (long)cp.size() ){
+        Application::instance()->logError("Util::fft2D: Array smaller than n1 x n2.  Computation not done.");
+        return;
     }
-    //////////////////////original code in Fortran//////////////////////
-/*  !----------------------------------------------------------------------
-    ! Computation of 2-D Fast Fourier Transform (FFT)
-    !---------------------------------------------------------------------
-    ! Input and output parameters:
-    !
-    ! N1=   dimension of the data array in x direction (integer)
-    ! N2=   dimension of the data array in y direction (integer)
-    ! CP=   data array (complex, dim=(N1,N2)) with input values in real part
-    ! ISIG= computation flag (int.) = 0 for forward and =1 for inverse FFT
-    !
-    ! Calls external subroutine FORK (for 1D FFT) to do the actual work.
-    !---------------------------------------------------------------------
-    ! M.Pirttijärvi, October, 2003
-
-      subroutine ft2d(n1,n2,cp,isig)
-        implicit none
-        integer :: n1,n2,isig,i1,i2
-        complex :: cp(n1,n2),cw(n2)
-        external fork
-
-        do i2= 1,n2
-          call fork(n1,cp(1,i2),isig)
-        end do
-
-        do i1= 1,n1
-          do i2= 1,n2
-            cw(i2)= cp(i1,i2)
-          end do
-          call fork(n2,cw,isig)
-          do i2= 1,n2
-            cp(i1,i2)= cw(i2)
-          end do
-        end do
-
-        return
-      end subroutine ft2d
-*/
+    std::vector< std::complex<double> > result( n );
+    //cp[i1 + i2*n1] is a row-major n2 x n1 array in FFTW's terms (the last dimension varies fastest).
+    spectral::FFTService::instance().c2c( reinterpret_cast<fftw_complex*>( cp.data() ),
+                                          reinterpret_cast<fftw_complex*>( result.data() ),
+                                          isig == FFTComputationMode::DIRECT ? FFTW_FORWARD : FFTW_BACKWARD,
+                                          2, n2, n1 );
+    //same scaling as two passes of fft1D().
+    double sc = std::sqrt( 1.0 / n );
+    for( long i = 0; i < n; ++i )
+        cp[i] = result[i] * sc;
 }
 
 void Util::fastSplit(const QString lineGEOEAS, QStringList & list)
@@ -1615,70 +1425,96 @@ void Util::fft3D(int nI, int nJ, int nK, std::vector<std::complex<double> > &val
                  FFTComputationMode isig,
                  FFTImageType itype )
 {
-    //create a vtk image from the input value array
-    ////// index_shift = ( index + nINDEX/2) % nINDEX), if in reverse FFT mode,
-    ////// shifts the lower frequencies components to the corners of the image for compatibility with RFFT algorithm/////
-    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
-    image->SetDimensions( nI, nJ, nK );
-    image->AllocateScalars( VTK_DOUBLE, 2 ); // two components: real and imaginary parts.
-    for(unsigned int k = 0; k < (unsigned int)nK; ++k) {
-        int k_shift = (k + nK/2) % nK;
-        if( isig == FFTComputationMode::DIRECT ) k_shift = k;
-        for(unsigned int j = 0; j < (unsigned int)nJ; ++j){
-            int j_shift = (j + nJ/2) % nJ;
-            if( isig == FFTComputationMode::DIRECT ) j_shift = j;
-            for(unsigned int i = 0; i < (unsigned int)nI; ++i){
-                int i_shift = (i + nI/2) % nI;
-                if( isig == FFTComputationMode::DIRECT ) i_shift = i;
-                std::complex<double> value = values[i_shift + j_shift*nI + k_shift*nJ*nI];
-                double* cell = static_cast<double*>(image->GetScalarPointer(i,j,k));
-                if( isig == FFTComputationMode::REVERSE && itype == FFTImageType::POLAR_FORM )
-                    value = std::polar( value.real(), value.imag() );
-                cell[0] = value.real();
-                cell[1] = value.imag();
+    spectral::index n = (spectral::index)nI * nJ * nK;
+    //the transforms are out-of-place, the scratch array is allocated with fftw_alloc_complex() for SIMD alignment.
+    fftw_complex* buffer = fftw_alloc_complex( n );
+    std::complex<double>* scratch = reinterpret_cast< std::complex<double>* >( buffer );
+    //values[i + j*nI + k*nJ*nI] is a row-major nK x nJ x nI array in FFTW's terms.
+    fftw_complex* data = reinterpret_cast<fftw_complex*>( values.data() );
+
+    if( isig == FFTComputationMode::DIRECT ){
+        spectral::FFTService::instance().c2c( data, buffer, FFTW_FORWARD, 3, nK, nJ, nI );
+        ////// index_shift = ( index + nINDEX/2) % nINDEX), in forward FFT mode,
+        ////// shifts the lower frequencies components to the center of the image for ease of interpretation/////
+        for( int k = 0; k < nK; ++k ){
+            int k_shift = (k + nK/2) % nK;
+            for( int j = 0; j < nJ; ++j ){
+                int j_shift = (j + nJ/2) % nJ;
+                const std::complex<double>* row = scratch + ( (spectral::index)k * nJ + j ) * nI;
+                std::complex<double>* rowShifted = values.data() + ( (spectral::index)k_shift * nJ + j_shift ) * nI;
+                for( int i = 0; i < nI; ++i ){
+                    int i_shift = (i + nI/2) % nI;
+                    if( itype == FFTImageType::POLAR_FORM )
+                        rowShifted[i_shift] = std::complex<double>( std::abs( row[i] ), std::arg( row[i] ) );
+                    else
+                        rowShifted[i_shift] = row[i];
+                }
             }
         }
+    } else { // FFTComputationMode::REVERSE
+        ////// index_shift = ( index + nINDEX/2) % nINDEX), in reverse FFT mode,
+        ////// shifts the lower frequencies components back to the corners of the image/////
+        for( int k = 0; k < nK; ++k ){
+            int k_shift = (k + nK/2) % nK;
+            for( int j = 0; j < nJ; ++j ){
+                int j_shift = (j + nJ/2) % nJ;
+                std::complex<double>* row = scratch + ( (spectral::index)k * nJ + j ) * nI;
+                const std::complex<double>* rowShifted = values.data() + ( (spectral::index)k_shift * nJ + j_shift ) * nI;
+                for( int i = 0; i < nI; ++i ){
+                    int i_shift = (i + nI/2) % nI;
+                    if( itype == FFTImageType::POLAR_FORM )
+                        row[i] = std::polar( rowShifted[i_shift].real(), rowShifted[i_shift].imag() );
+                    else
+                        row[i] = rowShifted[i_shift];
+                }
+            }
+        }
+        spectral::FFTService::instance().c2c( buffer, data, FFTW_BACKWARD, 3, nK, nJ, nI );
+        //the reverse transform is normalized, so reverse( direct( x ) ) == x.
+        double sc = 1.0 / n;
+        for( spectral::index i = 0; i < n; ++i )
+            values[i] *= sc;
     }
-    image->Modified();
-
-    vtkSmartPointer<vtkImageFourierFilter> fftFilter;
-    if( isig == FFTComputationMode::DIRECT )
-        // Compute the FFT of the image
-        fftFilter = vtkSmartPointer<vtkImageFFT>::New();
-    else // FFTComputationMode::REVERSE
-        // Compute the reverse FFT of the image
-        fftFilter = vtkSmartPointer<vtkImageRFFT>::New();
-    //fftFilter->SetInputConnection( image->GetData() );
-    fftFilter->SetInputData( image );
-    fftFilter->Update();
-
-    //return the result image in frequency/real domain (polar/rectangular form)
-    ////// index_shift = ( index + nINDEX/2) % nINDEX), if in forward FFT mode,
+
+    fftw_free( buffer );
+}
+
+void Util::fft3D(int nI, int nJ, int nK, const std::vector<double> &realValues,
+                 std::vector<std::complex<double> > &result, FFTImageType itype)
+{
+    spectral::index n = (spectral::index)nI * nJ * nK;
+    //the real-to-complex transform only outputs the non-redundant half of the spectrum along I.
+    int nIhalf = nI / 2 + 1;
+    fftw_complex* buffer = fftw_alloc_complex( (spectral::index)nK * nJ * nIhalf );
+    const std::complex<double>* halfSpectrum = reinterpret_cast< std::complex<double>* >( buffer );
+    //FFTW's r2c transforms do not write to the input array despite the non-const pointer.
+    spectral::FFTService::instance().r2c( const_cast<double*>( realValues.data() ), buffer, 3, nK, nJ, nI );
+
+    result.resize( n );
+    ////// index_shift = ( index + nINDEX/2) % nINDEX)
     ////// shifts the lower frequencies components to the center of the image for ease of interpretation/////
-    vtkSmartPointer<vtkImageData> imageOutput = fftFilter->GetOutput();
-    for(unsigned int k = 0; k < (unsigned int)nK; ++k) {
+    for( int k = 0; k < nK; ++k ){
         int k_shift = (k + nK/2) % nK;
-        if( isig == FFTComputationMode::REVERSE ) k_shift = k;
-        for(unsigned int j = 0; j < (unsigned int)nJ; ++j){
+        int k_mirror = (nK - k) % nK;
+        for( int j = 0; j < nJ; ++j ){
             int j_shift = (j + nJ/2) % nJ;
-            if( isig == FFTComputationMode::REVERSE ) j_shift = j;
-            for(unsigned int i = 0; i < (unsigned int)nI; ++i){
+            int j_mirror = (nJ - j) % nJ;
+            const std::complex<double>* row = halfSpectrum + ( (spectral::index)k * nJ + j ) * nIhalf;
+            const std::complex<double>* rowMirror = halfSpectrum + ( (spectral::index)k_mirror * nJ + j_mirror ) * nIhalf;
+            std::complex<double>* rowShifted = result.data() + ( (spectral::index)k_shift * nJ + j_shift ) * nI;
+            for( int i = 0; i < nI; ++i ){
                 int i_shift = (i + nI/2) % nI;
-                if( isig == FFTComputationMode::REVERSE ) i_shift = i;
-                std::complex<double> value;
-                double* cell = static_cast<double*>(imageOutput->GetScalarPointer(i,j,k));
-                if( isig == FFTComputationMode::DIRECT && itype == FFTImageType::POLAR_FORM ){
-                    std::complex<double> tmp( cell[0], cell[1] );
-                    value.real( std::abs( tmp ) );
-                    value.imag( std::arg( tmp ) );
-                } else {
-                    value.real( cell[0] );
-                    value.imag( cell[1] );
-                }
-                values[i_shift + j_shift*nI + k_shift*nJ*nI] = value;
+                //the spectrum of real data is Hermitian: X[k][j][i] == conj( X[-k][-j][-i] ).
+                std::complex<double> value = ( i < nIhalf ) ? row[i] : std::conj( rowMirror[ nI - i ] );
+                if( itype == FFTImageType::POLAR_FORM )
+                    rowShifted[i_shift] = std::complex<double>( std::abs( value ), std::arg( value ) );
+                else
+                    rowShifted[i_shift] = value;
             }
         }
     }
+
+    fftw_free( buffer );
 }
 
 double Util::getDip( double dx, double dy, double dz, int xstep, int ystep, int zstep )
@@ -1945,71 +1781,151 @@ bool Util::isInside(const Vertex3D & p, const std::vector<Face3D> & fs)
     return true;
 }
 
-spectral::array Util::getVarmapFIM(const spectral::array &inputData)
+/** Returns, for each of the first nFrequencies frequencies of a dimension with n cells, the factor that, multiplied
+ * with the spectrum, circularly shifts the signal by n/2 cells (same as spectral::shiftByHalf()).
+ */
+static std::vector< std::complex<double> > getHalfShiftPhases( spectral::index n, spectral::index nFrequencies )
 {
-    size_t nI = inputData.M();
-    size_t nJ = inputData.N();
-    size_t nK = inputData.K();
-
-    //compute FFT of input data
-    spectral::complex_array inputFFT( nI, nJ, nK );
-    spectral::array temp = inputData; //make local copy because spectral::foward()'s parameters are not const
-    spectral::foward( inputFFT, temp );
-
-    //convert the FT of the input to polar form
-    spectral::complex_array inputFFTpolar = spectral::to_polar_form( inputFFT );
-
-    //get the amplitudes
-    spectral::array inputFFTamplitudes = spectral::real( inputFFTpolar );
-
-    //get the spectral density
-    //NOTE: the division by ( nI * nJ * nK ) is due to FFTW's implementation's issue with scale. It is not from theory.
-    spectral::array inputSpectralDensity = inputFFTamplitudes.sqr() / static_cast<double>( nI * nJ * nK );
-
-    //make a polar FT image with the spectral density as amplitudes and0 zeros as phases
-    spectral::array zeroPhases( nI, nJ, nK, 0.0 );
-    spectral::complex_array varmapFFTpolar = spectral::to_complex_array( inputSpectralDensity, zeroPhases );
-
-    //convert the FT to Cartesian form
-    spectral::complex_array varmapFFT = spectral::to_rectangular_form(  varmapFFTpolar );
-
-    //get the covariance values by reversing the FT
-    spectral::array varmap( nI, nJ, nK, 0.0 );
-    spectral::backward( varmap, varmapFFT );
+    std::vector< std::complex<double> > phases( nFrequencies );
+    spectral::index shift = n / 2;
+    for( spectral::index f = 0; f < nFrequencies; ++f )
+        //the modulo keeps the angles small for accuracy.
+        phases[f] = std::polar( 1.0, -2.0 * (double)Util::PI * ( ( f * shift ) % n ) / n );
+    return phases;
+}
 
-    //centralize h=0 for ease of interpretation
-    varmap = spectral::shiftByHalf( varmap );
+spectral::array Util::getVarmapFIM(const spectral::array &inputData)
+{
+    spectral::index nI = inputData.M();
+    spectral::index nJ = inputData.N();
+    spectral::index nK = inputData.K();
+    spectral::index n = nI * nJ * nK;
+    spectral::index nKhalf = nK / 2 + 1;
+
+    //compute FFT of input data (only the non-redundant half of the spectrum is computed)
+    //this is the only complex array allocated by this function.
+    //NOTE: FFTW's out-of-place real-to-complex transforms do not change the input array.
+    spectral::complex_array spectrum( nI, nJ, nKhalf );
+    spectral::FFTService::instance().r2c( const_cast<double*>( inputData.d_.data() ), spectrum.data(), 3, nI, nJ, nK );
+
+    //the phase factors that centralize h=0 for ease of interpretation, so there is no need to shift the result.
+    std::vector< std::complex<double> > phasesI = getHalfShiftPhases( nI, nI );
+    std::vector< std::complex<double> > phasesJ = getHalfShiftPhases( nJ, nJ );
+    std::vector< std::complex<double> > phasesK = getHalfShiftPhases( nK, nKhalf );
+
+    //replace the FT with the spectral density (the FT with squared amplitudes and zero phases), in place.
+    //NOTE: one division by ( nI * nJ * nK ) is due to FFTW's implementation's issue with scale. It is not from theory.
+    //      The other one puts the covariance in the correct scale after the reverse FT.
+    double scale = 1.0 / n / n;
+    for( spectral::index i = 0; i < nI; ++i )
+        for( spectral::index j = 0; j < nJ; ++j ){
+            std::complex<double> phaseIJ = phasesI[i] * phasesJ[j];
+            fftw_complex* row = &spectrum( i, j, 0 );
+            for( spectral::index k = 0; k < nKhalf; ++k ){
+                double spectralDensity = ( row[k][0] * row[k][0] + row[k][1] * row[k][1] ) * scale;
+                std::complex<double> value = spectralDensity * phaseIJ * phasesK[k];
+                row[k][0] = value.real();
+                row[k][1] = value.imag();
+            }
+        }
 
-    //put the covariance in the correct scale (FFTW implementation characteristic, not from theory)
-    varmap = varmap / static_cast<double>( nI * nJ * nK );
-    varmap = varmap - varmap.min();
+    //get the covariance values by reversing the FT (the spectrum is destroyed)
+    spectral::array varmap( nI, nJ, nK );
+    spectral::FFTService::instance().c2r( spectrum.data(), varmap.d_.data(), 3, nI, nJ, nK );
 
     //convert covariance values to semivariances (zero @ h=0)
-    varmap = varmap.max() - varmap;
+    double maxCovariance = varmap.max();
+    for( spectral::index i = 0; i < n; ++i )
+        varmap.d_[i] = maxCovariance - varmap.d_[i];
 
     return varmap;
 }
 
 spectral::array Util::getVarmapSpectral(const spectral::array &inputData)
 {
-    size_t nI = inputData.M();
-    size_t nJ = inputData.N();
-    size_t nK = inputData.K();
-
-    //make a local copy (will be moved to inside of a SVDFacor object)
-    spectral::array varmap( inputData );
-
-    //compute varmap (output will go to temp)
-    spectral::autocovariance( varmap , inputData, false );
-
-    //put covariance at h=0 in the center of the grid for ease of interpretation
-    varmap = spectral::shiftByHalf( varmap );
-
-    //clips the varmap so the grid matches the input's
-    varmap = spectral::project( varmap, nI, nJ, nK );
+    //This is the same as spectral::autocovariance( varmap, inputData, false ) followed by a shift and a clipping
+    //of the result to the input grid's dimensions.  Since both operands are the same data, several of the transforms
+    //and intermediate arrays of spectral::covariance3d() are not needed.
+
+    spectral::index nI = inputData.M();
+    spectral::index nJ = inputData.N();
+    spectral::index nK = inputData.K();
+
+    //the input is zero-padded to avoid circular correlation
+    spectral::index K1 = 2 * nI - 1;
+    spectral::index K2 = 2 * nJ - 1;
+    spectral::index K3 = 2 * nK - 1;
+    spectral::index K3half = K3 / 2 + 1;
+
+    //the FTs of the valid value indicators (zero for NaNs and infinities) and of the values.
+    spectral::array padded( K1, K2, K3, 0.0 );
+    spectral::complex_array A( K1, K2, K3half ), NPA( K1, K2, K3half );
+    for( spectral::index i = 0; i < nI; ++i )
+        for( spectral::index j = 0; j < nJ; ++j )
+            for( spectral::index k = 0; k < nK; ++k )
+                padded( i, j, k ) = std::isfinite( inputData( i, j, k ) ) ? 1.0 : 0.0;
+    spectral::FFTService::instance().r2c( padded.d_.data(), NPA.data(), 3, K1, K2, K3 );
+    for( spectral::index i = 0; i < nI; ++i )
+        for( spectral::index j = 0; j < nJ; ++j )
+            for( spectral::index k = 0; k < nK; ++k ){
+                double value = inputData( i, j, k );
+                padded( i, j, k ) = std::isfinite( value ) ? value : 0.0;
+            }
+    spectral::FFTService::instance().r2c( padded.d_.data(), A.data(), 3, K1, K2, K3 );
+
+    //in place: the cross spectrum of indicators and values (for the lag means) and the power spectrum of
+    //the indicators (for the number of pairs).
+    for( spectral::index i = 0; i < A.size(); ++i ){
+        std::complex<double> a( A.d_[i][0], A.d_[i][1] );
+        std::complex<double> npa( NPA.d_[i][0], NPA.d_[i][1] );
+        std::complex<double> ma = npa * std::conj( a );
+        A.d_[i][0] = ma.real();
+        A.d_[i][1] = ma.imag();
+        NPA.d_[i][0] = std::norm( npa );
+        NPA.d_[i][1] = 0.0;
+    }
+
+    //back to the lag domain (the spectra are destroyed).  The 1/(K1*K2*K3) scaling of FFTW's reverse transform
+    //cancels out in the ratios below.
+    spectral::array means( K1, K2, K3 ), pairs( K1, K2, K3 );
+    spectral::FFTService::instance().c2r( A.data(), means.d_.data(), 3, K1, K2, K3 );
+    spectral::FFTService::instance().c2r( NPA.data(), pairs.d_.data(), 3, K1, K2, K3 );
+
+    //the power spectrum of the values (for the sum of products).  The FT of the values is computed again
+    //(the padded array still holds them) instead of keeping a third complex array in memory.
+    spectral::FFTService::instance().r2c( padded.d_.data(), A.data(), 3, K1, K2, K3 );
+    for( spectral::index i = 0; i < A.size(); ++i ){
+        A.d_[i][0] = A.d_[i][0] * A.d_[i][0] + A.d_[i][1] * A.d_[i][1];
+        A.d_[i][1] = 0.0;
+    }
+    spectral::array& products = padded;
+    spectral::FFTService::instance().c2r( A.data(), products.d_.data(), 3, K1, K2, K3 );
+
+    //covariance is E[ab] - E[a]E[b] for each lag.  Since a and b are the same data, the spectrum of the
+    //lag means of the tails is the conjugate of that of the heads, thus their lag means are those at -h.
+    //Only the lags within the input grid's dimensions are computed, with h=0 at the center for ease of interpretation.
+    spectral::array varmap( nI, nJ, nK );
+    for( spectral::index i = 0; i < nI; ++i ){
+        spectral::index iLag = ( i - nI / 2 + K1 ) % K1;
+        spectral::index iLagMirror = ( K1 - iLag ) % K1;
+        for( spectral::index j = 0; j < nJ; ++j ){
+            spectral::index jLag = ( j - nJ / 2 + K2 ) % K2;
+            spectral::index jLagMirror = ( K2 - jLag ) % K2;
+            for( spectral::index k = 0; k < nK; ++k ){
+                spectral::index kLag = ( k - nK / 2 + K3 ) % K3;
+                spectral::index kLagMirror = ( K3 - kLag ) % K3;
+                double np = pairs( iLag, jLag, kLag );
+                varmap( i, j, k ) = products( iLag, jLag, kLag ) / np -
+                                    ( means( iLag, jLag, kLag ) / np ) *
+                                    ( means( iLagMirror, jLagMirror, kLagMirror ) / np );
+            }
+        }
+    }
 
     //invert result so the value increases radially from the center at h=0
-    varmap = varmap.max() - varmap;
+    double maxCovariance = varmap.max();
+    for( spectral::index i = 0; i < varmap.size(); ++i )
+        varmap.d_[i] = maxCovariance - varmap.d_[i];
 
     return varmap;
 }
@@ -2253,6 +2169,15 @@ std::vector<hFTM> Util::computeFaciesTransitionMatrices(std::vector<Attribute*>&
         hFTMs.push_back( { h, ftmAll } );
     }
 
+    //the separations
+    std::vector<double> separations;
+    separations.reserve( hFTMs.size() );
+    for( const hFTM& hftm : hFTMs )
+        separations.push_back( hftm.first );
+
+    //an auxiliary object to count facies transitions at all separations in one pass
+    TransiographyEngine transiographyEngine( CDofFirst->getCategoryCount() );
+
     //for each file (each categorical attribute)
     for( Attribute* at : categoricalAttributes ){
         //get the data file
@@ -2263,24 +2188,35 @@ std::vector<hFTM> Util::computeFaciesTransitionMatrices(std::vector<Attribute*>&
         if( dataFile->getFileType() == "SEGMENTSET" ){
             //load data from file system
             dataFile->readFromFS();
-            //make an auxiliary object to count facies transitions at given separations
-            FaciesTransitionMatrixMaker<SegmentSet> ftmMaker( dynamic_cast<SegmentSet*>(dataFile),
-                                                              at->getAttributeGEOEASgivenIndex()-1 );
-            //for each separation h
-            for( hFTM& hftm : hFTMs ){
-                Application::instance()->logInfo("   working on h = " + QString::number( hftm.first ) + "...");
-                QApplication::processEvents();
-                //make a Facies Transion Matrix for a given h
-                FaciesTransitionMatrix ftm = ftmMaker.makeAlongTrajectory( hftm.first, toleranceCoefficient * hftm.first );
-                //add its counts to the global FTM for a given h
-                hftm.second.add( ftm );
-            }
+            //prepare the trajectory for the counts
+            if( ! transiographyEngine.addTrajectory( dynamic_cast<SegmentSet*>(dataFile),
+                                                     at->getAttributeGEOEASgivenIndex()-1 ) )
+                Application::instance()->logWarn("Util::computeFaciesTransitionMatrix(): " + dataFile->getName() + "/" +
+                                                  at->getName() + " does not have the same category definition as " +
+                                                  categoricalAttributes.front()->getName() + ".  It will be ignored.");
         } else {
             Application::instance()->logError("Util::computeFaciesTransitionMatrix(): Data files of type " +
                                                dataFile->getFileType()+ " not currently supported.  Transiogram calculation will be incomplete or not done at all.", true);
         }
     }
 
+    //count the facies transitions for all separations h
+    Application::instance()->logInfo("   counting facies transitions for " + QString::number( separations.size() ) + " separations...");
+    QApplication::processEvents();
+    std::vector< std::vector< long long > > counts = transiographyEngine.computeCounts( separations, toleranceCoefficient );
+
+    //add the counts to the global FTM of each separation h
+    int nCategories = CDofFirst->getCategoryCount();
+    for( size_t iSeparation = 0; iSeparation < hFTMs.size(); ++iSeparation ){
+        FaciesTransitionMatrix& ftm = hFTMs[iSeparation].second;
+        for( int i = 0; i < nCategories; ++i )
+            for( int j = 0; j < nCategories; ++j ){
+                long long count = counts[iSeparation][ i * nCategories + j ];
+                if( count )
+                    ftm.addCount( i, j, count );
+            }
+    }
+
     return hFTMs;
 }
 
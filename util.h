@@ -472,14 +472,9 @@ public:
 
     /** Computes FFT (forward or reverse) for a vector of values.  The result will be
      * stored in the input array.
-     *  This is a C++ port from the original Fortran implementation by Jon Claerbout
-     * (1985).
+     *  The transform is computed by spectral::FFTService (FFTW), so lx can be any size.
+     *  Both transforms are scaled by 1/sqrt(lx), so a back-transform yields the original values.
      *  @note The array elements are OVERWRITTEN during computation.
-     *  @note This is a WIP.  Not currently working accurately, probably by something
-     * misinterpreted from the
-     *        Fortran code.  Help with this will be much appreciated.  Original Fortran
-     * code is in the .cpp.
-     *        function body as a series of comments.
      *  @param lx Number of elements in values array.
      *  @param cx Input/output vector of values (complex numbers).
      *  @param startingElement Position in cx considered as 1st element (pass zero if the
@@ -490,25 +485,19 @@ public:
                       FFTComputationMode isig);
 
     /**
-     *  Slight modification to use the more portable STL's complex type and be called from
-     * an FFT 2D routine
-     *  from the modification of Paul Bourkes FFT code by Peter Cusack
-     *  to utilise the Microsoft complex type.
-     *
-     *  This computes an in-place complex-to-complex FFT
-     *  dir =  1 gives forward transform
-     *  dir = -1 gives reverse transform
+     *  Computes an in-place complex-to-complex FFT of 2^m elements starting at startingElement.
+     *  dir =  1 gives forward transform (scaled by 1/2^m)
+     *  dir = -1 gives reverse transform (not scaled)
      *
      *  @param m log2(number of cells). Number of cells should be 4, 16, 64, etc...
-     *  @note WIP: This function is not compatible with fft2D().
      */
     static void fft1DPPP(int dir, long m, std::vector<std::complex<double>> &x,
                          long startingElement);
 
     /** Computes 2D FFT (forward or reverse) for an array of values.  The result will be
      * stored in the input array.
-     *  This is a C++ port from the original Fortran implementation by M.Pirttijärvi
-     * (2003).
+     *  The transform is computed by spectral::FFTService (FFTW), so n1 and n2 can be any size.
+     *  Both transforms are scaled by 1/sqrt(n1*n2), so a back-transform yields the original values.
      *  @note The array elements are OVERWRITTEN during computation.
      *  @note The array should be created by making a[nI*nJ*nK] and not a[nI][nJ][nK] to
      * preserve memory locality (maximize cache hits)
@@ -538,6 +527,9 @@ public:
 
     /** Computes 3D FFT (forward or reverse) for an array of values.  The result will be
      * stored in the input array.
+     *  The transform is computed by spectral::FFTService (FFTW), so the grid dimensions can be any size.
+     *  In forward mode, the zero-frequency component is shifted to the center of the grid.  The reverse
+     *  transform expects the same layout and is normalized (scaled by 1/(nI*nJ*nK)).
      *  @note The array elements are OVERWRITTEN during computation.
      *  @note The array should be created by making a[nI*nJ*nK] and not a[nI][nJ][nK] to
      * preserve memory locality (maximize cache hits)
@@ -553,6 +545,19 @@ public:
                       FFTComputationMode isig,
                       FFTImageType itype = FFTImageType::RECTANGULAR_FORM);
 
+    /** Computes the forward 3D FFT of an array of real values (e.g. a variable of a Cartesian grid).
+     *  This is faster and uses much less memory than the complex fft3D(), since FFTW's real-to-complex
+     *  transform computes only half of the spectrum (the other half is its complex conjugate).
+     *  The result is the same as that of the complex fft3D() in DIRECT mode.
+     *  @param realValues Input array of values with nI*nJ*nK elements.
+     *  @param result Output array of values (complex numbers) with the spectrum.  It is resized to nI*nJ*nK.
+     *  @param itype Image type.  Either direct real and imaginary components or the
+     * complex numbers are in polar form (magnitude and angle).
+     */
+    static void fft3D(int nI, int nJ, int nK, const std::vector<double> &realValues,
+                      std::vector<std::complex<double>> &result,
+                      FFTImageType itype = FFTImageType::RECTANGULAR_FORM);
+
     /** Compute the dip angle corresponding to grid steps.
      * the d* parameters are the grid cell sizes.
      * The returned angle is in degrees and follow the GSLib convention.
@@ -634,12 +639,15 @@ public:
      * Computes the varmap using the FFT method for fast result.
      * It is based on the the Fourier Integral Method (Pardo-Iguzquiza & Chica-Olmo, 1993).
      * Review results if the cells are not squares/cubes.
+     * Besides the result, only one complex array with half of the spectrum is allocated.
      */
     static spectral::array getVarmapFIM( const spectral::array& inputData );
 
     /**
      * Computes the varmap using the spectral::autocovariance() method for fast result.
      * Review results if the cells are not squares/cubes.
+     * The transforms and intermediate arrays are reduced to the minimum needed for the autocovariance
+     * (the data are zero-padded to twice their size in each direction, though).
      */
     static spectral::array getVarmapSpectral( const spectral::array& inputData );
 
@@ -8,6 +8,8 @@
 #include "domain/segmentset.h"
 #include "view3dcolortables.h"
 #include "view3dwidget.h"
+#include "view3dgridpyramid.h"
+#include "view3dgeometrycache.h"
 
 #include <vtkSmartPointer.h>
 #include <vtkActor.h>
@@ -38,7 +40,12 @@
 #include <vtkDecimatePro.h>
 #include <vtkTriangleFilter.h>
 #include <vtkFloatArray.h>
+#include <vtkIntArray.h>
 #include <vtkExtractGrid.h>
+#include <vtkExtractVOI.h>
+#include <vtkImageData.h>
+#include <vtkRectilinearGrid.h>
+#include <vtkUnsignedCharArray.h>
 #include <vtkLODProp3D.h>
 #include <vtkRenderer.h>
 #include <vtkCallbackCommand.h>
@@ -52,6 +59,8 @@
 
 #include <QMessageBox>
 #include <QPushButton>
+#include <algorithm>
+#include <limits>
 
 
 void RefreshCallback( vtkObject* vtkNotUsed(caller),
@@ -521,59 +530,45 @@ View3DViewData View3DBuilders::buildForAttributeInMapCartesianGridWithVtkStructu
     values->SetName("values");
 
     //read sample values
-    values->Allocate( nX*nY );
+    values->SetNumberOfValues( nX*nY );
     for( int i = 0; i < nX*nY; ++i){
         // sample value
         double value = cartesianGrid->data( i, var_index - 1 );
-        values->InsertNextValue( value );
+        values->SetValue( i, value );
     }
 
     //we don't need file's data anymore
     cartesianGrid->freeLoadedData();
 
     // set up a transform to apply the rotation about the grid origin (location of the first data point)
+    //the rotation is applied by the actor, so the grid geometry remains implicit
     vtkSmartPointer<vtkTransform> xform = vtkSmartPointer<vtkTransform>::New();
     xform->Translate( X0, Y0, 0);
     xform->RotateZ( -azimuth );
     xform->Translate( -X0, -Y0, 0);
 
-    // Create a grid (corner-point, explicit geometry)
+    // Create a grid (implicit geometry: origin and cell sizes)
     //  As GSLib grids are cell-centered, then we must add an extra point in each direction
-    vtkSmartPointer<vtkStructuredGrid> structuredGrid =
-            vtkSmartPointer<vtkStructuredGrid>::New();
-    vtkSmartPointer<vtkPoints> points =
-            vtkSmartPointer<vtkPoints>::New();
-    for(int k = 0; k <= 1; ++k)
-        for(int j = 0; j <= nY; ++j)
-            for(int i = 0; i <= nX; ++i)
-                points->InsertNextPoint( X0frame + i * dX,
-                                         Y0frame + j * dY,
-                                         0 + k * 1 );
-    structuredGrid->SetDimensions( nX+1, nY+1, 1 );
-    structuredGrid->SetPoints(points);
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetOrigin( X0frame, Y0frame, 0.0 );
+    imageData->SetSpacing( dX, dY, 1.0 );
+    imageData->SetDimensions( nX+1, nY+1, 1 );
 
     //assign the grid values to the grid cells
-    structuredGrid->GetCellData()->SetScalars( values );
-
-    //apply the transform (rotation) to the grid
-    vtkSmartPointer<vtkTransformFilter> transformFilter =
-            vtkSmartPointer<vtkTransformFilter>::New();
-    transformFilter->SetInputData( structuredGrid );
-    transformFilter->SetTransform(xform);
-    transformFilter->Update();
+    imageData->GetCellData()->SetScalars( values );
 
     //apply several grid downscaling to enable level-of-detail
-    vtkSmartPointer<vtkExtractGrid> sg1 = vtkSmartPointer<vtkExtractGrid>::New();
-    sg1->SetInputConnection( transformFilter->GetOutputPort()  );
+    vtkSmartPointer<vtkExtractVOI> sg1 = vtkSmartPointer<vtkExtractVOI>::New();
+    sg1->SetInputData( imageData );
     sg1->SetSampleRate(50,50,1);
-    vtkSmartPointer<vtkExtractGrid> sg2 = vtkSmartPointer<vtkExtractGrid>::New();
-    sg2->SetInputConnection( transformFilter->GetOutputPort()  );
+    vtkSmartPointer<vtkExtractVOI> sg2 = vtkSmartPointer<vtkExtractVOI>::New();
+    sg2->SetInputData( imageData );
     sg2->SetSampleRate(25,25,1);
-    vtkSmartPointer<vtkExtractGrid> sg3 = vtkSmartPointer<vtkExtractGrid>::New();
-    sg3->SetInputConnection( transformFilter->GetOutputPort()  );
+    vtkSmartPointer<vtkExtractVOI> sg3 = vtkSmartPointer<vtkExtractVOI>::New();
+    sg3->SetInputData( imageData );
     sg3->SetSampleRate(10,10,1);
-    vtkSmartPointer<vtkExtractGrid> sg4 = vtkSmartPointer<vtkExtractGrid>::New();
-    sg4->SetInputConnection( transformFilter->GetOutputPort()  );
+    vtkSmartPointer<vtkExtractVOI> sg4 = vtkSmartPointer<vtkExtractVOI>::New();
+    sg4->SetInputData( imageData );
     sg4->SetSampleRate(2,2,1);
 
     //assign a color table
@@ -605,6 +600,7 @@ View3DViewData View3DBuilders::buildForAttributeInMapCartesianGridWithVtkStructu
     //rendering performances
     vtkSmartPointer<vtkLODProp3D> propLOD = vtkSmartPointer<vtkLODProp3D>::New();
     propLOD->AutomaticLODSelectionOn();
+    propLOD->SetUserTransform( xform );
     propLOD->SetLODLevel( propLOD->AddLOD(m1, 1e-12), 4.0 );
     propLOD->SetLODLevel( propLOD->AddLOD(m2, 1e-9), 3.0 );
     propLOD->SetLODLevel( propLOD->AddLOD(m3, 1e-6), 2.0 );
@@ -654,59 +650,47 @@ View3DViewData View3DBuilders::buildForAttributeInMapCartesianGridWithVtkStructu
     vtkSmartPointer<vtkFloatArray> values = vtkSmartPointer<vtkFloatArray>::New();
     values->SetName("values");
 
-    //create a visibility array. Cells with visibility >= 1 will be
-    //visible, and < 1 will be invisible.
-    vtkSmartPointer<vtkIntArray> visibility = vtkSmartPointer<vtkIntArray>::New();
-    visibility->SetNumberOfComponents(1);
-    visibility->SetName("Visibility");
+    //create a ghost array to blank the cells with no-data values (a much lighter
+    //alternative to a visibility array followed by a vtkThreshold).
+    vtkSmartPointer<vtkUnsignedCharArray> ghosts = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    ghosts->SetName( vtkDataSetAttributes::GhostArrayName() );
 
     //read sample values and cell visibility flags
-    values->Allocate( nX*nY );
-    visibility->Allocate( nX*nY );
+    //the data table is stored by rows, so the values cannot be wrapped without a copy
+    values->SetNumberOfValues( nX*nY );
+    ghosts->SetNumberOfValues( nX*nY );
+    float* valuesPointer = values->GetPointer( 0 );
+    unsigned char* ghostsPointer = ghosts->GetPointer( 0 );
     for( int i = 0; i < nX*nY; ++i){
         // sample value
         double value = cartesianGrid->data( i, var_index - 1 );
-        values->InsertNextValue( value );
+        valuesPointer[i] = value;
         // visibility flag
         if( cartesianGrid->isNDV( value ) )
-            visibility->InsertNextValue( (int)InvisibiltyFlag::INVISIBLE_NDV_VALUE );
+            ghostsPointer[i] = vtkDataSetAttributes::HIDDENCELL;
         else
-            visibility->InsertNextValue( (int)InvisibiltyFlag::VISIBLE );
+            ghostsPointer[i] = 0;
     }
 
     //we don't need file's data anymore
     cartesianGrid->freeLoadedData();
 
     // set up a transform to apply the rotation about the grid origin (location of the first data point)
+    //the rotation is applied by the actor, so the grid geometry remains implicit
     vtkSmartPointer<vtkTransform> xform = vtkSmartPointer<vtkTransform>::New();
     xform->Translate( X0, Y0, 0);
     xform->RotateZ( -azimuth );
     xform->Translate( -X0, -Y0, 0);
 
-    // Create a grid (corner-point, explicit geometry)
+    // Create a grid (implicit geometry: origin and cell sizes)
     //  As GSLib grids are cell-centered, then we must add an extra point in each direction
-    vtkSmartPointer<vtkStructuredGrid> structuredGrid =
-            vtkSmartPointer<vtkStructuredGrid>::New();
-    vtkSmartPointer<vtkPoints> points =
-            vtkSmartPointer<vtkPoints>::New();
-    for(int k = 0; k <= 1; ++k)
-        for(int j = 0; j <= nY; ++j)
-            for(int i = 0; i <= nX; ++i)
-                points->InsertNextPoint( X0frame + i * dX,
-                                         Y0frame + j * dY,
-                                         0 + k * 1 );
-    structuredGrid->SetDimensions( nX+1, nY+1, 1 );
-    structuredGrid->SetPoints(points);
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetOrigin( X0frame, Y0frame, 0.0 );
+    imageData->SetSpacing( dX, dY, 1.0 );
+    imageData->SetDimensions( nX+1, nY+1, 1 );
     //assign the grid values to the grid cells
-    structuredGrid->GetCellData()->SetScalars( values );
-    structuredGrid->GetCellData()->AddArray( visibility );
-
-    //apply the transform (rotation) to the grid
-    vtkSmartPointer<vtkTransformFilter> transformFilter =
-            vtkSmartPointer<vtkTransformFilter>::New();
-    transformFilter->SetInputData( structuredGrid );
-    transformFilter->SetTransform(xform);
-    transformFilter->Update();
+    imageData->GetCellData()->SetScalars( values );
+    imageData->GetCellData()->AddArray( ghosts );
 
     //try a sampling rate to keep the number of elements below the threshold
     int srate = 1;
@@ -724,17 +708,11 @@ View3DViewData View3DBuilders::buildForAttributeInMapCartesianGridWithVtkStructu
     }
 
     //apply grid downscaling (if necessary)
-    vtkSmartPointer<vtkExtractGrid> sg = vtkSmartPointer<vtkExtractGrid>::New();
-    sg->SetInputConnection( transformFilter->GetOutputPort()  );
-    sg->SetSampleRate(srate, srate, srate);
-    sg->Update();
-
-    // threshold to make unvalued cells invisible
-    vtkSmartPointer<vtkThreshold> threshold = vtkSmartPointer<vtkThreshold>::New();
-    threshold->SetInputData(sg->GetOutput());
-    threshold->ThresholdByUpper(1); // Criterion is cells whose scalars are greater or equal to threshold.
-    threshold->SetInputArrayToProcess(0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_CELLS, "Visibility");
-    threshold->Update();
+    vtkSmartPointer<vtkExtractVOI> voiExtractor = vtkSmartPointer<vtkExtractVOI>::New();
+    voiExtractor->SetInputData( imageData );
+    voiExtractor->SetVOI( 0, nX, 0, nY, 0, 0 );
+    voiExtractor->SetSampleRate(srate, srate, 1);
+    voiExtractor->Update();
 
     //create a color table according to variable type (continuous or categorical)
     vtkSmartPointer<vtkLookupTable> lut;
@@ -745,7 +723,7 @@ View3DViewData View3DBuilders::buildForAttributeInMapCartesianGridWithVtkStructu
 
     // Create mappers (visualization parameters) for each level-of-detail
     vtkSmartPointer<vtkDataSetMapper> mapper = vtkSmartPointer<vtkDataSetMapper>::New();
-    mapper->SetInputConnection( threshold->GetOutputPort() );
+    mapper->SetInputConnection( voiExtractor->GetOutputPort() );
     mapper->SetLookupTable(lut);
     mapper->SetScalarRange(min, max);
     mapper->Update();
@@ -753,10 +731,15 @@ View3DViewData View3DBuilders::buildForAttributeInMapCartesianGridWithVtkStructu
     //create a VTK actor
     vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
     actor->SetMapper( mapper );
+    actor->SetUserTransform( xform );
 
     // Finally, return the actor along with other visual objects
     // so the user can make adjustments to rendering.
-    return View3DViewData(actor, sg, mapper, threshold);
+    View3DViewData viewData( actor );
+    viewData.voiExtractor = voiExtractor;
+    viewData.mapper = mapper;
+    viewData.samplingRate = srate;
+    return viewData;
 }
 
 View3DViewData View3DBuilders::buildFor3DCartesianGrid(CartesianGrid *cartesianGrid, View3DWidget */*widget3D*/)
@@ -777,44 +760,29 @@ View3DViewData View3DBuilders::buildFor3DCartesianGrid(CartesianGrid *cartesianG
     double Z0frame = Z0 - dZ/2.0;
 
     // set up a transform to apply the rotation about the grid origin (location of the first data point)
+    //the rotation is applied by the actor, so the grid geometry remains implicit
     vtkSmartPointer<vtkTransform> xform = vtkSmartPointer<vtkTransform>::New();
     xform->Translate( X0, Y0, Z0);
     xform->RotateZ( -azimuth );
     xform->Translate( -X0, -Y0, -Z0);
 
-    // Create a grid (corner-point, explicit geometry)
+    // Create a grid (implicit geometry: origin and cell sizes)
     //  As GSLib grids are cell-centered, then we must add an extra point in each direction
-    vtkSmartPointer<vtkStructuredGrid> structuredGrid =
-            vtkSmartPointer<vtkStructuredGrid>::New();
-    vtkSmartPointer<vtkPoints> points =
-            vtkSmartPointer<vtkPoints>::New();
-    for(int k = 0; k <= nZ; ++k)
-        for(int j = 0; j <= nY; ++j)
-            for(int i = 0; i <= nX; ++i)
-                //the ( d* + d*/n* ) is to account for the extra cells in each direction due
-                //due to cell-centered-to-corner-point conversion
-                points->InsertNextPoint( X0frame + i * ( dX + dX/nX ),
-                                         Y0frame + j * ( dY + dY/nY ),
-                                         Z0frame + k * ( dZ + dZ/nZ ) );
-    structuredGrid->SetDimensions( nX+1, nY+1, nZ+1 );
-    structuredGrid->SetPoints(points);
-
-    //apply the transform (rotation) to the grid
-    vtkSmartPointer<vtkTransformFilter> transformFilter =
-            vtkSmartPointer<vtkTransformFilter>::New();
-    transformFilter->SetInputData( structuredGrid );
-    transformFilter->SetTransform(xform);
-    transformFilter->Update();
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetOrigin( X0frame, Y0frame, Z0frame );
+    imageData->SetSpacing( dX, dY, dZ );
+    imageData->SetDimensions( nX+1, nY+1, nZ+1 );
 
     // Create mapper (visualization parameters)
     vtkSmartPointer<vtkDataSetMapper> mapper =
             vtkSmartPointer<vtkDataSetMapper>::New();
-    mapper->SetInputConnection(transformFilter->GetOutputPort());
+    mapper->SetInputData( imageData );
 
     // Finally, create and return the actor
     vtkSmartPointer<vtkActor> actor =
             vtkSmartPointer<vtkActor>::New();
     actor->SetMapper(mapper);
+    actor->SetUserTransform( xform );
 
     // Show grid geometry as a wireframe
     actor->GetProperty()->EdgeVisibilityOn();
@@ -826,6 +794,83 @@ View3DViewData View3DBuilders::buildFor3DCartesianGrid(CartesianGrid *cartesianG
 View3DViewData View3DBuilders::buildForAttribute3DCartesianGridWithIJKClipping(CartesianGrid *cartesianGrid,
                                                                                Attribute *attribute,
                                                                                View3DWidget */*widget3D*/)
+{
+    //prepare the level-of-detail pyramid: View3DBuildService opens it in background (building the cache from
+    //the grid data if it is missing or outdated), then displays a coarse proxy and refines it.
+    std::shared_ptr<View3DGridPyramid> gridPyramid( new View3DGridPyramid( cartesianGrid, attribute ) );
+    if( ! gridPyramid->canOpen() ){
+        Application::instance()->logWarn("View3DBuilders::buildForAttribute3DCartesianGridWithIJKClipping: cannot write the level-of-detail cache ("
+                                         + gridPyramid->getCacheFilePath() + ").  Displaying a decimated grid instead.");
+        return buildForAttribute3DCartesianGridDecimated( cartesianGrid, attribute );
+    }
+
+    //get grid geometric parameters (loading data is not necessary)
+    int nX = cartesianGrid->getNX();
+    int nY = cartesianGrid->getNY();
+    int nZ = cartesianGrid->getNZ();
+    double X0 = cartesianGrid->getX0();
+    double Y0 = cartesianGrid->getY0();
+    double Z0 = cartesianGrid->getZ0();
+    double azimuth = cartesianGrid->getRot();
+
+    //the finest level of detail that keeps the number of elements below the threshold
+    int maxcells = Application::instance()->getMaxGridCellCountFor3DVisualizationSetting();
+    int level = gridPyramid->getFinestLevelFor( 0, nX, 0, nY, 0, nZ, maxcells );
+
+    //the level of the coarse proxy (about one brick) that is displayed first
+    int proxyLevel = gridPyramid->getFinestLevelFor( 0, nX, 0, nY, 0, nZ,
+                                   std::min<qint64>( maxcells, (qint64)View3DGridPyramid::BRICK_SIZE *
+                                                                       View3DGridPyramid::BRICK_SIZE *
+                                                                       View3DGridPyramid::BRICK_SIZE ) );
+
+    //warn user if the level of detail is less than maximum detail
+    if( level > 0 ){
+        QString message("Grid with too many cells (");
+        message += QString::number( (qint64)nX*nY*nZ ) +
+                " > " + QString::number(maxcells) + " ).  Displaying level of detail " +
+                QString::number(level) + " (0 = max. detail).  Clip the grid to see finer levels.";
+        Application::instance()->logWarn("View3DBuilders::buildForAttribute3DCartesianGridWithIJKClipping: " + message);
+    }
+
+    // set up a transform to apply the rotation about the grid origin (location of the first data point)
+    //the rotation is applied by the actor, so the grid geometry remains implicit
+    vtkSmartPointer<vtkTransform> xform = vtkSmartPointer<vtkTransform>::New();
+    xform->Translate( X0, Y0, Z0);
+    xform->RotateZ( -azimuth );
+    xform->Translate( -X0, -Y0, -Z0);
+
+    //create a color table according to variable type (continuous or categorical)
+    //the scalar range is set once the pyramid is open (see View3DBuildService::onLevelReady())
+    vtkSmartPointer<vtkLookupTable> lut;
+    if( attribute->isCategorical() )
+        lut = View3dColorTables::getCategoricalColorTable( cartesianGrid->getCategoryDefinition( attribute ), false );
+    else
+        lut = View3dColorTables::getColorTable( ColorTable::RAINBOW, 0.0, 1.0 );
+
+    // Create mapper (visualization parameters)
+    //the cells without valid values are blanked in the grid, so no threshold filter is needed
+    //the mapper shows an empty grid until View3DBuildService hands the proxy over to it
+    vtkSmartPointer<vtkDataSetMapper> mapper =
+            vtkSmartPointer<vtkDataSetMapper>::New();
+    mapper->SetInputData( vtkSmartPointer<vtkRectilinearGrid>::New() );
+    mapper->SetLookupTable(lut);
+
+    // Finally, pass everything to the actor and return it.
+    vtkSmartPointer<vtkActor> actor =
+            vtkSmartPointer<vtkActor>::New();
+    actor->SetMapper(mapper);
+    actor->SetUserTransform( xform );
+    //actor->GetProperty()->EdgeVisibilityOn();
+    View3DViewData viewData( actor );
+    viewData.mapper = mapper;
+    viewData.samplingRate = 1 << proxyLevel;
+    //the configuration widget uses the pyramid to load the clipped region (see View3DGridPyramid::makeGrid()).
+    viewData.gridPyramid = gridPyramid;
+    return viewData;
+}
+
+View3DViewData View3DBuilders::buildForAttribute3DCartesianGridDecimated(CartesianGrid *cartesianGrid,
+                                                                        Attribute *attribute)
 {
     //load grid data
     cartesianGrid->loadData();
@@ -837,7 +882,7 @@ View3DViewData View3DBuilders::buildForAttribute3DCartesianGridWithIJKClipping(C
     double min = cartesianGrid->min( var_index-1 );
     double max = cartesianGrid->max( var_index-1 );
 
-    //get grid geometric parameters (loading data is not necessary)
+    //get grid geometric parameters
     int nX = cartesianGrid->getNX();
     int nY = cartesianGrid->getNY();
     int nZ = cartesianGrid->getNZ();
@@ -863,36 +908,35 @@ View3DViewData View3DBuilders::buildForAttribute3DCartesianGridWithIJKClipping(C
     visibility->SetName("Visibility");
 
     //try a sampling rate to keep the number of elements below the threshold
-    int srate = 1;
-    int maxcells = Application::instance()->getMaxGridCellCountFor3DVisualizationSetting();
-    for( ; (nX*nY*nZ) / (srate*srate*srate) >  maxcells; ++srate);
+    qint64 srate = 1;
+    qint64 maxcells = Application::instance()->getMaxGridCellCountFor3DVisualizationSetting();
+    for( ; ((qint64)nX*nY*nZ) / (srate*srate*srate) >  maxcells; ++srate);
 
     //warn user if sampling rate is less than maximum detail
     if( srate > 1){
         QString message("Grid with too many cells (");
-        message += QString::number(nX*nY*nZ) +
+        message += QString::number( (qint64)nX*nY*nZ ) +
                 " > " + QString::number(maxcells) + " ).  Sampling rate set to " +
                 QString::number(srate) + " (1 = max. detail)";
-        QMessageBox::warning( nullptr, "Warning", message);
-        Application::instance()->logWarn("View3DBuilders::buildForAttribute3DCartesianGridWithIJKClipping: " + message);
+        Application::instance()->logWarn("View3DBuilders::buildForAttribute3DCartesianGridDecimated: " + message);
     }
 
     //set sub-sampled grid dimensions
-    int nXsub = nX / srate;
-    int nYsub = nY / srate;
-    int nZsub = nZ / srate;
+    int nXsub = std::max<int>( 1, nX / srate );
+    int nYsub = std::max<int>( 1, nY / srate );
+    int nZsub = std::max<int>( 1, nZ / srate );
 
     //read sample values
-    values->Allocate( nXsub*nYsub*nZsub );
-    visibility->Allocate( nXsub*nYsub*nZsub );
+    values->Allocate( (qint64)nXsub*nYsub*nZsub );
+    visibility->Allocate( (qint64)nXsub*nYsub*nZsub );
     for( int k = 0; k < nZsub; ++k){
         for( int j = 0; j < nYsub; ++j){
             for( int i = 0; i < nXsub; ++i){
                 // sample value
                 double value = cartesianGrid->dataIJK( var_index - 1,
-                                                       std::min(i*srate, nX-1),
-                                                       std::min(j*srate, nY-1),
-                                                       std::min(k*srate, nZ-1) );
+                                                       std::min<int>(i*srate, nX-1),
+                                                       std::min<int>(j*srate, nY-1),
+                                                       std::min<int>(k*srate, nZ-1) );
                 values->InsertNextValue( value );
                 // visibility flag
                 if( cartesianGrid->isNDV( value ) )
@@ -945,12 +989,11 @@ View3DViewData View3DBuilders::buildForAttribute3DCartesianGridWithIJKClipping(C
             vtkSmartPointer<vtkExtractGrid>::New();
     subGrid->SetInputConnection( transformFilter->GetOutputPort()  );
     subGrid->SetVOI( 0, nXsub, 0, nYsub, 0, nZsub );
-    subGrid->SetSampleRate(srate, srate, srate);
     subGrid->Update();
 
     // threshold to make unvalued cells invisible
     vtkSmartPointer<vtkThreshold> threshold = vtkSmartPointer<vtkThreshold>::New();
-    threshold->SetInputData(subGrid->GetOutput());
+    threshold->SetInputConnection( subGrid->GetOutputPort() );
     threshold->ThresholdByUpper(1); // Criterion is cells whose scalars are greater or equal to threshold.
     threshold->SetInputArrayToProcess(0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_CELLS, "Visibility");
     threshold->Update();
@@ -971,45 +1014,20 @@ View3DViewData View3DBuilders::buildForAttribute3DCartesianGridWithIJKClipping(C
     mapper->Update();
 
     // Finally, pass everything to the actor and return it.
+    //without a grid pyramid, the configuration widget clips the grid with the subgrider.
     vtkSmartPointer<vtkActor> actor =
             vtkSmartPointer<vtkActor>::New();
     actor->SetMapper(mapper);
-    //actor->GetProperty()->EdgeVisibilityOn();
-	return View3DViewData(actor, subGrid, mapper, threshold, srate);
+    return View3DViewData(actor, subGrid, mapper, threshold, srate);
 }
 
 View3DViewData View3DBuilders::buildForGeoGridMesh( GeoGrid * geoGrid, View3DWidget * widget3D )
 {
 	Q_UNUSED( widget3D );
 
-	// Create a VTK container with the points (mesh vertexes)
-	vtkSmartPointer< vtkPoints > hexaPoints = vtkSmartPointer< vtkPoints >::New();
-	hexaPoints->SetNumberOfPoints( geoGrid->getMeshNumberOfVertexes() );
-	for( int i = 0;  i < hexaPoints->GetNumberOfPoints(); ++i ){
-		double x, y, z;
-		geoGrid->getMeshVertexLocation( i, x, y, z );
-		hexaPoints->InsertPoint(i, x, y, z);
-	}
-
-	// Create a VTK unstructured grid object (allows faults, erosions, and other geologic discordances )
-	vtkSmartPointer<vtkUnstructuredGrid> unstructuredGrid = vtkSmartPointer<vtkUnstructuredGrid>::New();
-	uint nCells = geoGrid->getMeshNumberOfCells();
-	unstructuredGrid->Allocate( nCells );
-    vtkSmartPointer< vtkHexahedron > hexa = vtkSmartPointer< vtkHexahedron >::New();
-    for( uint i = 0; i < nCells; ++i ) {
-		uint vIds[8];
-		geoGrid->getMeshCellDefinition( i, vIds );
-		hexa->GetPointIds()->SetId(0, vIds[0]);
-		hexa->GetPointIds()->SetId(1, vIds[1]);
-		hexa->GetPointIds()->SetId(2, vIds[2]);
-		hexa->GetPointIds()->SetId(3, vIds[3]);
-		hexa->GetPointIds()->SetId(4, vIds[4]);
-		hexa->GetPointIds()->SetId(5, vIds[5]);
-		hexa->GetPointIds()->SetId(6, vIds[6]);
-		hexa->GetPointIds()->SetId(7, vIds[7]);
-		unstructuredGrid->InsertNextCell(hexa->GetCellType(), hexa->GetPointIds());
-	}
-	unstructuredGrid->SetPoints(hexaPoints);
+	// Get a VTK unstructured grid object (allows faults, erosions, and other geologic discordances )
+	//the mesh is shared with the other objects of the same grid (see View3DGeometryCache)
+	vtkSmartPointer<vtkUnstructuredGrid> unstructuredGrid = View3DGeometryCache::getGeoGridGeometry( geoGrid );
 
 	// Create a mapper and actor
     vtkSmartPointer<vtkDataSetMapper> mapper =
@@ -1034,11 +1052,9 @@ View3DViewData View3DBuilders::buildForAttributeGeoGrid( GeoGrid * geoGrid, Attr
 	vtkSmartPointer<vtkFloatArray> values = vtkSmartPointer<vtkFloatArray>::New();
 	values->SetName("values");
 
-	//create a visibility array. Cells with visibility >= 1 will be
-	//visible, and < 1 will be invisible.
-	vtkSmartPointer<vtkIntArray> visibility = vtkSmartPointer<vtkIntArray>::New();
-	visibility->SetNumberOfComponents(1);
-	visibility->SetName("Visibility");
+	//create a ghost array to blank the cells with no-data values (see buildForAttributeInMapCartesianGridWithVtkStructuredGrid())
+	vtkSmartPointer<vtkUnsignedCharArray> ghosts = vtkSmartPointer<vtkUnsignedCharArray>::New();
+	ghosts->SetName( vtkDataSetAttributes::GhostArrayName() );
 
 	//get the max and min of the selected variable
 	geoGrid->loadData();
@@ -1050,63 +1066,36 @@ View3DViewData View3DBuilders::buildForAttributeGeoGrid( GeoGrid * geoGrid, Attr
 	uint nJ = geoGrid->getNJ();
 	uint nK = geoGrid->getNK();
 
-	//read sample values
-	values->Allocate( nI * nJ * nK );
-	visibility->Allocate( nI * nJ * nK );
+	//read sample values and cell visibility flags
+	//no-data values are stored as NaN so the IJK clipping of the configuration widget can tell them apart
+	//(see V3DCfgWidForAttributeIn3DCartesianGrid::onUserMadeChanges())
+	values->SetNumberOfValues( (vtkIdType)nI * nJ * nK );
+	ghosts->SetNumberOfValues( (vtkIdType)nI * nJ * nK );
+	vtkIdType cellIndex = 0;
 	for( int k = 0; k < nK; ++k){
 		for( int j = 0; j < nJ; ++j){
-			for( int i = 0; i < nI; ++i){
+			for( int i = 0; i < nI; ++i, ++cellIndex){
 				// sample value
 				double value = geoGrid->dataIJK( var_index - 1, i, j, k);
-				values->InsertNextValue( value );
 				// visibility flag
-				if( geoGrid->isNDV( value ) )
-                    visibility->InsertNextValue( (int)InvisibiltyFlag::INVISIBLE_NDV_VALUE );
-				else
-                    visibility->InsertNextValue( (int)InvisibiltyFlag::VISIBLE );
+				if( geoGrid->isNDV( value ) ){
+					values->SetValue( cellIndex, std::numeric_limits<float>::quiet_NaN() );
+					ghosts->SetValue( cellIndex, vtkDataSetAttributes::HIDDENCELL );
+				} else {
+					values->SetValue( cellIndex, value );
+					ghosts->SetValue( cellIndex, 0 );
+				}
 			}
 		}
 	}
 
-	// Create a VTK container with the points (mesh vertexes)
-	vtkSmartPointer< vtkPoints > hexaPoints = vtkSmartPointer< vtkPoints >::New();
-	hexaPoints->SetNumberOfPoints( geoGrid->getMeshNumberOfVertexes() );
-	for( int i = 0;  i < hexaPoints->GetNumberOfPoints(); ++i ){
-		double x, y, z;
-		geoGrid->getMeshVertexLocation( i, x, y, z );
-		hexaPoints->InsertPoint(i, x, y, z);
-	}
-
-	// Create a VTK unstructured grid object (allows faults, erosions, and other geologic discordances )
-	vtkSmartPointer<vtkUnstructuredGrid> unstructuredGrid = vtkSmartPointer<vtkUnstructuredGrid>::New();
-	uint nCells = geoGrid->getMeshNumberOfCells();
-	unstructuredGrid->Allocate( nCells );
-    vtkSmartPointer< vtkHexahedron > hexa = vtkSmartPointer< vtkHexahedron >::New();
-    for( uint i = 0; i < nCells; ++i ) {
-        uint vIds[8];
-        geoGrid->getMeshCellDefinition( i, vIds );
-        hexa->GetPointIds()->SetId(0, vIds[0]);
-        hexa->GetPointIds()->SetId(1, vIds[1]);
-        hexa->GetPointIds()->SetId(2, vIds[2]);
-        hexa->GetPointIds()->SetId(3, vIds[3]);
-        hexa->GetPointIds()->SetId(4, vIds[4]);
-        hexa->GetPointIds()->SetId(5, vIds[5]);
-        hexa->GetPointIds()->SetId(6, vIds[6]);
-        hexa->GetPointIds()->SetId(7, vIds[7]);
-        unstructuredGrid->InsertNextCell(hexa->GetCellType(), hexa->GetPointIds());
-	}
-    unstructuredGrid->SetPoints(hexaPoints);
+	// Get a VTK unstructured grid object (allows faults, erosions, and other geologic discordances )
+	//the mesh is shared with the other attributes of the grid, only the values differ (see View3DGeometryCache)
+	vtkSmartPointer<vtkUnstructuredGrid> unstructuredGrid = View3DGeometryCache::getGeoGridGeometry( geoGrid );
 
 	//assign the grid values to the grid cells
 	unstructuredGrid->GetCellData()->SetScalars( values );
-	unstructuredGrid->GetCellData()->AddArray( visibility );
-
-    // threshold to make unvalued cells invisible
-	vtkSmartPointer<vtkThreshold> threshold = vtkSmartPointer<vtkThreshold>::New();
-	threshold->SetInputData( unstructuredGrid );
-	threshold->ThresholdByUpper(1); // Criterion is cells whose scalars are greater or equal to threshold.
-	threshold->SetInputArrayToProcess(0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_CELLS, "Visibility");
-	threshold->Update();
+	unstructuredGrid->GetCellData()->AddArray( ghosts );
 
     //create a color table according to variable type (continuous or categorical)
     vtkSmartPointer<vtkLookupTable> lut;
@@ -1116,9 +1105,10 @@ View3DViewData View3DBuilders::buildForAttributeGeoGrid( GeoGrid * geoGrid, Attr
         lut = View3dColorTables::getColorTable( ColorTable::RAINBOW, min, max );
 
 	// Create mapper (visualization parameters)
+	//the cells without valid values are blanked in the grid, so no threshold filter is needed
 	vtkSmartPointer<vtkDataSetMapper> mapper =
 			vtkSmartPointer<vtkDataSetMapper>::New();
-	mapper->SetInputConnection( threshold->GetOutputPort() );
+	mapper->SetInputData( unstructuredGrid );
 	mapper->SetLookupTable(lut);
 	mapper->SetScalarRange(min, max);
 	mapper->Update();
@@ -1129,7 +1119,10 @@ View3DViewData View3DBuilders::buildForAttributeGeoGrid( GeoGrid * geoGrid, Attr
 	actor->SetMapper(mapper);
 	//actor->GetProperty()->EdgeVisibilityOn();
 
-    return View3DViewData( actor, mapper, threshold );
+    View3DViewData viewData( actor );
+    //the configuration widget clips the grid by blanking cells of the mapper's input.
+    viewData.mapper = mapper;
+    return viewData;
 }
 
 View3DViewData View3DBuilders::buildForSurfaceCartesianGrid2D(CartesianGrid *cartesianGrid,
@@ -92,6 +92,13 @@ private:
             Attribute* attribute,
             View3DWidget * widget3D);
 
+    /** Fallback of buildForAttribute3DCartesianGridWithIJKClipping() for when the level-of-detail
+     *  cache cannot be written: the grid is loaded and decimated in memory.
+     */
+    static View3DViewData buildForAttribute3DCartesianGridDecimated(
+            CartesianGrid* cartesianGrid,
+            Attribute* attribute );
+
 	/** Specific builder for GeoGrid mesh without property.	 */
 	static View3DViewData buildForGeoGridMesh( GeoGrid* geoGrid, View3DWidget * widget3D );
 
@@ -0,0 +1,125 @@
+#include "view3dbuildservice.h"
+#include "view3dgridpyramid.h"
+#include "domain/application.h"
+
+#include <vtkRectilinearGrid.h>
+#include <vtkDataSetMapper.h>
+
+#include <algorithm>
+
+/** The caches are built with their own threads and the levels are read from disk one at a time per object,
+ *  so a few threads suffice. */
+static const unsigned int NUMBER_OF_THREADS = 2;
+
+View3DBuildService::View3DBuildService(QObject *parent) :
+    QObject( parent ),
+    m_pool( NUMBER_OF_THREADS )
+{
+}
+
+View3DBuildService::~View3DBuildService()
+{
+    for( std::shared_ptr<Job>& job : m_jobs )
+        job->cancelled = true;
+    m_pool.wait( m_tasks );
+}
+
+void View3DBuildService::build(const View3DListRecord &object_info, const View3DViewData &viewData)
+{
+    cancel( object_info );
+
+    std::shared_ptr<View3DGridPyramid> gridPyramid = viewData.gridPyramid;
+    if( ! gridPyramid || ! viewData.mapper )
+        return;
+
+    //the level of the proxy set by the builder and the finest level allowed by the cell count limit
+    int proxyLevel = 0;
+    for( int rate = viewData.samplingRate; rate > 1; rate >>= 1 )
+        ++proxyLevel;
+    int nI = gridPyramid->getNI();
+    int nJ = gridPyramid->getNJ();
+    int nK = gridPyramid->getNK();
+    int targetLevel = std::min( proxyLevel, gridPyramid->getFinestLevelFor( 0, nI, 0, nJ, 0, nK,
+                              Application::instance()->getMaxGridCellCountFor3DVisualizationSetting() ) );
+
+    std::shared_ptr<Job> job( new Job() );
+    job->objectInfo = object_info;
+    job->viewData = viewData;
+    job->targetLevel = targetLevel;
+    job->cancelled = false;
+    job->isOpen = false;
+    m_jobs.insert( object_info, job );
+
+    //the pyramid is opened (its cache is built from the copied grid values if needed), then the levels are made
+    //from coarse to fine, each one is displayed as soon as it is ready
+    m_pool.submit( m_tasks, [this, job, gridPyramid, proxyLevel, targetLevel, nI, nJ, nK](){
+        if( ! gridPyramid->open( &job->cancelled ) ){
+            {
+                std::unique_lock<std::mutex> lock( m_mutexResults );
+                m_results.push_back( { job, -1, nullptr } );
+            }
+            QMetaObject::invokeMethod( this, "onLevelReady", Qt::QueuedConnection );
+            return;
+        }
+        for( int level = proxyLevel; level >= targetLevel && ! job->cancelled; --level ){
+            vtkSmartPointer<vtkRectilinearGrid> grid = gridPyramid->makeGrid( level, 0, nI, 0, nJ, 0, nK );
+            {
+                std::unique_lock<std::mutex> lock( m_mutexResults );
+                m_results.push_back( { job, level, grid } );
+            }
+            QMetaObject::invokeMethod( this, "onLevelReady", Qt::QueuedConnection );
+            if( ! grid )
+                break;
+        }
+    });
+}
+
+bool View3DBuildService::isOpening(const View3DListRecord &object_info) const
+{
+    return m_jobs.contains( object_info ) && ! m_jobs.value( object_info )->isOpen;
+}
+
+void View3DBuildService::cancel(const View3DListRecord &object_info)
+{
+    if( m_jobs.contains( object_info ) )
+        m_jobs.take( object_info )->cancelled = true;
+}
+
+void View3DBuildService::onLevelReady()
+{
+    std::vector<Result> results;
+    {
+        std::unique_lock<std::mutex> lock( m_mutexResults );
+        results.swap( m_results );
+    }
+    for( Result& result : results ){
+        std::shared_ptr<Job> job = result.job;
+        if( job->cancelled )
+            continue;
+        if( result.level < 0 ){
+            Application::instance()->logError( "View3DBuildService::onLevelReady(): failed to open the level-of-detail cache of " +
+                                               job->objectInfo.getDescription() + "." );
+            cancel( job->objectInfo );
+            continue;
+        }
+        if( ! result.grid ){
+            Application::instance()->logError( "View3DBuildService::onLevelReady(): failed to read level " +
+                                               QString::number( result.level ) + " of " +
+                                               job->objectInfo.getDescription() + "." );
+            cancel( job->objectInfo );
+            continue;
+        }
+        //the value range is known once the pyramid is open
+        if( ! job->isOpen ){
+            job->viewData.mapper->SetScalarRange( job->viewData.gridPyramid->getMin(),
+                                                  job->viewData.gridPyramid->getMax() );
+            job->isOpen = true;
+        }
+        //see View3DBuilders::buildForAttribute3DCartesianGridWithIJKClipping()
+        job->viewData.mapper->SetInputData( result.grid );
+        job->viewData.mapper->Update();
+        if( result.level == job->targetLevel )
+            m_jobs.remove( job->objectInfo );
+        emit refined( job->objectInfo, result.level );
+    }
+}
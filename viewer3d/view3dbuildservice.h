@@ -0,0 +1,91 @@
+#ifndef VIEW3DBUILDSERVICE_H
+#define VIEW3DBUILDSERVICE_H
+
+#include <QObject>
+#include <QMap>
+#include <vtkSmartPointer.h>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "view3dlistrecord.h"
+#include "view3dviewdata.h"
+#include "algorithms/workstealingpool.h"
+
+class vtkRectilinearGrid;
+
+/**
+ * The View3DBuildService class builds the display of 3D Cartesian grids in background.  The builders only prepare
+ * a grid's View3DGridPyramid in the GUI thread (copying the grid values if its cache must be built), then build()
+ * opens the pyramid in a worker thread, building its cache if needed, and makes the grids of its levels from a
+ * coarse proxy down to the finest level allowed by the cell count limit.  Neither step uses the domain objects,
+ * so the user can interact with the scene and the project meanwhile.  Each level is handed over to the mapper of
+ * the object in the GUI thread as soon as it is ready.  A build is cancelled (during the cache build or between
+ * levels) when the object is removed or reconfigured.
+ */
+class View3DBuildService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit View3DBuildService( QObject *parent = nullptr );
+
+    /** Cancels the pending builds and waits for the running ones to stop. */
+    ~View3DBuildService();
+
+    /**
+     * Starts building the display of an object in background (see View3DBuilders::
+     * buildForAttribute3DCartesianGridWithIJKClipping()).  Any previous build of the same object is cancelled.
+     * Nothing is done if the object has no grid pyramid.
+     */
+    void build( const View3DListRecord& object_info, const View3DViewData& viewData );
+
+    /** Returns whether the grid pyramid of an object is still being opened, that is, whether it must not be
+     *  used yet (e.g. by the configuration widget of the object). */
+    bool isOpening( const View3DListRecord& object_info ) const;
+
+    /** Cancels the build of an object, if any.  Levels not yet handed over to the mapper are discarded. */
+    void cancel( const View3DListRecord& object_info );
+
+signals:
+    /** Emitted (in the GUI thread) after a level of the object has been set to its mapper. */
+    void refined( const View3DListRecord object_info, int level );
+
+private slots:
+    /** Sets the levels made by the workers to the mappers. */
+    void onLevelReady();
+
+private:
+    /** A build in progress. */
+    struct Job{
+        View3DListRecord objectInfo;
+        View3DViewData viewData;
+        int targetLevel;
+        std::atomic<bool> cancelled;
+        //whether the pyramid is open (set in the GUI thread when the proxy is handed over)
+        bool isOpen;
+    };
+
+    /** A level made by a worker.  A null grid means that the level could not be read, or that the pyramid could
+     *  not be opened if the level is negative. */
+    struct Result{
+        std::shared_ptr<Job> job;
+        int level;
+        vtkSmartPointer<vtkRectilinearGrid> grid;
+    };
+
+    /** The builds in progress, indexed by object. */
+    QMap<View3DListRecord, std::shared_ptr<Job>> m_jobs;
+
+    /** The levels made by the workers not yet handed over to the GUI thread. */
+    std::mutex m_mutexResults;
+    std::vector<Result> m_results;
+
+    WorkStealingPool::TaskGroup m_tasks;
+
+    //the pool is the last member so it is destroyed (its threads joined) first.
+    WorkStealingPool m_pool;
+};
+
+#endif // VIEW3DBUILDSERVICE_H
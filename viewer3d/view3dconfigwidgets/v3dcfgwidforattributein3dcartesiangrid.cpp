@@ -3,18 +3,22 @@
 
 #include "domain/cartesiangrid.h"
 #include "domain/application.h"
-#include "../view3dbuilders.h" // for the InvisibilityFlag enum
+#include "../view3dgridpyramid.h"
 #include "util.h"
 #include <vtkAlgorithmOutput.h>
 #include <vtkInformation.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkExtractGrid.h>
+#include <vtkRectilinearGrid.h>
 #include <vtkUnstructuredGrid.h>
-#include <vtkIntArray.h>
-#include <vtkThreshold.h>
+#include <vtkFloatArray.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkDataSetAttributes.h>
 #include <vtkCellData.h>
 #include <vtkDataSetMapper.h>
 #include <vtkLookupTable.h>
+#include <algorithm>
+#include <cmath>
 
 V3DCfgWidForAttributeIn3DCartesianGrid::V3DCfgWidForAttributeIn3DCartesianGrid(GridFile *gridFile,
         Attribute */*attribute*/,
@@ -42,7 +46,9 @@ V3DCfgWidForAttributeIn3DCartesianGrid::V3DCfgWidForAttributeIn3DCartesianGrid(G
         nXsub = gridFile->getNI() / _viewObjects.samplingRate + 1;
         nYsub = gridFile->getNJ() / _viewObjects.samplingRate + 1;
         nZsub = gridFile->getNK() / _viewObjects.samplingRate + 1;
-        if( _viewObjects.samplingRate == 1 ){
+        //with a level-of-detail pyramid, the sliders are in full resolution (the clipped region is reloaded
+        //from the pyramid, see onUserMadeChanges())
+        if( _viewObjects.samplingRate == 1 || _viewObjects.gridPyramid ){
             nXsub = gridFile->getNI();
             nYsub = gridFile->getNJ();
             nZsub = gridFile->getNK();
@@ -151,81 +157,79 @@ void V3DCfgWidForAttributeIn3DCartesianGrid::onUserMadeChanges()
             ui->sldKHighClip->setValue( ui->sldKLowClip->value() );
     }
 
-    //tell whether the Attribute belongs to a GeoGrid but it is being displayed
-    //in a UVW (depositional space) Cartesian grid.
-    bool isAttributeInGeoGridButDisplayedInUVWCartesianGrid = false;
-    {
-        //if this cast fails, then the Attribute is being displayed in the GeoGrid's UVW Cartesian grid.
-        vtkSmartPointer<vtkUnstructuredGrid> unstructuredGrid =
-                dynamic_cast<vtkUnstructuredGrid*>(_viewObjects.threshold->GetInputDataObject(0,0));
-        if( ! unstructuredGrid )
-            isAttributeInGeoGridButDisplayedInUVWCartesianGrid = true;
-    }
-
-    if( m_gridFile &&  ( m_gridFile->isRegular() || isAttributeInGeoGridButDisplayedInUVWCartesianGrid ) ){
-        //Since we are in a V3DCfgWidForAttributeIn3DCartesianGrid (data cube with clipping)
-        //assumes a vtkStructuredGridClip and a vtkDataSetMapper exist in the View3DViewData object
-        vtkSmartPointer<vtkExtractGrid> subgrider = _viewObjects.subgrider;
-
-        //set the cliping planes
-        subgrider->SetVOI( ui->sldILowClip->value(),
-                           ui->sldIHighClip->value(),
-                           ui->sldJLowClip->value(),
-                           ui->sldJHighClip->value(),
-                           ui->sldKLowClip->value(),
-                           ui->sldKHighClip->value());
-        subgrider->Update();
-
-    } else if ( m_gridFile ) {
-        //Since it is an Attribute of a GeoGrid, get the corresponding VTK object.
-        vtkSmartPointer<vtkUnstructuredGrid> unstructuredGrid =
-                dynamic_cast<vtkUnstructuredGrid*>(_viewObjects.threshold->GetInputDataObject(0,0));
-        if( ! unstructuredGrid ){
-            Application::instance()->logError("V3DCfgWidForAttributeIn3DCartesianGrid::onUserMadeChanges(): unstructured grid not found. Check View3DBuilders::buildForAttributeGeoGrid().");
+    //tell whether the Attribute belongs to a GeoGrid displayed in its true geometry (XYZ).  In this case,
+    //the mapper is fed directly with the mesh (see View3DBuilders::buildForAttributeGeoGrid()), otherwise
+    //the Attribute is being displayed in a Cartesian grid (either stand-alone or the GeoGrid's UVW grid).
+    vtkUnstructuredGrid* unstructuredGrid = nullptr;
+    if( ! _viewObjects.gridPyramid && _viewObjects.subgrider->GetNumberOfInputConnections( 0 ) == 0 )
+        unstructuredGrid = vtkUnstructuredGrid::SafeDownCast( _viewObjects.mapper->GetInput() );
+
+    if( m_gridFile && _viewObjects.gridPyramid ){
+        //load the clipped region at the finest level of detail that fits the cell count limit
+        //(at least one cell is shown along each direction)
+        int i0 = std::min( ui->sldILowClip->value(), m_gridFile->getNI() - 1 );
+        int j0 = std::min( ui->sldJLowClip->value(), m_gridFile->getNJ() - 1 );
+        int k0 = std::min( ui->sldKLowClip->value(), m_gridFile->getNK() - 1 );
+        int i1 = std::max( ui->sldIHighClip->value(), i0 + 1 );
+        int j1 = std::max( ui->sldJHighClip->value(), j0 + 1 );
+        int k1 = std::max( ui->sldKHighClip->value(), k0 + 1 );
+        int level;
+        vtkSmartPointer<vtkRectilinearGrid> rectilinearGrid = _viewObjects.gridPyramid->makeGrid(
+                    i0, i1, j0, j1, k0, k1,
+                    Application::instance()->getMaxGridCellCountFor3DVisualizationSetting(),
+                    level );
+        if( ! rectilinearGrid )
             return;
-        }
-
-        //Get visibility array
-        vtkSmartPointer<vtkIntArray> visibilityArray =
-                dynamic_cast<vtkIntArray*>( unstructuredGrid->GetCellData()->GetArray( "Visibility" ) );
-        if( ! visibilityArray ){
-            Application::instance()->logError("V3DCfgWidForAttributeIn3DCartesianGrid::onUserMadeChanges(): visibility array not found. Check View3DBuilders::buildForAttributeGeoGrid().");
+        _viewObjects.samplingRate = 1 << level;
+        //see View3DBuilders::buildForAttribute3DCartesianGridWithIJKClipping()
+        _viewObjects.mapper->SetInputData( rectilinearGrid );
+        mapper->Update();
+
+    } else if( m_gridFile && unstructuredGrid ){
+        //get the values and ghost arrays
+        vtkFloatArray* valuesArray = vtkFloatArray::SafeDownCast( unstructuredGrid->GetCellData()->GetScalars() );
+        vtkUnsignedCharArray* ghostsArray = vtkUnsignedCharArray::SafeDownCast(
+                    unstructuredGrid->GetCellData()->GetArray( vtkDataSetAttributes::GhostArrayName() ) );
+        if( ! valuesArray || ! ghostsArray ){
+            Application::instance()->logError("V3DCfgWidForAttributeIn3DCartesianGrid::onUserMadeChanges(): ghost array not found. Check View3DBuilders::buildForAttributeGeoGrid().");
             return;
         }
 
-        //Set transparency values for those cells outside clippling limits
-        // convention:
-        // 1 = visible
-        // 0 = invisible due to null value
-        // -1 = invisible due to being outside IJK clipping limits
+        //blank the cells outside clippling limits and those with no-data values (stored as NaN)
         int nI = m_gridFile->getNI();
         int nJ = m_gridFile->getNJ();
         int nK = m_gridFile->getNK();
         for( int k = 0; k < nK; ++k )
             for( int j = 0; j < nJ; ++j )
                 for( int i = 0; i < nI; ++i ) {
-                    int cellIndex = k*nJ*nI + j*nI + i;
-                    InvisibiltyFlag currentFlag = (InvisibiltyFlag)
-                            ( visibilityArray->GetValue( cellIndex ) );
+                    vtkIdType cellIndex = (vtkIdType)k*nJ*nI + j*nI + i;
                     if( i >= ui->sldILowClip->value() &&
                         i <= ui->sldIHighClip->value() &&
                         j >= ui->sldJLowClip->value() &&
                         j <= ui->sldJHighClip->value() &&
                         k >= ui->sldKLowClip->value() &&
-                        k <=ui->sldKHighClip->value() ){
-                        if( currentFlag == InvisibiltyFlag::INVISIBLE_NDV_AND_UVW_CLIPPING )
-                            visibilityArray->SetValue( cellIndex, (int)InvisibiltyFlag::INVISIBLE_NDV_VALUE );
-                        else if( currentFlag == InvisibiltyFlag::INVISIBLE_UVW_CLIPPING )
-                            visibilityArray->SetValue( cellIndex, (int)InvisibiltyFlag::VISIBLE );
-                    } else {
-                        if( currentFlag == InvisibiltyFlag::VISIBLE )
-                            visibilityArray->SetValue( cellIndex, (int)InvisibiltyFlag::INVISIBLE_UVW_CLIPPING );
-                        else if( currentFlag == InvisibiltyFlag::INVISIBLE_NDV_VALUE )
-                            visibilityArray->SetValue( cellIndex, (int)InvisibiltyFlag::INVISIBLE_NDV_AND_UVW_CLIPPING );
-                    }
-
+                        k <=ui->sldKHighClip->value() &&
+                        ! std::isnan( valuesArray->GetValue( cellIndex ) ) )
+                        ghostsArray->SetValue( cellIndex, 0 );
+                    else
+                        ghostsArray->SetValue( cellIndex, vtkDataSetAttributes::HIDDENCELL );
                 }
-        unstructuredGrid->GetCellData()->Modified();
+        ghostsArray->Modified();
+        unstructuredGrid->Modified();
+
+    } else if( m_gridFile ){
+        //Since we are in a V3DCfgWidForAttributeIn3DCartesianGrid (data cube with clipping)
+        //assumes a vtkStructuredGridClip and a vtkDataSetMapper exist in the View3DViewData object
+        vtkSmartPointer<vtkExtractGrid> subgrider = _viewObjects.subgrider;
+
+        //set the cliping planes
+        subgrider->SetVOI( ui->sldILowClip->value(),
+                           ui->sldIHighClip->value(),
+                           ui->sldJLowClip->value(),
+                           ui->sldJHighClip->value(),
+                           ui->sldKLowClip->value(),
+                           ui->sldKHighClip->value());
+        subgrider->Update();
 
     } else {
         Application::instance()->logError("V3DCfgWidForAttributeIn3DCartesianGrid::onUserMadeChanges(): null grid file.");
@@ -252,6 +256,17 @@ void V3DCfgWidForAttributeIn3DCartesianGrid::updateLabels()
     ui->lblKlowClip->setText ( QString::number( ui->sldKLowClip->value() * _viewObjects.samplingRate ) );
     ui->lblKhighClip->setText( QString::number( ui->sldKHighClip->value() * _viewObjects.samplingRate ) );
 
+    //the sliders of a grid with a level-of-detail pyramid are in full resolution
+    if( _viewObjects.gridPyramid ){
+        ui->lblIlowClip->setText ( QString::number( ui->sldILowClip->value() ) );
+        ui->lblIhighClip->setText( QString::number( ui->sldIHighClip->value() ) );
+        ui->lblJlowClip->setText ( QString::number( ui->sldJLowClip->value() ) );
+        ui->lblJhighClip->setText( QString::number( ui->sldJHighClip->value() ) );
+        ui->lblKlowClip->setText ( QString::number( ui->sldKLowClip->value() ) );
+        ui->lblKhighClip->setText( QString::number( ui->sldKHighClip->value() ) );
+        return;
+    }
+
     if( _viewObjects.samplingRate > 1 ){
         ui->lblIlowClip->setText ( "~ " + ui->lblIlowClip->text() );
         ui->lblIhighClip->setText( "~ " + ui->lblIhighClip->text() );
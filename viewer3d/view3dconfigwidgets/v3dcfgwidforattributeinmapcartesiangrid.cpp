@@ -2,7 +2,7 @@
 #include "ui_v3dcfgwidforattributeinmapcartesiangrid.h"
 #include "util.h"
 #include <vtkLogLookupTable.h>
-#include <vtkExtractGrid.h>
+#include <vtkExtractVOI.h>
 #include <vtkDataSetMapper.h>
 
 V3DCfgWidForAttributeInMapCartesianGrid::V3DCfgWidForAttributeInMapCartesianGrid(
@@ -19,7 +19,7 @@ V3DCfgWidForAttributeInMapCartesianGrid::V3DCfgWidForAttributeInMapCartesianGrid
     //prevent signals from being fired while configuring the spinner
     ui->spinSamplingRate->blockSignals(true);
     //assumes all three sample rates (for I, J and K directions) are the same
-    int * rate = _viewObjects.subgrider->GetSampleRate();
+    int * rate = _viewObjects.voiExtractor->GetSampleRate();
     // TODO: weird... setting sampling rate for a value less than originally set in pipe builder (serr View3DBuilders)
     //       causes the actor to disappear.  VTK got to get better documentation or examples...
     //       don't know what to do to be able to increase the sample rate.
@@ -43,9 +43,9 @@ V3DCfgWidForAttributeInMapCartesianGrid::V3DCfgWidForAttributeInMapCartesianGrid
     ui->cmbScaling->addItem("Logarithmic", QVariant( (uint)ColorScaling::LOG ));
     ui->cmbScaling->blockSignals(false);
 
-    //if the subgrider came without a connection (e.g. the attribute has been displayed as a surface)
-    //disable the widgets that are ineffective without a functioning subgrider.
-    if( ! _viewObjects.subgrider->GetNumberOfInputConnections( 0 ) ){
+    //if the sub-sampler came without a connection (e.g. the attribute has been displayed as a surface)
+    //disable the widgets that are ineffective without a functioning sub-sampler.
+    if( ! _viewObjects.voiExtractor->GetNumberOfInputConnections( 0 ) ){
         ui->tabWidget->setEnabled( false );
     }
 
@@ -58,13 +58,14 @@ V3DCfgWidForAttributeInMapCartesianGrid::~V3DCfgWidForAttributeInMapCartesianGri
 
 void V3DCfgWidForAttributeInMapCartesianGrid::onUserMadeChanges()
 {
-    vtkSmartPointer<vtkExtractGrid> subgrider = _viewObjects.subgrider;
+    vtkSmartPointer<vtkExtractVOI> voiExtractor = _viewObjects.voiExtractor;
     vtkSmartPointer<vtkMapper> mapper = _viewObjects.mapper;
 
-    subgrider->SetSampleRate( ui->spinSamplingRate->value(),
-                              ui->spinSamplingRate->value(),
-                              ui->spinSamplingRate->value() );
-    subgrider->Update();
+    //the map has a single layer of cells
+    voiExtractor->SetSampleRate( ui->spinSamplingRate->value(),
+                                 ui->spinSamplingRate->value(),
+                                 1 );
+    voiExtractor->Update();
 
     //change color map min and max
     mapper->SetScalarRange( ui->spinColorMin->value(),
@@ -0,0 +1,81 @@
+#include "view3dgeometrycache.h"
+#include "domain/geogrid.h"
+#include "domain/application.h"
+
+#include <QFileInfo>
+#include <vtkPoints.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkCellType.h>
+
+QList<View3DGeometryCache::Entry> View3DGeometryCache::s_entries;
+
+vtkSmartPointer<vtkUnstructuredGrid> View3DGeometryCache::getGeoGridGeometry(GeoGrid *geoGrid)
+{
+    vtkSmartPointer<vtkUnstructuredGrid> unstructuredGrid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+    QFileInfo meshFileInfo( geoGrid->getMeshFilePath() );
+
+    //a mesh not yet saved to a file cannot be identified later, so it is not cached
+    if( ! meshFileInfo.exists() ){
+        unstructuredGrid->CopyStructure( buildGeoGridGeometry( geoGrid ) );
+        return unstructuredGrid;
+    }
+
+    //look for the mesh of the grid, dropping it if the mesh file changed since it was built
+    int iEntry = 0;
+    while( iEntry < s_entries.size() && s_entries[iEntry].meshFilePath != meshFileInfo.absoluteFilePath() )
+        ++iEntry;
+    if( iEntry < s_entries.size() ){
+        const Entry& entry = s_entries[iEntry];
+        if( entry.meshFileSize == meshFileInfo.size() &&
+            entry.meshFileLastModified == meshFileInfo.lastModified() ){
+            s_entries.move( iEntry, 0 );
+            Application::instance()->logInfo( "View3DGeometryCache::getGeoGridGeometry(): reusing the mesh of " +
+                                              meshFileInfo.absoluteFilePath() + "." );
+        } else {
+            s_entries.removeAt( iEntry );
+            iEntry = s_entries.size();
+        }
+    }
+    if( iEntry == s_entries.size() ){
+        Entry entry;
+        entry.meshFilePath = meshFileInfo.absoluteFilePath();
+        entry.meshFileSize = meshFileInfo.size();
+        entry.meshFileLastModified = meshFileInfo.lastModified();
+        entry.geometry = buildGeoGridGeometry( geoGrid );
+        s_entries.prepend( entry );
+        while( s_entries.size() > MAX_ENTRIES )
+            s_entries.removeLast();
+    }
+
+    //the new grid references the cached points and cells, but has its own (empty) cell data
+    unstructuredGrid->CopyStructure( s_entries.first().geometry );
+    return unstructuredGrid;
+}
+
+vtkSmartPointer<vtkUnstructuredGrid> View3DGeometryCache::buildGeoGridGeometry(GeoGrid *geoGrid)
+{
+    // Create a VTK container with the points (mesh vertexes)
+    uint nVertexes = geoGrid->getMeshNumberOfVertexes();
+    vtkSmartPointer< vtkPoints > hexaPoints = vtkSmartPointer< vtkPoints >::New();
+    hexaPoints->SetNumberOfPoints( nVertexes );
+    for( uint i = 0; i < nVertexes; ++i ){
+        double x, y, z;
+        geoGrid->getMeshVertexLocation( i, x, y, z );
+        hexaPoints->SetPoint( i, x, y, z );
+    }
+
+    // Create a VTK unstructured grid object (allows faults, erosions, and other geologic discordances )
+    vtkSmartPointer<vtkUnstructuredGrid> unstructuredGrid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+    uint nCells = geoGrid->getMeshNumberOfCells();
+    unstructuredGrid->Allocate( nCells );
+    for( uint i = 0; i < nCells; ++i ) {
+        uint vIds[8];
+        geoGrid->getMeshCellDefinition( i, vIds );
+        vtkIdType pointIds[8];
+        for( int iVertex = 0; iVertex < 8; ++iVertex )
+            pointIds[iVertex] = vIds[iVertex];
+        unstructuredGrid->InsertNextCell( VTK_HEXAHEDRON, 8, pointIds );
+    }
+    unstructuredGrid->SetPoints( hexaPoints );
+    return unstructuredGrid;
+}
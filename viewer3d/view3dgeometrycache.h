@@ -0,0 +1,47 @@
+#ifndef VIEW3DGEOMETRYCACHE_H
+#define VIEW3DGEOMETRYCACHE_H
+
+#include <QString>
+#include <QDateTime>
+#include <QList>
+#include <vtkSmartPointer.h>
+
+class GeoGrid;
+class vtkUnstructuredGrid;
+
+/**
+ * The View3DGeometryCache class keeps the VTK meshes (vertexes and hexahedra, no cell data) of the last GeoGrids
+ * displayed in the 3D Viewer, so all the attributes of a GeoGrid share the same points and connectivity.
+ * Displaying another attribute of the same grid then only needs its values, not the whole mesh rebuilt.
+ * A mesh is identified by the path, size and timestamp of the grid's mesh file, thus it is rebuilt if the mesh
+ * file changes.  Only the GUI thread should use this class.
+ */
+class View3DGeometryCache
+{
+public:
+    /** The maximum number of meshes kept (the least recently used is dropped first). */
+    static const int MAX_ENTRIES = 4;
+
+    /**
+     * Returns a new unstructured grid sharing the points and the cells of the given GeoGrid's cached mesh,
+     * building it if necessary.  The returned grid has its own cell data, so the caller can add arrays to it.
+     */
+    static vtkSmartPointer<vtkUnstructuredGrid> getGeoGridGeometry( GeoGrid* geoGrid );
+
+private:
+    /** A cached mesh and the state of the mesh file it was built from. */
+    struct Entry{
+        QString meshFilePath;
+        qint64 meshFileSize;
+        QDateTime meshFileLastModified;
+        vtkSmartPointer<vtkUnstructuredGrid> geometry;
+    };
+
+    /** Builds the mesh of a GeoGrid from its vertexes and cell definitions. */
+    static vtkSmartPointer<vtkUnstructuredGrid> buildGeoGridGeometry( GeoGrid* geoGrid );
+
+    /** The cached meshes, the most recently used first. */
+    static QList<Entry> s_entries;
+};
+
+#endif // VIEW3DGEOMETRYCACHE_H
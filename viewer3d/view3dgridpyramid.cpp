@@ -0,0 +1,505 @@
+#include "view3dgridpyramid.h"
+#include "domain/application.h"
+#include "domain/project.h"
+#include "domain/cartesiangrid.h"
+#include "domain/attribute.h"
+
+#include <vtkRectilinearGrid.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkCellData.h>
+
+#include <QFile>
+#include <QTemporaryFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/** Identifies GammaRay LOD cache files ("LODG"). */
+const quint32 CACHE_MAGIC = 0x4C4F4447;
+
+/** Increment this whenever the cache file layout changes. */
+const quint32 CACHE_VERSION = 1;
+
+const int BRICK_SIZE = View3DGridPyramid::BRICK_SIZE;
+const qint64 BRICK_VALUES = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+const qint64 BRICK_BYTES = BRICK_VALUES * sizeof(float);
+
+/** Level 0 values copied from the grid data (no-data values are NaN, I index varies fastest). */
+struct GridSource{
+    const std::vector<float>& values;
+    int nI, nJ;
+    float value( int i, int j, int k ) const { return values[ ( (qint64)k * nJ + j ) * nI + i ]; }
+    float weight( int i, int j, int k ) const {
+        return std::isnan( value( i, j, k ) ) ? 0.0f : 1.0f;
+    }
+};
+
+/** Values and weights of a level held in memory (I index varies fastest). */
+struct LevelSource{
+    const std::vector<float>& values;
+    const std::vector<float>& weights;
+    int nI, nJ;
+    float value( int i, int j, int k ) const { return values[ ( (qint64)k * nJ + j ) * nI + i ]; }
+    float weight( int i, int j, int k ) const { return weights[ ( (qint64)k * nJ + j ) * nI + i ]; }
+};
+
+/** Runs worker( index ) for index in [0, n) in nThreads threads (the calling thread included). */
+void parallelFor( int n, unsigned int nThreads, const std::function<void(int)>& worker )
+{
+    std::atomic<int> next( 0 );
+    auto loop = [&](){
+        while( true ){
+            int index = next++;
+            if( index >= n )
+                break;
+            worker( index );
+        }
+    };
+    nThreads = std::min<unsigned int>( nThreads, std::max( n, 1 ) );
+    std::vector< std::thread > threads;
+    for( unsigned int iThread = 1; iThread < nThreads; ++iThread )
+        threads.emplace_back( loop );
+    loop();
+    for( std::thread& thread : threads )
+        thread.join();
+}
+
+/**
+ * Writes the bricks of a level to the file, one layer of bricks (same K brick index) at a time.  The bricks of a
+ * layer are filled in parallel.  The cells of the bricks beyond the level's extents are NaN.
+ * @param isCancelled Called after each layer of bricks is written.  The writing stops if it returns true.
+ * @return False if a write failed or the writing was cancelled.
+ */
+template< class Source >
+bool writeLevel( QFile& file, const Source& source, int nI, int nJ, int nK, unsigned int nThreads,
+                 double& min, double& max, const std::function<bool()>& isCancelled )
+{
+    int nBricksI = ( nI + BRICK_SIZE - 1 ) / BRICK_SIZE;
+    int nBricksJ = ( nJ + BRICK_SIZE - 1 ) / BRICK_SIZE;
+    int nBricksK = ( nK + BRICK_SIZE - 1 ) / BRICK_SIZE;
+    std::vector<float> layer( nBricksI * nBricksJ * BRICK_VALUES );
+    for( int bk = 0; bk < nBricksK; ++bk ){
+        parallelFor( nBricksI * nBricksJ, nThreads, [&]( int iBrick ){
+            int bi = iBrick % nBricksI;
+            int bj = iBrick / nBricksI;
+            float* brick = layer.data() + iBrick * BRICK_VALUES;
+            for( int k = 0; k < BRICK_SIZE; ++k )
+                for( int j = 0; j < BRICK_SIZE; ++j )
+                    for( int i = 0; i < BRICK_SIZE; ++i ){
+                        int iCell = bi * BRICK_SIZE + i;
+                        int jCell = bj * BRICK_SIZE + j;
+                        int kCell = bk * BRICK_SIZE + k;
+                        float& value = brick[ ( k * BRICK_SIZE + j ) * BRICK_SIZE + i ];
+                        if( iCell < nI && jCell < nJ && kCell < nK )
+                            value = source.value( iCell, jCell, kCell );
+                        else
+                            value = std::numeric_limits<float>::quiet_NaN();
+                    }
+        });
+        for( float value : layer )
+            if( ! std::isnan( value ) ){
+                min = std::min<double>( min, value );
+                max = std::max<double>( max, value );
+            }
+        qint64 nBytes = layer.size() * sizeof(float);
+        if( file.write( reinterpret_cast<const char*>( layer.data() ), nBytes ) != nBytes )
+            return false;
+        if( isCancelled() )
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Computes the values and weights of the next level from the cells of a level.  A cell of the next level
+ * aggregates up to 2x2x2 cells: the weighted mean of their values for continuous attributes, or the value with
+ * the largest total weight for categorical attributes (ties go to the smallest value).  The weight of a cell is
+ * the number of valid original cells aggregated (mean) or the weight of the winning value (mode).
+ */
+template< class Source >
+void aggregateLevel( const Source& source, int nI, int nJ, int nK, bool categorical, unsigned int nThreads,
+                     std::vector<float>& values, std::vector<float>& weights )
+{
+    int nINext = ( nI + 1 ) / 2;
+    int nJNext = ( nJ + 1 ) / 2;
+    int nKNext = ( nK + 1 ) / 2;
+    values.assign( (qint64)nINext * nJNext * nKNext, std::numeric_limits<float>::quiet_NaN() );
+    weights.assign( values.size(), 0.0f );
+    parallelFor( nKNext, nThreads, [&]( int kNext ){
+        for( int jNext = 0; jNext < nJNext; ++jNext )
+            for( int iNext = 0; iNext < nINext; ++iNext ){
+                //the (value, weight) pairs of the children, summed by value for the mode.
+                float childValues[8];
+                float childWeights[8];
+                int nChildren = 0;
+                double sum = 0.0;
+                double totalWeight = 0.0;
+                for( int k = 2 * kNext; k < std::min( 2 * kNext + 2, nK ); ++k )
+                    for( int j = 2 * jNext; j < std::min( 2 * jNext + 2, nJ ); ++j )
+                        for( int i = 2 * iNext; i < std::min( 2 * iNext + 2, nI ); ++i ){
+                            float weight = source.weight( i, j, k );
+                            if( weight <= 0.0f )
+                                continue;
+                            float value = source.value( i, j, k );
+                            if( categorical ){
+                                int iChild = 0;
+                                while( iChild < nChildren && childValues[iChild] != value )
+                                    ++iChild;
+                                if( iChild == nChildren ){
+                                    childValues[nChildren] = value;
+                                    childWeights[nChildren] = 0.0f;
+                                    ++nChildren;
+                                }
+                                childWeights[iChild] += weight;
+                            } else {
+                                sum += (double)value * weight;
+                                totalWeight += weight;
+                            }
+                        }
+                qint64 index = ( (qint64)kNext * nJNext + jNext ) * nINext + iNext;
+                if( categorical ){
+                    int iBest = -1;
+                    for( int iChild = 0; iChild < nChildren; ++iChild )
+                        if( iBest < 0 ||
+                            childWeights[iChild] > childWeights[iBest] ||
+                            ( childWeights[iChild] == childWeights[iBest] && childValues[iChild] < childValues[iBest] ) )
+                            iBest = iChild;
+                    if( iBest >= 0 ){
+                        values[index] = childValues[iBest];
+                        weights[index] = childWeights[iBest];
+                    }
+                } else if( totalWeight > 0.0 ){
+                    values[index] = sum / totalWeight;
+                    weights[index] = totalWeight;
+                }
+            }
+    });
+}
+
+}
+
+View3DGridPyramid::View3DGridPyramid(CartesianGrid *cartesianGrid, Attribute *attribute) :
+    m_column( cartesianGrid->getFieldGEOEASIndex( attribute->getName() ) - 1 ),
+    m_categorical( attribute->isCategorical() ),
+    m_nI( cartesianGrid->getNX() ),
+    m_nJ( cartesianGrid->getNY() ),
+    m_nK( cartesianGrid->getNZ() ),
+    m_x0( cartesianGrid->getX0() ),
+    m_y0( cartesianGrid->getY0() ),
+    m_z0( cartesianGrid->getZ0() ),
+    m_dX( cartesianGrid->getDX() ),
+    m_dY( cartesianGrid->getDY() ),
+    m_dZ( cartesianGrid->getDZ() ),
+    m_hasNDV( cartesianGrid->hasNoDataValue() ),
+    m_ndv( m_hasNDV ? cartesianGrid->getNoDataValueAsDouble() : 0.0 ),
+    m_timestamp( QFileInfo( cartesianGrid->getPath() ).lastModified().toMSecsSinceEpoch() ),
+    m_min( std::numeric_limits<double>::quiet_NaN() ),
+    m_max( std::numeric_limits<double>::quiet_NaN() ),
+    m_isCached( false ),
+    m_canBuild( false ),
+    m_dataOffset( 0 )
+{
+    //the caches are kept in the project's temporary files directory, so they do not pile up beside the grid files
+    //and are removed along with the other temporary files (see MainWindow::onCleanTmpFiles()).
+    m_cacheFilePath = QDir( Application::instance()->getProject()->getTmpPath() ).absoluteFilePath(
+                          QFileInfo( cartesianGrid->getPath() ).fileName() + "." + QString::number( m_column + 1 ) + ".lod" );
+
+    makeLevels();
+    m_isCached = readHeader();
+    if( m_isCached )
+        return;
+
+    //the cache must be (re)built: check whether it can be written before loading the grid
+    {
+        QTemporaryFile file( getCacheFilePath() + ".XXXXXX" );
+        if( ! file.open() )
+            return;
+    }
+    m_canBuild = true;
+
+    //copy the values, so open() does not need the grid
+    cartesianGrid->loadData();
+    m_values.resize( (qint64)m_nI * m_nJ * m_nK );
+    for( int k = 0; k < m_nK; ++k )
+        for( int j = 0; j < m_nJ; ++j )
+            for( int i = 0; i < m_nI; ++i ){
+                double value = cartesianGrid->dataIJKConst( m_column, i, j, k );
+                if( cartesianGrid->isNDV( value ) || ! std::isfinite( value ) )
+                    value = std::numeric_limits<float>::quiet_NaN();
+                m_values[ ( (qint64)k * m_nJ + j ) * m_nI + i ] = value;
+            }
+    cartesianGrid->freeLoadedData();
+}
+
+bool View3DGridPyramid::open( const std::atomic<bool> *cancelled )
+{
+    if( m_isCached )
+        return true;
+    if( ! m_canBuild )
+        return false;
+    m_isCached = build( cancelled );
+    //the copy of the grid values is no longer needed
+    std::vector<float>().swap( m_values );
+    m_canBuild = false;
+    return m_isCached;
+}
+
+QString View3DGridPyramid::getCacheFilePath() const
+{
+    return m_cacheFilePath;
+}
+
+int View3DGridPyramid::getFinestLevelFor(int i0, int i1, int j0, int j1, int k0, int k1, qint64 maxCells) const
+{
+    for( int level = 0; level < getNumberOfLevels(); ++level )
+        if( getCellCount( level, i0, i1, j0, j1, k0, k1 ) <= maxCells )
+            return level;
+    return getNumberOfLevels() - 1;
+}
+
+bool View3DGridPyramid::getRegion(int level, int i0, int i1, int j0, int j1, int k0, int k1,
+                                  std::vector<float> &result) const
+{
+    int nI = i1 - i0;
+    int nJ = j1 - j0;
+    int nK = k1 - k0;
+    result.assign( (qint64)nI * nJ * nK, std::numeric_limits<float>::quiet_NaN() );
+    if( result.empty() )
+        return true;
+
+    //the file is opened per call, so concurrent calls do not share a file position.
+    QFile file( getCacheFilePath() );
+    if( ! file.open( QFile::ReadOnly ) )
+        return false;
+
+    const Level& lv = m_levels[level];
+    std::vector<float> brick( BRICK_VALUES );
+    for( int bk = k0 / BRICK_SIZE; bk <= ( k1 - 1 ) / BRICK_SIZE; ++bk )
+        for( int bj = j0 / BRICK_SIZE; bj <= ( j1 - 1 ) / BRICK_SIZE; ++bj )
+            for( int bi = i0 / BRICK_SIZE; bi <= ( i1 - 1 ) / BRICK_SIZE; ++bi ){
+                qint64 iBrick = ( (qint64)bk * lv.nBricksJ + bj ) * lv.nBricksI + bi;
+                if( ! file.seek( m_dataOffset + lv.offset + iBrick * BRICK_BYTES ) ||
+                    file.read( reinterpret_cast<char*>( brick.data() ), BRICK_BYTES ) != BRICK_BYTES )
+                    return false;
+                //copy the part of the brick inside the region
+                int iBegin = std::max( i0, bi * BRICK_SIZE ), iEnd = std::min( i1, ( bi + 1 ) * BRICK_SIZE );
+                int jBegin = std::max( j0, bj * BRICK_SIZE ), jEnd = std::min( j1, ( bj + 1 ) * BRICK_SIZE );
+                int kBegin = std::max( k0, bk * BRICK_SIZE ), kEnd = std::min( k1, ( bk + 1 ) * BRICK_SIZE );
+                for( int k = kBegin; k < kEnd; ++k )
+                    for( int j = jBegin; j < jEnd; ++j ){
+                        const float* from = brick.data() + ( ( k - bk * BRICK_SIZE ) * BRICK_SIZE +
+                                                             ( j - bj * BRICK_SIZE ) ) * BRICK_SIZE
+                                                         + ( iBegin - bi * BRICK_SIZE );
+                        float* to = result.data() + ( (qint64)( k - k0 ) * nJ + ( j - j0 ) ) * nI + ( iBegin - i0 );
+                        std::copy( from, from + ( iEnd - iBegin ), to );
+                    }
+            }
+    return true;
+}
+
+vtkSmartPointer<vtkRectilinearGrid> View3DGridPyramid::makeGrid(int i0, int i1, int j0, int j1, int k0, int k1,
+                                                                qint64 maxCells, int &level) const
+{
+    level = getFinestLevelFor( i0, i1, j0, j1, k0, k1, maxCells );
+    vtkSmartPointer<vtkRectilinearGrid> rectilinearGrid = makeGrid( level, i0, i1, j0, j1, k0, k1 );
+    if( ! rectilinearGrid )
+        Application::instance()->logError( "View3DGridPyramid::makeGrid(): failed to read " + getCacheFilePath() + "." );
+    return rectilinearGrid;
+}
+
+vtkSmartPointer<vtkRectilinearGrid> View3DGridPyramid::makeGrid(int level,
+                                                                int i0, int i1, int j0, int j1, int k0, int k1) const
+{
+    //the cells of the level covering the region
+    int a0 = i0 >> level, a1 = ( ( i1 - 1 ) >> level ) + 1;
+    int b0 = j0 >> level, b1 = ( ( j1 - 1 ) >> level ) + 1;
+    int c0 = k0 >> level, c1 = ( ( k1 - 1 ) >> level ) + 1;
+    std::vector<float> regionValues;
+    if( ! getRegion( level, a0, a1, b0, b1, c0, c1, regionValues ) )
+        return nullptr;
+
+    //create the value array and the ghost array that blanks the cells without valid values
+    vtkSmartPointer<vtkFloatArray> values = vtkSmartPointer<vtkFloatArray>::New();
+    values->SetName("values");
+    values->SetNumberOfValues( regionValues.size() );
+    vtkSmartPointer<vtkUnsignedCharArray> ghosts = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    ghosts->SetName( vtkDataSetAttributes::GhostArrayName() );
+    ghosts->SetNumberOfValues( regionValues.size() );
+    for( vtkIdType i = 0; i < (vtkIdType)regionValues.size(); ++i ){
+        values->SetValue( i, regionValues[i] );
+        ghosts->SetValue( i, std::isnan( regionValues[i] ) ? vtkDataSetAttributes::HIDDENCELL : 0 );
+    }
+
+    //the cell corners, in full resolution cell indexes, cut at the region boundaries
+    auto makeCoordinates = [level]( int levelIndex0, int levelIndex1, int low, int high, double origin, double cellSize ){
+        vtkSmartPointer<vtkDoubleArray> coordinates = vtkSmartPointer<vtkDoubleArray>::New();
+        coordinates->SetNumberOfValues( levelIndex1 - levelIndex0 + 1 );
+        for( int levelIndex = levelIndex0; levelIndex <= levelIndex1; ++levelIndex ){
+            int index = std::min( std::max( levelIndex << level, low ), high );
+            coordinates->SetValue( levelIndex - levelIndex0, origin + index * cellSize );
+        }
+        return coordinates;
+    };
+
+    //GSLib grids are cell-centered, the coordinates are of the cell corners
+    vtkSmartPointer<vtkRectilinearGrid> rectilinearGrid = vtkSmartPointer<vtkRectilinearGrid>::New();
+    rectilinearGrid->SetDimensions( a1 - a0 + 1, b1 - b0 + 1, c1 - c0 + 1 );
+    rectilinearGrid->SetXCoordinates( makeCoordinates( a0, a1, i0, i1, m_x0 - m_dX/2.0, m_dX ) );
+    rectilinearGrid->SetYCoordinates( makeCoordinates( b0, b1, j0, j1, m_y0 - m_dY/2.0, m_dY ) );
+    rectilinearGrid->SetZCoordinates( makeCoordinates( c0, c1, k0, k1, m_z0 - m_dZ/2.0, m_dZ ) );
+    rectilinearGrid->GetCellData()->SetScalars( values );
+    rectilinearGrid->GetCellData()->AddArray( ghosts );
+    return rectilinearGrid;
+}
+
+bool View3DGridPyramid::readHeader()
+{
+    QFile file( getCacheFilePath() );
+    if( ! file.exists() || ! file.open( QFile::ReadOnly ) )
+        return false;
+    QDataStream in( &file );
+    quint32 magic, version;
+    qint64 timestamp;
+    qint32 column, nI, nJ, nK;
+    bool categorical, hasNDV;
+    double ndv;
+    in >> magic >> version >> timestamp >> column >> nI >> nJ >> nK >> categorical >> hasNDV >> ndv >> m_min >> m_max;
+    if( in.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION )
+        return false;
+
+    //the cache is outdated if the grid file or its metadata changed since it was built
+    if( timestamp != m_timestamp ||
+        column != m_column || nI != m_nI || nJ != m_nJ || nK != m_nK ||
+        categorical != m_categorical ||
+        hasNDV != m_hasNDV ||
+        ( hasNDV && ndv != m_ndv ) )
+        return false;
+
+    //the cache file must hold all the bricks
+    m_dataOffset = file.pos();
+    const Level& lastLevel = m_levels.back();
+    qint64 expectedSize = m_dataOffset + lastLevel.offset +
+            (qint64)lastLevel.nBricksI * lastLevel.nBricksJ * lastLevel.nBricksK * BRICK_BYTES;
+    return file.size() == expectedSize;
+}
+
+bool View3DGridPyramid::build( const std::atomic<bool> *cancelled )
+{
+    Application::instance()->logInfo( "View3DGridPyramid::build(): building level-of-detail cache " +
+                                      getCacheFilePath() + "..." );
+
+    //the cache is written to a temporary file, so an interrupted build does not leave a corrupt cache behind.
+    //the file name is unique, since the same cache may be built for another display of the grid at the same time.
+    QTemporaryFile file( getCacheFilePath() + ".XXXXXX" );
+    file.setAutoRemove( false );
+    if( ! file.open() ){
+        Application::instance()->logError( "View3DGridPyramid::build(): could not create a temporary file for " +
+                                           getCacheFilePath() + "." );
+        return false;
+    }
+    QString temporaryPath = file.fileName();
+
+    //the header is rewritten with the min and max at the end
+    auto writeHeader = [this, &file](){
+        QDataStream out( &file );
+        out << CACHE_MAGIC << CACHE_VERSION
+            << m_timestamp
+            << (qint32)m_column << (qint32)m_nI << (qint32)m_nJ << (qint32)m_nK
+            << m_categorical << m_hasNDV << m_ndv
+            << m_min << m_max;
+        return out.status() == QDataStream::Ok;
+    };
+    bool ok = writeHeader();
+    m_dataOffset = file.pos();
+
+    //the build is run by View3DBuildService, which cancels it if the object is removed in the meantime
+    auto isCancelled = [cancelled](){
+        return cancelled && *cancelled;
+    };
+
+    unsigned int nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+
+    //level 0 comes from the copy of the grid values, the others are aggregated from the previous level.
+    GridSource gridSource{ m_values, m_nI, m_nJ };
+    ok = ok && writeLevel( file, gridSource, m_nI, m_nJ, m_nK, nThreads, min, max, isCancelled );
+    std::vector<float> values, weights, nextValues, nextWeights;
+    if( ok && m_levels.size() > 1 )
+        aggregateLevel( gridSource, m_nI, m_nJ, m_nK, m_categorical, nThreads, values, weights );
+    for( int level = 1; ok && level < getNumberOfLevels(); ++level ){
+        const Level& lv = m_levels[level];
+        LevelSource levelSource{ values, weights, lv.nI, lv.nJ };
+        ok = writeLevel( file, levelSource, lv.nI, lv.nJ, lv.nK, nThreads, min, max, isCancelled );
+        if( ok && level + 1 < getNumberOfLevels() ){
+            aggregateLevel( levelSource, lv.nI, lv.nJ, lv.nK, m_categorical, nThreads, nextValues, nextWeights );
+            values.swap( nextValues );
+            weights.swap( nextWeights );
+        }
+    }
+
+    if( min <= max ){
+        m_min = min;
+        m_max = max;
+    }
+    ok = ok && file.seek( 0 ) && writeHeader();
+    file.close();
+
+    if( ok ){
+        QFile::remove( getCacheFilePath() );
+        ok = QFile::rename( temporaryPath, getCacheFilePath() );
+    }
+    if( ! ok ){
+        QFile::remove( temporaryPath );
+        if( isCancelled() ){
+            Application::instance()->logInfo( "View3DGridPyramid::build(): cancelled." );
+            return false;
+        }
+        Application::instance()->logError( "View3DGridPyramid::build(): failed to write " + getCacheFilePath() + "." );
+        return false;
+    }
+
+    Application::instance()->logInfo( "View3DGridPyramid::build(): done (" + QString::number( getNumberOfLevels() ) +
+                                      " levels)." );
+    return true;
+}
+
+void View3DGridPyramid::makeLevels()
+{
+    m_levels.clear();
+    qint64 offset = 0;
+    for( int level = 0; ; ++level ){
+        Level lv;
+        lv.nI = ( (qint64)m_nI + ( 1LL << level ) - 1 ) >> level;
+        lv.nJ = ( (qint64)m_nJ + ( 1LL << level ) - 1 ) >> level;
+        lv.nK = ( (qint64)m_nK + ( 1LL << level ) - 1 ) >> level;
+        lv.nBricksI = ( lv.nI + BRICK_SIZE - 1 ) / BRICK_SIZE;
+        lv.nBricksJ = ( lv.nJ + BRICK_SIZE - 1 ) / BRICK_SIZE;
+        lv.nBricksK = ( lv.nK + BRICK_SIZE - 1 ) / BRICK_SIZE;
+        lv.offset = offset;
+        offset += (qint64)lv.nBricksI * lv.nBricksJ * lv.nBricksK * BRICK_BYTES;
+        m_levels.push_back( lv );
+        //the coarsest level fits in a single brick
+        if( lv.nI <= BRICK_SIZE && lv.nJ <= BRICK_SIZE && lv.nK <= BRICK_SIZE )
+            break;
+    }
+}
+
+qint64 View3DGridPyramid::getCellCount(int level, int i0, int i1, int j0, int j1, int k0, int k1) const
+{
+    qint64 nI = ( ( i1 - 1 ) >> level ) - ( i0 >> level ) + 1;
+    qint64 nJ = ( ( j1 - 1 ) >> level ) - ( j0 >> level ) + 1;
+    qint64 nK = ( ( k1 - 1 ) >> level ) - ( k0 >> level ) + 1;
+    return nI * nJ * nK;
+}
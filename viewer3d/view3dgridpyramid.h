@@ -0,0 +1,145 @@
+#ifndef VIEW3DGRIDPYRAMID_H
+#define VIEW3DGRIDPYRAMID_H
+
+#include <QString>
+#include <vtkSmartPointer.h>
+#include <vector>
+#include <atomic>
+
+class CartesianGrid;
+class Attribute;
+class vtkRectilinearGrid;
+
+/**
+ * The View3DGridPyramid class manages a multi-resolution (level-of-detail) representation of an Attribute of
+ * a 3D CartesianGrid for the 3D Viewer.  Level 0 holds the original cells.  Each cell of level L+1 aggregates
+ * 2x2x2 cells of level L: the mean of the valid values for continuous attributes or the mode for categorical
+ * attributes (as opposed to simply picking one value every n cells).  No-data values are ignored in the
+ * aggregations.  A cell without valid values is NaN.
+ *
+ * Every level is split into bricks of BRICK_SIZE^3 cells.  The pyramid is built once and cached on disk in a
+ * file in the project's temporary files directory (see getCacheFilePath()), so subsequent displays do not need
+ * to load the grid file at all.  The cache is rebuilt automatically if the grid file changes.  Only the bricks
+ * that intersect the region being displayed are read from the cache.
+ *
+ * The pyramid copies what it needs from the grid on construction, in the GUI thread.  Then it does not use the
+ * grid anymore, so it can be opened (possibly building its cache) and read in worker threads (see
+ * View3DBuildService) even if the grid is changed or removed from the project meanwhile.
+ */
+class View3DGridPyramid
+{
+public:
+    /** The size of the bricks along each axis, in cells. */
+    static const int BRICK_SIZE = 32;
+
+    /**
+     * Must be called in the GUI thread.  If the cache does not exist or is outdated, this loads the grid data and
+     * copies the values of the attribute, so open() can build the cache without the grid.
+     * @param cartesianGrid The grid.  It must be 3D.
+     * @param attribute An attribute of the grid.
+     */
+    View3DGridPyramid( CartesianGrid* cartesianGrid, Attribute* attribute );
+
+    /** Returns false if the cache must be built but cannot be written (open() would fail). */
+    bool canOpen() const { return m_isCached || m_canBuild; }
+
+    /**
+     * Opens the cached pyramid, building it from the values copied on construction if the cache did not exist or
+     * was outdated.  This can be called from a worker thread, but only once, and the pyramid must not be read
+     * until it returns.
+     * @param cancelled If given, the build of the cache stops as soon as possible when it becomes true.
+     * @return False if the cache could not be written or its build was cancelled.
+     */
+    bool open( const std::atomic<bool>* cancelled = nullptr );
+
+    /** Returns the path to the cache file: <project tmp directory>/<grid file name>.<attribute GEO-EAS index>.lod. */
+    QString getCacheFilePath() const;
+
+    int getNumberOfLevels() const { return m_levels.size(); }
+
+    /** The dimensions of the grid (level 0). */
+    int getNI() const { return m_nI; }
+    int getNJ() const { return m_nJ; }
+    int getNK() const { return m_nK; }
+
+    /** The minimum and maximum valid values of the attribute. */
+    double getMin() const { return m_min; }
+    double getMax() const { return m_max; }
+
+    /**
+     * Returns the finest level whose cells covering the given region (full resolution cell indexes, inclusive
+     * lower bounds, exclusive upper bounds) do not exceed maxCells.  Returns the coarsest level if none fits.
+     */
+    int getFinestLevelFor( int i0, int i1, int j0, int j1, int k0, int k1, qint64 maxCells ) const;
+
+    /**
+     * Reads the values of the cells of a level in the given region (level cell indexes, inclusive lower bounds,
+     * exclusive upper bounds).  Only the bricks intersecting the region are read.  The values are returned with
+     * the I index varying fastest, then J, then K.  Cells without valid values are NaN.
+     * @return False if the cache file could not be read.
+     */
+    bool getRegion( int level, int i0, int i1, int j0, int j1, int k0, int k1, std::vector<float>& values ) const;
+
+    /**
+     * Makes a VTK grid for the given region (full resolution cell indexes, inclusive lower bounds, exclusive
+     * upper bounds) at the finest level that does not exceed maxCells.  The cells of the level on the borders
+     * of the region are cut, so the grid fits the region exactly.  The grid has implicit geometry, the "values"
+     * cell scalars and the cells without valid values blanked (hidden by a ghost array).  The coordinates are
+     * not rotated: apply the grid rotation as a transform of the actor.
+     * @param level Output: the level used.
+     * @return A null pointer if the cache file could not be read.
+     */
+    vtkSmartPointer<vtkRectilinearGrid> makeGrid( int i0, int i1, int j0, int j1, int k0, int k1,
+                                                  qint64 maxCells, int& level ) const;
+
+    /** Same as the other makeGrid(), but at the given level.  This is thread-safe (nothing is logged), so the
+     *  grids of finer levels can be made in background.
+     */
+    vtkSmartPointer<vtkRectilinearGrid> makeGrid( int level, int i0, int i1, int j0, int j1, int k0, int k1 ) const;
+
+private:
+    /** The dimensions and the position in the cache file of a level. */
+    struct Level{
+        int nI, nJ, nK;
+        int nBricksI, nBricksJ, nBricksK;
+        qint64 offset;
+    };
+
+    /** Reads the header of the cache file.  Returns false if it does not match the current grid. */
+    bool readHeader();
+
+    /** Builds the pyramid and writes it to the cache file. */
+    bool build( const std::atomic<bool>* cancelled );
+
+    /** Computes the dimensions and positions of the levels from the grid dimensions. */
+    void makeLevels();
+
+    /** Returns the number of cells of a level covering the given full resolution region. */
+    qint64 getCellCount( int level, int i0, int i1, int j0, int j1, int k0, int k1 ) const;
+
+    int m_column;
+    bool m_categorical;
+    int m_nI, m_nJ, m_nK;
+    double m_x0, m_y0, m_z0;
+    double m_dX, m_dY, m_dZ;
+    bool m_hasNDV;
+    double m_ndv;
+    /** Modification time of the grid file on construction. */
+    qint64 m_timestamp;
+    double m_min, m_max;
+    std::vector< Level > m_levels;
+    QString m_cacheFilePath;
+
+    /** Whether the cache is up to date or, else, whether it can be built from m_values. */
+    bool m_isCached;
+    bool m_canBuild;
+
+    /** The values of the attribute (NaN for no-data values, I index varies fastest), only while the cache is to
+     *  be built. */
+    std::vector< float > m_values;
+
+    /** Position of the first brick in the cache file. */
+    qint64 m_dataOffset;
+};
+
+#endif // VIEW3DGRIDPYRAMID_H
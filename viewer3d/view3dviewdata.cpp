@@ -4,6 +4,7 @@
 #include <vtkProp.h>
 #include <vtkStructuredGridClip.h>
 #include <vtkExtractGrid.h>
+#include <vtkExtractVOI.h>
 #include <vtkDataSetMapper.h>
 #include <vtkThreshold.h>
 
@@ -11,6 +12,7 @@ View3DViewData::View3DViewData() :
     actor( vtkSmartPointer<vtkActor>::New() ),
     clipper( vtkSmartPointer<vtkStructuredGridClip>::New() ),
     subgrider( vtkSmartPointer<vtkExtractGrid>::New() ),
+    voiExtractor( vtkSmartPointer<vtkExtractVOI>::New() ),
     mapper( vtkSmartPointer<vtkDataSetMapper>::New() ),
     threshold( vtkSmartPointer<vtkThreshold>::New() ),
     samplingRate( 1 )
@@ -20,6 +22,7 @@ View3DViewData::View3DViewData(vtkSmartPointer<vtkProp> pActor) :
     actor( pActor ),
     clipper( vtkSmartPointer<vtkStructuredGridClip>::New() ),
     subgrider( vtkSmartPointer<vtkExtractGrid>::New() ),
+    voiExtractor( vtkSmartPointer<vtkExtractVOI>::New() ),
     mapper( vtkSmartPointer<vtkDataSetMapper>::New() ),
     threshold( vtkSmartPointer<vtkThreshold>::New() ),
     samplingRate( 1 )
@@ -30,6 +33,7 @@ View3DViewData::View3DViewData(vtkSmartPointer<vtkProp> pActor,
     actor( pActor ),
     clipper( pClipper ),
     subgrider( vtkSmartPointer<vtkExtractGrid>::New() ),
+    voiExtractor( vtkSmartPointer<vtkExtractVOI>::New() ),
     mapper( vtkSmartPointer<vtkDataSetMapper>::New() ),
     threshold( vtkSmartPointer<vtkThreshold>::New() ),
     samplingRate( 1 )
@@ -39,6 +43,7 @@ View3DViewData::View3DViewData(vtkSmartPointer<vtkProp> pActor, vtkSmartPointer<
     actor( pActor ),
     clipper( vtkSmartPointer<vtkStructuredGridClip>::New() ),
     subgrider( pSubgrider ),
+    voiExtractor( vtkSmartPointer<vtkExtractVOI>::New() ),
     mapper( vtkSmartPointer<vtkDataSetMapper>::New() ),
     threshold( vtkSmartPointer<vtkThreshold>::New() ),
     samplingRate( 1 )
@@ -52,6 +57,7 @@ View3DViewData::View3DViewData(vtkSmartPointer<vtkProp> pActor,
     actor( pActor ),
     clipper( vtkSmartPointer<vtkStructuredGridClip>::New() ),
     subgrider( pSubgrider ),
+    voiExtractor( vtkSmartPointer<vtkExtractVOI>::New() ),
     mapper( pMapper ),
     threshold( pThreshold ),
     samplingRate( sRate )
@@ -61,6 +67,7 @@ View3DViewData::View3DViewData(vtkSmartPointer<vtkProp> pActor, vtkSmartPointer<
     actor( pActor ),
     clipper( vtkSmartPointer<vtkStructuredGridClip>::New() ),
     subgrider( vtkSmartPointer<vtkExtractGrid>::New() ),
+    voiExtractor( vtkSmartPointer<vtkExtractVOI>::New() ),
     mapper( vtkSmartPointer<vtkDataSetMapper>::New() ),
     threshold( pThreshold ),
     samplingRate( 1 )
@@ -73,6 +80,7 @@ View3DViewData::View3DViewData(vtkSmartPointer<vtkProp> pActor,
     actor( pActor ),
     clipper( vtkSmartPointer<vtkStructuredGridClip>::New() ),
     subgrider( vtkSmartPointer<vtkExtractGrid>::New() ),
+    voiExtractor( vtkSmartPointer<vtkExtractVOI>::New() ),
     mapper( pMapper ),
     threshold( pThreshold ),
     samplingRate( 1 )
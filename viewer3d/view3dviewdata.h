@@ -2,13 +2,16 @@
 #define VIEW3DVIEWDATA_H
 
 #include <vtkSmartPointer.h>
+#include <memory>
 
 class vtkProp;
 class vtkStructuredGridClip;
 class vtkExtractGrid;
+class vtkExtractVOI;
 class vtkDataSetMapper;
 class vtkThreshold;
 class vtkTubeFilter;
+class View3DGridPyramid;
 
 
 /** This class is just a data structure to hold objects and info related to 3D visualization of a domain object.
@@ -49,6 +52,9 @@ public:
     /** Some objects may have a configurable sub-grider/grid resampler. */
     vtkSmartPointer<vtkExtractGrid> subgrider;
 
+    /** Some objects with implicit geometry (vtkImageData) may have a configurable sub-sampler. */
+    vtkSmartPointer<vtkExtractVOI> voiExtractor;
+
     /** Some objects may have a configurable data set mapper. */
     vtkSmartPointer<vtkDataSetMapper> mapper;
 
@@ -60,6 +66,9 @@ public:
 
     /** Sampling rate. Default is 1: 1 cell per 1 sample in each topological direction (I, J, K). */
     int samplingRate;
+
+    /** Some objects may have a level-of-detail pyramid to load the grid cells of a region on demand. */
+    std::shared_ptr<View3DGridPyramid> gridPyramid;
 };
 
 #endif // VIEW3DVIEWDATA_H
@@ -32,6 +32,7 @@ VTK_MODULE_INIT(vtkRenderingFreeType)
 #include "domain/project.h"
 #include "domain/projectcomponent.h"
 #include "view3dbuilders.h"
+#include "view3dbuildservice.h"
 #include "view3dconfigwidget.h"
 #include "view3dverticalexaggerationwidget.h"
 #include "viewer3d/v3dmouseinteractor.h"
@@ -39,7 +40,7 @@ VTK_MODULE_INIT(vtkRenderingFreeType)
 
 View3DWidget::View3DWidget(QWidget *parent)
     : QWidget(parent), ui(new Ui::View3DWidget), _currentCfgWidget(nullptr),
-      _verticalExaggWiget(nullptr)
+      _verticalExaggWiget(nullptr), _buildService(nullptr)
 {
     ui->setupUi(this);
 
@@ -162,6 +163,10 @@ View3DWidget::View3DWidget(QWidget *parent)
     connect(_verticalExaggWiget, SIGNAL(valueChanged(double)), this,
             SLOT(onVerticalExaggerationChanged(double)));
 
+    _buildService = new View3DBuildService(this);
+    connect(_buildService, SIGNAL(refined(View3DListRecord, int)), this,
+            SLOT(onObjectRefined(View3DListRecord, int)));
+
     if( Util::getDisplayResolutionClass() == DisplayResolution::HIGH_DPI ){
         ui->btnGlobal->setIconSize( QSize( 64, 64 ) );
         ui->btnGlobal->setIcon( QIcon(":icons32/v3Dglobal32") );
@@ -233,10 +238,17 @@ void View3DWidget::onNewObject(const View3DListRecord object_info)
 
     // keeps a list of locator-actor pairs to allow management
     _currentObjects.insert(object_info, viewData);
+
+    // 3D grids are loaded in background, displayed coarse at first, then refined
+    if (viewData.gridPyramid)
+        _buildService->build(object_info, viewData);
 }
 
 void View3DWidget::onRemoveObject(const View3DListRecord object_info)
 {
+    // stops building the object (if it is being built)
+    _buildService->cancel(object_info);
+
     // removes the VTK actor matching the object locator from the list.
     vtkSmartPointer<vtkProp> actor = _currentObjects.take(object_info).actor;
 
@@ -328,6 +340,12 @@ void View3DWidget::onObjectsListItemActivated(QListWidgetItem *item)
         View3DConfigWidget *widget = nullptr;
         if (_currentCfgWidgets.contains(object_info)) {
             widget = _currentCfgWidgets[object_info];
+        } else if (_buildService->isOpening(object_info)) {
+            // the config widget would read the grid pyramid while it is being opened
+            Application::instance()->logInfo(
+                "View3DWidget::onObjectsListItemActivated(): " + object->getName()
+                + " is still being loaded.");
+            return;
         } else {
             View3DViewData viewObjects = _currentObjects[object_info];
             widget = object->build3DViewerConfigWidget(viewObjects);
@@ -357,6 +375,10 @@ void View3DWidget::onObjectsListItemActivated(QListWidgetItem *item)
 void View3DWidget::onConfigWidgetChanged()
 {
     Application::instance()->logInfo("View3DWidget::onConfigWidgetChanged()");
+    // the user settings take precedence over the background refinement of the object
+    View3DConfigWidget *widget = qobject_cast<View3DConfigWidget *>(sender());
+    if (widget)
+        _buildService->cancel(_currentCfgWidgets.key(widget));
     _renderer->Render();
     _vtkwidget->GetRenderWindow()->Render();
 }
@@ -409,3 +431,12 @@ void View3DWidget::onVerticalExaggerationChanged(double value)
         ui->splitter->setSizes(oldSizes);
     }
 }
+
+void View3DWidget::onObjectRefined(const View3DListRecord object_info, int level)
+{
+    // keeps the current level of detail of the object for its config widget
+    if (_currentObjects.contains(object_info))
+        _currentObjects[object_info].samplingRate = 1 << level;
+    // redraw the scene
+    _vtkwidget->GetRenderWindow()->Render();
+}
@@ -19,6 +19,7 @@ class View3DWidget;
 }
 
 class View3DStyle;
+class View3DBuildService;
 
 class QVTKOpenGLWidget;
 class QListWidgetItem;
@@ -64,6 +65,9 @@ private:
     // the floating widget for configuring the vertical scale.
     View3DVerticalExaggerationWidget *_verticalExaggWiget;
 
+    // builds the display of 3D grids in background.
+    View3DBuildService *_buildService;
+
     // removes the current 3D viewing config widget.
     void removeCurrentConfigWidget();
 
@@ -84,6 +88,7 @@ private slots:
     void onConfigWidgetChanged();
     void onVerticalExaggeration();
     void onVerticalExaggerationChanged(double value);
+    void onObjectRefined(const View3DListRecord object_info, int level);
 };
 
 #endif // VIEW3DWIDGET_H